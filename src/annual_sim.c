@@ -0,0 +1,448 @@
+/*
+ * Annual energy simulation from typical-meteorological-year weather
+ */
+
+#include "app.h"
+#include "annual_sim.h"
+#include "export_stream.h"
+#include "simulation/string_cache.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+//------------------------------------------------------------------------------
+// Weather
+//------------------------------------------------------------------------------
+bool LoadWeatherFile(AppState *app, const char *path) {
+    WeatherYear weather;
+    char error[128];
+    if (!Weather_LoadCSV(&weather, path, error, sizeof(error))) {
+        SetStatus(app, "Weather file not loaded: %s", error);
+        return false;
+    }
+
+    Weather_Free(&app->weather);
+    app->weather = weather;
+    app->weather_revision++;
+    strncpy(app->weather_path, path, MAX_PATH_LENGTH - 1);
+    app->weather_path[MAX_PATH_LENGTH - 1] = '\0';
+    app->annual_sim_run = false;
+
+    // The file's site replaces the typed coordinates so sun and weather agree
+    if (weather.has_location) {
+        app->sim_settings.latitude = weather.latitude;
+        app->sim_settings.longitude = weather.longitude;
+    }
+    SetStatus(app, "Weather: %d records of %.2g h at %.2f, %.2f", weather.record_count, weather.dt_hours,
+              app->sim_settings.latitude, app->sim_settings.longitude);
+    return true;
+}
+
+void FreeAnnualSimCache(AppState *app) {
+    AnnualSimCache *cache = &app->annual_cache;
+    SimCore_FreeSkyHistogram(&cache->sky);
+    free(cache->visible);
+    free(cache->sky_view);
+    free(cache->ground_view);
+    memset(cache, 0, sizeof(*cache));
+}
+
+//------------------------------------------------------------------------------
+// Sun Histogram and Visibility
+//------------------------------------------------------------------------------
+
+// Histogram of the loaded weather at the current site, rebuilt when either changed; NULL if unavailable
+const SimSkyHistogram *GetAnnualSkyHistogram(AppState *app) {
+    AnnualSimCache *cache = &app->annual_cache;
+    const SimSettings *s = &app->sim_settings;
+    if (app->weather.record_count == 0)
+        return NULL;
+    // Record hours are on the file's clock when it names its zone, else on the site's
+    SimSite site = GetSimSite(s);
+    if (app->weather.has_timezone)
+        site.utc_offset = app->weather.timezone;
+    if (cache->sky.bin_count > 0 && cache->weather_revision == app->weather_revision &&
+        cache->latitude == s->latitude && cache->longitude == s->longitude && cache->year == site.year &&
+        cache->utc_offset == site.utc_offset)
+        return &cache->sky;
+
+    SimCore_FreeSkyHistogram(&cache->sky);
+    cache->visibility_valid = false;
+
+    if (!SimCore_BuildSkyHistogram(&app->weather, &site, ANNUAL_HEADINGS, &cache->sky))
+        return NULL;
+
+    cache->weather_revision = app->weather_revision;
+    cache->latitude = s->latitude;
+    cache->longitude = s->longitude;
+    cache->year = site.year;
+    cache->utc_offset = site.utc_offset;
+    cache->sky_builds++;
+    return cache->sky.bin_count > 0 ? &cache->sky : NULL;
+}
+
+static bool VisibilityCurrent(const AppState *app, bool draft) {
+    const AnnualSimCache *cache = &app->annual_cache;
+    return cache->visibility_valid && cache->cell_count == app->cell_count &&
+           cache->cell_revision == app->cell_revision && cache->mesh_revision == app->mesh_revision &&
+           cache->obstacle_revision == app->obstacle_revision &&
+           cache->sky_revision == cache->sky_builds && cache->draft == draft;
+}
+
+// Progress overlay drawn between batches of work; false if the user cancelled
+static bool ShowAnnualProgress(AppState *app, const char *stage, int progress) {
+    PollInputEvents();
+    if (WindowShouldClose() || IsKeyDown(KEY_ESCAPE))
+        return false;
+
+    BeginDrawing();
+    ClearBackground(BLACK);
+    AppDraw(app);
+
+    int cx = app->screen_width / 2;
+    int cy = app->screen_height / 2 - 200;
+    DrawRectangle(0, 0, app->screen_width, app->screen_height, (Color) {0, 0, 0, 100});
+
+    DrawRectangle(cx - 175, cy - 45, 350, 90, (Color) {30, 30, 30, 245});
+    DrawRectangleLines(cx - 175, cy - 45, 350, 90, WHITE);
+
+    DrawText("Annual Sim (esc to cancel)", cx - 80, cy - 35, 20, WHITE);
+    DrawText(stage, cx - 140, cy - 8, 16, LIGHTGRAY);
+
+    int barY = cy + 15;
+    DrawRectangle(cx - 150, barY, 300, 18, DARKGRAY);
+    DrawRectangle(cx - 150, barY, (300 * progress) / 100, 18, GREEN);
+    DrawRectangleLines(cx - 150, barY, 300, 18, WHITE);
+    DrawText(TextFormat("%d%%", progress), cx - 12, barY + 2, 14, WHITE);
+
+    EndDrawing();
+    return true;
+}
+
+// Trace every cell against every sun direction bin and the sky hemisphere once; later runs on the same layout,
+// mesh and weather reuse the result
+static bool TraceVisibility(AppState *app, const SimLayout *layout, bool draft) {
+    AnnualSimCache *cache = &app->annual_cache;
+    int dir_count = cache->sky.dir_count;
+    cache->visibility_valid = false;
+
+    uint8_t *visible = (uint8_t *) realloc(cache->visible, (size_t) layout->cell_count * dir_count);
+    if (visible)
+        cache->visible = visible;
+    float *sky_view = (float *) realloc(cache->sky_view, layout->cell_count * sizeof(float));
+    if (sky_view)
+        cache->sky_view = sky_view;
+    float *ground_view = (float *) realloc(cache->ground_view, layout->cell_count * sizeof(float));
+    if (ground_view)
+        cache->ground_view = ground_view;
+    if (!visible || !sky_view || !ground_view) {
+        SetStatus(app, "Not enough memory for the annual visibility cache");
+        return false;
+    }
+
+    SimGeometry geometry = GetSimGeometry(app);
+    if (!ShowAnnualProgress(app, "Tracing sky view", 0)) {
+        SetStatus(app, "Simulation cancelled");
+        return false;
+    }
+    SimCore_CellViewFactors(&geometry, layout, draft, sky_view, ground_view);
+
+    for (int d = 0; d < dir_count; d += ANNUAL_VISIBILITY_CHUNK) {
+        if (!ShowAnnualProgress(app, TextFormat("Tracing %d sun directions", dir_count), d * 100 / dir_count)) {
+            SetStatus(app, "Simulation cancelled");
+            return false;
+        }
+        int end = d + ANNUAL_VISIBILITY_CHUNK < dir_count ? d + ANNUAL_VISIBILITY_CHUNK : dir_count;
+        SimCore_CellVisibility(&geometry, layout, cache->sky.dirs, d, end, dir_count, draft, visible);
+    }
+
+    cache->visibility_valid = true;
+    cache->cell_count = layout->cell_count;
+    cache->cell_revision = app->cell_revision;
+    cache->mesh_revision = app->mesh_revision;
+    cache->obstacle_revision = app->obstacle_revision;
+    cache->sky_revision = cache->sky_builds;
+    cache->draft = draft;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Annual Simulation
+//------------------------------------------------------------------------------
+void RunAnnualSimulation(AppState *app) {
+    if (app->cell_count == 0 || !app->mesh_loaded) {
+        SetStatus(app, "No cells or mesh to simulate");
+        return;
+    }
+    if (app->weather.record_count == 0) {
+        SetStatus(app, "Load a weather file first");
+        return;
+    }
+    if (!GetAnnualSkyHistogram(app)) {
+        SetStatus(app, "No daylight hours with irradiance in the weather file");
+        return;
+    }
+
+    CellPreset *preset = (CellPreset *) &CELL_PRESETS[app->selected_preset];
+    bool draft = app->sim_settings.draft_shading && EnsureDraftOccluder(app);
+
+    int cell_count = app->cell_count;
+    Vector3 *positions = (Vector3 *) malloc(cell_count * sizeof(Vector3));
+    Vector3 *normals = (Vector3 *) malloc(cell_count * sizeof(Vector3));
+    float *ratios = (float *) malloc(cell_count * sizeof(float));
+    float *cell_op_voltage = (float *) calloc(cell_count, sizeof(float));
+    float *cell_energy = (float *) calloc(cell_count, sizeof(float));
+    float *cell_beam = (float *) calloc(2 * cell_count, sizeof(float));
+    if (!positions || !normals || !ratios || !cell_op_voltage || !cell_energy || !cell_beam) {
+        free(positions);
+        free(normals);
+        free(ratios);
+        free(cell_op_voltage);
+        free(cell_energy);
+        free(cell_beam);
+        SetStatus(app, "Not enough memory for the annual simulation");
+        return;
+    }
+    for (int c = 0; c < cell_count; c++) {
+        positions[c] = CellGetWorldPosition(app, &app->cells[c]);
+        normals[c] = CellGetWorldNormal(app, &app->cells[c]);
+    }
+    SimLayout layout = {cell_count, positions, normals};
+
+    bool reused = VisibilityCurrent(app, draft);
+    if (!reused && !TraceVisibility(app, &layout, draft)) {
+        free(positions);
+        free(normals);
+        free(ratios);
+        free(cell_op_voltage);
+        free(cell_energy);
+        free(cell_beam);
+        return;
+    }
+    const AnnualSimCache *cache = &app->annual_cache;
+    const SimSkyHistogram *sky = &cache->sky;
+
+    // Cells of each string in the order the daily sweep evaluates them, and their string slots
+    int string_cells[MAX_STRINGS][MAX_CELLS_PER_STRING];
+    int string_cell_count[MAX_STRINGS] = {0};
+    int cell_string_slot[MAX_CELLS];
+    bool has_shared_channel = false;
+    for (int c = 0; c < cell_count; c++) {
+        cell_string_slot[c] = -1;
+        for (int s = 0; s < app->string_count; s++) {
+            CellString *str = &app->strings[s];
+            if (str->id == app->cells[c].string_id && str->cell_count > 0 &&
+                string_cell_count[s] < str->cell_count && string_cell_count[s] < MAX_CELLS_PER_STRING) {
+                string_cells[s][string_cell_count[s]++] = c;
+                cell_string_slot[c] = s;
+                has_shared_channel |= str->mppt_channel > 0;
+                break;
+            }
+        }
+    }
+    IVTrace *channel_traces =
+            has_shared_channel ? (IVTrace *) calloc(app->string_count, sizeof(IVTrace)) : NULL;
+
+    StringSimCache string_cache;
+    bool use_cache = app->sim_settings.iv_cache_step > 0.0f &&
+                     StringSimCache_Init(&string_cache, STRING_CACHE_DEFAULT_CAPACITY, app->sim_settings.iv_cache_step);
+
+    SimCellModel cell_model = {preset->voc, preset->isc, preset->n_ideal, preset->series_r, preset->bypass_v_drop};
+    float cell_area = preset->width * preset->height;
+
+    AnnualSimResults results = {0};
+    float beam_incident = 0.0f, beam_lit = 0.0f;
+
+    // Optional per-(weather bin, string) export through the same background writer as the daily sweep
+    ExportStream *export_stream = NULL;
+    if (app->export_path[0] != '\0') {
+        export_stream = ExportStream_Open(app->export_path, EXPORT_LAYOUT_ANNUAL);
+        if (!export_stream)
+            TraceLog(LOG_WARNING, "Could not open export file %s", app->export_path);
+    }
+
+    for (int b = 0; b < sky->bin_count; b++) {
+        const SimSkyBin *bin = &sky->bins[b];
+        Vector3 dir = sky->dirs[bin->dir];
+
+        if (b % 64 == 0 &&
+            !ShowAnnualProgress(app, TextFormat("Evaluating %d weather bins", sky->bin_count),
+                                b * 100 / sky->bin_count)) {
+            free(positions);
+            free(normals);
+            free(ratios);
+            free(cell_op_voltage);
+            free(cell_energy);
+            free(cell_beam);
+            free(channel_traces);
+            if (use_cache)
+                StringSimCache_Free(&string_cache);
+            ExportStream_Close(export_stream, NULL);
+            SetStatus(app, "Simulation cancelled");
+            return;
+        }
+
+        // Plane-of-array irradiance: beam where the cell sees the sun bin, isotropic sky and ground reflection
+        for (int c = 0; c < cell_count; c++) {
+            float beam = bin->dni * fmaxf(Vector3DotProduct(normals[c], dir), 0.0f);
+            float lit = cache->visible[(size_t) c * sky->dir_count + bin->dir] ? beam : 0.0f;
+            cell_beam[2 * c] += beam * bin->hours;
+            cell_beam[2 * c + 1] += lit * bin->hours;
+            float poa = lit + bin->dhi * cache->sky_view[c] + bin->ghi * ANNUAL_GROUND_ALBEDO * cache->ground_view[c];
+            ratios[c] = poa / 1000.0f;
+        }
+
+        // Strings at their MPP, memoised on the quantised pattern like the daily sweep
+        float string_power[MAX_STRINGS] = {0};
+        float string_current[MAX_STRINGS] = {0};
+        float string_v_scale[MAX_STRINGS];
+        for (int s = 0; s < app->string_count; s++) {
+            int n = string_cell_count[s];
+            if (n == 0) continue;
+
+            float string_ratios[MAX_CELLS_PER_STRING];
+            bool has_bypass[MAX_CELLS_PER_STRING];
+            for (int i = 0; i < n; i++) {
+                string_ratios[i] = ratios[string_cells[s][i]];
+                has_bypass[i] = app->cells[string_cells[s][i]].has_bypass_diode;
+            }
+
+            uint16_t codes[MAX_CELLS_PER_STRING];
+            uint32_t key = 0;
+            const StringSimCacheEntry *cached = NULL;
+            if (use_cache) {
+                key = StringSimCache_Quantise(&string_cache, string_ratios, n, codes, string_ratios);
+                cached = StringSimCache_Find(&string_cache, s, codes, n, key);
+            }
+
+            float cell_voltage[MAX_CELLS_PER_STRING];
+            StringSimResult sim_result;
+            if (cached) {
+                sim_result = cached->result;
+                memcpy(cell_voltage, cached->cell_voltage, n * sizeof(float));
+            } else {
+                SimCore_EvaluateString(&cell_model, string_ratios, has_bypass, n, &sim_result, cell_voltage);
+                if (use_cache) {
+                    StringSimCacheEntry *entry = StringSimCache_Insert(&string_cache, s, codes, n, key);
+                    if (entry) {
+                        entry->result = sim_result;
+                        memcpy(entry->cell_voltage, cell_voltage, n * sizeof(float));
+                    }
+                }
+            }
+
+            string_power[s] = sim_result.power_out;
+            string_current[s] = sim_result.current;
+            if (channel_traces && app->strings[s].mppt_channel > 0)
+                channel_traces[s] = sim_result.iv_trace;
+            for (int i = 0; i < n; i++) {
+                cell_op_voltage[string_cells[s][i]] = cell_voltage[i];
+            }
+        }
+
+        SolveMpptChannels(app, channel_traces, string_power, string_current, string_v_scale);
+
+        // Cell temperature from the NOCT model for a cell in the bin's global irradiance
+        float cell_temp = bin->temp_c + (ANNUAL_NOCT - 20.0f) / 800.0f * bin->ghi;
+        float derate = fmaxf(1.0f + ANNUAL_POWER_TEMP_COEFF * (cell_temp - 25.0f), 0.0f);
+        float hours = bin->hours * derate;
+
+        float bin_energy = 0.0f, unwired_power = 0.0f;
+        for (int c = 0; c < cell_count; c++) {
+            int s = cell_string_slot[c];
+            float power = s >= 0 ? string_current[s] * cell_op_voltage[c] * string_v_scale[s]
+                                 : ratios[c] * 1000.0f * cell_area * preset->efficiency;
+            cell_energy[c] += power * hours;
+            if (s < 0)
+                unwired_power += power;
+        }
+        bin_energy += unwired_power * hours;
+        for (int s = 0; s < app->string_count; s++) {
+            bin_energy += string_power[s] * hours;
+        }
+
+        // Rows carry the temperature-derated power, so power_w x hours sums to the annual energy
+        if (export_stream) {
+            float elevation = asinf(Clamp(Vector3Normalize(dir).y, -1.0f, 1.0f)) * RAD2DEG;
+            float azimuth = atan2f(dir.x, -dir.z) * RAD2DEG;
+            if (azimuth < 0.0f)
+                azimuth += 360.0f;
+            ExportRecord rec = {0};
+            rec.bin = b;
+            rec.hours = bin->hours;
+            rec.elevation_deg = elevation;
+            rec.azimuth_deg = azimuth;
+            for (int s = 0; s < app->string_count; s++) {
+                if (app->strings[s].cell_count == 0) continue;
+                rec.string_id = app->strings[s].id;
+                rec.power_w = string_power[s] * derate;
+                rec.current_a = string_current[s];
+                ExportStream_Push(export_stream, &rec);
+            }
+            rec.string_id = -1;
+            rec.power_w = unwired_power * derate;
+            rec.current_a = 0.0f;
+            ExportStream_Push(export_stream, &rec);
+        }
+
+        results.total_energy_kwh += bin_energy / 1000.0f;
+        for (int m = 0; m < 12; m++) {
+            results.energy_by_month_kwh[m] += bin_energy * bin->month_share[m] / 1000.0f;
+        }
+    }
+
+    // Cells show their average daylight power; those losing most of their direct sun count as shaded
+    int shaded_count = 0;
+    for (int c = 0; c < cell_count; c++) {
+        SolarCell *cell = &app->cells[c];
+        cell->power_output = cell_energy[c] / sky->daylight_hours;
+        cell->is_shaded = cell_beam[2 * c + 1] < 0.5f * cell_beam[2 * c];
+        cell->is_bypassed = false;
+        shaded_count += cell->is_shaded;
+        beam_incident += cell_beam[2 * c];
+        beam_lit += cell_beam[2 * c + 1];
+    }
+
+    results.daylight_hours = sky->daylight_hours;
+    results.specific_yield = results.total_energy_kwh / (cell_count * cell_area);
+    results.beam_shaded_pct = beam_incident > 0.0f ? 100.0f * (1.0f - beam_lit / beam_incident) : 0.0f;
+    results.dir_count = sky->dir_count;
+    results.bin_count = sky->bin_count;
+    results.visibility_reused = reused;
+    results.draft = draft;
+    app->annual_results = results;
+
+    app->sim_results.total_power = results.total_energy_kwh * 1000.0f / sky->daylight_hours;
+    app->sim_results.shaded_percentage = results.beam_shaded_pct;
+    app->sim_results.shaded_count = shaded_count;
+    app->sim_run = true;
+    app->annual_sim_run = true;
+
+    free(positions);
+    free(normals);
+    free(ratios);
+    free(cell_op_voltage);
+    free(cell_energy);
+    free(cell_beam);
+    free(channel_traces);
+    if (use_cache)
+        StringSimCache_Free(&string_cache);
+
+    if (export_stream) {
+        ExportStreamStats stats;
+        if (ExportStream_Close(export_stream, &stats)) {
+            if (stats.records_dropped > 0)
+                SetStatus(app, "Annual: %.1f kWh, exported %lld rows, %lld dropped (writer too slow)",
+                          results.total_energy_kwh, stats.records_written, stats.records_dropped);
+            else
+                SetStatus(app, "Annual: %.1f kWh, exported %lld rows", results.total_energy_kwh,
+                          stats.records_written);
+        } else {
+            SetStatus(app, "Annual: %.1f kWh, export to %s failed", results.total_energy_kwh, app->export_path);
+        }
+        return;
+    }
+
+    SetStatus(app, "Annual: %.1f kWh (%.2f kWh/m2), %.1f%% direct sun shaded%s", results.total_energy_kwh,
+              results.specific_yield, results.beam_shaded_pct, reused ? ", visibility reused" : "");
+}
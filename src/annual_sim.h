@@ -0,0 +1,14 @@
+#ifndef ANNUAL_SIM_H
+#define ANNUAL_SIM_H
+
+// Annual simulation implementation
+// Function declarations are in app.h
+// This header contains implementation-specific constants
+
+#define ANNUAL_HEADINGS 36 // Vehicle headings folded into the sun histogram
+#define ANNUAL_VISIBILITY_CHUNK 32 // Sun directions traced between progress redraws
+#define ANNUAL_GROUND_ALBEDO 0.2f // Share of global irradiance the ground reflects
+#define ANNUAL_NOCT 45.0f // Nominal operating cell temperature (C at 800 W/m^2, 20 C ambient)
+#define ANNUAL_POWER_TEMP_COEFF -0.004f // Cell power change per degree above 25 C
+
+#endif // ANNUAL_SIM_H
@@ -5,10 +5,15 @@
 
 #include "app.h"
 #include "auto_layout.h"
+#include "export_stream.h"
+#include "job_system.h"
 #include "stl_loader.h"
 #include "updater.h"
 #include "simulation/iv_trace.h"
 #include "simulation/string_sim.h"
+#include "simulation/string_cache.h"
+#include "simulation/mppt_sim.h"
+#include <float.h>
 #include <math.h>
 #include <stdarg.h>
 #include <stdint.h>
@@ -18,6 +23,7 @@
 #include <sys/stat.h>
 #include <time.h>
 #include "raygui.h"
+#include "rlgl.h"
 
 #ifdef _WIN32
 #ifndef WIN32_LEAN_AND_MEAN
@@ -144,12 +150,304 @@ Color GenerateStringColor(void) {
                     230};
 }
 
+//------------------------------------------------------------------------------
+// Wireframe
+//------------------------------------------------------------------------------
+
+// rlgl only draws vertex arrays as triangles; glDrawArrays is core OpenGL 1.1, exported by the system GL library
+#ifdef _WIN32
+__declspec(dllimport) void APIENTRY glDrawArrays(unsigned int mode, int first, int count);
+#else
+void glDrawArrays(unsigned int mode, int first, int count);
+#endif
+
+static void UnloadVehicleWireframe(AppState *app) {
+    if (app->wire_vao)
+        rlUnloadVertexArray(app->wire_vao);
+    if (app->wire_vbo)
+        rlUnloadVertexBuffer(app->wire_vbo);
+    app->wire_vao = 0;
+    app->wire_vbo = 0;
+    app->wire_vertex_count = 0;
+}
+
+// Upload the edges drawn for wireframe_mode as a static mesh-local line list. The vehicle transform is applied
+// when drawing, so only a new mesh or mode needs a rebuild.
+static void BuildVehicleWireframe(AppState *app) {
+    const MeshTopology *topo = &app->vehicle_topology;
+    UnloadVehicleWireframe(app);
+    app->wire_built_mode = app->wireframe_mode;
+    if (app->wireframe_mode == WIREFRAME_OFF || topo->edge_count == 0)
+        return;
+
+    float *vertices = (float *) RL_MALLOC(sizeof(float) * 6 * topo->edge_count);
+    if (!vertices)
+        return;
+    bool creases_only = (app->wireframe_mode == WIREFRAME_CREASES);
+    int count = 0;
+    for (int e = 0; e < topo->edge_count; e++) {
+        if (creases_only && !MeshTopology_IsCrease(topo, e, WIREFRAME_CREASE_DEG))
+            continue;
+        for (int k = 0; k < 2; k++) {
+            Vector3 p = topo->positions[topo->edges[e].v[k]];
+            vertices[3 * count] = p.x;
+            vertices[3 * count + 1] = p.y;
+            vertices[3 * count + 2] = p.z;
+            count++;
+        }
+    }
+
+    if (count > 0) {
+        app->wire_vao = rlLoadVertexArray();
+        if (app->wire_vao) {
+            rlEnableVertexArray(app->wire_vao);
+            app->wire_vbo = rlLoadVertexBuffer(vertices, (int) sizeof(float) * 3 * count, false);
+            rlSetVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_POSITION, 3, RL_FLOAT, false, 0, 0);
+            rlEnableVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_POSITION);
+            rlDisableVertexArray();
+            app->wire_vertex_count = count;
+        }
+    }
+    RL_FREE(vertices);
+}
+
+static void FreeVehicleWireframe(AppState *app) {
+    UnloadVehicleWireframe(app);
+    MeshTopology_Free(&app->vehicle_topology);
+}
+
+static void DrawVehicleWireframe(AppState *app, Color color) {
+    if (app->wireframe_mode == WIREFRAME_OFF)
+        return;
+    if (app->vehicle_topology.edge_count == 0) {
+        DrawModelWires(app->vehicle_model, (Vector3) {0, 0, 0}, 1.0f, color);
+        return;
+    }
+    if (app->wire_built_mode != app->wireframe_mode)
+        BuildVehicleWireframe(app);
+    if (app->wire_vertex_count == 0)
+        return;
+
+    // Flush the immediate-mode batch first so the lines keep their place in the draw order
+    rlDrawRenderBatchActive();
+    int *locs = rlGetShaderLocsDefault();
+    Matrix model = MatrixMultiply(app->vehicle_model.transform, rlGetMatrixTransform());
+    Matrix mvp = MatrixMultiply(MatrixMultiply(model, rlGetMatrixModelview()), rlGetMatrixProjection());
+    float tint[4] = {color.r / 255.0f, color.g / 255.0f, color.b / 255.0f, color.a / 255.0f};
+    float white[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+    float origin[2] = {0.0f, 0.0f};
+
+    rlEnableShader(rlGetShaderIdDefault());
+    rlSetUniformMatrix(locs[RL_SHADER_LOC_MATRIX_MVP], mvp);
+    rlSetUniform(locs[RL_SHADER_LOC_COLOR_DIFFUSE], tint, RL_SHADER_UNIFORM_VEC4, 1);
+    rlActiveTextureSlot(0);
+    rlEnableTexture(rlGetTextureIdDefault());
+    rlEnableVertexArray(app->wire_vao);
+    rlSetVertexAttributeDefault(locs[RL_SHADER_LOC_VERTEX_TEXCOORD01], origin, RL_SHADER_ATTRIB_VEC2, 2);
+    rlSetVertexAttributeDefault(locs[RL_SHADER_LOC_VERTEX_COLOR], white, RL_SHADER_ATTRIB_VEC4, 4);
+    glDrawArrays(RL_LINES, 0, app->wire_vertex_count);
+    rlDisableVertexArray();
+    rlDisableTexture();
+    rlDisableShader();
+}
+
+//------------------------------------------------------------------------------
+// Display LOD
+//------------------------------------------------------------------------------
+static void FreeVehicleLod(AppState *app) {
+    if (app->lod_job) {
+        MeshSimplify_Cancel(app->lod_job);
+        app->lod_job = NULL;
+    }
+    for (int l = 0; l < app->lod_level_count; l++) {
+        UnloadMesh(app->vehicle_lod[l]);
+    }
+    app->lod_level_count = 0;
+    app->lod_level = 0;
+}
+
+// Upload decimated levels once the background job has finished
+static void PollVehicleLod(AppState *app) {
+    if (!app->lod_job || !MeshSimplify_IsDone(app->lod_job))
+        return;
+
+    app->lod_level_count = MeshSimplify_Finish(app->lod_job, app->vehicle_lod);
+    app->lod_job = NULL;
+    for (int l = 0; l < app->lod_level_count; l++) {
+        UploadMesh(&app->vehicle_lod[l], false);
+    }
+    TraceLog(LOG_INFO, "Display LOD ready: %d levels", app->lod_level_count);
+}
+
+// Pick a display level from how much of the view the vehicle's bounding sphere covers
+static int SelectVehicleLod(AppState *app) {
+    if (app->lod_level_count == 0)
+        return 0;
+
+    Vector3 center = Vector3Scale(Vector3Add(app->mesh_bounds.min, app->mesh_bounds.max), 0.5f);
+    float radius = Vector3Distance(app->mesh_bounds.min, app->mesh_bounds.max) * 0.5f;
+    Camera3D *camera = &app->cam.camera;
+
+    float half_view;
+    if (camera->projection == CAMERA_ORTHOGRAPHIC) {
+        half_view = camera->fovy * 0.5f;
+    } else {
+        float dist = fmaxf(Vector3Distance(camera->position, center) - radius, 0.001f);
+        half_view = dist * tanf(camera->fovy * 0.5f * DEG2RAD);
+    }
+    float coverage = radius / half_view;
+
+    // Full resolution only when zoomed in past the whole vehicle
+    if (coverage > 2.0f)
+        return 0;
+    if (coverage > 0.4f || app->lod_level_count < 2)
+        return 1;
+    return 2;
+}
+
+static void DrawVehicleModel(AppState *app, Color tint) {
+    app->lod_level = SelectVehicleLod(app);
+    Model model = app->vehicle_model;
+    if (app->lod_level > 0)
+        model.meshes = &app->vehicle_lod[app->lod_level - 1];
+    DrawModel(model, (Vector3) {0, 0, 0}, 1.0f, tint);
+}
+
+//------------------------------------------------------------------------------
+// Draft Occluder
+//------------------------------------------------------------------------------
+static void FreeDraftOccluder(AppState *app) {
+    MeshBVH_Free(&app->draft_bvh);
+    app->draft_bvh_scale = 0.0f;
+}
+
+// Bounded-error decimation of the vehicle for draft shading, rebuilt when the scale changes the bound
+bool EnsureDraftOccluder(AppState *app) {
+    if (!app->mesh_loaded || app->vehicle_topology.tri_count == 0)
+        return false;
+    if (app->draft_bvh.nodes && app->draft_bvh_scale == app->mesh_scale)
+        return true;
+
+    FreeDraftOccluder(app);
+    Mesh proxy;
+    // Inflated by its own error bound, the proxy encloses the vehicle, so a ray that clears it clears the vehicle
+    float error = DRAFT_OCCLUDER_ERROR / app->mesh_scale;
+    if (!MeshSimplify_DecimateToError(&app->vehicle_topology, error, error, &proxy))
+        return false;
+    bool built = MeshBVH_Build(&app->draft_bvh, proxy);
+    MeshSimplify_FreeMesh(&proxy);
+    if (!built)
+        return false;
+
+    MeshBVH_SetTransform(&app->draft_bvh, app->vehicle_model.transform);
+    app->draft_bvh_scale = app->mesh_scale;
+    TraceLog(LOG_INFO, "Draft occluder: %d of %d triangles", app->draft_bvh.tri_count,
+             app->vehicle_topology.tri_count);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Surface Panels
+//------------------------------------------------------------------------------
+
+// Segmentation at the current transform and surface_threshold, rebuilt when either changes; NULL if unavailable
+const SurfacePanels *GetSurfacePanels(AppState *app) {
+    SurfacePanels *sp = &app->surface_panels;
+    if (!app->mesh_loaded || app->vehicle_topology.tri_count == 0)
+        return NULL;
+    if (sp->panels && app->panels_revision == app->mesh_revision &&
+        sp->threshold_deg == app->auto_layout.surface_threshold)
+        return sp;
+
+    SurfacePanels_Free(sp);
+    if (!SurfacePanels_Build(sp, &app->vehicle_topology, app->vehicle_model.transform,
+                             app->auto_layout.surface_threshold))
+        return NULL;
+    app->panels_revision = app->mesh_revision;
+    TraceLog(LOG_INFO, "Surface panels: %d panels from %d triangles", sp->panel_count, sp->tri_count);
+    return sp;
+}
+
+// Surface under panel p's frame point (u, v), seen along the panel normal; false if another panel is in the way
+bool ProjectOntoPanel(AppState *app, const SurfacePanels *panels, int p, float u, float v, RayCollision *hit) {
+    const SurfacePanel *panel = &panels->panels[p];
+    float lift = (panel->max_u - panel->min_u) + (panel->max_v - panel->min_v) + 1.0f;
+
+    Ray ray;
+    ray.position = Vector3Add(SurfacePanels_ToWorld(panels, p, u, v), Vector3Scale(panel->normal, lift));
+    ray.direction = Vector3Negate(panel->normal);
+
+    int triangle;
+    *hit = RaycastVehicle(app, ray, &triangle);
+    return hit->hit && (triangle < 0 || panels->tri_panel[triangle] == p);
+}
+
+//------------------------------------------------------------------------------
+// Height Map
+//------------------------------------------------------------------------------
+
+// Rasterised at the current transform, rebuilt on the first probe after it or the resolution changes
+const HeightMap *GetHeightMap(AppState *app) {
+    HeightMap *hm = &app->height_map;
+    if (!app->mesh_loaded)
+        return NULL;
+    if (hm->counts && app->height_map_revision == app->mesh_revision &&
+        app->height_map_texel == app->auto_layout.height_map_texel)
+        return hm;
+
+    HeightMap_Free(hm);
+    if (!HeightMap_Build(hm, app->vehicle_mesh, app->vehicle_model.transform, app->mesh_bounds,
+                         app->auto_layout.height_map_texel))
+        return NULL;
+    app->height_map_revision = app->mesh_revision;
+    app->height_map_texel = app->auto_layout.height_map_texel;
+    TraceLog(LOG_INFO, "Height map: %dx%d texels at %.1f cm", hm->width, hm->depth, hm->texel * 100.0f);
+    return hm;
+}
+
+// Topmost surface under (x, z), as a straight-down ray from above the mesh would see it
+RayCollision ProbeSurfaceBelow(AppState *app, float x, float z, int *out_triangle) {
+    Vector3 origin = {x, app->mesh_bounds.max.y + 1.0f, z};
+    const HeightMap *hm = GetHeightMap(app);
+    if (!hm)
+        return RaycastVehicle(app, (Ray) {origin, {0, -1, 0}}, out_triangle);
+
+    RayCollision hit = {0};
+    HeightMapSample top;
+    if (out_triangle)
+        *out_triangle = -1;
+    if (HeightMap_Top(hm, x, z, &top)) {
+        hit.hit = true;
+        hit.point = (Vector3) {x, top.y, z};
+        hit.normal = top.normal;
+        hit.distance = origin.y - top.y;
+        if (out_triangle)
+            *out_triangle = top.triangle;
+    }
+    return hit;
+}
+
+// Distance straight up from position to the vehicle, FLT_MAX if nothing is above
+float ProbeClearance(AppState *app, Vector3 position) {
+    const HeightMap *hm = GetHeightMap(app);
+    if (hm)
+        return HeightMap_Clearance(hm, position.x, position.y, position.z);
+
+    RayCollision hit = RaycastVehicle(app, (Ray) {position, {0, 1, 0}}, NULL);
+    return hit.hit ? hit.distance : FLT_MAX;
+}
+
 //------------------------------------------------------------------------------
 // App Lifecycle
 //------------------------------------------------------------------------------
 void AppInit(AppState *app) {
     srand((unsigned int) time(NULL));
 
+    // Thread pool shared by the sweep, auto-layout and module fill
+    if (!JobSystem_Init(0))
+        TraceLog(LOG_WARNING, "Job system unavailable, running single-threaded");
+    TraceLog(LOG_INFO, "Job system: %d worker threads", JobSystem_WorkerCount());
+
     // Initialize updater
     UpdaterInit();
     app->update_check_done = false;
@@ -187,6 +485,9 @@ void AppInit(AppState *app) {
     // Modules
     InitModules(app);
 
+    // Undo history
+    UndoJournal_Init(&app->undo);
+
     // Auto-layout
     InitAutoLayout(app);
 
@@ -200,11 +501,15 @@ void AppInit(AppState *app) {
     app->sim_settings.month = 6;
     app->sim_settings.day = 21;
     app->sim_settings.hour = 12.0f;
+    app->sim_settings.auto_utc_offset = true;
     app->sim_settings.irradiance = 1000.0f;
+    app->sim_settings.iv_cache_step = STRING_CACHE_DEFAULT_STEP;
+    app->sim_settings.record_timeseries = true;
     app->sim_run = false;
 
     // UI
     app->hovered_cell_id = -1;
+    app->selected_obstacle = -1;
     app->is_drag_selecting = false;
     app->drag_start = (Vector2){0, 0};
     app->drag_end = (Vector2){0, 0};
@@ -217,11 +522,44 @@ void AppInit(AppState *app) {
     GuiSetStyle(DEFAULT, TEXT_SIZE, 16);
 }
 
+// Per-process recording file, so concurrent instances never truncate a file another one has mapped
+static void GetTimeSeriesPath(char *path_out, size_t path_size) {
+#ifdef _WIN32
+    char temp_dir[MAX_PATH];
+    if (GetTempPathA(MAX_PATH, temp_dir) == 0)
+        snprintf(temp_dir, sizeof(temp_dir), ".\\");
+    snprintf(path_out, path_size, "%sshellpower_timeseries_%lu.bin", temp_dir, (unsigned long) GetCurrentProcessId());
+#else
+    const char *temp_dir = getenv("TMPDIR");
+    if (!temp_dir)
+        temp_dir = "/tmp";
+    snprintf(path_out, path_size, "%s/shellpower_timeseries_%ld.bin", temp_dir, (long) getpid());
+#endif
+}
+
 void AppClose(AppState *app) {
     if (app->mesh_loaded) {
         UnloadModel(app->vehicle_model);
-    }
+        MeshBVH_Free(&app->vehicle_bvh);
+        FreeVehicleWireframe(app);
+        FreeVehicleLod(app);
+        FreeDraftOccluder(app);
+        SurfacePanels_Free(&app->surface_panels);
+        HeightMap_Free(&app->height_map);
+    }
+    TimeSeries_Unmap(&app->timeseries);
+    char ts_path[MAX_PATH_LENGTH];
+    GetTimeSeriesPath(ts_path, sizeof(ts_path));
+    remove(ts_path);
+    PickGrid_Free(&app->pick_grid);
+    UndoJournal_Free(&app->undo);
+    FreeAnnualSimCache(app);
+    FreeInsolationMap(app);
+    ClearObstacles(app);
+    Weather_Free(&app->weather);
+    NetworkSim_Free(&app->network);
     UpdaterCleanup();
+    JobSystem_Shutdown();
 }
 
 //------------------------------------------------------------------------------
@@ -273,6 +611,13 @@ bool LoadVehicleMesh(AppState *app, const char *path) {
     // Unload existing mesh
     if (app->mesh_loaded) {
         UnloadModel(app->vehicle_model);
+        MeshBVH_Free(&app->vehicle_bvh);
+        FreeVehicleWireframe(app);
+        FreeVehicleLod(app);
+        FreeDraftOccluder(app);
+        SurfacePanels_Free(&app->surface_panels);
+        HeightMap_Free(&app->height_map);
+        FreeInsolationMap(app);
         app->mesh_loaded = false;
     }
 
@@ -298,6 +643,23 @@ bool LoadVehicleMesh(AppState *app, const char *path) {
 
     // Keep a copy of mesh for raycasting
     app->vehicle_mesh = app->vehicle_model.meshes[0];
+    if (!MeshBVH_Build(&app->vehicle_bvh, app->vehicle_mesh))
+        TraceLog(LOG_WARNING, "Mesh BVH build failed, falling back to brute-force raycasts");
+
+    // Deduplicated edges for the wireframe overlay (mesh-local, so transforms don't invalidate them)
+    if (MeshTopology_Build(&app->vehicle_topology, app->vehicle_mesh)) {
+        if (app->vehicle_topology.edge_count > WIREFRAME_DENSE_EDGES && app->wireframe_mode == WIREFRAME_ALL)
+            app->wireframe_mode = WIREFRAME_CREASES;
+        BuildVehicleWireframe(app);
+
+        // Decimated display levels are built in the background; full resolution is drawn until they arrive
+        if (app->vehicle_topology.tri_count > MESH_LOD_MIN_TRIANGLES) {
+            int targets[MESH_LOD_MAX_LEVELS] = {MESH_LOD_NEAR_TRIANGLES, MESH_LOD_FAR_TRIANGLES};
+            app->lod_job = MeshSimplify_Start(&app->vehicle_topology, targets, MESH_LOD_MAX_LEVELS);
+        }
+    } else {
+        TraceLog(LOG_WARNING, "Mesh topology build failed, falling back to per-triangle wireframe");
+    }
 
     // Store path
     strncpy(app->mesh_path, path, MAX_PATH_LENGTH - 1);
@@ -309,8 +671,9 @@ bool LoadVehicleMesh(AppState *app, const char *path) {
     // Reset camera to fit mesh
     CameraFitToBounds(&app->cam, app->mesh_bounds);
 
-    // Clear existing cells
+    // Clear existing cells; edits made on the previous mesh cannot be undone onto this one
     ClearAllCells(app);
+    ClearEditHistory(app);
 
     SetStatus(app, "Loaded mesh: %s", GetFileName(path));
     return true;
@@ -320,6 +683,9 @@ void UpdateMeshTransform(AppState *app) {
     if (!app->mesh_loaded)
         return;
 
+    // Cell world positions follow the mesh transform
+    app->cell_revision++;
+
     // Build transform: translate to origin -> scale -> rotate -> translate to final position
     // This ensures rotation happens about the mesh center
 
@@ -377,12 +743,62 @@ void UpdateMeshTransform(AppState *app) {
 
     // Final transform
     app->vehicle_model.transform = MatrixMultiply(transform, toFinal);
+    MeshBVH_SetTransform(&app->vehicle_bvh, app->vehicle_model.transform);
+    if (app->draft_bvh.nodes)
+        MeshBVH_SetTransform(&app->draft_bvh, app->vehicle_model.transform);
+    app->mesh_revision++;
 
     // Update bounds to final position
     app->mesh_bounds.min = (Vector3) {newMin.x + finalX, newMin.y + finalY, newMin.z + finalZ};
     app->mesh_bounds.max = (Vector3) {newMax.x + finalX, newMax.y + finalY, newMax.z + finalZ};
 }
 
+// Read-only view of the vehicle for the simulation core; draft hits within the proxy's shell are the cell's own surface
+SimGeometry GetSimGeometry(AppState *app) {
+    SimGeometry geometry = {0};
+    geometry.bvh = app->vehicle_bvh.nodes ? &app->vehicle_bvh : NULL;
+    geometry.mesh = app->vehicle_mesh;
+    geometry.transform = app->vehicle_model.transform;
+    geometry.draft = app->draft_bvh.nodes ? &app->draft_bvh : NULL;
+    geometry.draft_min_hit = SIM_CORE_MIN_HIT + 2.0f * DRAFT_OCCLUDER_ERROR;
+    geometry.obstacles = app->obstacle_count > 0 ? &app->obstacle_scene : NULL;
+    return geometry;
+}
+
+bool IsSunOccluded(AppState *app, Vector3 position, Vector3 normal, Vector3 sun_dir, bool draft) {
+    SimGeometry geometry = GetSimGeometry(app);
+    return SimCore_SunOccluded(&geometry, position, normal, sun_dir, draft);
+}
+
+RayCollision RaycastVehicle(AppState *app, Ray ray, int *out_triangle) {
+    if (app->vehicle_bvh.nodes)
+        return MeshBVH_Raycast(&app->vehicle_bvh, ray, out_triangle);
+
+    if (out_triangle)
+        *out_triangle = -1;
+    return GetRayCollisionMesh(ray, app->vehicle_mesh, app->vehicle_model.transform);
+}
+
+const HoverPick *GetHoverPick(AppState *app) {
+    HoverPick *pick = &app->hover_pick;
+    Vector2 mouse = GetMousePosition();
+
+    if (!pick->valid || pick->mouse.x != mouse.x || pick->mouse.y != mouse.y ||
+        pick->mesh_revision != app->mesh_revision ||
+        memcmp(&pick->camera, &app->cam.camera, sizeof(Camera3D)) != 0) {
+        pick->mouse = mouse;
+        pick->camera = app->cam.camera;
+        pick->mesh_revision = app->mesh_revision;
+        pick->hit = (RayCollision) {0};
+        pick->triangle = -1;
+        if (app->mesh_loaded) {
+            pick->hit = RaycastVehicle(app, GetMouseRay(mouse, app->cam.camera), &pick->triangle);
+        }
+        pick->valid = true;
+    }
+    return pick;
+}
+
 //------------------------------------------------------------------------------
 // Cell Placement
 //------------------------------------------------------------------------------
@@ -417,17 +833,6 @@ Vector3 CellGetWorldTangent(AppState *app, SolarCell *cell) {
     return Vector3Normalize(worldTangent);
 }
 int PlaceCellEx(AppState *app, Vector3 world_position, Vector3 world_normal, bool check_overlap) {
-    if (app->cell_count >= MAX_CELLS) {
-        SetStatus(app, "Maximum cell count reached");
-        return -1;
-    }
-
-    // Check minimum surface angle (in world space)
-    if (world_normal.y < MIN_UPWARD_NORMAL) {
-        SetStatus(app, "Surface too steep for cell placement");
-        return -1;
-    }
-
     // Check for overlapping cells (in world space) - skip if check_overlap is false
     if (check_overlap) {
         CellPreset *preset = (CellPreset *) &CELL_PRESETS[app->selected_preset];
@@ -454,6 +859,26 @@ int PlaceCellEx(AppState *app, Vector3 world_position, Vector3 world_normal, boo
     }
     world_tangent = Vector3Normalize(world_tangent);
 
+    return PlaceCellOriented(app, world_position, world_normal, world_tangent);
+}
+
+// Place a cell whose width runs along world_tangent (projected onto the surface plane); no overlap check
+int PlaceCellOriented(AppState *app, Vector3 world_position, Vector3 world_normal, Vector3 world_tangent) {
+    if (app->cell_count >= MAX_CELLS) {
+        SetStatus(app, "Maximum cell count reached");
+        return -1;
+    }
+
+    // Check minimum surface angle (in world space)
+    if (world_normal.y < MIN_UPWARD_NORMAL) {
+        SetStatus(app, "Surface too steep for cell placement");
+        return -1;
+    }
+
+    world_tangent = Vector3Subtract(world_tangent,
+                                    Vector3Scale(world_normal, Vector3DotProduct(world_tangent, world_normal)));
+    world_tangent = Vector3Normalize(world_tangent);
+
     // Convert world coords to local (inverse of mesh transform)
     Matrix invTransform = MatrixInvert(app->vehicle_model.transform);
     Vector3 local_position = Vector3Transform(world_position, invTransform);
@@ -467,6 +892,7 @@ int PlaceCellEx(AppState *app, Vector3 world_position, Vector3 world_normal, boo
     Vector3 local_tangent = Vector3Normalize(Vector3Transform(world_tangent, normalInvTransform));
 
     // Create cell with local coordinates
+    BeginEdit(app, "Place cell");
     SolarCell *cell = &app->cells[app->cell_count];
     cell->id = app->next_cell_id++;
     cell->local_position = local_position;
@@ -479,6 +905,9 @@ int PlaceCellEx(AppState *app, Vector3 world_position, Vector3 world_normal, boo
     cell->power_output = 0;
 
     app->cell_count++;
+    app->cell_revision++;
+    JournalCellAdded(app, app->cell_count - 1);
+    EndEdit(app);
 
     SetStatus(app, "Placed cell #%d", cell->id);
     return cell->id;
@@ -501,6 +930,7 @@ void RemoveCell(AppState *app, int cell_id) {
     if (idx < 0)
         return;
 
+    BeginEdit(app, "Remove cell");
     SolarCell *cell = &app->cells[idx];
 
     // Remove from string if wired
@@ -512,6 +942,7 @@ void RemoveCell(AppState *app, int cell_id) {
                 for (int c = 0; c < str->cell_count; c++) {
                     if (str->cell_ids[c] == cell_id) {
                         // Shift remaining
+                        JournalStringCellRemoving(app, s, c);
                         for (int j = c; j < str->cell_count - 1; j++) {
                             str->cell_ids[j] = str->cell_ids[j + 1];
                         }
@@ -525,18 +956,30 @@ void RemoveCell(AppState *app, int cell_id) {
     }
 
     // Remove cell by shifting array
+    JournalCellRemoving(app, idx);
     for (int i = idx; i < app->cell_count - 1; i++) {
         app->cells[i] = app->cells[i + 1];
     }
     app->cell_count--;
+    app->cell_revision++;
+    EndEdit(app);
 
     SetStatus(app, "Removed cell");
 }
 
 void ClearAllCells(AppState *app) {
+    BeginEdit(app, "Clear cells");
+    for (int i = app->cell_count - 1; i >= 0; i--) {
+        JournalCellRemoving(app, i);
+    }
+    for (int s = app->string_count - 1; s >= 0; s--) {
+        JournalStringRemoving(app, s);
+    }
     app->cell_count = 0;
+    app->cell_revision++;
     app->string_count = 0;
     app->active_string_id = -1;
+    EndEdit(app);
     app->sim_run = false;
     SetStatus(app, "Cleared all cells");
 }
@@ -551,6 +994,21 @@ int FindCellAtPosition(AppState *app, Vector3 pos, float threshold) {
     return -1;
 }
 
+PickGrid *GetCellPickGrid(AppState *app) {
+    PickGrid *grid = &app->pick_grid;
+    int sw = GetScreenWidth();
+    int sh = GetScreenHeight();
+
+    if (PickGrid_IsStale(grid, app->cam.camera, sw, sh, app->cell_revision)) {
+        static Vector3 positions[MAX_CELLS];
+        for (int i = 0; i < app->cell_count; i++) {
+            positions[i] = CellGetWorldPosition(app, &app->cells[i]);
+        }
+        PickGrid_Build(grid, positions, app->cell_count, app->cam.camera, sw, sh, app->cell_revision);
+    }
+    return grid->valid ? grid : NULL;
+}
+
 int FindCellNearRay(AppState *app, Ray ray, float *out_distance) {
     int closest_id = -1;
     float closest_dist = 1000000.0f;
@@ -558,7 +1016,31 @@ int FindCellNearRay(AppState *app, Ray ray, float *out_distance) {
     CellPreset *preset = (CellPreset *) &CELL_PRESETS[app->selected_preset];
     float threshold = fmaxf(preset->width, preset->height) * 0.7f;
 
-    for (int i = 0; i < app->cell_count; i++) {
+    // Only test cells projected near the ray's screen position. The search radius is the
+    // threshold's size on screen at the nearest cell depth, so no candidate can be missed.
+    static int candidates[MAX_CELLS];
+    int candidate_count = app->cell_count;
+    bool use_candidates = false;
+    PickGrid *grid = GetCellPickGrid(app);
+    if (grid) {
+        Camera3D cam = app->cam.camera;
+        Vector2 center = PickGrid_Project(cam, grid->screen_width, grid->screen_height,
+                                          Vector3Add(ray.position, ray.direction), NULL);
+        float px_per_unit;
+        if (cam.projection == CAMERA_ORTHOGRAPHIC) {
+            px_per_unit = grid->screen_height / fmaxf(cam.fovy, 1e-6f);
+        } else {
+            float depth = fmaxf(grid->min_depth, 0.01f);
+            px_per_unit = grid->screen_height / (2.0f * tanf(cam.fovy * 0.5f * DEG2RAD) * depth);
+        }
+        candidate_count = PickGrid_QueryRadius(grid, center, threshold * px_per_unit * 1.5f + 2.0f, candidates,
+                                               MAX_CELLS);
+        use_candidates = true;
+    }
+
+    for (int k = 0; k < candidate_count; k++) {
+        int i = use_candidates ? candidates[k] : k;
+
         // Simple distance from ray to point (use world position)
         Vector3 cellPos = CellGetWorldPosition(app, &app->cells[i]);
         Vector3 toCell = Vector3Subtract(cellPos, ray.position);
@@ -589,14 +1071,18 @@ int StartNewString(AppState *app) {
         return -1;
     }
 
+    BeginEdit(app, "New string");
     CellString *str = &app->strings[app->string_count];
     str->id = app->next_string_id++;
     str->color = GenerateStringColor();
     str->cell_count = 0;
     str->total_power = 0;
+    str->mppt_channel = 0;
 
     app->active_string_id = str->id;
     app->string_count++;
+    JournalStringAdded(app, app->string_count - 1);
+    EndEdit(app);
 
     SetStatus(app, "Started string #%d", str->id);
     return str->id;
@@ -621,9 +1107,12 @@ void AddCellToString(AppState *app, int cell_id) {
     }
 
     // Start new string if needed
+    BeginEdit(app, "Wire cell");
     if (app->active_string_id < 0) {
-        if (StartNewString(app) < 0)
+        if (StartNewString(app) < 0) {
+            EndEdit(app);
             return;
+        }
     }
 
     // Find active string
@@ -634,18 +1123,25 @@ void AddCellToString(AppState *app, int cell_id) {
             break;
         }
     }
-    if (!str)
+    if (!str) {
+        EndEdit(app);
         return;
+    }
 
     if (str->cell_count >= MAX_CELLS_PER_STRING) {
         SetStatus(app, "String is full");
+        EndEdit(app);
         return;
     }
 
     // Add cell to string
+    int old_string_id = cell->string_id, old_order = cell->order_in_string;
     cell->string_id = str->id;
     cell->order_in_string = str->cell_count;
     str->cell_ids[str->cell_count++] = cell_id;
+    JournalCellWired(app, (int) (cell - app->cells), old_string_id, old_order);
+    JournalStringCellAdded(app, (int) (str - app->strings), str->cell_count - 1);
+    EndEdit(app);
 
     SetStatus(app, "Added cell #%d to string #%d (%d cells)", cell_id, str->id, str->cell_count);
 }
@@ -657,10 +1153,12 @@ void EndCurrentString(AppState *app) {
     }
 
     // Find string and check if empty
+    BeginEdit(app, "End string");
     for (int i = 0; i < app->string_count; i++) {
         if (app->strings[i].id == app->active_string_id) {
             if (app->strings[i].cell_count == 0) {
                 // Remove empty string
+                JournalStringRemoving(app, i);
                 for (int j = i; j < app->string_count - 1; j++) {
                     app->strings[j] = app->strings[j + 1];
                 }
@@ -672,6 +1170,7 @@ void EndCurrentString(AppState *app) {
 
     SetStatus(app, "Ended string #%d", app->active_string_id);
     app->active_string_id = -1;
+    EndEdit(app);
 }
 
 void CancelCurrentString(AppState *app) {
@@ -689,20 +1188,24 @@ void CancelCurrentString(AppState *app) {
     if (strIdx < 0)
         return;
 
+    BeginEdit(app, "Cancel string");
     CellString *str = &app->strings[strIdx];
 
     // Unwire all cells in string
     for (int i = 0; i < str->cell_count; i++) {
         for (int c = 0; c < app->cell_count; c++) {
             if (app->cells[c].id == str->cell_ids[i]) {
+                int old_string_id = app->cells[c].string_id, old_order = app->cells[c].order_in_string;
                 app->cells[c].string_id = -1;
                 app->cells[c].order_in_string = -1;
+                JournalCellWired(app, c, old_string_id, old_order);
                 break;
             }
         }
     }
 
     // Remove string
+    JournalStringRemoving(app, strIdx);
     for (int i = strIdx; i < app->string_count - 1; i++) {
         app->strings[i] = app->strings[i + 1];
     }
@@ -710,22 +1213,150 @@ void CancelCurrentString(AppState *app) {
 
     SetStatus(app, "Cancelled string");
     app->active_string_id = -1;
+    EndEdit(app);
 }
 
 void ClearAllWiring(AppState *app) {
     // Unwire all cells
+    BeginEdit(app, "Clear wiring");
     for (int i = 0; i < app->cell_count; i++) {
+        int old_string_id = app->cells[i].string_id, old_order = app->cells[i].order_in_string;
         app->cells[i].string_id = -1;
         app->cells[i].order_in_string = -1;
+        JournalCellWired(app, i, old_string_id, old_order);
     }
 
+    for (int s = app->string_count - 1; s >= 0; s--) {
+        JournalStringRemoving(app, s);
+    }
     app->string_count = 0;
     app->active_string_id = -1;
     app->sim_run = false;
+    EndEdit(app);
 
     SetStatus(app, "Cleared all wiring");
 }
 
+// World positions of a string's cells in wiring order; returns how many were found
+static int CollectStringPositions(AppState *app, const CellString *str, Vector3 *positions) {
+    int found = 0;
+    for (int i = 0; i < str->cell_count; i++) {
+        for (int c = 0; c < app->cell_count; c++) {
+            if (app->cells[c].id == str->cell_ids[i]) {
+                positions[found++] = CellGetWorldPosition(app, &app->cells[c]);
+                break;
+            }
+        }
+    }
+    return found;
+}
+
+float GetStringRouteLength(AppState *app, const CellString *str) {
+    Vector3 positions[MAX_CELLS_PER_STRING];
+    int count = CollectStringPositions(app, str, positions);
+    float length = 0.0f;
+    for (int i = 0; i + 1 < count; i++) {
+        length += Vector3Distance(positions[i], positions[i + 1]);
+    }
+    return length;
+}
+
+bool OptimiseStringRoute(AppState *app, int string_index, RouteStats *stats) {
+    CellString *str = &app->strings[string_index];
+    Vector3 positions[MAX_CELLS_PER_STRING];
+    int count = str->cell_count;
+    if (CollectStringPositions(app, str, positions) != count)
+        return false;
+
+    // Bypass diodes cover the cells between their end cells, so those cells stay put and only the runs between
+    // them are reordered
+    bool pinned[MAX_CELLS_PER_STRING] = {false};
+    for (int d = 0; d < app->bypass_diode_count; d++) {
+        BypassDiode *diode = &app->bypass_diodes[d];
+        if (diode->string_id != str->id)
+            continue;
+        for (int i = 0; i < count; i++) {
+            if (str->cell_ids[i] == diode->start_cell_id || str->cell_ids[i] == diode->end_cell_id)
+                pinned[i] = true;
+        }
+    }
+
+    int new_ids[MAX_CELLS_PER_STRING];
+    int order[MAX_CELLS_PER_STRING];
+    RouteStats total = {0};
+    int first = 0;
+    while (first < count) {
+        int last = first + 1;
+        while (last < count - 1 && !pinned[last]) {
+            last++;
+        }
+        if (last >= count)
+            last = count - 1;
+
+        RouteStats run;
+        int len = last - first + 1;
+        if (!StringRouter_Solve(&positions[first], len, pinned[first], pinned[last], order, &run))
+            return false;
+        for (int i = 0; i < len; i++) {
+            new_ids[first + i] = str->cell_ids[first + order[i]];
+        }
+        total.initial_length += run.initial_length;
+        total.length += run.length;
+        total.two_opt_moves += run.two_opt_moves;
+        total.or_opt_moves += run.or_opt_moves;
+        first = last; // Runs share their pinned end cell
+        if (first == count - 1)
+            break;
+    }
+
+    int old_ids[MAX_CELLS_PER_STRING];
+    memcpy(old_ids, str->cell_ids, count * sizeof(int));
+    BeginEdit(app, "Optimise route");
+    for (int i = 0; i < count; i++) {
+        str->cell_ids[i] = new_ids[i];
+        for (int c = 0; c < app->cell_count; c++) {
+            if (app->cells[c].id == new_ids[i]) {
+                int old_order = app->cells[c].order_in_string;
+                app->cells[c].order_in_string = i;
+                JournalCellWired(app, c, app->cells[c].string_id, old_order);
+                break;
+            }
+        }
+    }
+    if (memcmp(old_ids, new_ids, count * sizeof(int)) != 0)
+        JournalStringReordered(app, string_index, old_ids);
+    EndEdit(app);
+    if (stats)
+        *stats = total;
+    return true;
+}
+
+void OptimiseAllStringRoutes(AppState *app) {
+    if (app->string_count == 0) {
+        SetStatus(app, "No strings to route");
+        return;
+    }
+
+    // Ribbon loss at the preset's MPP current, the same in every series cell of a string
+    float imp = CELL_PRESETS[app->selected_preset].imp;
+    float before = 0.0f, after = 0.0f;
+    int routed = 0;
+    BeginEdit(app, "Optimise routes");
+    for (int s = 0; s < app->string_count; s++) {
+        RouteStats stats;
+        if (app->strings[s].cell_count < 2 || !OptimiseStringRoute(app, s, &stats))
+            continue;
+        before += stats.initial_length;
+        after += stats.length;
+        routed++;
+    }
+    EndEdit(app);
+
+    float loss = imp * imp * INTERCONNECT_OHMS_PER_M * after;
+    SetStatus(app, "Routed %d strings: %.2f m -> %.2f m of interconnect, %.3f W loss at %.2f A", routed, before, after,
+              loss, imp);
+}
+
 //------------------------------------------------------------------------------
 // Bypass Diodes
 //------------------------------------------------------------------------------
@@ -769,6 +1400,7 @@ int AddBypassDiode(AppState *app, int start_cell_id, int end_cell_id) {
 
     CellPreset *preset = (CellPreset *)&CELL_PRESETS[app->selected_preset];
 
+    BeginEdit(app, "Add bypass diode");
     BypassDiode *diode = &app->bypass_diodes[app->bypass_diode_count];
     diode->id = app->next_bypass_diode_id++;
     diode->string_id = start_cell->string_id;
@@ -777,6 +1409,8 @@ int AddBypassDiode(AppState *app, int start_cell_id, int end_cell_id) {
     diode->is_conducting = false;
     diode->voltage_drop = preset->bypass_v_drop;
     app->bypass_diode_count++;
+    JournalDiodeAdded(app, app->bypass_diode_count - 1);
+    EndEdit(app);
 
     SetStatus(app, "Added bypass diode #%d", diode->id);
     return diode->id;
@@ -786,10 +1420,13 @@ void RemoveBypassDiode(AppState *app, int diode_id) {
     for (int i = 0; i < app->bypass_diode_count; i++) {
         if (app->bypass_diodes[i].id == diode_id) {
             // Shift remaining diodes down
+            BeginEdit(app, "Remove bypass diode");
+            JournalDiodeRemoving(app, i);
             for (int j = i; j < app->bypass_diode_count - 1; j++) {
                 app->bypass_diodes[j] = app->bypass_diodes[j + 1];
             }
             app->bypass_diode_count--;
+            EndEdit(app);
             SetStatus(app, "Removed bypass diode");
             return;
         }
@@ -797,7 +1434,12 @@ void RemoveBypassDiode(AppState *app, int diode_id) {
 }
 
 void ClearAllBypassDiodes(AppState *app) {
+    BeginEdit(app, "Clear bypass diodes");
+    for (int i = app->bypass_diode_count - 1; i >= 0; i--) {
+        JournalDiodeRemoving(app, i);
+    }
     app->bypass_diode_count = 0;
+    EndEdit(app);
     app->placing_bypass_diode = false;
     app->bypass_diode_start_cell = -1;
     SetStatus(app, "Cleared all bypass diodes");
@@ -869,44 +1511,9 @@ static int CompareCellsByRow(const void *a, const void *b) {
     return 0;
 }
 
-int AddCellsInRectToString(AppState *app, Vector2 screenMin, Vector2 screenMax) {
-    // Normalize rectangle bounds
-    float minX = fminf(screenMin.x, screenMax.x);
-    float maxX = fmaxf(screenMin.x, screenMax.x);
-    float minY = fminf(screenMin.y, screenMax.y);
-    float maxY = fmaxf(screenMin.y, screenMax.y);
-
-    // Start new string if needed
-    if (app->active_string_id < 0) {
-        if (StartNewString(app) < 0)
-            return 0;
-    }
-
-    // First pass: collect all cells in the selection rectangle
-    CellSortEntry *selected = (CellSortEntry *)malloc(app->cell_count * sizeof(CellSortEntry));
-    int selectedCount = 0;
-
-    for (int i = 0; i < app->cell_count; i++) {
-        SolarCell *cell = &app->cells[i];
-
-        // Skip already wired cells
-        if (cell->string_id >= 0)
-            continue;
-
-        // Get world position and project to screen
-        Vector3 worldPos = CellGetWorldPosition(app, cell);
-        Vector2 screenPos = GetWorldToScreen(worldPos, app->cam.camera);
-
-        // Check if within selection rectangle
-        if (screenPos.x >= minX && screenPos.x <= maxX &&
-            screenPos.y >= minY && screenPos.y <= maxY) {
-            selected[selectedCount].cell_index = i;
-            selected[selectedCount].x = worldPos.x;
-            selected[selectedCount].z = worldPos.z;
-            selectedCount++;
-        }
-    }
-
+// Order selected cells by rows in a snake pattern and append them to the active string
+// Takes ownership of selected
+static int AddSelectedCellsToString(AppState *app, CellSortEntry *selected, int selectedCount) {
     if (selectedCount == 0) {
         free(selected);
         return 0;
@@ -970,9 +1577,12 @@ int AddCellsInRectToString(AppState *app, Vector2 screenMin, Vector2 screenMax)
     if (str) {
         for (int i = 0; i < selectedCount && str->cell_count < MAX_CELLS_PER_STRING; i++) {
             SolarCell *cell = &app->cells[selected[i].cell_index];
+            int old_string_id = cell->string_id, old_order = cell->order_in_string;
             cell->string_id = str->id;
             cell->order_in_string = str->cell_count;
             str->cell_ids[str->cell_count++] = cell->id;
+            JournalCellWired(app, selected[i].cell_index, old_string_id, old_order);
+            JournalStringCellAdded(app, (int) (str - app->strings), str->cell_count - 1);
             added++;
         }
     }
@@ -986,6 +1596,81 @@ int AddCellsInRectToString(AppState *app, Vector2 screenMin, Vector2 screenMax)
     return added;
 }
 
+// Unwired cells among pick grid hits, with world X/Z for row ordering
+static CellSortEntry *CollectUnwiredCells(AppState *app, const int *hits, int hitCount, int *outCount) {
+    CellSortEntry *selected = (CellSortEntry *)malloc((hitCount > 0 ? hitCount : 1) * sizeof(CellSortEntry));
+    int selectedCount = 0;
+
+    for (int k = 0; selected && k < hitCount; k++) {
+        SolarCell *cell = &app->cells[hits[k]];
+
+        // Skip already wired cells
+        if (cell->string_id >= 0)
+            continue;
+
+        Vector3 worldPos = CellGetWorldPosition(app, cell);
+        selected[selectedCount].cell_index = hits[k];
+        selected[selectedCount].x = worldPos.x;
+        selected[selectedCount].z = worldPos.z;
+        selectedCount++;
+    }
+
+    *outCount = selectedCount;
+    return selected;
+}
+
+int AddCellsInRectToString(AppState *app, Vector2 screenMin, Vector2 screenMax) {
+    // Normalize rectangle bounds
+    float minX = fminf(screenMin.x, screenMax.x);
+    float maxX = fmaxf(screenMin.x, screenMax.x);
+    float minY = fminf(screenMin.y, screenMax.y);
+    float maxY = fmaxf(screenMin.y, screenMax.y);
+
+    // Start new string if needed
+    if (app->active_string_id < 0) {
+        if (StartNewString(app) < 0)
+            return 0;
+    }
+
+    PickGrid *grid = GetCellPickGrid(app);
+    if (!grid)
+        return 0;
+
+    // Collect cells in the selection rectangle (only overlapping buckets are visited)
+    static int hits[MAX_CELLS];
+    int hitCount = PickGrid_QueryRect(grid, (Rectangle) {minX, minY, maxX - minX, maxY - minY}, hits, MAX_CELLS);
+
+    int selectedCount = 0;
+    CellSortEntry *selected = CollectUnwiredCells(app, hits, hitCount, &selectedCount);
+    if (!selected)
+        return 0;
+    return AddSelectedCellsToString(app, selected, selectedCount);
+}
+
+int AddCellsInLassoToString(AppState *app, const Vector2 *points, int pointCount) {
+    if (pointCount < 3)
+        return 0;
+
+    // Start new string if needed
+    if (app->active_string_id < 0) {
+        if (StartNewString(app) < 0)
+            return 0;
+    }
+
+    PickGrid *grid = GetCellPickGrid(app);
+    if (!grid)
+        return 0;
+
+    static int hits[MAX_CELLS];
+    int hitCount = PickGrid_QueryPolygon(grid, points, pointCount, hits, MAX_CELLS);
+
+    int selectedCount = 0;
+    CellSortEntry *selected = CollectUnwiredCells(app, hits, hitCount, &selectedCount);
+    if (!selected)
+        return 0;
+    return AddSelectedCellsToString(app, selected, selectedCount);
+}
+
 //------------------------------------------------------------------------------
 // Modules
 //------------------------------------------------------------------------------
@@ -993,6 +1678,9 @@ void InitModules(AppState *app) {
     app->module_count = 0;
     app->selected_module = -1;
     app->placing_module = false;
+    app->filling_module = false;
+    app->module_fill_angle = 0.0f;
+    app->module_fill_gap = 0.02f;
 
 // Create modules directory if it doesn't exist
 #ifdef _WIN32
@@ -1209,6 +1897,7 @@ int PlaceModule(AppState *app, int module_index, Vector3 world_position, Vector3
 
     // Calculate rotation to align module with surface normal
     // For simplicity, we just offset cells - proper rotation would need more math
+    BeginEdit(app, "Place module");
     for (int i = 0; i < mod->cell_count; i++) {
         Vector3 cellPos = Vector3Add(world_position, mod->cells[i].offset);
 
@@ -1217,6 +1906,7 @@ int PlaceModule(AppState *app, int module_index, Vector3 world_position, Vector3
         if (id >= 0)
             placed++;
     }
+    EndEdit(app);
 
     SetStatus(app, "Placed module '%s' (%d/%d cells)", mod->name, placed, mod->cell_count);
     return placed;
@@ -1271,12 +1961,8 @@ Vector3 ApplyGridSnap(AppState *app, Vector3 position) {
 
     // If mesh is loaded, project snapped position back onto surface
     if (app->mesh_loaded) {
-        // Cast ray downward from above the snapped position
-        Ray ray;
-        ray.position = (Vector3) {snapped.x, app->mesh_bounds.max.y + 1.0f, snapped.z};
-        ray.direction = (Vector3) {0, -1, 0};
-
-        RayCollision hit = GetRayCollisionMesh(ray, app->vehicle_mesh, app->vehicle_model.transform);
+        // Look straight down from above the snapped position
+        RayCollision hit = ProbeSurfaceBelow(app, snapped.x, snapped.z, NULL);
         if (hit.hit) {
             snapped.y = hit.point.y;
         }
@@ -1345,83 +2031,16 @@ void DrawSnapGrid(AppState *app) {
 //------------------------------------------------------------------------------
 // Simulation
 //------------------------------------------------------------------------------
-Vector3 CalculateSunDirection(SimSettings *s, float *out_alt, float *out_az) {
-    // Simplified solar position algorithm (NOAA method)
-    float lat = s->latitude * DEG2RAD;
-
-    // Clamp latitude to avoid edge cases at poles
-    lat = Clampf(lat, -89.0f * DEG2RAD, 89.0f * DEG2RAD);
-
-    // Day of year (approximate)
-    int doy = (s->month - 1) * 30 + s->day;
-    doy = (doy < 1) ? 1 : (doy > 365) ? 365 : doy;
-
-    // Fractional year (gamma) for equation of time and declination
-    float gamma = 2.0f * PI / 365.0f * (doy - 1);
-
-    // Equation of time (in minutes) - accounts for Earth's elliptical orbit
-    float eqtime = 229.18f * (0.000075f + 0.001868f * cosf(gamma) - 0.032077f * sinf(gamma) -
-                              0.014615f * cosf(2 * gamma) - 0.040849f * sinf(2 * gamma));
-
-    // Solar declination (in radians)
-    float decl = 0.006918f - 0.399912f * cosf(gamma) + 0.070257f * sinf(gamma) - 0.006758f * cosf(2 * gamma) +
-                 0.000907f * sinf(2 * gamma) - 0.002697f * cosf(3 * gamma) + 0.00148f * sinf(3 * gamma);
-
-    // Calculate timezone offset from longitude (approximate standard timezone)
-    // Each 15 degrees of longitude = 1 hour timezone difference
-    // This assumes standard time (not daylight saving)
-    float timezone_offset = roundf(s->longitude / 15.0f); // hours from UTC
-
-    // Convert local clock time to solar time
-    // Solar time = clock time + 4*(longitude - timezone*15) + equation_of_time
-    // The 4 is because Earth rotates 1 degree every 4 minutes
-    float longitude_correction = 4.0f * (s->longitude - timezone_offset * 15.0f); // minutes
-    float solar_time_minutes = s->hour * 60.0f + longitude_correction + eqtime;
-
-    // Hour angle: solar noon is 0 degrees, morning is negative, afternoon is positive
-    // At solar noon (12:00 solar time), hour angle = 0
-    float ha = (solar_time_minutes / 4.0f) - 180.0f; // degrees
-    float ha_rad = ha * DEG2RAD;
-
-    // Solar zenith angle calculation
-    float cos_zen = sinf(lat) * sinf(decl) + cosf(lat) * cosf(decl) * cosf(ha_rad);
-    cos_zen = Clampf(cos_zen, -1.0f, 1.0f);
-
-    float zenith = acosf(cos_zen);
-    float altitude = 90.0f - zenith * RAD2DEG;
-
-    // Azimuth calculation
-    float sin_zen = sinf(zenith);
-    float azimuth = 0.0f;
-
-    if (fabsf(sin_zen) > 0.001f) {
-        float cos_az = (sinf(decl) - sinf(lat) * cos_zen) / (cosf(lat) * sin_zen);
-        cos_az = Clampf(cos_az, -1.0f, 1.0f);
-        azimuth = acosf(cos_az) * RAD2DEG;
-        if (ha > 0)
-            azimuth = 360.0f - azimuth;
-    } else {
-        azimuth = 180.0f;
-    }
-
-    if (out_alt)
-        *out_alt = altitude;
-    if (out_az)
-        *out_az = azimuth;
-
-    // Return direction vector toward the sun
-    // If sun is below horizon, return downward vector
-    if (altitude <= 0) {
-        return (Vector3) {0, -1, 0};
-    }
-
-    float alt_rad = altitude * DEG2RAD;
-    float az_rad = azimuth * DEG2RAD;
-
-    Vector3 dir = {cosf(alt_rad) * sinf(az_rad), sinf(alt_rad), -cosf(alt_rad) * cosf(az_rad)};
+SimSite GetSimSite(const SimSettings *s) {
+    float utc_offset = s->auto_utc_offset ? roundf(s->longitude / 15.0f) : s->utc_offset;
+    return (SimSite) {s->latitude, s->longitude, s->year, s->month, s->day, utc_offset};
+}
 
-    return Vector3Normalize(dir);
+Vector3 CalculateSunDirection(SimSettings *s, float *out_alt, float *out_az) {
+    SimSite site = GetSimSite(s);
+    return SimCore_SunDirection(&site, s->hour, out_alt, out_az);
 }
+
 bool CheckCellShading(AppState *app, SolarCell *cell, Vector3 sun_dir) {
     if (!app->mesh_loaded)
         return false;
@@ -1435,10 +2054,11 @@ bool CheckCellShading(AppState *app, SolarCell *cell, Vector3 sun_dir) {
     ray.position = Vector3Add(worldPos, Vector3Scale(worldNormal, 0.01f));
     ray.direction = sun_dir;
 
-    // Check collision with mesh
-    RayCollision hit = GetRayCollisionMesh(ray, app->vehicle_mesh, app->vehicle_model.transform);
-
-    return hit.hit;
+    // Check collision with mesh, then the scenery
+    RayCollision hit = RaycastVehicle(app, ray, NULL);
+    if (hit.hit)
+        return true;
+    return app->obstacle_count > 0 && ObstacleScene_Occluded(&app->obstacle_scene, ray, 0.0f, FLT_MAX);
 }
 
 float CalculateCellPower(AppState *app, SolarCell *cell, Vector3 sun_dir, CellPreset *preset, float irradiance) {
@@ -1459,6 +2079,46 @@ float CalculateCellPower(AppState *app, SolarCell *cell, Vector3 sun_dir, CellPr
     return power;
 }
 
+// Strings that share an MPPT channel are held at the channel's combined MPP voltage
+// string_traces: each string's IV trace, indexed like app->strings; NULL when no channel is shared
+// string_power, string_current: string MPP on entry, operating point on its channel on exit
+// string_v_scale: operating voltage over string MPP voltage (1 on a dedicated tracker)
+void SolveMpptChannels(const AppState *app, const IVTrace *string_traces, float *string_power, float *string_current,
+                       float *string_v_scale) {
+    for (int s = 0; s < app->string_count; s++) {
+        string_v_scale[s] = 1.0f;
+    }
+    if (!string_traces)
+        return;
+
+    for (int ch = 1; ch <= MAX_MPPT_CHANNELS; ch++) {
+        const IVTrace *traces[MPPT_SIM_MAX_STRINGS];
+        int members[MPPT_SIM_MAX_STRINGS];
+        int n = 0;
+
+        for (int s = 0; s < app->string_count && n < MPPT_SIM_MAX_STRINGS; s++) {
+            if (app->strings[s].mppt_channel == ch && app->strings[s].cell_count > 0) {
+                traces[n] = &string_traces[s];
+                members[n] = s;
+                n++;
+            }
+        }
+        // A lone string already sits at its own MPP
+        if (n < 2) continue;
+
+        MpptChannelResult channel;
+        MpptSim_CombineParallel(traces, n, &channel);
+
+        for (int k = 0; k < n; k++) {
+            int s = members[k];
+            float vmp = string_traces[s].Vmp;
+            string_v_scale[s] = (vmp > 0) ? channel.voltage / vmp : 0.0f;
+            string_current[s] = channel.string_current[k];
+            string_power[s] = channel.voltage * channel.string_current[k];
+        }
+    }
+}
+
 void RunStaticSimulation(AppState *app) {
     if (app->cell_count == 0) {
         SetStatus(app, "No cells to simulate");
@@ -1522,6 +2182,7 @@ void RunStaticSimulation(AppState *app) {
     // String power with series constraints
     float total_string_power = 0;
     float total_unwired_power = 0;
+    IVTrace *string_traces = (IVTrace *) calloc(app->string_count > 0 ? app->string_count : 1, sizeof(IVTrace));
 
     for (int s = 0; s < app->string_count; s++) {
         CellString *str = &app->strings[s];
@@ -1658,7 +2319,40 @@ void RunStaticSimulation(AppState *app) {
         }
 
         str->power_ideal = string_cell_count * preset->vmp * preset->imp;
-        total_string_power += sim_result.power_out;
+        if (string_traces)
+            string_traces[s] = sim_result.iv_trace;
+    }
+
+    // Parallel strings on a shared MPPT channel move off their own MPP
+    if (string_traces) {
+        float string_power[MAX_STRINGS], string_current[MAX_STRINGS], string_v_scale[MAX_STRINGS];
+        for (int s = 0; s < app->string_count; s++) {
+            string_power[s] = app->strings[s].total_power;
+            string_current[s] = app->strings[s].string_current;
+        }
+        SolveMpptChannels(app, string_traces, string_power, string_current, string_v_scale);
+
+        for (int s = 0; s < app->string_count; s++) {
+            CellString *str = &app->strings[s];
+            if (str->mppt_channel > 0) {
+                // Cell voltages follow the string voltage; cell traces are not kept, so scale them
+                str->total_power = string_power[s];
+                str->string_current = string_current[s];
+                str->string_voltage *= string_v_scale[s];
+                for (int c = 0; c < app->cell_count; c++) {
+                    SolarCell *cell = &app->cells[c];
+                    if (cell->string_id != str->id) continue;
+                    cell->voltage_output *= string_v_scale[s];
+                    cell->power_output = string_current[s] * cell->voltage_output;
+                }
+            }
+        }
+        free(string_traces);
+    }
+
+    for (int s = 0; s < app->string_count; s++) {
+        if (app->strings[s].cell_count > 0)
+            total_string_power += app->strings[s].total_power;
     }
 
     // Add power from unwired cells (they contribute individually)
@@ -1691,6 +2385,199 @@ void RunStaticSimulation(AppState *app) {
                   app->sim_results.total_power, app->sim_results.shaded_percentage);
     }
 }
+// Per-sample recordings live in the temp directory; only the latest sweep is kept
+bool ShowTimeSeriesSample(AppState *app, int index) {
+    const TimeSeriesHeader *h = app->timeseries.header;
+    if (!h)
+        return false;
+    if ((int) h->cell_count != app->cell_count || (int) h->string_count != app->string_count) {
+        SetStatus(app, "Recorded sweep no longer matches the layout - rerun the daily simulation");
+        return false;
+    }
+
+    float cell_power[MAX_CELLS];
+    uint8_t cell_flags[MAX_CELLS];
+    float string_power[MAX_STRINGS];
+    TimeSeriesSampleHeader sample;
+    if (!TimeSeries_ReadSample(&app->timeseries, index, &sample, cell_power, cell_flags, string_power))
+        return false;
+
+    for (int c = 0; c < app->cell_count; c++) {
+        SolarCell *cell = &app->cells[c];
+        cell->power_output = cell_power[c];
+        cell->is_shaded = (cell_flags[c] & TIMESERIES_CELL_SHADED) != 0;
+        cell->is_bypassed = (cell_flags[c] & TIMESERIES_CELL_BYPASSED) != 0;
+    }
+    for (int s = 0; s < app->string_count; s++) {
+        app->strings[s].total_power = string_power[s];
+    }
+
+    app->sim_results.sun_direction = (Vector3) {sample.sun_dir[0], sample.sun_dir[1], sample.sun_dir[2]};
+    app->sim_results.sun_altitude = sample.sun_altitude;
+    app->sim_results.sun_azimuth = sample.sun_azimuth;
+    app->sim_results.is_daytime = !(sample.flags & TIMESERIES_SAMPLE_NIGHT);
+    app->sim_results.total_power = sample.total_power;
+    app->timeseries_sample = index;
+    return true;
+}
+
+bool LoadAttitudeRoute(AppState *app, const char *path) {
+    AttitudeSet route;
+    char error[128];
+    if (!Attitude_LoadCSV(&route, path, error, sizeof(error))) {
+        SetStatus(app, "Route attitude not loaded: %s", error);
+        return false;
+    }
+    app->attitude_route = route;
+    strncpy(app->attitude_path, path, MAX_PATH_LENGTH - 1);
+    app->attitude_path[MAX_PATH_LENGTH - 1] = '\0';
+    SetStatus(app, "Route attitude: %d samples in %d pitch/roll bins", route.route_samples, route.count);
+    return true;
+}
+
+void ClearAttitudeRoute(AppState *app) {
+    Attitude_Level(&app->attitude_route);
+    app->attitude_path[0] = '\0';
+}
+
+bool LoadArrayNetwork(AppState *app, const char *path) {
+    const CellPreset *preset = &CELL_PRESETS[app->selected_preset];
+    NetworkSim network = {0};
+    char error[128];
+    if (!NetworkSim_LoadNetlist(&network, path, preset->bypass_v_drop, error, sizeof(error))) {
+        SetStatus(app, "Array network not loaded: %s", error);
+        return false;
+    }
+
+    // Cells are matched by id when the sweep runs; report the ones the layout does not have now
+    int missing = 0;
+    for (int e = 0; e < network.element_count; e++) {
+        if (network.elements[e].type != NETWORK_SIM_CELL)
+            continue;
+        bool found = false;
+        for (int c = 0; c < app->cell_count && !found; c++) {
+            found = app->cells[c].id == network.elements[e].cell_id;
+        }
+        missing += !found;
+    }
+
+    NetworkSim_Free(&app->network);
+    app->network = network;
+    strncpy(app->network_path, path, MAX_PATH_LENGTH - 1);
+    app->network_path[MAX_PATH_LENGTH - 1] = '\0';
+    if (missing > 0)
+        SetStatus(app, "Array network: %d cells, %d nodes (%d cell ids not in the layout)", network.cell_count,
+                  network.node_count, missing);
+    else
+        SetStatus(app, "Array network: %d cells, %d nodes", network.cell_count, network.node_count);
+    return true;
+}
+
+void ClearArrayNetwork(AppState *app) {
+    NetworkSim_Free(&app->network);
+    app->network_path[0] = '\0';
+}
+
+// Forward axis of the vehicle: along the longer horizontal side of the mesh bounds
+static Vector3 GetVehicleForward(const AppState *app) {
+    Vector3 size = Vector3Subtract(app->mesh_bounds.max, app->mesh_bounds.min);
+    return size.x > size.z ? (Vector3) {1, 0, 0} : (Vector3) {0, 0, 1};
+}
+
+static bool ShowSweepTraceProgress(AppState *app, int dir_count, int progress) {
+    PollInputEvents();
+    if (WindowShouldClose() || IsKeyDown(KEY_ESCAPE))
+        return false;
+
+    BeginDrawing();
+    ClearBackground(BLACK);
+    AppDraw(app);
+
+    int cx = app->screen_width / 2;
+    int cy = app->screen_height / 2 - 200;
+    DrawRectangle(0, 0, app->screen_width, app->screen_height, (Color) {0, 0, 0, 100});
+
+    DrawRectangle(cx - 175, cy - 45, 350, 90, (Color) {30, 30, 30, 245});
+    DrawRectangleLines(cx - 175, cy - 45, 350, 90, WHITE);
+
+    DrawText("Time Sim (esc to cancel)", cx - 70, cy - 35, 20, WHITE);
+    DrawText(TextFormat("Tracing %d attitude directions", dir_count), cx - 140, cy - 8, 16, LIGHTGRAY);
+
+    int barY = cy + 15;
+    DrawRectangle(cx - 150, barY, 300, 18, DARKGRAY);
+    DrawRectangle(cx - 150, barY, (300 * progress) / 100, 18, GREEN);
+    DrawRectangleLines(cx - 150, barY, 300, 18, WHITE);
+    DrawText(TextFormat("%d%%", progress), cx - 12, barY + 2, 14, WHITE);
+
+    EndDrawing();
+    return true;
+}
+
+// Cell visibility for every vehicle-frame direction bin the sweep's (time, heading, attitude) suns fall in.
+// dir_index (SIM_CORE_DIR_ALT_BINS * SIM_CORE_SKY_AZ_BINS slots) maps a bin to its column of *out_visible.
+// Returns the traced direction count, or -1 if out of memory or cancelled (status set).
+static int TraceAttitudeVisibility(AppState *app, const SimGeometry *geometry, const SimLayout *layout,
+                                   const Vector3 *sun_dirs, const float *sun_altitudes, int time_samples,
+                                   int heading_samples, const AttitudeSet *attitudes, bool draft, int *dir_index,
+                                   uint8_t **out_visible) {
+    const int dir_slots = SIM_CORE_DIR_ALT_BINS * SIM_CORE_SKY_AZ_BINS;
+    Vector3 forward = GetVehicleForward(app);
+    Vector3 *dir_sums = (Vector3 *) calloc(dir_slots, sizeof(Vector3));
+    if (!dir_sums) {
+        SetStatus(app, "Not enough memory for the attitude visibility cache");
+        return -1;
+    }
+
+    for (int ti = 0; ti < time_samples; ti++) {
+        if (sun_altitudes[ti] <= 0)
+            continue;
+        for (int hi = 0; hi < heading_samples; hi++) {
+            Vector3 level = SimCore_RotateToHeading(sun_dirs[ti], hi * 360.0f / heading_samples);
+            for (int a = 0; a < attitudes->count; a++) {
+                const AttitudeState *state = &attitudes->states[a];
+                Vector3 dir = SimCore_RotateToAttitude(level, forward, state->pitch_deg, state->roll_deg);
+                int slot = SimCore_DirectionSlot(dir);
+                dir_sums[slot] = Vector3Add(dir_sums[slot], dir);
+            }
+        }
+    }
+
+    // Compact to the occupied bins, each traced along its mean direction
+    int dir_count = 0;
+    for (int d = 0; d < dir_slots; d++) {
+        dir_index[d] = Vector3LengthSqr(dir_sums[d]) > 0.0f ? dir_count++ : -1;
+    }
+    Vector3 *dirs = (Vector3 *) malloc((dir_count ? dir_count : 1) * sizeof(Vector3));
+    uint8_t *visible = (uint8_t *) malloc((size_t) layout->cell_count * (dir_count ? dir_count : 1));
+    if (!dirs || !visible) {
+        free(dir_sums);
+        free(dirs);
+        free(visible);
+        SetStatus(app, "Not enough memory for the attitude visibility cache");
+        return -1;
+    }
+    for (int d = 0; d < dir_slots; d++) {
+        if (dir_index[d] >= 0)
+            dirs[dir_index[d]] = Vector3Normalize(dir_sums[d]);
+    }
+    free(dir_sums);
+
+    for (int d = 0; d < dir_count; d += SWEEP_VISIBILITY_CHUNK) {
+        if (!ShowSweepTraceProgress(app, dir_count, d * 100 / dir_count)) {
+            free(dirs);
+            free(visible);
+            SetStatus(app, "Simulation cancelled");
+            return -1;
+        }
+        int end = d + SWEEP_VISIBILITY_CHUNK < dir_count ? d + SWEEP_VISIBILITY_CHUNK : dir_count;
+        SimCore_CellVisibility(geometry, layout, dirs, d, end, dir_count, draft, visible);
+    }
+
+    free(dirs);
+    *out_visible = visible;
+    return dir_count;
+}
+
 void RunTimeSimulationAnimated(AppState *app) {
     if (app->cell_count == 0 || !app->mesh_loaded) {
         SetStatus(app, "No cells or mesh to simulate");
@@ -1714,33 +2601,192 @@ void RunTimeSimulationAnimated(AppState *app) {
 
     float total_energy = 0.0f;
     float peak_power = 0.0f;
-    int total_samples = 0;
-    int shaded_samples = 0;
+    float total_samples = 0.0f;
+    float shaded_samples = 0.0f;
 
     // Clear hourly data
     for (int h = 0; h < 24; h++) {
         app->time_sim_results.energy_by_hour[h] = 0;
     }
 
-    int step = 0;
-    int total_steps = TIME_SAMPLES * HEADING_SAMPLES;
+    // Cell -> string slot lookup, per-sample cell operating voltages, and the world-space layout the core shades
+    int *cell_string_slot = (int *) malloc(app->cell_count * sizeof(int));
+    float *cell_op_voltage = (float *) calloc(app->cell_count, sizeof(float));
+    Vector3 *cell_positions = (Vector3 *) malloc(app->cell_count * sizeof(Vector3));
+    Vector3 *cell_normals = (Vector3 *) malloc(app->cell_count * sizeof(Vector3));
+    float *cell_facing = (float *) malloc(app->cell_count * sizeof(float));
+    float *cell_sample_power = (float *) malloc(app->cell_count * sizeof(float));
+    float *cell_irradiance_ratio = (float *) malloc(app->cell_count * sizeof(float));
+    float *cell_check = (float *) malloc(2 * app->cell_count * sizeof(float)); // Draft and full incident cosines
+    Vector3 *sun_dirs = (Vector3 *) malloc(TIME_SAMPLES * sizeof(Vector3));
+    float *sun_hours = (float *) malloc(TIME_SAMPLES * 3 * sizeof(float));
+    if (!cell_string_slot || !cell_op_voltage || !cell_positions || !cell_normals || !cell_facing ||
+        !cell_sample_power || !cell_irradiance_ratio || !cell_check || !sun_dirs || !sun_hours) {
+        free(cell_energy);
+        free(string_energy);
+        free(cell_string_slot);
+        free(cell_op_voltage);
+        free(cell_positions);
+        free(cell_normals);
+        free(cell_facing);
+        free(cell_sample_power);
+        free(cell_irradiance_ratio);
+        free(cell_check);
+        free(sun_dirs);
+        free(sun_hours);
+        return;
+    }
+    for (int c = 0; c < app->cell_count; c++) {
+        cell_positions[c] = CellGetWorldPosition(app, &app->cells[c]);
+        cell_normals[c] = CellGetWorldNormal(app, &app->cells[c]);
+    }
+    SimLayout layout = {app->cell_count, cell_positions, cell_normals};
 
-    // Main simulation loop: TIME x HEADING
+    // The day's sun path in one batch
+    SimSite site = GetSimSite(&app->sim_settings);
+    float *sun_altitudes = sun_hours + TIME_SAMPLES;
+    float *sun_azimuths = sun_altitudes + TIME_SAMPLES;
     for (int ti = 0; ti < TIME_SAMPLES; ti++) {
-        float hour = START_HOUR + (DURATION * ti / (float) (TIME_SAMPLES - 1));
+        sun_hours[ti] = START_HOUR + (DURATION * ti / (float) (TIME_SAMPLES - 1));
+    }
+    SimCore_SunDirections(&site, sun_hours, TIME_SAMPLES, sun_dirs, sun_altitudes, sun_azimuths);
+
+    // Draft mode shades against the simplified proxy and keeps a sampled comparison with the full mesh
+    bool draft = app->sim_settings.draft_shading && EnsureDraftOccluder(app);
+    SimGeometry geometry = GetSimGeometry(app);
+    float check_incident_draft = 0.0f, check_incident_full = 0.0f;
+    int draft_check_samples = 0;
+
+    // Pitch and roll come from the route histogram if one is loaded, else from the spread settings. A tilted
+    // distribution looks each sample's shading up from cell visibility traced once per vehicle-frame direction
+    // bin, so the extra dimension costs lookups and string evaluations rather than rays.
+    AttitudeSet attitudes;
+    if (app->attitude_route.route_samples > 0)
+        attitudes = app->attitude_route;
+    else
+        Attitude_FromSpread(&attitudes, app->sim_settings.pitch_spread_deg, app->sim_settings.roll_spread_deg);
+    bool tilted = !Attitude_IsLevel(&attitudes);
+    Vector3 forward = GetVehicleForward(app);
+    // The most likely attitude goes last, so the cell states each sample leaves behind are its own
+    int likely = 0;
+    for (int a = 1; a < attitudes.count; a++) {
+        if (attitudes.states[a].weight > attitudes.states[likely].weight)
+            likely = a;
+    }
+    AttitudeState swap = attitudes.states[likely];
+    attitudes.states[likely] = attitudes.states[attitudes.count - 1];
+    attitudes.states[attitudes.count - 1] = swap;
+
+    int attitude_dir_index[SIM_CORE_DIR_ALT_BINS * SIM_CORE_SKY_AZ_BINS];
+    uint8_t *attitude_visible = NULL;
+    int attitude_dirs = 0;
+    if (tilted) {
+        attitude_dirs = TraceAttitudeVisibility(app, &geometry, &layout, sun_dirs, sun_altitudes, TIME_SAMPLES,
+                                                HEADING_SAMPLES, &attitudes, draft, attitude_dir_index,
+                                                &attitude_visible);
+        if (attitude_dirs < 0) {
+            free(cell_energy);
+            free(string_energy);
+            free(cell_string_slot);
+            free(cell_op_voltage);
+            free(cell_positions);
+            free(cell_normals);
+            free(cell_facing);
+            free(cell_sample_power);
+            free(cell_irradiance_ratio);
+            free(cell_check);
+            free(sun_dirs);
+            free(sun_hours);
+            return;
+        }
+    }
+    SimCellModel cell_model = {preset->voc, preset->isc, preset->n_ideal, preset->series_r, preset->bypass_v_drop};
 
-        // Calculate sun direction once per time step
-        app->sim_settings.hour = hour;
-        float altitude, azimuth;
-        Vector3 sun_dir = CalculateSunDirection(&app->sim_settings, &altitude, &azimuth);
+    // A loaded array network replaces the strings. Its cells are matched to the layout by id and its matrix is
+    // ordered and symbolically factorised once here; each sample then only refactors numerically.
+    int *cell_network_element = (int *) malloc(app->cell_count * sizeof(int));
+    bool use_network = false;
+    int network_cells = 0, network_solves = 0, network_steps = 0, network_failures = 0;
+    if (cell_network_element) {
+        for (int c = 0; c < app->cell_count; c++) {
+            cell_network_element[c] = -1;
+        }
+        NetworkSimCellModel network_model = {preset->voc, preset->isc, preset->n_ideal, preset->series_r};
+        if (app->network.element_count > 0 && NetworkSim_Build(&app->network, &network_model)) {
+            use_network = true;
+            for (int e = 0; e < app->network.element_count; e++) {
+                if (app->network.elements[e].type != NETWORK_SIM_CELL)
+                    continue;
+                NetworkSim_SetCellIrradiance(&app->network, e, 0.0f);
+                for (int c = 0; c < app->cell_count; c++) {
+                    if (app->cells[c].id == app->network.elements[e].cell_id && cell_network_element[c] < 0) {
+                        cell_network_element[c] = e;
+                        network_cells++;
+                        break;
+                    }
+                }
+            }
+        } else if (app->network.element_count > 0) {
+            TraceLog(LOG_WARNING, "Array network could not be built, simulating strings");
+        }
+    }
 
-        float effective_irradiance = 0.0f;
-        if (altitude > 0.0f) {
-            float sin_alt = sinf(altitude * DEG2RAD);
-            float air_mass = 1.0f / fmaxf(sin_alt, 0.01f);
-            float atmospheric_factor = powf(0.7f, powf(air_mass, 0.678f));
-            effective_irradiance = app->sim_settings.irradiance * atmospheric_factor;
+    bool has_shared_channel = false;
+    for (int c = 0; c < app->cell_count; c++) {
+        cell_string_slot[c] = -1;
+        for (int s = 0; s < app->string_count && !use_network; s++) {
+            if (app->strings[s].id == app->cells[c].string_id && app->strings[s].cell_count > 0) {
+                cell_string_slot[c] = s;
+                if (app->strings[s].mppt_channel > 0)
+                    has_shared_channel = true;
+                break;
+            }
         }
+    }
+    // String traces are only kept when strings share a channel
+    IVTrace *channel_traces =
+            has_shared_channel ? (IVTrace *) calloc(app->string_count, sizeof(IVTrace)) : NULL;
+
+    // String results are memoised per sweep (wiring and bypass flags are fixed for its duration)
+    StringSimCache cache;
+    bool use_cache = app->sim_settings.iv_cache_step > 0.0f &&
+                     StringSimCache_Init(&cache, STRING_CACHE_DEFAULT_CAPACITY, app->sim_settings.iv_cache_step);
+
+    // Per-sample results are streamed to disk for the timeline scrubber
+    TimeSeries_Unmap(&app->timeseries);
+    char ts_path[MAX_PATH_LENGTH];
+    GetTimeSeriesPath(ts_path, sizeof(ts_path));
+    TimeSeriesWriter ts_writer = {0};
+    uint8_t *sample_cell_flags = NULL;
+    bool recording = false;
+    if (app->sim_settings.record_timeseries) {
+        float power_scale = fmaxf(preset->voc, preset->bypass_v_drop) * preset->isc * 2.0f / 32767.0f;
+        sample_cell_flags = (uint8_t *) malloc(app->cell_count);
+        recording = sample_cell_flags &&
+                    TimeSeries_Open(&ts_writer, ts_path, app->cell_count, app->string_count, TIME_SAMPLES,
+                                    HEADING_SAMPLES, START_HOUR, dt_hours, heading_step, power_scale);
+        if (!recording)
+            TraceLog(LOG_WARNING, "Could not record time series to %s", ts_path);
+    }
+
+    // Optional per-(time, heading, string) export, written by a background thread
+    ExportStream *export_stream = NULL;
+    if (app->export_path[0] != '\0') {
+        export_stream = ExportStream_Open(app->export_path, EXPORT_LAYOUT_DAILY);
+        if (!export_stream)
+            TraceLog(LOG_WARNING, "Could not open export file %s", app->export_path);
+    }
+
+    int step = 0;
+    int total_steps = TIME_SAMPLES * HEADING_SAMPLES;
+
+    // Main simulation loop: TIME x HEADING
+    for (int ti = 0; ti < TIME_SAMPLES; ti++) {
+        float hour = sun_hours[ti];
+        float altitude = sun_altitudes[ti];
+        float azimuth = sun_azimuths[ti];
+        Vector3 sun_dir = sun_dirs[ti];
+        float effective_irradiance = SimCore_EffectiveIrradiance(app->sim_settings.irradiance, altitude);
         // Store for visualization
         app->sim_results.sun_altitude = altitude;
         app->sim_results.sun_azimuth = azimuth;
@@ -1748,6 +2794,13 @@ void RunTimeSimulationAnimated(AppState *app) {
 
         // Skip night time
         if (altitude <= 0) {
+            if (recording) {
+                for (int hi = 0; hi < HEADING_SAMPLES; hi++) {
+                    TimeSeriesSampleHeader sample = {hour, hi * heading_step, {sun_dir.x, sun_dir.y, sun_dir.z},
+                                                     altitude, azimuth, 0.0f, TIMESERIES_SAMPLE_NIGHT, 0};
+                    TimeSeries_WriteSample(&ts_writer, &sample, NULL, NULL, NULL);
+                }
+            }
             step += HEADING_SAMPLES;
             continue;
         }
@@ -1762,7 +2815,6 @@ void RunTimeSimulationAnimated(AppState *app) {
         // Inner loop: HEADING (vehicle rotation)
         for (int hi = 0; hi < HEADING_SAMPLES; hi++) {
             float heading_deg = hi * heading_step;
-            float heading_rad = heading_deg * DEG2RAD;
 
             // Check for cancel
             PollInputEvents();
@@ -1771,110 +2823,239 @@ void RunTimeSimulationAnimated(AppState *app) {
                 free(cell_power_this_timestep);
                 if (string_energy)
                     free(string_energy);
+                if (use_cache)
+                    StringSimCache_Free(&cache);
+                free(cell_string_slot);
+                free(cell_network_element);
+                free(cell_op_voltage);
+                free(cell_positions);
+                free(cell_normals);
+                free(cell_facing);
+                free(cell_sample_power);
+                free(cell_irradiance_ratio);
+                free(cell_check);
+                free(sun_dirs);
+                free(sun_hours);
+                free(attitude_visible);
+                free(channel_traces);
+                if (recording)
+                    TimeSeries_Close(&ts_writer);
+                free(sample_cell_flags);
+                ExportStream_Close(export_stream, NULL);
                 SetStatus(app, "Simulation cancelled");
                 return;
             }
 
             // Rotate sun direction relative to vehicle heading
-            Vector3 rotated_sun = {sun_dir.x * cosf(-heading_rad) - sun_dir.z * sinf(-heading_rad), sun_dir.y,
-                                   sun_dir.x * sinf(-heading_rad) + sun_dir.z * cosf(-heading_rad)};
+            Vector3 rotated_sun = SimCore_RotateToHeading(sun_dir, heading_deg);
 
             // Set for visualization
             app->sim_results.sun_direction = rotated_sun;
 
+            // Attitude-weighted results of this sample (a single level attitude of weight 1 unless tilted)
             float instant_power = 0.0f;
-
-            // First pass: determine shading and irradiance for each cell
-            float *cell_irradiance_ratio = (float *)calloc(app->cell_count, sizeof(float));
+            float string_power[MAX_STRINGS] = {0};
+            float string_current[MAX_STRINGS] = {0};
+            float network_power = 0.0f, network_current = 0.0f;
             for (int c = 0; c < app->cell_count; c++) {
-                SolarCell *cell = &app->cells[c];
-                Vector3 pos = CellGetWorldPosition(app, cell);
-                Vector3 norm = CellGetWorldNormal(app, cell);
-
-                total_samples++;
-                float facing = Vector3DotProduct(norm, rotated_sun);
-
-                if (facing <= 0) {
-                    shaded_samples++;
-                    cell->is_shaded = true;
-                    cell->current_output = 0;
-                    cell_irradiance_ratio[c] = 0;
-                    continue;
-                }
+                cell_sample_power[c] = 0.0f;
+            }
 
-                // Occlusion check
-                Ray ray = {Vector3Add(pos, Vector3Scale(norm, 0.01f)), rotated_sun};
-                RayCollision hit = GetRayCollisionMesh(ray, app->vehicle_mesh, app->vehicle_model.transform);
+            bool draft_check = draft && !tilted && step % DRAFT_CHECK_STRIDE == 0;
+            draft_check_samples += draft_check;
+
+            for (int ai = 0; ai < attitudes.count; ai++) {
+                const AttitudeState *attitude = &attitudes.states[ai];
+                float attitude_power = 0.0f;
+
+                // First pass: determine shading and irradiance for each cell, spread over the job threads
+                if (tilted) {
+                    Vector3 dir =
+                            SimCore_RotateToAttitude(rotated_sun, forward, attitude->pitch_deg, attitude->roll_deg);
+                    const uint8_t *column = attitude_visible + attitude_dir_index[SimCore_DirectionSlot(dir)];
+                    for (int c = 0; c < app->cell_count; c++) {
+                        float facing = Vector3DotProduct(cell_normals[c], dir);
+                        cell_facing[c] = (column[(size_t) c * attitude_dirs] && facing > 0.0f) ? facing : 0.0f;
+                    }
+                } else {
+                    SimCore_ShadeCells(&geometry, &layout, rotated_sun, draft, cell_facing,
+                                       draft_check ? cell_check : NULL);
+                }
 
-                if (hit.hit && hit.distance > 0.02f) {
-                    shaded_samples++;
-                    cell->is_shaded = true;
-                    cell->current_output = 0;
-                    cell_irradiance_ratio[c] = 0;
-                    continue;
+                total_samples += attitude->weight * app->cell_count;
+                for (int c = 0; c < app->cell_count; c++) {
+                    SolarCell *cell = &app->cells[c];
+                    cell->is_shaded = cell_facing[c] <= 0.0f;
+                    cell_irradiance_ratio[c] = effective_irradiance / 1000.0f * cell_facing[c];
+                    cell->current_output = preset->isc * cell_irradiance_ratio[c];
+                    shaded_samples += attitude->weight * cell->is_shaded;
+                    if (draft_check) {
+                        check_incident_draft += cell_check[2 * c];
+                        check_incident_full += cell_check[2 * c + 1];
+                    }
                 }
 
-                cell->is_shaded = false;
-                cell_irradiance_ratio[c] = (effective_irradiance / 1000.0f) * facing;
-                cell->current_output = preset->isc * cell_irradiance_ratio[c];
-            }
+                // Second pass: calculate string power using IV trace model
+                float attitude_string_power[MAX_STRINGS] = {0};
+                float attitude_string_current[MAX_STRINGS] = {0};
+                float string_v_scale[MAX_STRINGS];
 
-            // Second pass: calculate string power using IV trace model
-            for (int s = 0; s < app->string_count; s++) {
-                CellString *str = &app->strings[s];
-                if (str->cell_count == 0) continue;
-
-                // Create IV traces for each cell in the string
-                IVTrace cell_traces[MAX_CELLS_PER_STRING];
-                bool has_bypass[MAX_CELLS_PER_STRING];
-                int cell_indices[MAX_CELLS_PER_STRING];
-                int string_cell_count = 0;
-
-                for (int c = 0; c < app->cell_count && string_cell_count < str->cell_count; c++) {
-                    if (app->cells[c].string_id == str->id) {
-                        IVTrace_CreateCellTrace(&cell_traces[string_cell_count],
-                                                preset->voc, preset->isc, preset->n_ideal,
-                                                preset->series_r, cell_irradiance_ratio[c]);
-                        has_bypass[string_cell_count] = app->cells[c].has_bypass_diode;
-                        cell_indices[string_cell_count] = c;
-                        string_cell_count++;
+                for (int s = 0; s < app->string_count; s++) {
+                    CellString *str = &app->strings[s];
+                    if (str->cell_count == 0 || use_network) continue;
+
+                    float ratios[MAX_CELLS_PER_STRING];
+                    bool has_bypass[MAX_CELLS_PER_STRING];
+                    int cell_indices[MAX_CELLS_PER_STRING];
+                    int string_cell_count = 0;
+
+                    for (int c = 0; c < app->cell_count && string_cell_count < str->cell_count; c++) {
+                        if (app->cells[c].string_id == str->id) {
+                            ratios[string_cell_count] = cell_irradiance_ratio[c];
+                            has_bypass[string_cell_count] = app->cells[c].has_bypass_diode;
+                            cell_indices[string_cell_count] = c;
+                            string_cell_count++;
+                        }
+                    }
+
+                    // Identical quantised shading patterns reuse the memoised result
+                    uint16_t codes[MAX_CELLS_PER_STRING];
+                    uint32_t key = 0;
+                    const StringSimCacheEntry *cached = NULL;
+                    if (use_cache) {
+                        key = StringSimCache_Quantise(&cache, ratios, string_cell_count, codes, ratios);
+                        cached = StringSimCache_Find(&cache, s, codes, string_cell_count, key);
+                    }
+
+                    float cell_voltage[MAX_CELLS_PER_STRING];
+
+                    if (cached) {
+                        attitude_string_power[s] = cached->result.power_out;
+                        attitude_string_current[s] = cached->result.current;
+                        memcpy(cell_voltage, cached->cell_voltage, string_cell_count * sizeof(float));
+                        if (channel_traces && str->mppt_channel > 0)
+                            channel_traces[s] = cached->result.iv_trace;
+                    } else {
+                        StringSimResult sim_result;
+                        SimCore_EvaluateString(&cell_model, ratios, has_bypass, string_cell_count, &sim_result,
+                                               cell_voltage);
+
+                        attitude_string_power[s] = sim_result.power_out;
+                        attitude_string_current[s] = sim_result.current;
+                        if (channel_traces && str->mppt_channel > 0)
+                            channel_traces[s] = sim_result.iv_trace;
+
+                        if (use_cache) {
+                            StringSimCacheEntry *entry =
+                                    StringSimCache_Insert(&cache, s, codes, string_cell_count, key);
+                            if (entry) {
+                                entry->result = sim_result;
+                                memcpy(entry->cell_voltage, cell_voltage, string_cell_count * sizeof(float));
+                            }
+                        }
+                    }
+
+                    for (int i = 0; i < string_cell_count; i++) {
+                        cell_op_voltage[cell_indices[i]] = cell_voltage[i];
                     }
                 }
 
-                // Calculate string IV and find MPP
-                StringSimResult sim_result;
-                StringSim_CalcStringIV(cell_traces, string_cell_count,
-                                       preset->bypass_v_drop, has_bypass, &sim_result);
+                SolveMpptChannels(app, channel_traces, attitude_string_power, attitude_string_current, string_v_scale);
 
-                instant_power += sim_result.power_out;
+                for (int s = 0; s < app->string_count; s++) {
+                    attitude_power += attitude_string_power[s];
+                    string_power[s] += attitude->weight * attitude_string_power[s];
+                    string_current[s] += attitude->weight * attitude_string_current[s];
+                }
 
                 // Update cell power outputs based on string operating point
-                for (int i = 0; i < string_cell_count; i++) {
-                    int c = cell_indices[i];
-                    if (sim_result.current >= cell_traces[i].Isc && has_bypass[i]) {
-                        app->cells[c].power_output = sim_result.current * (-preset->bypass_v_drop);
-                    } else {
-                        float v = IVTrace_InterpV(&cell_traces[i], sim_result.current);
-                        app->cells[c].power_output = sim_result.current * v;
+                for (int c = 0; c < app->cell_count; c++) {
+                    int s = cell_string_slot[c];
+                    if (s < 0) continue;
+                    app->cells[c].power_output =
+                            attitude_string_current[s] * cell_op_voltage[c] * string_v_scale[s];
+                    cell_sample_power[c] += attitude->weight * app->cells[c].power_output;
+                }
+
+                // Network: the whole array at its port MPP, warm-started from the previous sample
+                if (use_network) {
+                    for (int c = 0; c < app->cell_count; c++) {
+                        if (cell_network_element[c] >= 0)
+                            NetworkSim_SetCellIrradiance(&app->network, cell_network_element[c],
+                                                         cell_irradiance_ratio[c]);
+                    }
+                    NetworkSimResult network_result;
+                    network_failures += !NetworkSim_SolveMpp(&app->network, &network_result);
+                    network_steps += network_result.newton_steps;
+                    network_solves++;
+                    attitude_power += network_result.power;
+                    network_power += attitude->weight * network_result.power;
+                    network_current += attitude->weight * network_result.current;
+                    for (int c = 0; c < app->cell_count; c++) {
+                        if (cell_network_element[c] < 0) continue;
+                        float cell_current;
+                        NetworkSim_CellOperatingPoint(&app->network, cell_network_element[c], &cell_op_voltage[c],
+                                                      &cell_current);
+                        app->cells[c].power_output = cell_op_voltage[c] * cell_current;
+                        cell_sample_power[c] += attitude->weight * app->cells[c].power_output;
                     }
-                    cell_power_this_timestep[c] += app->cells[c].power_output;
                 }
+
+                // Third pass: unwired cells use simple calculation
+                for (int c = 0; c < app->cell_count; c++) {
+                    bool wired = use_network ? cell_network_element[c] >= 0 : app->cells[c].string_id >= 0;
+                    if (!wired && !app->cells[c].is_shaded) {
+                        float area = preset->width * preset->height;
+                        // Simplified: power = irradiance * area * cos(angle) * efficiency
+                        float power_w = cell_irradiance_ratio[c] * 1000.0f * area * preset->efficiency;
+                        attitude_power += power_w;
+                        cell_sample_power[c] += attitude->weight * power_w;
+                    }
+                }
+                instant_power += attitude->weight * attitude_power;
             }
 
-            // Third pass: unwired cells use simple calculation
+            // Shading and bypass states are left by the last (most likely) attitude; power is the weighted mean
             for (int c = 0; c < app->cell_count; c++) {
-                if (app->cells[c].string_id < 0 && !app->cells[c].is_shaded) {
-                    float area = preset->width * preset->height;
-                    float power_w = effective_irradiance * area * cell_irradiance_ratio[c] * preset->efficiency / (effective_irradiance / 1000.0f);
-                    // Simplified: power = irradiance * area * cos(angle) * efficiency
-                    power_w = cell_irradiance_ratio[c] * 1000.0f * area * preset->efficiency;
-                    instant_power += power_w;
-                    app->cells[c].power_output = power_w;
-                    cell_power_this_timestep[c] += power_w;
+                app->cells[c].power_output = cell_sample_power[c];
+                cell_power_this_timestep[c] += cell_sample_power[c];
+            }
+
+            if (recording) {
+                for (int c = 0; c < app->cell_count; c++) {
+                    bool wired = cell_string_slot[c] >= 0 || cell_network_element[c] >= 0;
+                    sample_cell_flags[c] = (app->cells[c].is_shaded ? TIMESERIES_CELL_SHADED : 0) |
+                                           ((wired && cell_op_voltage[c] < 0) ? TIMESERIES_CELL_BYPASSED : 0);
+                }
+                TimeSeriesSampleHeader sample = {hour, heading_deg, {rotated_sun.x, rotated_sun.y, rotated_sun.z},
+                                                 altitude, azimuth, instant_power, 0, 0};
+                if (!TimeSeries_WriteSample(&ts_writer, &sample, cell_sample_power, sample_cell_flags,
+                                            string_power)) {
+                    TraceLog(LOG_WARNING, "Time series write failed, recording stopped");
+                    TimeSeries_Close(&ts_writer);
+                    recording = false;
                 }
             }
 
-            free(cell_irradiance_ratio);
+            if (export_stream) {
+                float unwired_power = instant_power;
+                for (int s = 0; s < app->string_count; s++) {
+                    if (app->strings[s].cell_count == 0) continue;
+                    ExportRecord rec = {.hour = hour, .heading_deg = heading_deg, .string_id = app->strings[s].id,
+                                        .power_w = string_power[s], .current_a = string_current[s]};
+                    ExportStream_Push(export_stream, &rec);
+                    unwired_power -= string_power[s];
+                }
+                if (use_network) {
+                    ExportRecord network_rec = {.hour = hour, .heading_deg = heading_deg, .string_id = -2,
+                                                .power_w = network_power, .current_a = network_current};
+                    ExportStream_Push(export_stream, &network_rec);
+                    unwired_power -= network_power;
+                }
+                ExportRecord rec = {.hour = hour, .heading_deg = heading_deg, .string_id = -1,
+                                    .power_w = unwired_power};
+                ExportStream_Push(export_stream, &rec);
+            }
 
             // Track peak instantaneous power
             if (instant_power > peak_power) {
@@ -1938,7 +3119,7 @@ void RunTimeSimulationAnimated(AppState *app) {
 
             // Add to string energy
             SolarCell *cell = &app->cells[c];
-            if (cell->string_id >= 0 && string_energy) {
+            if (cell->string_id >= 0 && string_energy && !use_network) {
                 for (int s = 0; s < app->string_count; s++) {
                     if (app->strings[s].id == cell->string_id) {
                         string_energy[s] += cell_energy_step;
@@ -1974,6 +3155,23 @@ void RunTimeSimulationAnimated(AppState *app) {
     app->time_sim_results.peak_power_w = peak_power;
     app->time_sim_results.average_shaded_pct = (total_samples > 0) ? (100.0f * shaded_samples / total_samples) : 0.0f;
 
+    app->time_sim_results.cache_hits = use_cache ? cache.hits : 0;
+    app->time_sim_results.cache_misses = use_cache ? cache.misses : 0;
+    app->time_sim_results.cache_hit_rate = use_cache ? StringSimCache_HitRate(&cache) : 0.0f;
+
+    app->time_sim_results.draft = draft;
+    app->time_sim_results.draft_check_samples = draft_check_samples;
+    app->time_sim_results.attitude_count = attitudes.count;
+    app->time_sim_results.attitude_dirs = attitude_dirs;
+    app->time_sim_results.network = use_network;
+    app->time_sim_results.network_cells = network_cells;
+    app->time_sim_results.network_newton_steps = network_solves > 0 ? (float) network_steps / network_solves : 0.0f;
+    app->time_sim_results.network_failures = network_failures;
+    app->time_sim_results.draft_discrepancy_pct =
+            (check_incident_full > 0.0f)
+                    ? 100.0f * (check_incident_draft - check_incident_full) / check_incident_full
+                    : 0.0f;
+
     app->sim_results.total_power = app->time_sim_results.average_power_w;
     app->sim_results.shaded_percentage = app->time_sim_results.average_shaded_pct;
 
@@ -1984,11 +3182,10 @@ void RunTimeSimulationAnimated(AppState *app) {
             app->sim_results.shaded_count++;
     }
 
-    // Reset sun to noon for final view
-    app->sim_settings.hour = 12.0f;
+    // Final view shows the sun at the hour the user picked; the sweep never touches the settings
     app->sim_results.sun_direction =
             CalculateSunDirection(&app->sim_settings, &app->sim_results.sun_altitude, &app->sim_results.sun_azimuth);
-    app->sim_results.is_daytime = true;
+    app->sim_results.is_daytime = app->sim_results.sun_altitude > 0;
 
     app->sim_run = true;
     app->time_sim_run = true;
@@ -1996,6 +3193,40 @@ void RunTimeSimulationAnimated(AppState *app) {
     free(cell_energy);
     if (string_energy)
         free(string_energy);
+    if (use_cache)
+        StringSimCache_Free(&cache);
+    free(cell_string_slot);
+    free(cell_network_element);
+    free(cell_op_voltage);
+    free(cell_positions);
+    free(cell_normals);
+    free(cell_facing);
+    free(cell_sample_power);
+    free(cell_irradiance_ratio);
+    free(cell_check);
+    free(sun_dirs);
+    free(sun_hours);
+    free(attitude_visible);
+    free(channel_traces);
+
+    if (recording && TimeSeries_Close(&ts_writer))
+        TimeSeries_Map(&app->timeseries, ts_path);
+    app->timeseries_sample = -1;
+    free(sample_cell_flags);
+
+    if (export_stream) {
+        ExportStreamStats stats;
+        if (ExportStream_Close(export_stream, &stats)) {
+            if (stats.records_dropped > 0)
+                SetStatus(app, "Daily: %.1f Wh total, exported %lld rows, %lld dropped (writer too slow)",
+                          total_energy, stats.records_written, stats.records_dropped);
+            else
+                SetStatus(app, "Daily: %.1f Wh total, exported %lld rows", total_energy, stats.records_written);
+        } else {
+            SetStatus(app, "Daily: %.1f Wh total, export to %s failed", total_energy, app->export_path);
+        }
+        return;
+    }
 
     SetStatus(app, "Daily: %.1f Wh total, %.1f W avg, %.1f W peak", total_energy, total_energy / daylight_hours,
               peak_power);
@@ -2004,6 +3235,8 @@ void RunTimeSimulationAnimated(AppState *app) {
 // Update & Draw
 //------------------------------------------------------------------------------
 void AppUpdate(AppState *app) {
+    PollVehicleLod(app);
+
     // Keyboard shortcuts
     // if (IsKeyPressed(KEY_ONE)) app->mode = MODE_IMPORT;
     // if (IsKeyPressed(KEY_TWO)) app->mode = MODE_CELL_PLACEMENT;
@@ -2018,6 +3251,17 @@ void AppUpdate(AppState *app) {
         CameraReset(&app->cam, app->mesh_bounds);
     }
 
+    // Ctrl+Z undo, Ctrl+Y / Ctrl+Shift+Z redo (Cmd on macOS)
+    bool command = IsKeyDown(KEY_LEFT_CONTROL) || IsKeyDown(KEY_RIGHT_CONTROL) || IsKeyDown(KEY_LEFT_SUPER) ||
+                   IsKeyDown(KEY_RIGHT_SUPER);
+    if (command && !app->gui_text_editing && !app->auto_layout_running) {
+        bool shift = IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_RIGHT_SHIFT);
+        if (IsKeyPressed(KEY_Z) && !shift)
+            UndoEdit(app);
+        else if (IsKeyPressed(KEY_Y) || (IsKeyPressed(KEY_Z) && shift))
+            RedoEdit(app);
+    }
+
     if (IsKeyPressed(KEY_S) && !IsKeyDown(KEY_LEFT_CONTROL)) {
         if (app->mode == MODE_SIMULATION) {
             RunStaticSimulation(app);
@@ -2055,14 +3299,27 @@ void AppUpdate(AppState *app) {
 
     // Handle mouse picking (only when over 3D view)
     Vector2 mouse = GetMousePosition();
+    app->hovered_cell_id = -1;
     if (mouse.x > app->sidebar_width && app->mesh_loaded) {
+        // Hover highlight (pick grid keeps this cheap with many cells)
+        if (app->mode == MODE_WIRING || app->mode == MODE_CELL_PLACEMENT) {
+            app->hovered_cell_id = FindCellNearRay(app, GetMouseRay(mouse, app->cam.camera), NULL);
+        }
+
         if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) {
             Ray ray = GetMouseRay(mouse, app->cam.camera);
 
             if (app->mode == MODE_CELL_PLACEMENT) {
-                if (app->placing_module && app->selected_module >= 0) {
+                if (app->filling_module && app->selected_module >= 0) {
+                    // Tile the module over the clicked surface panel
+                    const HoverPick *pick = GetHoverPick(app);
+                    const SurfacePanels *panels = GetSurfacePanels(app);
+                    if (pick->hit.hit && panels && pick->triangle >= 0 && pick->triangle < panels->tri_count) {
+                        FillModuleOnPanel(app, app->selected_module, panels->tri_panel[pick->triangle]);
+                    }
+                } else if (app->placing_module && app->selected_module >= 0) {
                     // Place module at clicked location
-                    RayCollision hit = GetRayCollisionMesh(ray, app->vehicle_mesh, app->vehicle_model.transform);
+                    RayCollision hit = GetHoverPick(app)->hit;
                     if (hit.hit) {
                         PlaceModule(app, app->selected_module, hit.point, hit.normal);
                         // Stay in placing mode for multiple placements
@@ -2074,7 +3331,7 @@ void AppUpdate(AppState *app) {
                         RemoveCell(app, cell_id);
                     } else {
                         // Try to place new cell (no overlap check for manual placement)
-                        RayCollision hit = GetRayCollisionMesh(ray, app->vehicle_mesh, app->vehicle_model.transform);
+                        RayCollision hit = GetHoverPick(app)->hit;
                         if (hit.hit) {
                             PlaceCellEx(app, hit.point, hit.normal, false);
                         }
@@ -2247,9 +3504,11 @@ void DrawCell(AppState *app, SolarCell *cell) {
     DrawTriangle3D(p1, p2, p3, color);
     DrawTriangle3D(p1, p3, p4, color);
 
-    // Draw outline
+    // Draw outline (highlighted under the mouse)
     Color outline = BLACK;
     outline.a = 100;
+    if (cell->id == app->hovered_cell_id)
+        outline = WHITE;
     DrawLine3D(p1, p2, outline);
     DrawLine3D(p2, p3, outline);
     DrawLine3D(p3, p4, outline);
@@ -2283,6 +3542,23 @@ void DrawWiring(AppState *app) {
     }
 }
 
+// Unwired cells inside a screen rectangle, or inside a lasso polygon when lasso has 3+ points
+static int CountUnwiredCellsInSelection(AppState *app, Rectangle rect, const Vector2 *lasso, int lassoCount) {
+    PickGrid *grid = GetCellPickGrid(app);
+    if (!grid)
+        return 0;
+
+    static int hits[MAX_CELLS];
+    int hitCount = (lassoCount >= 3) ? PickGrid_QueryPolygon(grid, lasso, lassoCount, hits, MAX_CELLS)
+                                     : PickGrid_QueryRect(grid, rect, hits, MAX_CELLS);
+    int count = 0;
+    for (int k = 0; k < hitCount; k++) {
+        if (app->cells[hits[k]].string_id < 0)
+            count++;
+    }
+    return count;
+}
+
 void DrawSelectionRect(AppState *app) {
     if (!app->is_drag_selecting)
         return;
@@ -2305,20 +3581,7 @@ void DrawSelectionRect(AppState *app) {
     DrawRectangleLines((int)minX, (int)minY, (int)width, (int)height, borderColor);
 
     // Count cells in selection for preview
-    int count = 0;
-    for (int i = 0; i < app->cell_count; i++) {
-        SolarCell *cell = &app->cells[i];
-        if (cell->string_id >= 0)
-            continue;
-
-        Vector3 worldPos = CellGetWorldPosition(app, cell);
-        Vector2 screenPos = GetWorldToScreen(worldPos, app->cam.camera);
-
-        if (screenPos.x >= minX && screenPos.x <= maxX &&
-            screenPos.y >= minY && screenPos.y <= maxY) {
-            count++;
-        }
-    }
+    int count = CountUnwiredCellsInSelection(app, (Rectangle) {minX, minY, width, height}, NULL, 0);
 
     // Show count near cursor
     if (count > 0) {
@@ -2405,83 +3668,6 @@ void DrawMeshShadow(AppState *app) {
     }
 }
 
-// Draw shadows ON the mesh itself (occluded regions shown darker)
-void DrawMeshShadowsOnSurface(AppState *app) {
-    if (!app->sim_run || !app->sim_results.is_daytime)
-        return;
-    if (!app->mesh_loaded)
-        return;
-
-    Vector3 sun_dir = app->sim_results.sun_direction;
-    if (sun_dir.y < 0.05f)
-        return;
-
-    Mesh *mesh = &app->vehicle_mesh;
-    Matrix transform = app->vehicle_model.transform;
-
-    float *vertices = mesh->vertices;
-    unsigned short *indices = mesh->indices;
-    int triangleCount = mesh->triangleCount;
-
-    Color shadowOnMesh = (Color) {0, 0, 50, 120}; // Dark blue tint for shadowed areas
-
-    // Sample triangles for shadow testing (for performance)
-    int step = (triangleCount > 2000) ? triangleCount / 500 : 1;
-
-    for (int i = 0; i < triangleCount; i += step) {
-        int idx0, idx1, idx2;
-        if (indices) {
-            idx0 = indices[i * 3 + 0];
-            idx1 = indices[i * 3 + 1];
-            idx2 = indices[i * 3 + 2];
-        } else {
-            idx0 = i * 3 + 0;
-            idx1 = i * 3 + 1;
-            idx2 = i * 3 + 2;
-        }
-
-        // Get vertices and transform them
-        Vector3 v0 = {vertices[idx0 * 3], vertices[idx0 * 3 + 1], vertices[idx0 * 3 + 2]};
-        Vector3 v1 = {vertices[idx1 * 3], vertices[idx1 * 3 + 1], vertices[idx1 * 3 + 2]};
-        Vector3 v2 = {vertices[idx2 * 3], vertices[idx2 * 3 + 1], vertices[idx2 * 3 + 2]};
-
-        v0 = Vector3Transform(v0, transform);
-        v1 = Vector3Transform(v1, transform);
-        v2 = Vector3Transform(v2, transform);
-
-        // Calculate triangle normal
-        Vector3 edge1 = Vector3Subtract(v1, v0);
-        Vector3 edge2 = Vector3Subtract(v2, v0);
-        Vector3 normal = Vector3Normalize(Vector3CrossProduct(edge1, edge2));
-
-        // Only check triangles facing toward the sun (could receive light)
-        float facingSun = Vector3DotProduct(normal, sun_dir);
-        if (facingSun < 0.1f)
-            continue; // Not facing sun, skip
-
-        // Triangle center
-        Vector3 center = {(v0.x + v1.x + v2.x) / 3.0f, (v0.y + v1.y + v2.y) / 3.0f, (v0.z + v1.z + v2.z) / 3.0f};
-
-        // Offset slightly along normal to avoid self-intersection
-        Vector3 rayStart = Vector3Add(center, Vector3Scale(normal, 0.005f));
-
-        // Cast ray toward sun
-        Ray ray = {rayStart, sun_dir};
-        RayCollision hit = GetRayCollisionMesh(ray, *mesh, transform);
-
-        // If ray hits something, this triangle is in shadow
-        if (hit.hit && hit.distance > 0.01f) {
-            // Draw shadow overlay on this triangle (slightly offset to avoid z-fighting)
-            Vector3 offset = Vector3Scale(normal, 0.002f);
-            Vector3 sv0 = Vector3Add(v0, offset);
-            Vector3 sv1 = Vector3Add(v1, offset);
-            Vector3 sv2 = Vector3Add(v2, offset);
-
-            DrawTriangle3D(sv0, sv1, sv2, shadowOnMesh);
-        }
-    }
-}
-
 void DrawSunIndicator(AppState *app) {
     if (!app->sim_run || !app->sim_results.is_daytime)
         return;
@@ -2505,6 +3691,8 @@ void DrawSunIndicator(AppState *app) {
 
 // Height bounds editor implementation in auto_layout.c
 
+#define GROUP_SELECT_MAX_LASSO_POINTS 512
+
 void RunGroupCellSelect(AppState *app) {
     if (app->cell_count == 0) {
         SetStatus(app, "No cells to select");
@@ -2521,11 +3709,16 @@ void RunGroupCellSelect(AppState *app) {
     Vector2 dragStart = {0, 0};
     Vector2 dragEnd = {0, 0};
 
+    // Shift-drag draws a freehand lasso instead of a rectangle
+    bool lasso = false;
+    static Vector2 lassoPoints[GROUP_SELECT_MAX_LASSO_POINTS];
+    int lassoCount = 0;
+
     int viewX = app->sidebar_width;
     int viewW = app->screen_width - app->sidebar_width;
     int viewH = app->screen_height - 30;
 
-    SetStatus(app, "Drag to select cells. ESC/Right-click to cancel, Release to confirm.");
+    SetStatus(app, "Drag to select cells (Shift: lasso). ESC/Right-click to cancel, Release to confirm.");
 
     while (!done && !WindowShouldClose()) {
         // Get input state (EndDrawing from previous frame already polled)
@@ -2536,20 +3729,32 @@ void RunGroupCellSelect(AppState *app) {
             dragging = true;
             dragStart = mouse;
             dragEnd = mouse;
+            lasso = IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_RIGHT_SHIFT);
+            lassoCount = 0;
+            if (lasso)
+                lassoPoints[lassoCount++] = mouse;
         }
 
         // Update drag end
         if (dragging) {
             dragEnd = mouse;
+            if (lasso && lassoCount < GROUP_SELECT_MAX_LASSO_POINTS &&
+                Vector2Distance(lassoPoints[lassoCount - 1], mouse) > 4.0f) {
+                lassoPoints[lassoCount++] = mouse;
+            }
         }
 
         // Release - add cells and exit
         if (IsMouseButtonReleased(MOUSE_BUTTON_LEFT) && dragging) {
-            float dist = Vector2Distance(dragStart, dragEnd);
-            if (dist > 5.0f) {
-                int added = AddCellsInRectToString(app, dragStart, dragEnd);
-                SetStatus(app, "Added %d cells to string #%d", added, app->active_string_id);
+            int added = 0;
+            BeginEdit(app, "Wire selection");
+            if (lasso && lassoCount >= 3) {
+                added = AddCellsInLassoToString(app, lassoPoints, lassoCount);
+            } else if (!lasso && Vector2Distance(dragStart, dragEnd) > 5.0f) {
+                added = AddCellsInRectToString(app, dragStart, dragEnd);
             }
+            EndEdit(app);
+            SetStatus(app, "Added %d cells to string #%d", added, app->active_string_id);
             done = true;
         }
 
@@ -2570,7 +3775,7 @@ void RunGroupCellSelect(AppState *app) {
         DrawGrid(20, 0.5f);
 
         if (app->mesh_loaded) {
-            DrawModel(app->vehicle_model, (Vector3){0, 0, 0}, 1.0f, COLOR_MESH);
+            DrawVehicleModel(app, COLOR_MESH);
         }
 
         // Draw cells
@@ -2585,33 +3790,29 @@ void RunGroupCellSelect(AppState *app) {
         EndMode3D();
         EndScissorMode();
 
-        // Draw selection rectangle
+        // Draw selection rectangle or lasso
         if (dragging) {
             float minX = fminf(dragStart.x, dragEnd.x);
             float maxX = fmaxf(dragStart.x, dragEnd.x);
             float minY = fminf(dragStart.y, dragEnd.y);
             float maxY = fmaxf(dragStart.y, dragEnd.y);
 
-            DrawRectangle((int)minX, (int)minY, (int)(maxX - minX), (int)(maxY - minY),
-                          (Color){100, 150, 255, 50});
-            DrawRectangleLines((int)minX, (int)minY, (int)(maxX - minX), (int)(maxY - minY),
-                               (Color){50, 100, 255, 200});
-
-            // Count cells in selection
-            int count = 0;
-            for (int i = 0; i < app->cell_count; i++) {
-                SolarCell *cell = &app->cells[i];
-                if (cell->string_id >= 0) continue;
-
-                Vector3 worldPos = CellGetWorldPosition(app, cell);
-                Vector2 screenPos = GetWorldToScreen(worldPos, app->cam.camera);
-
-                if (screenPos.x >= minX && screenPos.x <= maxX &&
-                    screenPos.y >= minY && screenPos.y <= maxY) {
-                    count++;
+            if (lasso) {
+                for (int i = 0; i < lassoCount; i++) {
+                    Vector2 next = (i + 1 < lassoCount) ? lassoPoints[i + 1] : lassoPoints[0];
+                    DrawLineV(lassoPoints[i], next, (Color){50, 100, 255, 200});
                 }
+            } else {
+                DrawRectangle((int)minX, (int)minY, (int)(maxX - minX), (int)(maxY - minY),
+                              (Color){100, 150, 255, 50});
+                DrawRectangleLines((int)minX, (int)minY, (int)(maxX - minX), (int)(maxY - minY),
+                                   (Color){50, 100, 255, 200});
             }
 
+            // Count cells in selection
+            int count = CountUnwiredCellsInSelection(app, (Rectangle){minX, minY, maxX - minX, maxY - minY},
+                                                     lassoPoints, lasso ? lassoCount : 0);
+
             if (count > 0) {
                 char countText[32];
                 snprintf(countText, sizeof(countText), "%d cells", count);
@@ -2628,7 +3829,7 @@ void RunGroupCellSelect(AppState *app) {
         DrawRectangle(panelX, panelY, panelW, panelH, (Color){40, 40, 40, 220});
         DrawRectangleLines(panelX, panelY, panelW, panelH, WHITE);
         DrawText("GROUP SELECT", panelX + 80, panelY + 12, 18, WHITE);
-        DrawText("Drag to select cells", panelX + 70, panelY + 38, 14, LIGHTGRAY);
+        DrawText("Drag to select cells (Shift: lasso)", panelX + 30, panelY + 38, 14, LIGHTGRAY);
         DrawText("ESC or Right-click to cancel", panelX + 50, panelY + 56, 14, LIGHTGRAY);
 
         // Status bar
@@ -2668,15 +3869,15 @@ void AppDraw(AppState *app) {
 
     // Draw mesh
     if (app->mesh_loaded) {
-        DrawModel(app->vehicle_model, (Vector3) {0, 0, 0}, 1.0f, COLOR_MESH);
-        DrawModelWires(app->vehicle_model, (Vector3) {0, 0, 0}, 1.0f, (Color) {100, 100, 100, 50});
-
-        // Draw shadows on the mesh surface (occluded areas)
-        // DrawMeshShadowsOnSurface(app);
+        // Exposure map in place of the plain mesh when one is shown
+        if (!DrawInsolationMap(app))
+            DrawVehicleModel(app, COLOR_MESH);
+        DrawVehicleWireframe(app, (Color) {100, 100, 100, 50});
 
         // Draw auto-layout surface preview
         DrawAutoLayoutPreview(app);
     }
+    DrawObstacles(app);
 
     // Draw cells
     for (int i = 0; i < app->cell_count; i++) {
@@ -2691,11 +3892,10 @@ void AppDraw(AppState *app) {
     DrawSunIndicator(app);
 
     // Draw ghost cell preview in cell placement mode
-    if (app->mode == MODE_CELL_PLACEMENT && app->mesh_loaded && !app->placing_module) {
+    if (app->mode == MODE_CELL_PLACEMENT && app->mesh_loaded && !app->placing_module && !app->filling_module) {
         Vector2 mouse = GetMousePosition();
         if (mouse.x > app->sidebar_width) {
-            Ray ray = GetMouseRay(mouse, app->cam.camera);
-            RayCollision hit = GetRayCollisionMesh(ray, app->vehicle_mesh, app->vehicle_model.transform);
+            RayCollision hit = GetHoverPick(app)->hit;
             if (hit.hit && hit.normal.y > 0.1f) {  // Only on upward-facing surfaces
                 CellPreset *preset = (CellPreset *)&CELL_PRESETS[app->selected_preset];
                 Vector3 pos = Vector3Add(hit.point, Vector3Scale(hit.normal, CELL_SURFACE_OFFSET));
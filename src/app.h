@@ -4,6 +4,19 @@
 #include <stdbool.h>
 #include "raylib.h"
 #include "raymath.h"
+#include "cell_packer.h"
+#include "height_map.h"
+#include "mesh_bvh.h"
+#include "mesh_simplify.h"
+#include "mesh_topology.h"
+#include "pick_grid.h"
+#include "sim_core.h"
+#include "string_router.h"
+#include "surface_panels.h"
+#include "undo_journal.h"
+#include "simulation/attitude.h"
+#include "simulation/network_sim.h"
+#include "simulation/timeseries.h"
 
 //------------------------------------------------------------------------------
 // Constants
@@ -11,16 +24,31 @@
 #define MAX_CELLS 1000
 #define MAX_STRINGS 50
 #define MAX_CELLS_PER_STRING 100
+#define MAX_MPPT_CHANNELS 8 // Shared trackers (channel 0 = string has its own tracker)
 #define MAX_PATH_LENGTH 512
 #define MAX_MODULES 50
 #define MAX_CELLS_PER_MODULE 100
 #define MAX_MODULE_NAME 64
 #define MODULES_DIRECTORY "modules"
 #define MAX_BYPASS_DIODES 100
+#define MAX_OBSTACLES 64
+#define MAX_OBSTACLE_MESHES 16
 
 #define CELL_SURFACE_OFFSET 0.002f // Offset above mesh surface
 #define MIN_CELL_DISTANCE_FACTOR 1.05f // Slightly more than 1.0 to prevent any overlap
 #define MIN_UPWARD_NORMAL 0.3f
+#define INTERCONNECT_OHMS_PER_M 0.0085f // Cell-to-cell ribbon, two 5 x 0.2 mm copper strips in parallel
+
+#define WIREFRAME_CREASE_DEG 30.0f // Face angle above which an edge counts as a crease
+#define WIREFRAME_DENSE_EDGES 200000 // Meshes with more edges start in crease-only mode
+
+#define MESH_LOD_MIN_TRIANGLES 300000 // Smaller meshes are always drawn at full resolution
+#define MESH_LOD_NEAR_TRIANGLES 250000 // Display level used at normal viewing distance
+#define MESH_LOD_FAR_TRIANGLES 60000 // Display level used when the vehicle is small on screen
+
+#define DRAFT_OCCLUDER_ERROR 0.01f // Max deviation of the draft shading proxy from the vehicle (meters)
+#define DRAFT_CHECK_STRIDE 7 // Draft sweeps re-check every Nth sample against the full mesh
+#define SWEEP_VISIBILITY_CHUNK 32 // Attitude directions traced between progress redraws
 
 //------------------------------------------------------------------------------
 // Colors
@@ -30,6 +58,7 @@
 #define COLOR_CELL_SHADED (Color){128, 128, 128, 230}
 #define COLOR_BACKGROUND (Color){245, 245, 245, 255}
 #define COLOR_PANEL (Color){230, 230, 230, 255}
+#define COLOR_OBSTACLE (Color){150, 140, 120, 230}
 
 //------------------------------------------------------------------------------
 // Enums
@@ -45,6 +74,13 @@ typedef enum {
     VIS_MODE_BYPASS              // Highlight bypassed cells
 } CellVisMode;
 
+// Vehicle wireframe overlay density
+typedef enum {
+    WIREFRAME_ALL = 0,  // Every unique edge
+    WIREFRAME_CREASES,  // Boundary, non-manifold and sharp edges only
+    WIREFRAME_OFF
+} WireframeMode;
+
 //------------------------------------------------------------------------------
 // Data Structures
 //------------------------------------------------------------------------------
@@ -92,6 +128,7 @@ typedef struct {
     float string_voltage; // Total string voltage (V)
     int bypassed_count;   // Number of cells being bypassed
     float power_ideal;    // Power if all cells were in full sun
+    int mppt_channel;     // Shared MPPT channel (0 = dedicated tracker)
 } CellString;
 
 // Bypass diode segment - bypasses cells between start and end (inclusive)
@@ -120,6 +157,14 @@ typedef struct {
     float height; // Bounding height for preview
 } CellModule;
 
+// Scenery that can shade the vehicle; index matches its obstacle_scene instance
+typedef struct {
+    int mesh; // Index into obstacle_models and the obstacle_scene meshes
+    Vector3 position; // Ground point under the mesh centre (m)
+    float yaw_deg;
+    float scale; // Mesh units to meters
+} Obstacle;
+
 // Simulation settings
 typedef struct {
     float latitude; // degrees
@@ -127,8 +172,15 @@ typedef struct {
     int year;
     int month;
     int day;
-    float hour; // 0-24 decimal hours
+    float hour; // 0-24 decimal hours on the site's clock
+    float utc_offset; // Hours the clock is ahead of UTC, when not taken from the longitude
+    bool auto_utc_offset; // Clock is the standard zone of the longitude (nearest 15 degrees)
     float irradiance; // W/m^2
+    float iv_cache_step; // Irradiance quantisation for string result memoisation (0 = off)
+    bool record_timeseries; // Stream per-sample results to disk during the daily sweep
+    bool draft_shading; // Occlusion against the simplified proxy (daily sweep and auto-layout scoring)
+    float pitch_spread_deg; // Standard deviation of the daily sweep's pitch (0 = level, unused with a route)
+    float roll_spread_deg; // Standard deviation of the daily sweep's roll
 } SimSettings;
 
 // Auto-layout settings
@@ -147,12 +199,16 @@ typedef struct {
     float max_height; // Maximum height for cell placement
     bool use_grid_layout; // Use grid-based layout instead of mesh triangles
     float grid_spacing; // Grid spacing for layout (0 = auto based on cell size)
+    float height_map_texel; // Resolution of the top-down surface map used for vertical probes (m)
+    bool conform_packing; // Pack cells in each panel's own plane instead of scanning a grid
+    PackOrientation pack_orientation; // Cell orientation within a panel when conform_packing is on
 } AutoLayoutSettings;
 
 // Candidate position for auto-layout
 typedef struct {
     Vector3 position;
     Vector3 normal;
+    Vector3 tangent; // Cell width direction from the packer, zero = derive from the normal
     float occlusion_score; // 0 = no occlusion, 1 = always occluded
     bool valid;
 } LayoutCandidate;
@@ -182,7 +238,70 @@ typedef struct TimeSimResults {
     float average_shaded_pct; // Average shading percentage
     float min_power_w; // Minimum power (when not zero)
     float energy_by_hour[24]; // Energy breakdown by hour (optional)
+    int cache_hits; // String results reused from the memoisation cache
+    int cache_misses; // String results computed with a full IV sweep
+    float cache_hit_rate; // Fraction of string lookups served by the cache (0-1)
+    bool draft; // Shaded against the draft proxy
+    float draft_discrepancy_pct; // Sampled incident energy, draft vs full mesh (%)
+    int draft_check_samples; // Samples traced against both meshes
+    int attitude_count; // Pitch/roll states averaged per sample (1 = level only)
+    int attitude_dirs; // Vehicle-frame direction bins traced for them (0 = shaded per sample)
+    bool network; // Solved as the loaded array network instead of separate strings
+    int network_cells; // Layout cells the network wires
+    float network_newton_steps; // Average Newton steps per network MPP
+    int network_failures; // MPP solves that did not converge
 } TimeSimResults;
+// Annual results from the loaded weather year
+typedef struct {
+    float total_energy_kwh;
+    float energy_by_month_kwh[12];
+    float daylight_hours; // Hours with the sun up and any irradiance
+    float specific_yield; // kWh per m^2 of cell area
+    float beam_shaded_pct; // Direct irradiation on facing cells lost to occlusion
+    int dir_count; // Sun direction bins traced per cell
+    int bin_count; // Weather bins evaluated electrically
+    bool visibility_reused; // Visibility came from the cache
+    bool draft; // Shaded against the draft proxy
+} AnnualSimResults;
+
+// Sun histogram and per-cell visibility kept between annual runs
+typedef struct {
+    SimSkyHistogram sky;
+    unsigned int weather_revision; // Weather and site the histogram was built for
+    float latitude;
+    float longitude;
+    int year;
+    float utc_offset;
+
+    uint8_t *visible; // cell x direction, 1 = the cell faces the sun bin and nothing blocks it
+    float *sky_view; // Per-cell cosine-weighted share of open sky
+    float *ground_view; // Per-cell share of open ground
+    bool visibility_valid;
+    int cell_count; // Layout, mesh and histogram the visibility was traced for
+    unsigned int cell_revision;
+    unsigned int mesh_revision;
+    unsigned int obstacle_revision;
+    unsigned int sky_revision;
+    bool draft;
+    unsigned int sky_builds; // Bumped on every histogram build
+} AnnualSimCache;
+
+// Direct sun exposure of the whole vehicle surface, baked into vertex colours
+typedef struct {
+    float *exposure; // Per welded topology vertex: Wh/m^2 for a day, kWh/m^2 for the weather year
+    int vertex_count;
+    float max_exposure;
+    bool annual; // Built from the weather year rather than the daily clear-sky sweep
+    Mesh mesh; // Coloured copy of vehicle_mesh, uploaded once per build
+    unsigned int mesh_revision; // mesh_revision and obstacle_revision the exposure was computed for
+    unsigned int obstacle_revision;
+    SimSite site; // Site and date, as GetSimSite gave them
+    float irradiance; // Daily maps: clear-sky irradiance setting
+    unsigned int weather_revision; // Annual maps: weather file
+    bool draft; // draft_shading setting it was traced with
+    bool show;
+} InsolationMap;
+
 // Camera controller state
 typedef struct {
     Camera3D camera;
@@ -194,6 +313,16 @@ typedef struct {
     float ortho_scale; // Zoom for orthographic
 } CameraController;
 
+// Mouse pick against the vehicle, reused while mouse, camera and mesh are unchanged
+typedef struct {
+    bool valid;
+    Vector2 mouse;
+    Camera3D camera;
+    unsigned int mesh_revision;
+    RayCollision hit;
+    int triangle; // Triangle index in vehicle_mesh, -1 = miss
+} HoverPick;
+
 // Main application state
 typedef struct {
     // Application mode
@@ -202,6 +331,25 @@ typedef struct {
     // Mesh
     Model vehicle_model;
     Mesh vehicle_mesh; // Copy for raycasting
+    MeshBVH vehicle_bvh; // Raycast acceleration for vehicle_mesh
+    unsigned int mesh_revision; // Bumped when the mesh or its transform changes
+    MeshTopology vehicle_topology; // Welded vertices and edge adjacency of vehicle_mesh
+    unsigned int wire_vao; // GPU line list of the edges drawn for wireframe_mode (mesh-local)
+    unsigned int wire_vbo;
+    int wire_vertex_count;
+    WireframeMode wireframe_mode;
+    WireframeMode wire_built_mode; // Mode the line list was built for
+    MeshSimplifyJob *lod_job; // Background decimation, NULL when idle
+    Mesh vehicle_lod[MESH_LOD_MAX_LEVELS]; // Display-only decimated meshes (rays use vehicle_mesh)
+    int lod_level_count;
+    int lod_level; // Level drawn last frame, 0 = full resolution
+    MeshBVH draft_bvh; // Occlusion proxy for draft shading
+    float draft_bvh_scale; // mesh_scale the proxy error bound was computed for, 0 = not built
+    SurfacePanels surface_panels; // Smooth world-space panels for auto-layout (see GetSurfacePanels)
+    unsigned int panels_revision; // mesh_revision surface_panels was built for
+    HeightMap height_map; // Top-down surface layers for vertical probes (see GetHeightMap)
+    unsigned int height_map_revision; // mesh_revision height_map was built for
+    float height_map_texel; // auto_layout.height_map_texel height_map was built for
     BoundingBox mesh_bounds;
     BoundingBox mesh_bounds_raw; // Original bounds before transform
     Vector3 mesh_center_raw; // Original center for rotation pivot
@@ -215,6 +363,7 @@ typedef struct {
     int cell_count;
     int next_cell_id;
     int selected_preset; // Index into CELL_PRESETS
+    unsigned int cell_revision; // Bumped when cell world positions change (invalidates caches)
 
     // Strings
     CellString strings[MAX_STRINGS];
@@ -234,6 +383,9 @@ typedef struct {
     int module_count;
     int selected_module; // Currently selected module for placement, -1 = none
     bool placing_module; // True when in module placement mode
+    bool filling_module; // True when the next mesh click tiles the selected module over a panel
+    float module_fill_angle; // Module X axis from the panel's horizontal axis (degrees)
+    float module_fill_gap; // Extra spacing between tiled module instances (m)
 
     // Auto-layout
     AutoLayoutSettings auto_layout;
@@ -243,6 +395,10 @@ typedef struct {
     // Snap settings
     SnapSettings snap;
 
+    // Undo history of cell, wiring, bypass diode and mesh transform edits
+    UndoJournal undo;
+    int edit_active_string; // active_string_id when the open edit began
+
     // Camera
     CameraController cam;
 
@@ -252,11 +408,38 @@ typedef struct {
     bool sim_run; // Has simulation been run?
     bool time_sim_run;
     TimeSimResults time_sim_results;
+    TimeSeriesReader timeseries; // Mapped per-sample recording of the last daily sweep
+    int timeseries_sample; // Sample shown by the timeline scrubber
+    char export_path[MAX_PATH_LENGTH]; // Per-sample CSV export of the daily sweep ("" = off)
+    AttitudeSet attitude_route; // Pitch/roll histogram of a route log, route_samples 0 = none (use the spread)
+    char attitude_path[MAX_PATH_LENGTH];
+    NetworkSim network; // Series-parallel array netlist, element_count 0 = none (strings are solved separately)
+    char network_path[MAX_PATH_LENGTH];
     CellVisMode vis_mode; // How to color cells after simulation
 
+    // Obstacle scenery (shades cells, never holds them)
+    ObstacleScene obstacle_scene;
+    Model obstacle_models[MAX_OBSTACLE_MESHES]; // Display model of each scene mesh
+    char obstacle_paths[MAX_OBSTACLE_MESHES][MAX_PATH_LENGTH];
+    Obstacle obstacles[MAX_OBSTACLES];
+    int obstacle_count;
+    int selected_obstacle; // -1 = none
+    unsigned int obstacle_revision; // Bumped when scenery is added, moved or removed
+
+    // Annual simulation
+    WeatherYear weather; // Loaded TMY year, record_count 0 = none
+    unsigned int weather_revision; // Bumped on every weather load
+    char weather_path[MAX_PATH_LENGTH];
+    AnnualSimCache annual_cache;
+    bool annual_sim_run;
+    AnnualSimResults annual_results;
+    InsolationMap insolation;
+
     // UI state
     bool show_file_dialog;
     int hovered_cell_id; // -1 = none
+    PickGrid pick_grid; // Screen-space buckets of projected cell centres
+    HoverPick hover_pick; // Cached mouse ray hit shared by the ghost preview and clicks
     char status_msg[256];
     bool gui_text_editing; // True when any text field is in edit mode
 
@@ -297,6 +480,18 @@ void AppClose(AppState *app);
 // Mesh loading
 bool LoadVehicleMesh(AppState *app, const char *path);
 void UpdateMeshTransform(AppState *app);
+RayCollision RaycastVehicle(AppState *app, Ray ray, int *out_triangle);
+const HoverPick *GetHoverPick(AppState *app);
+const SurfacePanels *GetSurfacePanels(AppState *app);
+bool ProjectOntoPanel(AppState *app, const SurfacePanels *panels, int p, float u, float v, RayCollision *hit);
+const HeightMap *GetHeightMap(AppState *app);
+RayCollision ProbeSurfaceBelow(AppState *app, float x, float z, int *out_triangle);
+float ProbeClearance(AppState *app, Vector3 position);
+bool EnsureDraftOccluder(AppState *app);
+// Snapshot of the vehicle meshes for the simulation core (valid until the mesh or its BVHs change)
+SimGeometry GetSimGeometry(AppState *app);
+
+bool IsSunOccluded(AppState *app, Vector3 position, Vector3 normal, Vector3 sun_dir, bool draft);
 
 // Camera
 void CameraInit(CameraController *cam);
@@ -307,6 +502,7 @@ void CameraFitToBounds(CameraController *cam, BoundingBox bounds);
 
 // Cells
 int PlaceCell(AppState *app, Vector3 world_position, Vector3 world_normal);
+int PlaceCellOriented(AppState *app, Vector3 world_position, Vector3 world_normal, Vector3 world_tangent);
 void RemoveCell(AppState *app, int cell_id);
 void ClearAllCells(AppState *app);
 int FindCellAtPosition(AppState *app, Vector3 pos, float threshold);
@@ -323,6 +519,11 @@ void CancelCurrentString(AppState *app);
 void ClearAllWiring(AppState *app);
 Color GenerateStringColor(void);
 int AddCellsInRectToString(AppState *app, Vector2 screenMin, Vector2 screenMax);
+int AddCellsInLassoToString(AppState *app, const Vector2 *points, int pointCount);
+float GetStringRouteLength(AppState *app, const CellString *str);
+bool OptimiseStringRoute(AppState *app, int string_index, RouteStats *stats);
+void OptimiseAllStringRoutes(AppState *app);
+PickGrid *GetCellPickGrid(AppState *app);
 void DrawSelectionRect(AppState *app);
 void RunGroupCellSelect(AppState *app);
 
@@ -339,14 +540,44 @@ bool SaveModule(CellModule *module, const char *filename);
 bool LoadAppModule(CellModule *module, const char *filename);
 void LoadAllModules(AppState *app);
 int PlaceModule(AppState *app, int module_index, Vector3 world_position, Vector3 world_normal);
+int FillModuleOnPanel(AppState *app, int module_index, int panel);
 void DeleteModule(AppState *app, int module_index);
 
 // Simulation
 void RunStaticSimulation(AppState *app);
 void RunTimeSimulationAnimated(AppState *app);
+bool ShowTimeSeriesSample(AppState *app, int index);
+bool LoadAttitudeRoute(AppState *app, const char *path);
+void ClearAttitudeRoute(AppState *app);
+bool LoadArrayNetwork(AppState *app, const char *path);
+void ClearArrayNetwork(AppState *app);
+SimSite GetSimSite(const SimSettings *settings);
 Vector3 CalculateSunDirection(SimSettings *settings, float *altitude, float *azimuth);
 bool CheckCellShading(AppState *app, SolarCell *cell, Vector3 sun_dir);
 float CalculateCellPower(AppState *app, SolarCell *cell, Vector3 sun_dir, CellPreset *preset, float irradiance);
+void SolveMpptChannels(const AppState *app, const IVTrace *string_traces, float *string_power, float *string_current,
+                       float *string_v_scale);
+
+// Obstacle scenery
+int AddObstacleFromFile(AppState *app, const char *path);
+int DuplicateObstacle(AppState *app, int index);
+void UpdateObstacleTransform(AppState *app, int index);
+void RemoveObstacle(AppState *app, int index);
+void ClearObstacles(AppState *app);
+void DrawObstacles(AppState *app);
+
+// Annual simulation from a TMY weather file
+bool LoadWeatherFile(AppState *app, const char *path);
+void RunAnnualSimulation(AppState *app);
+const SimSkyHistogram *GetAnnualSkyHistogram(AppState *app);
+void FreeAnnualSimCache(AppState *app);
+
+// Whole-surface sun exposure map
+bool ComputeInsolationMap(AppState *app, bool annual);
+void FreeInsolationMap(AppState *app);
+bool InsolationMapCurrent(const AppState *app);
+float SampleInsolationPrior(AppState *app, Vector3 position, Vector3 normal);
+bool DrawInsolationMap(AppState *app);
 
 // Auto-layout
 void InitAutoLayout(AppState *app);
@@ -356,6 +587,24 @@ bool IsValidSurface(AppState *app, Vector3 position, Vector3 normal);
 void DrawAutoLayoutPreview(AppState *app);
 void RunHeightBoundsEditor(AppState *app);
 
+// Undo (edits group the changes made between BeginEdit and EndEdit; nested pairs join the outer edit)
+void BeginEdit(AppState *app, const char *label);
+void EndEdit(AppState *app);
+bool UndoEdit(AppState *app);
+bool RedoEdit(AppState *app);
+void ClearEditHistory(AppState *app);
+void JournalCellAdded(AppState *app, int index);
+void JournalCellRemoving(AppState *app, int index);
+void JournalCellWired(AppState *app, int index, int old_string_id, int old_order);
+void JournalStringAdded(AppState *app, int index);
+void JournalStringRemoving(AppState *app, int index);
+void JournalStringCellAdded(AppState *app, int index, int position);
+void JournalStringCellRemoving(AppState *app, int index, int position);
+void JournalStringReordered(AppState *app, int index, const int *old_cell_ids);
+void JournalDiodeAdded(AppState *app, int index);
+void JournalDiodeRemoving(AppState *app, int index);
+void RecordTransformEdit(AppState *app, float old_scale, Vector3 old_rotation);
+
 // Snap
 void InitSnap(AppState *app);
 Vector3 ApplyGridSnap(AppState *app, Vector3 position);
@@ -1,5 +1,7 @@
 #include "app.h"
 #include "auto_layout.h"
+#include "job_system.h"
+#include <float.h>
 #include <stdlib.h>
 #include <math.h>
 #include <stdio.h>
@@ -23,6 +25,7 @@ void InitAutoLayout(AppState *app) {
     app->auto_layout.max_height = 10.0f;
     app->auto_layout.use_grid_layout = true;
     app->auto_layout.grid_spacing = 0.0f;
+    app->auto_layout.height_map_texel = 0.01f;
     app->auto_layout_running = false;
     app->auto_layout_progress = 0;
 }
@@ -31,11 +34,7 @@ bool IsPointOnMesh(AppState *app, Vector3 position, float tolerance) {
     if (!app->mesh_loaded)
         return false;
 
-    Ray ray;
-    ray.position = (Vector3){position.x, app->mesh_bounds.max.y + 1.0f, position.z};
-    ray.direction = (Vector3){0, -1, 0};
-
-    RayCollision hit = GetRayCollisionMesh(ray, app->vehicle_mesh, app->vehicle_model.transform);
+    RayCollision hit = ProbeSurfaceBelow(app, position.x, position.z, NULL);
 
     if (!hit.hit)
         return false;
@@ -82,11 +81,7 @@ bool IsCellFootprintValid(AppState *app, Vector3 position, Vector3 normal, float
         Vector3 checkPos = checkPoints[i];
 
         // Check that this point is on the mesh
-        Ray rayDown;
-        rayDown.position = (Vector3){checkPos.x, app->mesh_bounds.max.y + 1.0f, checkPos.z};
-        rayDown.direction = (Vector3){0, -1, 0};
-
-        RayCollision hitDown = GetRayCollisionMesh(rayDown, app->vehicle_mesh, app->vehicle_model.transform);
+        RayCollision hitDown = ProbeSurfaceBelow(app, checkPos.x, checkPos.z, NULL);
 
         if (!hitDown.hit) {
             return false;
@@ -105,14 +100,8 @@ bool IsCellFootprintValid(AppState *app, Vector3 position, Vector3 normal, float
         }
 
         // Check for mesh geometry above this point
-        Ray rayUp;
-        rayUp.position = Vector3Add(checkPos, (Vector3){0, 0.01f, 0});
-        rayUp.direction = (Vector3){0, 1, 0};
-
-        RayCollision hitUp = GetRayCollisionMesh(rayUp, app->vehicle_mesh, app->vehicle_model.transform);
-
         float clearance_required = 0.05f;
-        if (hitUp.hit && hitUp.distance < clearance_required) {
+        if (ProbeClearance(app, Vector3Add(checkPos, (Vector3){0, 0.01f, 0})) < clearance_required) {
             return false;
         }
     }
@@ -120,14 +109,18 @@ bool IsCellFootprintValid(AppState *app, Vector3 position, Vector3 normal, float
     return true;
 }
 
-bool IsValidSurface(AppState *app, Vector3 position, Vector3 normal) {
+// Angle and height limits only, without the footprint probes
+static bool PassesAngleLimits(AppState *app, Vector3 normal) {
     float angle_from_vertical = acosf(Clampf(normal.y, -1.0f, 1.0f)) * RAD2DEG;
     float angle_from_horizontal = 90.0f - angle_from_vertical;
 
-    if (angle_from_horizontal < app->auto_layout.min_normal_angle ||
-        angle_from_horizontal > app->auto_layout.max_normal_angle) {
+    return angle_from_horizontal >= app->auto_layout.min_normal_angle &&
+           angle_from_horizontal <= app->auto_layout.max_normal_angle;
+}
+
+static bool PassesSurfaceLimits(AppState *app, Vector3 position, Vector3 normal) {
+    if (!PassesAngleLimits(app, normal))
         return false;
-    }
 
     if (position.y < 0.01f)
         return false;
@@ -138,6 +131,13 @@ bool IsValidSurface(AppState *app, Vector3 position, Vector3 normal) {
         }
     }
 
+    return true;
+}
+
+bool IsValidSurface(AppState *app, Vector3 position, Vector3 normal) {
+    if (!PassesSurfaceLimits(app, position, normal))
+        return false;
+
     CellPreset *preset = (CellPreset *)&CELL_PRESETS[app->selected_preset];
     if (!IsCellFootprintValid(app, position, normal, preset->width, preset->height)) {
         return false;
@@ -146,105 +146,455 @@ bool IsValidSurface(AppState *app, Vector3 position, Vector3 normal) {
     return true;
 }
 
+static int CompareSunSamples(const void *a, const void *b) {
+    float aa = ((const SunSample *)a)->altitude;
+    float ab = ((const SunSample *)b)->altitude;
+    return (aa > ab) - (aa < ab);
+}
+
+// Every heading x hour with the sun up over 6:00-18:00, lowest sun first: low sun separates good and bad spots soonest
+static int BuildScoreSamples(AppState *app, SunSample *samples) {
+    SimSite site = GetSimSite(&app->sim_settings);
+    int count = SimCore_BuildSunSamples(&site, 6.0f, 12.0f, app->auto_layout.time_samples, OCCLUSION_HEADINGS,
+                                        samples);
+    qsort(samples, count, sizeof(SunSample), CompareSunSamples);
+    return count;
+}
+
 float CalculateOcclusionScore(AppState *app, Vector3 position, Vector3 normal) {
     if (!app->mesh_loaded)
         return 0.0f;
 
-    int occluded_count = 0;
-    int total_samples = 0;
+    SunSample *samples = (SunSample *)malloc(OCCLUSION_HEADINGS * app->auto_layout.time_samples * sizeof(SunSample));
+    if (!samples)
+        return 1.0f;
 
-    SimSettings original = app->sim_settings;
-    int heading_samples = 10;
+    SimGeometry geometry = GetSimGeometry(app);
+    bool draft = app->sim_settings.draft_shading && app->draft_bvh.nodes;
+    int sample_count = BuildScoreSamples(app, samples);
+    float score = SimCore_OcclusionScore(&geometry, position, normal, samples, sample_count, FLT_MAX, draft, NULL);
+    free(samples);
+    return score;
+}
 
-    for (int heading_idx = 0; heading_idx < heading_samples; heading_idx++) {
-        float heading_angle = (360.0f * heading_idx) / heading_samples;
-        float heading_rad = heading_angle * DEG2RAD;
+// Max-heap holding the lowest cap scores seen so far; once full, its top is the bar for entering the set
+static void OfferScore(float *heap, int *count, int cap, float score) {
+    int i;
+    if (*count < cap) {
+        i = (*count)++;
+        while (i > 0 && heap[(i - 1) / 2] < score) {
+            heap[i] = heap[(i - 1) / 2];
+            i = (i - 1) / 2;
+        }
+        heap[i] = score;
+        return;
+    }
+    if (score >= heap[0])
+        return;
 
-        for (int hour_idx = 0; hour_idx < app->auto_layout.time_samples; hour_idx++) {
-            float hour = 6.0f + (12.0f * hour_idx / (app->auto_layout.time_samples - 1));
-            app->sim_settings.hour = hour;
+    // Replace the top and sift down
+    i = 0;
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= *count)
+            break;
+        if (child + 1 < *count && heap[child + 1] > heap[child])
+            child++;
+        if (heap[child] <= score)
+            break;
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = score;
+}
 
-            float altitude, azimuth;
-            Vector3 sun_dir = CalculateSunDirection(&app->sim_settings, &altitude, &azimuth);
+// Candidate scoring shared by the job threads; best, best_count and rays hold one entry (or keep scores) per slot
+typedef struct {
+    const SimGeometry *geometry;
+    LayoutCandidate *candidates;
+    const SunSample *samples;
+    int sample_count;
+    bool draft;
+    int keep;
+    float *best;
+    int *best_count;
+    int *rays;
+} ScoreJob;
+
+// Each thread keeps its own heap of the best keep scores. Its top can only be at or above the overall keep-th
+// best, so rejecting against it never drops a candidate that belongs in the set; it just prunes a little later.
+// Settled scores are upper bounds, so the heap never holds a score better than the candidate's exact one.
+static void ScoreCandidateRange(void *ctx, int begin, int end, int slot) {
+    ScoreJob *job = (ScoreJob *)ctx;
+    float *best = &job->best[slot * job->keep];
+    int *best_count = &job->best_count[slot];
+    for (int i = begin; i < end; i++) {
+        LayoutCandidate *c = &job->candidates[i];
+        float bar = (*best_count == job->keep) ? best[0] : 2.0f;
+        c->occlusion_score = SimCore_OcclusionScore(job->geometry, c->position, c->normal, job->samples,
+                                                    job->sample_count, bar, job->draft, &job->rays[slot]);
+        OfferScore(best, best_count, job->keep, c->occlusion_score);
+    }
+}
 
-            if (altitude <= 0)
-                continue;
+static int CompareCandidates(const void *a, const void *b) {
+    float sa = ((const LayoutCandidate *)a)->occlusion_score;
+    float sb = ((const LayoutCandidate *)b)->occlusion_score;
+    return (sa > sb) - (sa < sb);
+}
 
-            total_samples++;
+// Sunniest candidates first according to a current exposure map, which scores are seeded with
+// (lower = sunnier) until they are traced. Returns false, leaving the order alone, without a map.
+static bool OrderCandidatesByExposure(AppState *app, LayoutCandidate *candidates, int count) {
+    for (int i = 0; i < count; i++) {
+        float prior = SampleInsolationPrior(app, candidates[i].position, candidates[i].normal);
+        if (prior < 0.0f)
+            return false;
+        candidates[i].occlusion_score = 1.0f - prior;
+    }
+    qsort(candidates, count, sizeof(LayoutCandidate), CompareCandidates);
+    return true;
+}
 
-            Vector3 rotated_sun_dir = {
-                sun_dir.x * cosf(-heading_rad) - sun_dir.z * sinf(-heading_rad),
-                sun_dir.y,
-                sun_dir.x * sinf(-heading_rad) + sun_dir.z * cosf(-heading_rad)
-            };
+// Whether any face of a panel can pass the angle and height tests in IsValidSurface
+static bool PanelMayHoldCells(AppState *app, const SurfacePanel *panel) {
+    float min_angle = asinf(Clampf(panel->min_ny, -1.0f, 1.0f)) * RAD2DEG;
+    float max_angle = asinf(Clampf(panel->max_ny, -1.0f, 1.0f)) * RAD2DEG;
+    if (max_angle < app->auto_layout.min_normal_angle || min_angle > app->auto_layout.max_normal_angle)
+        return false;
+
+    if (panel->max_y < 0.01f)
+        return false;
+
+    if (app->auto_layout.use_height_constraint) {
+        if (panel->max_y < app->auto_layout.min_height || panel->min_y > app->auto_layout.max_height)
+            return false;
+    }
+    return true;
+}
+
+// Append a candidate unless it crowds an earlier candidate or an existing cell
+static bool AddCandidate(AppState *app, LayoutCandidate *candidates, int *count, Vector3 position, Vector3 normal,
+                         float min_spacing) {
+    for (int c = 0; c < *count; c++) {
+        if (Vector3Distance(position, candidates[c].position) < min_spacing * 0.9f)
+            return false;
+    }
+
+    for (int c = 0; c < app->cell_count; c++) {
+        Vector3 existingPos = CellGetWorldPosition(app, &app->cells[c]);
+        if (Vector3Distance(position, existingPos) < min_spacing)
+            return false;
+    }
+
+    candidates[*count].position = position;
+    candidates[*count].normal = normal;
+    candidates[*count].tangent = (Vector3){0, 0, 0};
+    candidates[*count].occlusion_score = 0.0f;
+    candidates[*count].valid = true;
+    (*count)++;
+    return true;
+}
+
+// A layout grid: world XZ when panel < 0, otherwise the (u, v) frame of one surface panel
+typedef struct {
+    const SurfacePanels *panels;
+    int panel;
+} GridDomain;
+
+// Topmost surface under a grid point; panel grids only accept hits on their own panel
+static bool ProbeGridPoint(AppState *app, const GridDomain *grid, float a, float b, RayCollision *hit) {
+    if (grid->panel < 0) {
+        *hit = ProbeSurfaceBelow(app, a, b, NULL);
+        return hit->hit;
+    }
+
+    Vector3 q = SurfacePanels_ToWorld(grid->panels, grid->panel, a, b);
+    int triangle;
+    *hit = ProbeSurfaceBelow(app, q.x, q.z, &triangle);
+    return hit->hit && (triangle < 0 || grid->panels->tri_panel[triangle] == grid->panel);
+}
+
+// Whether any probe in [a0, a1] x [b0, b1] could pass the angle and height limits. Probes read the height map,
+// which answers every point of a texel from its top face plane, so every texel under the area is tested with
+// the plane's height range across it: a tile holding even one passing point is never rejected.
+static bool TileMayPassLimits(AppState *app, const GridDomain *grid, float a0, float a1, float b0, float b1) {
+    const HeightMap *hm = GetHeightMap(app);
+    if (!hm)
+        return true; // Probes fall back to raycasts; nothing to bound them with
+
+    float x0 = a0, x1 = a1, z0 = b0, z1 = b1;
+    if (grid->panel >= 0) {
+        // Footprint of the panel-plane rectangle: bounding box of its corners
+        x0 = z0 = FLT_MAX;
+        x1 = z1 = -FLT_MAX;
+        for (int k = 0; k < 4; k++) {
+            Vector3 q = SurfacePanels_ToWorld(grid->panels, grid->panel, (k & 1) ? a1 : a0, (k & 2) ? b1 : b0);
+            x0 = fminf(x0, q.x);
+            x1 = fmaxf(x1, q.x);
+            z0 = fminf(z0, q.z);
+            z1 = fmaxf(z1, q.z);
+        }
+    }
+
+    int i0 = (int)floorf((x0 - hm->min_x) / hm->texel);
+    int i1 = (int)floorf((x1 - hm->min_x) / hm->texel);
+    int j0 = (int)floorf((z0 - hm->min_z) / hm->texel);
+    int j1 = (int)floorf((z1 - hm->min_z) / hm->texel);
+    if (i1 < 0 || j1 < 0 || i0 >= hm->width || j0 >= hm->depth)
+        return false;
+    i0 = i0 < 0 ? 0 : i0;
+    j0 = j0 < 0 ? 0 : j0;
+    i1 = i1 >= hm->width ? hm->width - 1 : i1;
+    j1 = j1 >= hm->depth ? hm->depth - 1 : j1;
+
+    float min_y = 0.01f;
+    float max_y = FLT_MAX;
+    if (app->auto_layout.use_height_constraint) {
+        min_y = fmaxf(min_y, app->auto_layout.min_height);
+        max_y = app->auto_layout.max_height;
+    }
 
-            float facing = Vector3DotProduct(normal, rotated_sun_dir);
-            if (facing <= 0) {
-                occluded_count++;
+    for (int j = j0; j <= j1; j++) {
+        for (int i = i0; i <= i1; i++) {
+            int texel = j * hm->width + i;
+            if (hm->counts[texel] == 0)
                 continue;
+            const HeightMapSample *top = &hm->samples[texel * HEIGHT_MAP_LAYERS];
+            if (grid->panel >= 0 && (top->triangle >= grid->panels->tri_count ||
+                                     grid->panels->tri_panel[top->triangle] != grid->panel))
+                continue;
+            if (!PassesAngleLimits(app, top->normal))
+                continue;
+            // Height change along the face plane from the texel centre to its corners
+            float ny = fmaxf(fabsf(top->normal.y), 0.05f);
+            float rise = (fabsf(top->normal.x) + fabsf(top->normal.z)) / ny * hm->texel * 0.5f;
+            if (top->y + rise >= min_y && top->y - rise <= max_y)
+                return true;
+        }
+    }
+    return false;
+}
+
+// Coarse-to-fine scan of [min_a, max_a] x [min_b, max_b]. Tiles of COARSE_TILE_CELLS grid points are first
+// bounded against the angle and height limits from the height map; tiles where nothing can pass are skipped.
+// In the rest, each grid point tries a few sub-cell offsets until one passes full footprint validation.
+// Progress runs from progress_begin to progress_end across the scan.
+static void ScanGridDomain(AppState *app, const GridDomain *grid, float min_a, float max_a, float min_b,
+                           float max_b, float spacing, float min_spacing, LayoutCandidate *candidates, int *count,
+                           int *tiles_refined, int progress_begin, int progress_end) {
+    static const float offsets[][2] = {{0, 0}, {0.33f, 0}, {-0.33f, 0}, {0, 0.33f}, {0, -0.33f}};
+    float reach = 0.33f * spacing; // Largest sub-cell offset
+    float tile = spacing * COARSE_TILE_CELLS;
+    int tilesA = (int)((max_a - min_a) / tile) + 1;
+    int tilesB = (int)((max_b - min_b) / tile) + 1;
+
+    for (int ta = 0; ta < tilesA && *count < MAX_CANDIDATES; ta++) {
+        app->auto_layout_progress = progress_begin + ta * (progress_end - progress_begin) / tilesA;
+        for (int tb = 0; tb < tilesB && *count < MAX_CANDIDATES; tb++) {
+            float a0 = min_a + ta * tile;
+            float b0 = min_b + tb * tile;
+
+            // Every point the refinement below can probe, offsets included
+            float a1 = a0 + (COARSE_TILE_CELLS - 1) * spacing;
+            float b1 = b0 + (COARSE_TILE_CELLS - 1) * spacing;
+            if (!TileMayPassLimits(app, grid, a0 - reach, fminf(a1, max_a) + reach, b0 - reach,
+                                   fminf(b1, max_b) + reach))
+                continue;
+            (*tiles_refined)++;
+
+            for (int ga = 0; ga < COARSE_TILE_CELLS && *count < MAX_CANDIDATES; ga++) {
+                for (int gb = 0; gb < COARSE_TILE_CELLS && *count < MAX_CANDIDATES; gb++) {
+                    float a = a0 + ga * spacing;
+                    float b = b0 + gb * spacing;
+                    if (a > max_a || b > max_b)
+                        continue;
+
+                    for (int o = 0; o < (int)(sizeof(offsets) / sizeof(offsets[0])); o++) {
+                        RayCollision hit;
+                        if (!ProbeGridPoint(app, grid, a + offsets[o][0] * spacing, b + offsets[o][1] * spacing,
+                                            &hit))
+                            continue;
+                        if (!IsValidSurface(app, hit.point, hit.normal))
+                            continue;
+                        AddCandidate(app, candidates, count, hit.point, hit.normal, min_spacing);
+                        break;
+                    }
+                }
             }
+        }
+    }
+}
 
-            Ray ray;
-            ray.position = Vector3Add(position, Vector3Scale(normal, 0.01f));
-            ray.direction = rotated_sun_dir;
+// Flatten each usable panel into its plane, pack cell rectangles there and map them back onto the surface.
+// Projection onto the plane only shortens distances, so rectangles disjoint in the plane stay disjoint on it.
+static int PackPanelCandidates(AppState *app, const SurfacePanels *panels, LayoutCandidate *candidates,
+                               int max_candidates) {
+    CellPreset *preset = (CellPreset *)&CELL_PRESETS[app->selected_preset];
+    float texel = fminf(preset->width, preset->height) / PACK_TEXELS_PER_CELL;
+    float gap = fmaxf(preset->width, preset->height) * (MIN_CELL_DISTANCE_FACTOR - 1.0f);
+    float min_dist = fmaxf(preset->width, preset->height) * MIN_CELL_DISTANCE_FACTOR;
+
+    PackedRect *rects = (PackedRect *)malloc(max_candidates * sizeof(PackedRect));
+    int *owner = (int *)malloc(max_candidates * sizeof(int));
+    if (!rects || !owner) {
+        free(rects);
+        free(owner);
+        return 0;
+    }
 
-            RayCollision hit = GetRayCollisionMesh(ray, app->vehicle_mesh, app->vehicle_model.transform);
-            if (hit.hit && hit.distance > 0.02f) {
-                occluded_count++;
+    float usable_area = 0.0f;
+    for (int p = 0; p < panels->panel_count; p++) {
+        if (PanelMayHoldCells(app, &panels->panels[p]))
+            usable_area += panels->panels[p].area;
+    }
+
+    int count = 0;
+    float scanned_area = 0.0f;
+    for (int p = 0; p < panels->panel_count && count < max_candidates; p++) {
+        const SurfacePanel *panel = &panels->panels[p];
+        if (!PanelMayHoldCells(app, panel))
+            continue;
+
+        PackDomain domain;
+        if (!CellPacker_InitDomain(&domain, panel->min_u, panel->max_u, panel->min_v, panel->max_v, texel))
+            continue;
+
+        // Rasterise where this panel can carry cell area: visible along its normal, within limits, with headroom
+        for (int r = 0; r < domain.rows; r++) {
+            for (int c = 0; c < domain.cols; c++) {
+                float u, v;
+                RayCollision hit;
+                CellPacker_TexelCenter(&domain, c, r, &u, &v);
+                domain.usable[r * domain.cols + c] =
+                    ProjectOntoPanel(app, panels, p, u, v, &hit) && PassesSurfaceLimits(app, hit.point, hit.normal) &&
+                    ProbeClearance(app, Vector3Add(hit.point, (Vector3){0, 0.01f, 0})) >= 0.05f;
+            }
+        }
+
+        int packed = CellPacker_Pack(&domain, preset->width, preset->height, gap, app->auto_layout.pack_orientation,
+                                     rects, max_candidates - count);
+        for (int i = 0; i < packed; i++) {
+            RayCollision hit;
+            if (!ProjectOntoPanel(app, panels, p, rects[i].u, rects[i].v, &hit))
+                continue;
+
+            // Rectangles are only guaranteed apart within a panel; across panel seams and existing cells use distance
+            bool too_close = false;
+            for (int c = 0; c < count && !too_close; c++) {
+                too_close = owner[c] != p && Vector3Distance(hit.point, candidates[c].position) < min_dist;
+            }
+            for (int c = 0; c < app->cell_count && !too_close; c++) {
+                too_close = Vector3Distance(hit.point, CellGetWorldPosition(app, &app->cells[c])) < min_dist;
             }
+            if (too_close)
+                continue;
+
+            candidates[count].position = hit.point;
+            candidates[count].normal = hit.normal;
+            candidates[count].tangent = rects[i].rotated ? panel->axis_v : panel->axis_u;
+            candidates[count].occlusion_score = 0.0f;
+            candidates[count].valid = true;
+            owner[count] = p;
+            count++;
         }
+
+        CellPacker_FreeDomain(&domain);
+        scanned_area += panel->area;
+        app->auto_layout_progress = (int)(scanned_area * 30 / usable_area);
     }
 
-    app->sim_settings = original;
-    return (total_samples > 0) ? (float)occluded_count / total_samples : 1.0f;
+    free(rects);
+    free(owner);
+    return count;
+}
+
+typedef struct {
+    float y;
+    float area;
+} HeightSample;
+
+static int CompareHeightSamples(const void *a, const void *b) {
+    float ya = ((const HeightSample *)a)->y;
+    float yb = ((const HeightSample *)b)->y;
+    return (ya > yb) - (ya < yb);
 }
 
 void AutoDetectHeightRange(AppState *app) {
     if (!app->mesh_loaded)
         return;
 
-    Mesh *mesh = &app->vehicle_mesh;
-    Matrix transform = app->vehicle_model.transform;
-    float *vertices = mesh->vertices;
-    unsigned short *indices = mesh->indices;
-    int triangleCount = mesh->triangleCount;
-
     float tolerance = app->auto_layout.height_tolerance;
 
-    float *heights = (float *)malloc(MAX_HEIGHT_SAMPLES * sizeof(float));
+    HeightSample *heights = (HeightSample *)malloc(MAX_HEIGHT_SAMPLES * sizeof(HeightSample));
     int heightCount = 0;
 
-    int step = (triangleCount > MAX_HEIGHT_SAMPLES) ? triangleCount / MAX_HEIGHT_SAMPLES : 1;
+    const SurfacePanels *panels = GetSurfacePanels(app);
+    if (panels) {
+        // Upward faces of upward panels, weighted by area so a few large panels outvote many small details
+        int upward = 0;
+        for (int p = 0; p < panels->panel_count; p++) {
+            if (panels->panels[p].max_ny >= MIN_UPWARD_NORMAL)
+                upward += panels->panels[p].tri_count;
+        }
+        int step = (upward > MAX_HEIGHT_SAMPLES) ? upward / MAX_HEIGHT_SAMPLES + 1 : 1;
+        int seen = 0;
 
-    for (int i = 0; i < triangleCount && heightCount < MAX_HEIGHT_SAMPLES; i += step) {
-        int idx0, idx1, idx2;
-        if (indices) {
-            idx0 = indices[i * 3 + 0];
-            idx1 = indices[i * 3 + 1];
-            idx2 = indices[i * 3 + 2];
-        } else {
-            idx0 = i * 3 + 0;
-            idx1 = i * 3 + 1;
-            idx2 = i * 3 + 2;
+        for (int p = 0; p < panels->panel_count; p++) {
+            const SurfacePanel *panel = &panels->panels[p];
+            if (panel->max_ny < MIN_UPWARD_NORMAL)
+                continue;
+            for (int i = panel->first; i < panel->first + panel->tri_count; i++, seen++) {
+                int t = panels->tri_order[i];
+                if (seen % step != 0 || panels->tri_normals[t].y < MIN_UPWARD_NORMAL ||
+                    heightCount >= MAX_HEIGHT_SAMPLES)
+                    continue;
+                heights[heightCount].y = panels->tri_centers[t].y;
+                heights[heightCount].area = panels->tri_areas[t];
+                heightCount++;
+            }
         }
+    } else {
+        Mesh *mesh = &app->vehicle_mesh;
+        Matrix transform = app->vehicle_model.transform;
+        float *vertices = mesh->vertices;
+        unsigned short *indices = mesh->indices;
+        int triangleCount = mesh->triangleCount;
 
-        Vector3 v0 = {vertices[idx0 * 3], vertices[idx0 * 3 + 1], vertices[idx0 * 3 + 2]};
-        Vector3 v1 = {vertices[idx1 * 3], vertices[idx1 * 3 + 1], vertices[idx1 * 3 + 2]};
-        Vector3 v2 = {vertices[idx2 * 3], vertices[idx2 * 3 + 1], vertices[idx2 * 3 + 2]};
+        int step = (triangleCount > MAX_HEIGHT_SAMPLES) ? triangleCount / MAX_HEIGHT_SAMPLES : 1;
 
-        v0 = Vector3Transform(v0, transform);
-        v1 = Vector3Transform(v1, transform);
-        v2 = Vector3Transform(v2, transform);
+        for (int i = 0; i < triangleCount && heightCount < MAX_HEIGHT_SAMPLES; i += step) {
+            int idx0, idx1, idx2;
+            if (indices) {
+                idx0 = indices[i * 3 + 0];
+                idx1 = indices[i * 3 + 1];
+                idx2 = indices[i * 3 + 2];
+            } else {
+                idx0 = i * 3 + 0;
+                idx1 = i * 3 + 1;
+                idx2 = i * 3 + 2;
+            }
 
-        Vector3 edge1 = Vector3Subtract(v1, v0);
-        Vector3 edge2 = Vector3Subtract(v2, v0);
-        Vector3 normal = Vector3Normalize(Vector3CrossProduct(edge1, edge2));
+            Vector3 v0 = {vertices[idx0 * 3], vertices[idx0 * 3 + 1], vertices[idx0 * 3 + 2]};
+            Vector3 v1 = {vertices[idx1 * 3], vertices[idx1 * 3 + 1], vertices[idx1 * 3 + 2]};
+            Vector3 v2 = {vertices[idx2 * 3], vertices[idx2 * 3 + 1], vertices[idx2 * 3 + 2]};
 
-        if (normal.y < MIN_UPWARD_NORMAL)
-            continue;
+            v0 = Vector3Transform(v0, transform);
+            v1 = Vector3Transform(v1, transform);
+            v2 = Vector3Transform(v2, transform);
+
+            Vector3 edge1 = Vector3Subtract(v1, v0);
+            Vector3 edge2 = Vector3Subtract(v2, v0);
+            Vector3 cross = Vector3CrossProduct(edge1, edge2);
+            Vector3 normal = Vector3Normalize(cross);
 
-        float center_y = (v0.y + v1.y + v2.y) / 3.0f;
-        heights[heightCount++] = center_y;
+            if (normal.y < MIN_UPWARD_NORMAL)
+                continue;
+
+            heights[heightCount].y = (v0.y + v1.y + v2.y) / 3.0f;
+            heights[heightCount].area = 0.5f * Vector3Length(cross);
+            heightCount++;
+        }
     }
 
     if (heightCount == 0) {
@@ -252,36 +602,29 @@ void AutoDetectHeightRange(AppState *app) {
         return;
     }
 
-    // Sort heights
-    for (int i = 0; i < heightCount - 1; i++) {
-        for (int j = i + 1; j < heightCount; j++) {
-            if (heights[j] < heights[i]) {
-                float temp = heights[i];
-                heights[i] = heights[j];
-                heights[j] = temp;
-            }
-        }
-    }
+    qsort(heights, heightCount, sizeof(HeightSample), CompareHeightSamples);
 
-    // Sliding window to find best height range
-    int bestCount = 0;
-    float bestMinY = heights[0];
-    float bestMaxY = heights[0] + tolerance;
+    // Sliding window to find the height band holding the most upward surface area
+    float bestArea = -1.0f;
+    float bestMinY = heights[0].y;
+    float bestMaxY = heights[0].y + tolerance;
+    float windowArea = 0.0f;
 
-    for (int i = 0; i < heightCount; i++) {
-        float windowMin = heights[i];
+    for (int i = 0, j = 0; i < heightCount; i++) {
+        float windowMin = heights[i].y;
         float windowMax = windowMin + tolerance;
 
-        int count = 0;
-        for (int j = i; j < heightCount && heights[j] <= windowMax; j++) {
-            count++;
+        while (j < heightCount && heights[j].y <= windowMax) {
+            windowArea += heights[j].area;
+            j++;
         }
 
-        if (count > bestCount) {
-            bestCount = count;
+        if (windowArea > bestArea) {
+            bestArea = windowArea;
             bestMinY = windowMin;
             bestMaxY = windowMax;
         }
+        windowArea -= heights[i].area;
     }
 
     app->auto_layout.min_height = bestMinY;
@@ -289,7 +632,7 @@ void AutoDetectHeightRange(AppState *app) {
 
     free(heights);
 
-    SetStatus(app, "Auto-detected height: %.2f - %.2f m (%d surfaces)", bestMinY, bestMaxY, bestCount);
+    SetStatus(app, "Auto-detected height: %.2f - %.2f m", bestMinY, bestMaxY);
 }
 
 int RunAutoLayout(AppState *app) {
@@ -328,7 +671,41 @@ int RunAutoLayout(AppState *app) {
 
     float min_spacing = grid_spacing;
 
-    if (app->auto_layout.use_grid_layout) {
+    const SurfacePanels *panels = GetSurfacePanels(app);
+
+    if (panels && app->auto_layout.conform_packing) {
+        SetStatus(app, "Auto-layout: packing %d panels...", panels->panel_count);
+        candidate_count = PackPanelCandidates(app, panels, candidates, MAX_CANDIDATES);
+    } else if (panels && app->auto_layout.use_grid_layout) {
+        // Grid each usable panel in its own plane, so the scan scales with surface area, not the XZ footprint
+        int usable = 0;
+        float usable_area = 0.0f;
+        for (int p = 0; p < panels->panel_count; p++) {
+            if (PanelMayHoldCells(app, &panels->panels[p])) {
+                usable++;
+                usable_area += panels->panels[p].area;
+            }
+        }
+        SetStatus(app, "Auto-layout: scanning %d of %d panels (%.1f m²)...", usable, panels->panel_count,
+                  usable_area);
+
+        int tiles_refined = 0;
+        float scanned_area = 0.0f;
+        for (int p = 0; p < panels->panel_count && candidate_count < MAX_CANDIDATES; p++) {
+            const SurfacePanel *panel = &panels->panels[p];
+            if (!PanelMayHoldCells(app, panel))
+                continue;
+
+            GridDomain grid = {panels, p};
+            int progress_begin = (int)(scanned_area * 30 / usable_area);
+            scanned_area += panel->area;
+            int progress_end = (int)(scanned_area * 30 / usable_area);
+            ScanGridDomain(app, &grid, panel->min_u, panel->max_u, panel->min_v, panel->max_v, grid_spacing,
+                           min_spacing, candidates, &candidate_count, &tiles_refined, progress_begin, progress_end);
+            app->auto_layout_progress = progress_end;
+        }
+        TraceLog(LOG_INFO, "Auto-layout: refined %d tiles across %d panels", tiles_refined, usable);
+    } else if (app->auto_layout.use_grid_layout) {
         float minX = app->mesh_bounds.min.x;
         float maxX = app->mesh_bounds.max.x;
         float minZ = app->mesh_bounds.min.z;
@@ -336,67 +713,27 @@ int RunAutoLayout(AppState *app) {
 
         int gridX = (int)((maxX - minX) / grid_spacing) + 1;
         int gridZ = (int)((maxZ - minZ) / grid_spacing) + 1;
-        int totalGridPoints = gridX * gridZ;
         SetStatus(app, "Auto-layout: scanning %dx%d grid...", gridX, gridZ);
 
-        int processed = 0;
-        for (int gx = 0; gx < gridX && candidate_count < MAX_CANDIDATES; gx++) {
-            for (int gz = 0; gz < gridZ && candidate_count < MAX_CANDIDATES; gz++) {
-                float x = minX + gx * grid_spacing;
-                float z = minZ + gz * grid_spacing;
-
-                Ray ray;
-                ray.position = (Vector3){x, app->mesh_bounds.max.y + 1.0f, z};
-                ray.direction = (Vector3){0, -1, 0};
-
-                RayCollision hit = GetRayCollisionMesh(ray, *mesh, transform);
-                if (!hit.hit)
-                    continue;
-
-                Vector3 position = hit.point;
-                Vector3 normal = hit.normal;
-
-                if (!IsValidSurface(app, position, normal))
-                    continue;
-
-                bool too_close = false;
-                for (int c = 0; c < candidate_count; c++) {
-                    if (Vector3Distance(position, candidates[c].position) < min_spacing * 0.9f) {
-                        too_close = true;
-                        break;
-                    }
-                }
-                if (too_close)
-                    continue;
-
-                for (int c = 0; c < app->cell_count; c++) {
-                    Vector3 existingPos = CellGetWorldPosition(app, &app->cells[c]);
-                    if (Vector3Distance(position, existingPos) < min_spacing) {
-                        too_close = true;
-                        break;
-                    }
-                }
-                if (too_close)
-                    continue;
-
-                candidates[candidate_count].position = position;
-                candidates[candidate_count].normal = normal;
-                candidates[candidate_count].occlusion_score = 0.0f;
-                candidates[candidate_count].valid = true;
-                candidate_count++;
-
-                processed++;
-                if (processed % 100 == 0) {
-                    app->auto_layout_progress = (processed * 30) / totalGridPoints;
-                }
-            }
-        }
+        int tiles_refined = 0;
+        GridDomain grid = {NULL, -1};
+        ScanGridDomain(app, &grid, minX, maxX, minZ, maxZ, grid_spacing, min_spacing, candidates, &candidate_count,
+                       &tiles_refined, 0, 30);
+        TraceLog(LOG_INFO, "Auto-layout: refined %d tiles of the %dx%d grid", tiles_refined, gridX, gridZ);
+        app->auto_layout_progress = 30;
     } else {
         float *vertices = mesh->vertices;
         unsigned short *indices = mesh->indices;
         int triangleCount = mesh->triangleCount;
 
         for (int i = 0; i < triangleCount && candidate_count < MAX_CANDIDATES; i++) {
+            // Whole panels outside the angle and height limits are rejected without touching their faces
+            if (panels && i < panels->tri_count) {
+                int p = panels->tri_panel[i];
+                if (p < 0 || !PanelMayHoldCells(app, &panels->panels[p]))
+                    continue;
+            }
+
             int idx0, idx1, idx2;
             if (indices) {
                 idx0 = indices[i * 3 + 0];
@@ -451,6 +788,7 @@ int RunAutoLayout(AppState *app) {
 
             candidates[candidate_count].position = center;
             candidates[candidate_count].normal = normal;
+            candidates[candidate_count].tangent = (Vector3){0, 0, 0};
             candidates[candidate_count].occlusion_score = 0.0f;
             candidates[candidate_count].valid = true;
             candidate_count++;
@@ -461,35 +799,72 @@ int RunAutoLayout(AppState *app) {
 
     SetStatus(app, "Auto-layout: scoring %d candidates...", candidate_count);
 
+    // Scoring the likely winners first fills the keep-th bar early, so the rest are rejected after fewer rays;
+    // without occlusion scoring the exposure order is the ranking
+    if (OrderCandidatesByExposure(app, candidates, candidate_count))
+        TraceLog(LOG_INFO, "Auto-layout: candidates ordered by the %s exposure map",
+                 app->insolation.annual ? "annual" : "daily");
+
     if (app->auto_layout.optimize_occlusion && candidate_count > 0) {
-        for (int i = 0; i < candidate_count; i++) {
-            candidates[i].occlusion_score = CalculateOcclusionScore(app, candidates[i].position, candidates[i].normal);
-            app->auto_layout_progress = 30 + (i * 50) / candidate_count;
+        if (app->sim_settings.draft_shading && !EnsureDraftOccluder(app))
+            TraceLog(LOG_WARNING, "Draft occluder unavailable, scoring against the full mesh");
+
+        // Only the best few times target_cells can be placed, so candidates that cannot beat the current
+        // keep-th best score stop scoring as soon as that is certain
+        int keep = target_cells * OCCLUSION_KEEP_FACTOR;
+        if (keep < 1)
+            keep = 1;
+        int slots = JobSystem_SlotCount();
+        SunSample *samples = (SunSample *)malloc(OCCLUSION_HEADINGS * app->auto_layout.time_samples *
+                                                 sizeof(SunSample));
+        float *best = (float *)malloc(slots * keep * sizeof(float));
+        int *best_count = (int *)calloc(slots, sizeof(int));
+        int *rays = (int *)calloc(slots, sizeof(int));
+        if (samples && best && best_count && rays) {
+            SimGeometry geometry = GetSimGeometry(app);
+            ScoreJob job = {&geometry, candidates, samples, 0, false, keep, best, best_count, rays};
+            job.draft = app->sim_settings.draft_shading && app->draft_bvh.nodes;
+            job.sample_count = BuildScoreSamples(app, samples);
+            JobSystem_ParallelFor(candidate_count, OCCLUSION_SCORE_GRAIN, ScoreCandidateRange, &job, NULL);
+            app->auto_layout_progress = 80;
+
+            int total_rays = 0;
+            for (int s = 0; s < slots; s++) {
+                total_rays += rays[s];
+            }
+            TraceLog(LOG_INFO, "Auto-layout: scored %d candidates on %d threads with %d of %d possible rays",
+                     candidate_count, JobSystem_WorkerCount() + 1, total_rays, candidate_count * job.sample_count);
+        } else {
+            for (int i = 0; i < candidate_count; i++) {
+                candidates[i].occlusion_score = CalculateOcclusionScore(app, candidates[i].position,
+                                                                        candidates[i].normal);
+                app->auto_layout_progress = 30 + (i * 50) / candidate_count;
+            }
         }
+        free(samples);
+        free(best);
+        free(best_count);
+        free(rays);
 
         // Sort by occlusion score (lowest first)
-        for (int i = 0; i < candidate_count - 1; i++) {
-            for (int j = i + 1; j < candidate_count; j++) {
-                if (candidates[j].occlusion_score < candidates[i].occlusion_score) {
-                    LayoutCandidate temp = candidates[i];
-                    candidates[i] = candidates[j];
-                    candidates[j] = temp;
-                }
-            }
-        }
+        qsort(candidates, candidate_count, sizeof(LayoutCandidate), CompareCandidates);
     }
 
-    // Place cells at best positions
+    // Place cells at best positions, undone as one step
     int placed = 0;
+    BeginEdit(app, "Auto-layout");
     for (int i = 0; i < candidate_count && placed < target_cells; i++) {
         if (!candidates[i].valid)
             continue;
 
-        int id = PlaceCell(app, candidates[i].position, candidates[i].normal);
+        // Packed candidates were kept apart when they were generated
+        bool packed = Vector3LengthSqr(candidates[i].tangent) > 0;
+        int id = packed ? PlaceCellOriented(app, candidates[i].position, candidates[i].normal, candidates[i].tangent)
+                        : PlaceCell(app, candidates[i].position, candidates[i].normal);
         if (id >= 0) {
             placed++;
 
-            for (int j = i + 1; j < candidate_count; j++) {
+            for (int j = i + 1; j < candidate_count && !packed; j++) {
                 if (Vector3Distance(candidates[i].position, candidates[j].position) < min_spacing) {
                     candidates[j].valid = false;
                 }
@@ -500,6 +875,7 @@ int RunAutoLayout(AppState *app) {
             app->auto_layout_progress = 80 + (placed * 20) / target_cells;
         }
     }
+    EndEdit(app);
 
     free(candidates);
 
@@ -517,14 +893,50 @@ void DrawAutoLayoutPreview(AppState *app) {
     if (!app->mesh_loaded)
         return;
 
+    Color validColor = (Color){0, 200, 0, 100};
+
+    const SurfacePanels *panels = GetSurfacePanels(app);
+    if (panels) {
+        // Spend the sample budget only on panels that can hold cells
+        int usable = 0;
+        for (int p = 0; p < panels->panel_count; p++) {
+            if (PanelMayHoldCells(app, &panels->panels[p]))
+                usable += panels->panels[p].tri_count;
+        }
+        int step = (usable > 2000) ? usable / 500 : 1;
+        int seen = 0;
+
+        for (int p = 0; p < panels->panel_count; p++) {
+            const SurfacePanel *panel = &panels->panels[p];
+            if (!PanelMayHoldCells(app, panel))
+                continue;
+            for (int i = panel->first; i < panel->first + panel->tri_count; i++, seen++) {
+                if (seen % step != 0)
+                    continue;
+                int t = panels->tri_order[i];
+                Vector3 normal = panels->tri_normals[t];
+                if (!IsValidSurface(app, panels->tri_centers[t], normal))
+                    continue;
+
+                const int *tv = &app->vehicle_topology.tri_vertices[t * 3];
+                Vector3 offset = Vector3Scale(normal, 0.003f);
+                Vector3 sv[3];
+                for (int k = 0; k < 3; k++) {
+                    sv[k] = Vector3Add(Vector3Transform(app->vehicle_topology.positions[tv[k]],
+                                                        app->vehicle_model.transform), offset);
+                }
+                DrawTriangle3D(sv[0], sv[1], sv[2], validColor);
+            }
+        }
+        return;
+    }
+
     Mesh *mesh = &app->vehicle_mesh;
     Matrix transform = app->vehicle_model.transform;
     float *vertices = mesh->vertices;
     unsigned short *indices = mesh->indices;
     int triangleCount = mesh->triangleCount;
 
-    Color validColor = (Color){0, 200, 0, 100};
-
     int step = (triangleCount > 2000) ? triangleCount / 500 : 1;
 
     for (int i = 0; i < triangleCount; i += step) {
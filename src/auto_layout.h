@@ -7,5 +7,10 @@
 
 #define MAX_CANDIDATES 10000
 #define MAX_HEIGHT_SAMPLES 5000
+#define OCCLUSION_HEADINGS 10 // Vehicle headings sampled per time of day when scoring
+#define OCCLUSION_KEEP_FACTOR 2 // Candidates ranked exactly, as a multiple of the cells to place
+#define OCCLUSION_SCORE_GRAIN 32 // Candidates per job when scoring in parallel
+#define COARSE_TILE_CELLS 4 // Grid points per side of a coarse search tile
+#define PACK_TEXELS_PER_CELL 10 // Packing raster resolution across the short side of a cell
 
 #endif // AUTO_LAYOUT_H
@@ -0,0 +1,152 @@
+/*
+ * Greedy rectangle packing on a rasterised surface domain
+ */
+
+#include "cell_packer.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PACK_ROW_PHASES 4   // Row offsets tried per orientation (fractions of the row pitch)
+
+//------------------------------------------------------------------------------
+// Domain
+//------------------------------------------------------------------------------
+bool CellPacker_InitDomain(PackDomain *domain, float min_u, float max_u, float min_v, float max_v, float texel) {
+    memset(domain, 0, sizeof(PackDomain));
+    if (texel <= 0 || max_u < min_u || max_v < min_v)
+        return false;
+
+    domain->min_u = min_u;
+    domain->min_v = min_v;
+    domain->texel = texel;
+    domain->cols = (int) ceilf((max_u - min_u) / texel) + 1;
+    domain->rows = (int) ceilf((max_v - min_v) / texel) + 1;
+    domain->usable = (unsigned char *) calloc((size_t) domain->cols * domain->rows, 1);
+    return domain->usable != NULL;
+}
+
+void CellPacker_FreeDomain(PackDomain *domain) {
+    free(domain->usable);
+    memset(domain, 0, sizeof(PackDomain));
+}
+
+void CellPacker_TexelCenter(const PackDomain *domain, int col, int row, float *u, float *v) {
+    *u = domain->min_u + (col + 0.5f) * domain->texel;
+    *v = domain->min_v + (row + 0.5f) * domain->texel;
+}
+
+//------------------------------------------------------------------------------
+// Packing
+//------------------------------------------------------------------------------
+
+// Unusable texels in [c0, c1) x [r0, r1) from a (cols + 1) x (rows + 1) summed-area table
+static int BlockedCount(const int *sat, int stride, int c0, int r0, int c1, int r1) {
+    return sat[r1 * stride + c1] - sat[r0 * stride + c1] - sat[r1 * stride + c0] + sat[r0 * stride + c0];
+}
+
+// Whether a size_u x size_v footprint with its low corner at (u, v) covers only usable texels
+static bool Fits(const PackDomain *domain, const int *sat, float u, float v, float size_u, float size_v) {
+    int c0 = (int) floorf((u - domain->min_u) / domain->texel + 1e-4f);
+    int r0 = (int) floorf((v - domain->min_v) / domain->texel + 1e-4f);
+    int c1 = (int) ceilf((u + size_u - domain->min_u) / domain->texel - 1e-4f);
+    int r1 = (int) ceilf((v + size_v - domain->min_v) / domain->texel - 1e-4f);
+    if (c0 < 0 || r0 < 0 || c1 > domain->cols || r1 > domain->rows)
+        return false;
+    return BlockedCount(sat, domain->cols + 1, c0, r0, c1, r1) == 0;
+}
+
+// Rows at a fixed pitch starting from v0; each row slides along u to wherever the footprint fits
+static int PackRows(const PackDomain *domain, const int *sat, float width, float height, float gap, bool rotated,
+                    float v0, PackedRect *out, int max_out) {
+    float size_u = rotated ? height : width;
+    float size_v = rotated ? width : height;
+    float max_u = domain->min_u + domain->cols * domain->texel;
+    float max_v = domain->min_v + domain->rows * domain->texel;
+
+    int count = 0;
+    for (float v = v0; v + size_v <= max_v && count < max_out; v += size_v + gap) {
+        float u = domain->min_u;
+        while (u + size_u <= max_u && count < max_out) {
+            if (Fits(domain, sat, u, v, size_u, size_v)) {
+                out[count].u = u + size_u * 0.5f;
+                out[count].v = v + size_v * 0.5f;
+                out[count].rotated = rotated;
+                count++;
+                u += size_u + gap;
+            } else {
+                // Slide to the next texel boundary
+                u = domain->min_u + (floorf((u - domain->min_u) / domain->texel + 1e-4f) + 1.0f) * domain->texel;
+            }
+        }
+    }
+    return count;
+}
+
+// Best of PACK_ROW_PHASES row offsets for one orientation, written to out
+static int PackOriented(const PackDomain *domain, const int *sat, float width, float height, float gap, bool rotated,
+                        PackedRect *out, PackedRect *scratch, int max_out) {
+    float pitch_v = (rotated ? width : height) + gap;
+    int best = 0;
+    for (int phase = 0; phase < PACK_ROW_PHASES; phase++) {
+        float v0 = domain->min_v + pitch_v * phase / PACK_ROW_PHASES;
+        int count = PackRows(domain, sat, width, height, gap, rotated, v0, scratch, max_out);
+        if (count > best) {
+            memcpy(out, scratch, count * sizeof(PackedRect));
+            best = count;
+        }
+    }
+    return best;
+}
+
+int CellPacker_Pack(const PackDomain *domain, float width, float height, float gap, PackOrientation orientation,
+                    PackedRect *out, int max_out) {
+    if (!domain->usable || max_out <= 0 || width <= 0 || height <= 0)
+        return 0;
+
+    int cols = domain->cols, rows = domain->rows, stride = cols + 1;
+    int *sat = (int *) calloc((size_t) stride * (rows + 1), sizeof(int));
+    PackedRect *scratch = (PackedRect *) malloc(max_out * sizeof(PackedRect));
+    PackedRect *across = (PackedRect *) malloc(max_out * sizeof(PackedRect));
+    if (!sat || !scratch || !across) {
+        free(sat);
+        free(scratch);
+        free(across);
+        return 0;
+    }
+
+    // Texels are sampled at their centres, so a texel only counts as usable if its neighbours are too;
+    // that keeps footprints from hanging half a texel past the region's edge
+    for (int r = 0; r < rows; r++) {
+        int run = 0;
+        for (int c = 0; c < cols; c++) {
+            bool usable = true;
+            for (int dr = -1; dr <= 1 && usable; dr++) {
+                for (int dc = -1; dc <= 1 && usable; dc++) {
+                    int nr = r + dr, nc = c + dc;
+                    usable = nr >= 0 && nc >= 0 && nr < rows && nc < cols && domain->usable[nr * cols + nc];
+                }
+            }
+            run += usable ? 0 : 1;
+            sat[(r + 1) * stride + c + 1] = sat[r * stride + c + 1] + run;
+        }
+    }
+
+    int count;
+    if (orientation == PACK_ORIENT_BEST && width != height) {
+        count = PackOriented(domain, sat, width, height, gap, false, out, scratch, max_out);
+        int across_count = PackOriented(domain, sat, width, height, gap, true, across, scratch, max_out);
+        if (across_count > count) {
+            memcpy(out, across, across_count * sizeof(PackedRect));
+            count = across_count;
+        }
+    } else {
+        count = PackOriented(domain, sat, width, height, gap, orientation == PACK_ORIENT_ACROSS, out, scratch,
+                             max_out);
+    }
+
+    free(sat);
+    free(scratch);
+    free(across);
+    return count;
+}
@@ -0,0 +1,51 @@
+#ifndef CELL_PACKER_H
+#define CELL_PACKER_H
+
+#include <stdbool.h>
+
+//------------------------------------------------------------------------------
+// Rectangle packing on a rasterised 2D domain
+//------------------------------------------------------------------------------
+// The caller flattens a surface region into a (u, v) frame and marks which
+// texels can carry a cell. Rectangles are then placed greedily row by row,
+// each row sliding to the first texel where the whole footprint fits, so the
+// layout follows the region's outline instead of a fixed global grid. The
+// usable mask is read through a summed-area table, so every fit test is O(1)
+// plus a scan of the occupied strip.
+
+typedef enum {
+    PACK_ORIENT_ALONG = 0,  // Rectangle width along u
+    PACK_ORIENT_ACROSS,     // Rectangle width along v
+    PACK_ORIENT_BEST        // Whichever of the two fits more on this domain
+} PackOrientation;
+
+typedef struct {
+    float u, v;         // Rectangle centre in the domain frame
+    bool rotated;       // Width runs along v
+} PackedRect;
+
+typedef struct {
+    float min_u, min_v; // Frame position of texel (0, 0)'s corner
+    float texel;        // Texel edge length
+    int cols, rows;     // Texels along u and v
+    unsigned char *usable; // cols * rows, nonzero where a cell may cover the texel
+} PackDomain;
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+
+// Allocate a domain covering [min_u, max_u] x [min_v, max_v] with every texel unusable
+bool CellPacker_InitDomain(PackDomain *domain, float min_u, float max_u, float min_v, float max_v, float texel);
+
+// Release memory (safe on an uninitialised domain)
+void CellPacker_FreeDomain(PackDomain *domain);
+
+// Frame position of a texel centre
+void CellPacker_TexelCenter(const PackDomain *domain, int col, int row, float *u, float *v);
+
+// Pack width x height rectangles at least gap apart; returns the number written to out
+int CellPacker_Pack(const PackDomain *domain, float width, float height, float gap, PackOrientation orientation,
+                    PackedRect *out, int max_out);
+
+#endif // CELL_PACKER_H
@@ -0,0 +1,260 @@
+/*
+ * Streaming per-sample export (writer thread + bounded, non-blocking batch queue)
+ */
+
+#include "export_stream.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <process.h>
+#else
+#include <pthread.h>
+#endif
+
+//------------------------------------------------------------------------------
+// Platform threading
+//------------------------------------------------------------------------------
+#ifdef _WIN32
+typedef CRITICAL_SECTION ExportMutex;
+typedef CONDITION_VARIABLE ExportCond;
+#define MutexInit(m) InitializeCriticalSection(m)
+#define MutexDestroy(m) DeleteCriticalSection(m)
+#define MutexLock(m) EnterCriticalSection(m)
+#define MutexUnlock(m) LeaveCriticalSection(m)
+#define CondInit(c) InitializeConditionVariable(c)
+#define CondDestroy(c) ((void)(c))
+#define CondWait(c, m) SleepConditionVariableCS(c, m, INFINITE)
+#define CondSignal(c) WakeConditionVariable(c)
+#else
+typedef pthread_mutex_t ExportMutex;
+typedef pthread_cond_t ExportCond;
+#define MutexInit(m) pthread_mutex_init(m, NULL)
+#define MutexDestroy(m) pthread_mutex_destroy(m)
+#define MutexLock(m) pthread_mutex_lock(m)
+#define MutexUnlock(m) pthread_mutex_unlock(m)
+#define CondInit(c) pthread_cond_init(c, NULL)
+#define CondDestroy(c) pthread_cond_destroy(c)
+#define CondWait(c, m) pthread_cond_wait(c, m)
+#define CondSignal(c) pthread_cond_signal(c)
+#endif
+
+typedef struct {
+    ExportRecord records[EXPORT_BATCH_RECORDS];
+    int count;
+} ExportBatch;
+
+struct ExportStream {
+    FILE *file;
+    ExportLayout layout;
+    ExportBatch *batches[EXPORT_MAX_BATCHES]; // Pool, grown on demand
+    int batch_count;
+    ExportBatch *current;   // Batch being filled by the producer
+
+    // Ring buffers of batch pointers, guarded by lock
+    ExportBatch *full[EXPORT_MAX_BATCHES];
+    int full_head, full_count;
+    ExportBatch *free_list[EXPORT_MAX_BATCHES];
+    int free_count;
+    bool closing;
+
+    ExportMutex lock;
+    ExportCond has_full;    // Writer waits for work
+
+    ExportStreamStats stats;
+
+#ifdef _WIN32
+    HANDLE thread;
+#else
+    pthread_t thread;
+#endif
+};
+
+//------------------------------------------------------------------------------
+// Writer thread
+//------------------------------------------------------------------------------
+static bool WriteBatch(FILE *file, ExportLayout layout, const ExportBatch *batch) {
+    for (int i = 0; i < batch->count; i++) {
+        const ExportRecord *r = &batch->records[i];
+        int written = layout == EXPORT_LAYOUT_ANNUAL
+                              ? fprintf(file, "%d,%.4f,%.2f,%.2f,%d,%.4f,%.4f\n", r->bin, r->hours, r->elevation_deg,
+                                        r->azimuth_deg, r->string_id, r->power_w, r->current_a)
+                              : fprintf(file, "%.4f,%.1f,%d,%.4f,%.4f\n", r->hour, r->heading_deg, r->string_id,
+                                        r->power_w, r->current_a);
+        if (written < 0)
+            return false;
+    }
+    return true;
+}
+
+static void WriterLoop(ExportStream *stream) {
+    for (;;) {
+        MutexLock(&stream->lock);
+        while (stream->full_count == 0 && !stream->closing) {
+            CondWait(&stream->has_full, &stream->lock);
+        }
+        if (stream->full_count == 0) {
+            MutexUnlock(&stream->lock);
+            break; // Closing and drained
+        }
+        ExportBatch *batch = stream->full[stream->full_head];
+        stream->full_head = (stream->full_head + 1) % EXPORT_MAX_BATCHES;
+        stream->full_count--;
+        MutexUnlock(&stream->lock);
+
+        // Serialise outside the lock so the producer keeps running
+        bool ok = stream->stats.write_failed || WriteBatch(stream->file, stream->layout, batch);
+
+        MutexLock(&stream->lock);
+        if (ok && !stream->stats.write_failed) {
+            stream->stats.records_written += batch->count;
+            stream->stats.batches_written++;
+        } else {
+            stream->stats.write_failed = true;
+        }
+        batch->count = 0;
+        stream->free_list[stream->free_count++] = batch;
+        MutexUnlock(&stream->lock);
+    }
+}
+
+#ifdef _WIN32
+static unsigned __stdcall ExportWriterThread(void *arg) {
+    WriterLoop((ExportStream *)arg);
+    return 0;
+}
+#else
+static void *ExportWriterThread(void *arg) {
+    WriterLoop((ExportStream *)arg);
+    return NULL;
+}
+#endif
+
+//------------------------------------------------------------------------------
+// Producer API
+//------------------------------------------------------------------------------
+static void FreeBatches(ExportStream *stream) {
+    for (int i = 0; i < stream->batch_count; i++) {
+        free(stream->batches[i]);
+    }
+}
+
+ExportStream *ExportStream_Open(const char *path, ExportLayout layout) {
+    ExportStream *stream = (ExportStream *)calloc(1, sizeof(ExportStream));
+    if (!stream) return NULL;
+
+    bool allocated = true;
+    for (int i = 0; i < EXPORT_QUEUE_BATCHES && allocated; i++) {
+        stream->batches[i] = (ExportBatch *)calloc(1, sizeof(ExportBatch));
+        allocated = stream->batches[i] != NULL;
+        stream->batch_count += allocated;
+    }
+    stream->file = allocated ? fopen(path, "w") : NULL;
+    if (!stream->file) {
+        FreeBatches(stream);
+        free(stream);
+        return NULL;
+    }
+    stream->layout = layout;
+    fprintf(stream->file, layout == EXPORT_LAYOUT_ANNUAL
+                                  ? "bin,hours,elevation_deg,azimuth_deg,string_id,power_w,current_a\n"
+                                  : "hour,heading_deg,string_id,power_w,current_a\n");
+
+    stream->current = stream->batches[0];
+    for (int i = 1; i < stream->batch_count; i++) {
+        stream->free_list[stream->free_count++] = stream->batches[i];
+    }
+    stream->stats.batches_allocated = stream->batch_count;
+
+    MutexInit(&stream->lock);
+    CondInit(&stream->has_full);
+
+#ifdef _WIN32
+    stream->thread = (HANDLE)_beginthreadex(NULL, 0, ExportWriterThread, stream, 0, NULL);
+    bool started = stream->thread != NULL;
+#else
+    bool started = pthread_create(&stream->thread, NULL, ExportWriterThread, stream) == 0;
+#endif
+    if (!started) {
+        CondDestroy(&stream->has_full);
+        MutexDestroy(&stream->lock);
+        fclose(stream->file);
+        FreeBatches(stream);
+        free(stream);
+        return NULL;
+    }
+    return stream;
+}
+
+// Hand the full current batch to the writer and take a free one, growing the pool if none is free. Never waits
+// for the writer; returns false (keeping the current batch) when the pool is exhausted.
+static bool SubmitCurrent(ExportStream *stream, bool need_next) {
+    ExportBatch *next = NULL;
+    if (need_next) {
+        MutexLock(&stream->lock);
+        if (stream->free_count > 0)
+            next = stream->free_list[--stream->free_count];
+        MutexUnlock(&stream->lock);
+        // Only the producer grows the pool, so the allocation can run outside the lock
+        if (!next && stream->batch_count < EXPORT_MAX_BATCHES) {
+            next = (ExportBatch *)calloc(1, sizeof(ExportBatch));
+            if (next) {
+                stream->batches[stream->batch_count++] = next;
+                stream->stats.batches_allocated = stream->batch_count;
+            }
+        }
+        if (!next) return false;
+    }
+
+    MutexLock(&stream->lock);
+    stream->full[(stream->full_head + stream->full_count) % EXPORT_MAX_BATCHES] = stream->current;
+    stream->full_count++;
+    CondSignal(&stream->has_full);
+    MutexUnlock(&stream->lock);
+    stream->current = next;
+    return true;
+}
+
+bool ExportStream_Push(ExportStream *stream, const ExportRecord *record) {
+    ExportBatch *batch = stream->current;
+    if (batch->count == EXPORT_BATCH_RECORDS && !SubmitCurrent(stream, true)) {
+        stream->stats.records_dropped++;
+        return false;
+    }
+    batch = stream->current;
+    batch->records[batch->count++] = *record;
+    return true;
+}
+
+bool ExportStream_Close(ExportStream *stream, ExportStreamStats *stats) {
+    if (!stream) return false;
+
+    if (stream->current && stream->current->count > 0) {
+        SubmitCurrent(stream, false);
+    }
+
+    MutexLock(&stream->lock);
+    stream->closing = true;
+    CondSignal(&stream->has_full);
+    MutexUnlock(&stream->lock);
+
+#ifdef _WIN32
+    WaitForSingleObject(stream->thread, INFINITE);
+    CloseHandle(stream->thread);
+#else
+    pthread_join(stream->thread, NULL);
+#endif
+
+    if (fclose(stream->file) != 0) stream->stats.write_failed = true;
+    bool ok = !stream->stats.write_failed;
+    if (stats) *stats = stream->stats;
+
+    CondDestroy(&stream->has_full);
+    MutexDestroy(&stream->lock);
+    FreeBatches(stream);
+    free(stream);
+    return ok;
+}
@@ -0,0 +1,68 @@
+#ifndef EXPORT_STREAM_H
+#define EXPORT_STREAM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+//------------------------------------------------------------------------------
+// Constants
+//------------------------------------------------------------------------------
+#define EXPORT_BATCH_RECORDS 4096 // Records per batch handed to the writer
+#define EXPORT_QUEUE_BATCHES 8    // Batches allocated up front
+#define EXPORT_MAX_BATCHES 32     // Pool limit when the writer falls behind (bounds memory use)
+
+//------------------------------------------------------------------------------
+// Streaming per-sample export
+//------------------------------------------------------------------------------
+// Records are collected into fixed-size batches that a writer thread
+// serialises to CSV while the sweep keeps running. The producer never waits
+// for the writer: when every batch is queued the pool grows, up to a fixed
+// limit so memory stays bounded however long the run is, and past that the
+// records are dropped and counted.
+
+// Row layout of the file, fixed when it is opened
+typedef enum {
+    EXPORT_LAYOUT_DAILY,  // hour,heading_deg,string_id,power_w,current_a
+    EXPORT_LAYOUT_ANNUAL, // bin,hours,elevation_deg,azimuth_deg,string_id,power_w,current_a
+} ExportLayout;
+
+typedef struct {
+    float hour;        // Decimal hour of the sample
+    float heading_deg; // Vehicle heading of the sample
+    int string_id;     // String id (-1 = unwired cells, -2 = the array network)
+    float power_w;
+    float current_a;
+    // Annual layout only (hour and heading are unused there)
+    int bin;             // Weather bin index
+    float hours;         // Hours of the year the bin stands for; power_w x hours is its energy
+    float elevation_deg; // Sun direction of the bin in the vehicle frame (as seen at heading 0)
+    float azimuth_deg;
+} ExportRecord;
+
+typedef struct {
+    long long records_written;
+    int batches_written;
+    long long records_dropped; // Records lost because the writer was too far behind
+    int batches_allocated; // Pool size reached
+    bool write_failed;
+} ExportStreamStats;
+
+typedef struct ExportStream ExportStream;
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+
+// Create the output file, write the CSV header for layout and start the writer thread
+// Returns NULL on failure
+ExportStream *ExportStream_Open(const char *path, ExportLayout layout);
+
+// Append one record (batched; never waits for the writer). Returns false if the record was dropped.
+bool ExportStream_Push(ExportStream *stream, const ExportRecord *record);
+
+// Drain queued batches, stop the writer thread and close the file
+// stats: optional output
+// Returns false if any write failed
+bool ExportStream_Close(ExportStream *stream, ExportStreamStats *stats);
+
+#endif // EXPORT_STREAM_H
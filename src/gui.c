@@ -2,6 +2,7 @@
  * GUI implementation using raygui
  */
 
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -125,7 +126,22 @@ void DrawSidebar(AppState *app) {
         app->mode = MODE_WIRING;
     if (GuiButton((Rectangle) {padding + 3 * (bw + 2), y, bw, 25}, app->mode == MODE_SIMULATION ? "#12#Sim" : "Sim"))
         app->mode = MODE_SIMULATION;
-    y += 35;
+    y += 30;
+
+    // Undo / redo
+    int hw = (w - 2) / 2;
+    const UndoJournal *undo = &app->undo;
+    if (undo->position == 0)
+        GuiDisable();
+    if (GuiButton((Rectangle) {padding, y, hw, 22}, "#56#Undo (Ctrl+Z)"))
+        UndoEdit(app);
+    GuiEnable();
+    if (undo->position >= undo->step_count)
+        GuiDisable();
+    if (GuiButton((Rectangle) {padding + hw + 2, y, hw, 22}, "#57#Redo (Ctrl+Y)"))
+        RedoEdit(app);
+    GuiEnable();
+    y += 32;
 
     GuiLine((Rectangle) {padding, y, w, 1}, NULL);
     y += 10;
@@ -179,6 +195,13 @@ void DrawSidebar(AppState *app) {
     }
     y += 25;
 
+    // Wireframe density (crease-only keeps huge meshes readable)
+    GuiLabel((Rectangle) {padding, y, 75, 20}, "Wireframe:");
+    int wireMode = app->wireframe_mode;
+    GuiToggleGroup((Rectangle) {padding + 75, y, (w - 75) / 3.0f, 20}, "All;Creases;Off", &wireMode);
+    app->wireframe_mode = (WireframeMode) wireMode;
+    y += 25;
+
     if (GuiButton((Rectangle) {padding, y, w, 25}, "Reset Camera (R)")) {
         CameraReset(&app->cam, app->mesh_bounds);
     }
@@ -217,6 +240,10 @@ int DrawImportPanel(AppState *app, int x, int y, int w) {
     }
     y += 35;
 
+    // Transform edits are journalled against the values at the start of the frame
+    float oldScale = app->mesh_scale;
+    Vector3 oldRotation = app->mesh_rotation;
+
     // Scale input
     GuiLabel((Rectangle) {x, y, 50, 20}, "Scale:");
     static char scaleText[16] = "0.001";
@@ -237,6 +264,8 @@ int DrawImportPanel(AppState *app, int x, int y, int w) {
             if (newScale > 0) {
                 app->mesh_scale = newScale;
                 lastScale = newScale;
+                if (newScale != oldScale)
+                    RecordTransformEdit(app, oldScale, oldRotation);
                 if (app->mesh_loaded) {
                     UpdateMeshTransform(app);
                     CameraFitToBounds(&app->cam, app->mesh_bounds);
@@ -334,6 +363,7 @@ int DrawImportPanel(AppState *app, int x, int y, int w) {
 
         if (transformChanged) {
             UpdateMeshTransform(app);
+            RecordTransformEdit(app, oldScale, oldRotation);
         }
     }
 
@@ -350,6 +380,71 @@ int DrawImportPanel(AppState *app, int x, int y, int w) {
         y += 25;
     }
 
+    // Obstacle scenery
+    GuiLine((Rectangle) {x, y, w, 1}, NULL);
+    y += 10;
+    GuiLabel((Rectangle) {x, y, w, 20}, "OBSTACLES (SHADE ONLY)");
+    y += 22;
+
+    if (GuiButton((Rectangle) {x, y, w, 25}, "Add Obstacle Mesh...")) {
+        char path[MAX_PATH_LENGTH] = {0};
+        if (OpenFileDialog(path, MAX_PATH_LENGTH, NULL)) {
+            AddObstacleFromFile(app, path);
+        }
+    }
+    y += 30;
+
+    int sel = app->selected_obstacle;
+    if (sel >= 0 && sel < app->obstacle_count) {
+        Obstacle *obstacle = &app->obstacles[sel];
+
+        if (GuiButton((Rectangle) {x, y, 25, 20}, "<"))
+            app->selected_obstacle = (sel + app->obstacle_count - 1) % app->obstacle_count;
+        GuiLabel((Rectangle) {x + 30, y, w - 60, 20},
+                 TextFormat("%d/%d: %s", sel + 1, app->obstacle_count,
+                            GetFileName(app->obstacle_paths[obstacle->mesh])));
+        if (GuiButton((Rectangle) {x + w - 25, y, 25, 20}, ">"))
+            app->selected_obstacle = (sel + 1) % app->obstacle_count;
+        y += 24;
+
+        bool moved = false;
+        GuiLabel((Rectangle) {x, y, 45, 20}, "X (m):");
+        moved |= GuiSlider((Rectangle) {x + 50, y, w - 95, 20}, NULL, NULL, &obstacle->position.x, -30.0f, 30.0f);
+        GuiLabel((Rectangle) {x + w - 40, y, 40, 20}, TextFormat("%.1f", obstacle->position.x));
+        y += 22;
+        GuiLabel((Rectangle) {x, y, 45, 20}, "Z (m):");
+        moved |= GuiSlider((Rectangle) {x + 50, y, w - 95, 20}, NULL, NULL, &obstacle->position.z, -30.0f, 30.0f);
+        GuiLabel((Rectangle) {x + w - 40, y, 40, 20}, TextFormat("%.1f", obstacle->position.z));
+        y += 22;
+        GuiLabel((Rectangle) {x, y, 45, 20}, "Yaw:");
+        moved |= GuiSlider((Rectangle) {x + 50, y, w - 95, 20}, NULL, NULL, &obstacle->yaw_deg, -180.0f, 180.0f);
+        GuiLabel((Rectangle) {x + w - 40, y, 40, 20}, TextFormat("%.0f", obstacle->yaw_deg));
+        y += 22;
+
+        GuiLabel((Rectangle) {x, y, w - 70, 20}, TextFormat("Scale: %g", obstacle->scale));
+        if (GuiButton((Rectangle) {x + w - 65, y, 30, 20}, "/10")) {
+            obstacle->scale /= 10.0f;
+            moved = true;
+        }
+        if (GuiButton((Rectangle) {x + w - 30, y, 30, 20}, "x10")) {
+            obstacle->scale *= 10.0f;
+            moved = true;
+        }
+        y += 24;
+        if (moved)
+            UpdateObstacleTransform(app, sel);
+
+        int halfW = (w - 5) / 2;
+        if (GuiButton((Rectangle) {x, y, halfW, 22}, "Duplicate"))
+            DuplicateObstacle(app, sel);
+        if (GuiButton((Rectangle) {x + halfW + 5, y, halfW, 22}, "Remove"))
+            RemoveObstacle(app, sel);
+        y += 26;
+        if (GuiButton((Rectangle) {x, y, w, 22}, "Clear All Obstacles"))
+            ClearObstacles(app);
+        y += 26;
+    }
+
     return y;
 }
 
@@ -368,6 +463,35 @@ int DrawCellPanel(AppState *app, int x, int y, int w) {
             app->placing_module = false;
         }
         y += 30;
+    } else if (app->filling_module && app->selected_module >= 0) {
+        GuiLabel((Rectangle) {x, y, w, 20}, "Filling panel with:");
+        y += 20;
+        GuiLabel((Rectangle) {x, y, w, 20}, app->modules[app->selected_module].name);
+        y += 22;
+        GuiLabel((Rectangle) {x, y, w, 20}, "Click a surface panel");
+        y += 22;
+
+        GuiLabel((Rectangle) {x, y, 45, 20}, "Angle:");
+        GuiSlider((Rectangle) {x + 50, y, w - 95, 20}, NULL, NULL, &app->module_fill_angle, 0, 180);
+        char angleText[16];
+        snprintf(angleText, sizeof(angleText), "%.0f", app->module_fill_angle);
+        GuiLabel((Rectangle) {x + w - 40, y, 40, 20}, angleText);
+        y += 22;
+
+        float gapCm = app->module_fill_gap * 100.0f;
+        GuiLabel((Rectangle) {x, y, 45, 20}, "Gap:");
+        if (GuiSlider((Rectangle) {x + 50, y, w - 95, 20}, NULL, NULL, &gapCm, 0.0f, 20.0f)) {
+            app->module_fill_gap = gapCm / 100.0f;
+        }
+        char gapText[16];
+        snprintf(gapText, sizeof(gapText), "%.0fcm", gapCm);
+        GuiLabel((Rectangle) {x + w - 40, y, 40, 20}, gapText);
+        y += 25;
+
+        if (GuiButton((Rectangle) {x, y, w, 25}, "Cancel Module Fill")) {
+            app->filling_module = false;
+        }
+        y += 30;
     } else {
         GuiLabel((Rectangle) {x, y, w, 40}, "Click on mesh to place\nRight-click to remove");
         y += 45;
@@ -448,6 +572,12 @@ int DrawCellPanel(AppState *app, int x, int y, int w) {
         if (app->selected_module >= 0) {
             if (GuiButton((Rectangle) {x, y, w, 25}, "Place Selected Module")) {
                 app->placing_module = true;
+                app->filling_module = false;
+            }
+            y += 28;
+            if (GuiButton((Rectangle) {x, y, w, 25}, "Fill Panel With Module")) {
+                app->filling_module = true;
+                app->placing_module = false;
             }
             y += 28;
         }
@@ -512,6 +642,25 @@ int DrawCellPanel(AppState *app, int x, int y, int w) {
     char maxAngleText[16];
     snprintf(maxAngleText, sizeof(maxAngleText), "%.0f", app->auto_layout.max_normal_angle);
     GuiLabel((Rectangle) {x + w - 40, y, 40, 20}, maxAngleText);
+    y += 22;
+
+    // Panels split where adjacent faces bend more than this
+    GuiLabel((Rectangle) {x, y, 45, 20}, "Panels:");
+    GuiSlider((Rectangle) {x + 50, y, w - 95, 20}, NULL, NULL, &app->auto_layout.surface_threshold, 5, 60);
+    char thresholdText[16];
+    snprintf(thresholdText, sizeof(thresholdText), "%.0f", app->auto_layout.surface_threshold);
+    GuiLabel((Rectangle) {x + w - 40, y, 40, 20}, thresholdText);
+    y += 22;
+
+    // Texel size of the top-down surface map behind footprint and clearance checks
+    float texelCm = app->auto_layout.height_map_texel * 100.0f;
+    GuiLabel((Rectangle) {x, y, 45, 20}, "Map:");
+    if (GuiSlider((Rectangle) {x + 50, y, w - 95, 20}, NULL, NULL, &texelCm, 0.5f, 5.0f)) {
+        app->auto_layout.height_map_texel = texelCm / 100.0f;
+    }
+    char texelText[16];
+    snprintf(texelText, sizeof(texelText), "%.1fcm", texelCm);
+    GuiLabel((Rectangle) {x + w - 40, y, 40, 20}, texelText);
     y += 24;
 
     // Optimization toggle
@@ -526,6 +675,18 @@ int DrawCellPanel(AppState *app, int x, int y, int w) {
     GuiCheckBox((Rectangle) {x, y, 20, 20}, "Use grid layout", &app->auto_layout.use_grid_layout);
     y += 24;
 
+    // Dense packing in each panel's plane (overrides the grid)
+    GuiCheckBox((Rectangle) {x, y, 20, 20}, "Pack to panels (dense)", &app->auto_layout.conform_packing);
+    y += 24;
+
+    if (app->auto_layout.conform_packing) {
+        int orientation = (int) app->auto_layout.pack_orientation;
+        GuiLabel((Rectangle) {x, y, 45, 20}, "Cells:");
+        GuiToggleGroup((Rectangle) {x + 50, y, (w - 54) / 3, 20}, "Along;Across;Best", &orientation);
+        app->auto_layout.pack_orientation = (PackOrientation) orientation;
+        y += 24;
+    }
+
     // Height constraint section
     GuiCheckBox((Rectangle) {x, y, 20, 20}, "Limit height (exclude canopy)", &app->auto_layout.use_height_constraint);
     y += 22;
@@ -620,7 +781,33 @@ int DrawWiringPanel(AppState *app, int x, int y, int w) {
         snprintf(stringInfo, sizeof(stringInfo), "Current: None");
     }
     GuiLabel((Rectangle) {x, y, w, 20}, stringInfo);
-    y += 25;
+    y += 22;
+
+    // Interconnect of the active string and its ribbon loss at the MPP current
+    for (int s = 0; s < app->string_count; s++) {
+        if (app->strings[s].id == app->active_string_id) {
+            float length = GetStringRouteLength(app, &app->strings[s]);
+            float imp = CELL_PRESETS[app->selected_preset].imp;
+            snprintf(stringInfo, sizeof(stringInfo), "Route: %.2f m, %.3f W loss", length,
+                     imp * imp * INTERCONNECT_OHMS_PER_M * length);
+            GuiLabel((Rectangle) {x, y, w, 20}, stringInfo);
+            y += 22;
+            break;
+        }
+    }
+    y += 3;
+
+    // MPPT channel of the active string (strings on the same channel are wired in parallel)
+    for (int s = 0; s < app->string_count; s++) {
+        if (app->strings[s].id == app->active_string_id) {
+            GuiLabel((Rectangle) {x, y, 100, 20}, "MPPT channel:");
+            GuiSpinner((Rectangle) {x + 100, y, 80, 20}, NULL, &app->strings[s].mppt_channel, 0, MAX_MPPT_CHANNELS,
+                       false);
+            GuiLabel((Rectangle) {x + 185, y, w - 185, 20}, app->strings[s].mppt_channel == 0 ? "own" : "shared");
+            y += 25;
+            break;
+        }
+    }
 
     int bw = (w - 4) / 2;
     if (GuiButton((Rectangle) {x, y, bw, 25}, "New (N)")) {
@@ -631,6 +818,11 @@ int DrawWiringPanel(AppState *app, int x, int y, int w) {
     }
     y += 30;
 
+    if (GuiButton((Rectangle) {x, y, w, 25}, "Optimise String Routes")) {
+        OptimiseAllStringRoutes(app);
+    }
+    y += 30;
+
     if (GuiButton((Rectangle) {x, y, w, 25}, "Clear All Wiring")) {
         ClearAllWiring(app);
     }
@@ -736,6 +928,24 @@ int DrawSimulationPanel(AppState *app, int x, int y, int w) {
     GuiLabel((Rectangle) {x + 115, y, 30, 20}, "Day:");
     GuiSpinner((Rectangle) {x + 150, y, 50, 20}, NULL, &app->sim_settings.day, 1, 31, false);
     y += 25;
+    GuiLabel((Rectangle) {x, y, 50, 20}, "Year:");
+    GuiSpinner((Rectangle) {x + 55, y, 70, 20}, NULL, &app->sim_settings.year, 1950, 2100, false);
+    y += 25;
+
+    // Clock zone: the standard zone of the longitude, or a fixed offset in quarter hours
+    GuiCheckBox((Rectangle) {x, y, 20, 20}, "UTC offset from longitude", &app->sim_settings.auto_utc_offset);
+    y += 24;
+    if (app->sim_settings.auto_utc_offset) {
+        app->sim_settings.utc_offset = roundf(app->sim_settings.longitude / 15.0f);
+        GuiDisable();
+    }
+    GuiLabel((Rectangle) {x, y, 70, 20}, "UTC offset:");
+    GuiSlider((Rectangle) {x + 75, y, w - 125, 20}, NULL, NULL, &app->sim_settings.utc_offset, -12.0f, 14.0f);
+    app->sim_settings.utc_offset = roundf(app->sim_settings.utc_offset * 4.0f) / 4.0f;
+    GuiLabel((Rectangle) {x + w - 45, y, 45, 20}, TextFormat("%+.2f h", app->sim_settings.utc_offset));
+    if (app->sim_settings.auto_utc_offset)
+        GuiEnable();
+    y += 25;
 
     // Irradiance
     GuiLabel((Rectangle) {x, y, 70, 20}, "Irradiance:");
@@ -791,12 +1001,13 @@ int DrawSimulationPanel(AppState *app, int x, int y, int w) {
     // Run static simulation button
     if (GuiButton((Rectangle) {x, y, w, 25}, "#04#Run Instant Simulation")) {
         app->time_sim_run = false;
+        app->annual_sim_run = false;
         RunStaticSimulation(app);
     }
     y += 30;
 
     // Static simulation results
-    if (app->sim_run && !app->time_sim_run) {
+    if (app->sim_run && !app->time_sim_run && !app->annual_sim_run) {
         char results[256];
         if (app->string_count > 0) {
             int total_bypassed = 0;
@@ -856,6 +1067,83 @@ int DrawSimulationPanel(AppState *app, int x, int y, int w) {
     GuiLabel((Rectangle) {x, y, w, 20}, "Heading samples:");
     static int headingSamples = 12;
     GuiSpinner((Rectangle) {x + 100, y, 80, 20}, NULL, &headingSamples, 4, 36, false);
+    y += 24;
+
+    // String result memoisation: coarser steps reuse more results at some accuracy cost
+    GuiLabel((Rectangle) {x, y, 100, 20}, "Cache step:");
+    GuiSlider((Rectangle) {x + 100, y, w - 145, 20}, NULL, NULL, &app->sim_settings.iv_cache_step, 0.0f, 0.02f);
+    GuiLabel((Rectangle) {x + w - 40, y, 40, 20},
+             app->sim_settings.iv_cache_step > 0.0f ? TextFormat("%.3f", app->sim_settings.iv_cache_step) : "off");
+    y += 28;
+
+    // Draft shading: simplified occluders for quick what-if runs (also used by auto-layout scoring)
+    GuiCheckBox((Rectangle) {x, y, 20, 20}, "Draft shading", &app->sim_settings.draft_shading);
+    y += 26;
+
+    // Vehicle attitude: a pitch/roll spread, or the histogram of a route log in its place
+    bool hasRoute = app->attitude_route.route_samples > 0;
+    if (hasRoute)
+        GuiDisable();
+    GuiLabel((Rectangle) {x, y, 100, 20}, "Pitch spread:");
+    GuiSlider((Rectangle) {x + 100, y, w - 145, 20}, NULL, NULL, &app->sim_settings.pitch_spread_deg, 0.0f, 8.0f);
+    GuiLabel((Rectangle) {x + w - 40, y, 40, 20},
+             app->sim_settings.pitch_spread_deg > 0.0f ? TextFormat("%.1f°", app->sim_settings.pitch_spread_deg)
+                                                       : "level");
+    y += 24;
+    GuiLabel((Rectangle) {x, y, 100, 20}, "Roll spread:");
+    GuiSlider((Rectangle) {x + 100, y, w - 145, 20}, NULL, NULL, &app->sim_settings.roll_spread_deg, 0.0f, 8.0f);
+    GuiLabel((Rectangle) {x + w - 40, y, 40, 20},
+             app->sim_settings.roll_spread_deg > 0.0f ? TextFormat("%.1f°", app->sim_settings.roll_spread_deg)
+                                                      : "level");
+    y += 24;
+    if (hasRoute)
+        GuiEnable();
+
+    const char *routeLabel =
+            hasRoute ? TextFormat("Route: %s", GetFileName(app->attitude_path)) : "Load Route Attitude (CSV)...";
+    if (GuiButton((Rectangle) {x, y, w - 28, 22}, routeLabel)) {
+        char const *filterPatterns[] = {"*.csv", "*.CSV"};
+        char *result = tinyfd_openFileDialog("Select Route Log", "", 2, filterPatterns, "Route log (*.csv)", 0);
+        if (result) {
+            LoadAttitudeRoute(app, result);
+        }
+    }
+    if (GuiButton((Rectangle) {x + w - 24, y, 24, 22}, "X")) {
+        ClearAttitudeRoute(app);
+    }
+    y += 28;
+
+    // Series-parallel array netlist (replaces the strings in the sweep)
+    const char *networkLabel = app->network.element_count > 0
+                                       ? TextFormat("Network: %s", GetFileName(app->network_path))
+                                       : "Load Array Network...";
+    if (GuiButton((Rectangle) {x, y, w - 28, 22}, networkLabel)) {
+        char const *filterPatterns[] = {"*.net", "*.txt"};
+        char *result = tinyfd_openFileDialog("Select Array Network", "", 2, filterPatterns,
+                                             "Array netlist (*.net, *.txt)", 0);
+        if (result) {
+            LoadArrayNetwork(app, result);
+        }
+    }
+    if (GuiButton((Rectangle) {x + w - 24, y, 24, 22}, "X")) {
+        ClearArrayNetwork(app);
+    }
+    y += 28;
+
+    // Export target, streamed while the daily sweep (per sample) or the annual run (per weather bin) runs
+    const char *exportLabel = app->export_path[0] ? TextFormat("Export: %s", GetFileName(app->export_path))
+                                                  : "Export Samples (CSV)...";
+    if (GuiButton((Rectangle) {x, y, w - 28, 22}, exportLabel)) {
+        char const *filterPatterns[] = {"*.csv"};
+        char *result = tinyfd_saveFileDialog("Export Samples", "samples.csv", 1, filterPatterns, "CSV files (*.csv)");
+        if (result) {
+            strncpy(app->export_path, result, MAX_PATH_LENGTH - 1);
+            app->export_path[MAX_PATH_LENGTH - 1] = '\0';
+        }
+    }
+    if (GuiButton((Rectangle) {x + w - 24, y, 24, 22}, "X")) {
+        app->export_path[0] = '\0';
+    }
     y += 28;
 
     // Run time simulation button
@@ -884,6 +1172,75 @@ int DrawSimulationPanel(AppState *app, int x, int y, int w) {
         GuiLabel((Rectangle) {x, y, w, 70}, timeResults);
         y += 75;
 
+        int lookups = app->time_sim_results.cache_hits + app->time_sim_results.cache_misses;
+        if (lookups > 0) {
+            GuiLabel((Rectangle) {x, y, w, 18},
+                     TextFormat("String cache: %.0f%% hits (%d IV traces computed)",
+                                100.0f * app->time_sim_results.cache_hit_rate, app->time_sim_results.cache_misses));
+            y += 20;
+        }
+
+        if (app->time_sim_results.draft) {
+            // No sample is traced twice while attitudes are on, so there is no discrepancy to show
+            if (app->time_sim_results.draft_check_samples == 0) {
+                GuiLabel((Rectangle) {x, y, w, 18},
+                         app->time_sim_results.attitude_count > 1 ? "Draft vs full mesh: n/a (attitudes on)"
+                                                                  : "Draft vs full mesh: n/a (no samples checked)");
+            } else {
+                GuiLabel((Rectangle) {x, y, w, 18},
+                         TextFormat("Draft vs full mesh: %+.1f%% (%d samples)",
+                                    app->time_sim_results.draft_discrepancy_pct,
+                                    app->time_sim_results.draft_check_samples));
+            }
+            y += 20;
+            GuiLabel((Rectangle) {x, y, w, 18}, "Untick Draft shading for the final run");
+            y += 20;
+        }
+
+        if (app->time_sim_results.attitude_count > 1) {
+            GuiLabel((Rectangle) {x, y, w, 18},
+                     TextFormat("Attitudes: %d (%d directions traced)", app->time_sim_results.attitude_count,
+                                app->time_sim_results.attitude_dirs));
+            y += 20;
+        }
+
+        if (app->time_sim_results.network) {
+            GuiLabel((Rectangle) {x, y, w, 18},
+                     TextFormat("Network: %d cells, %.0f Newton steps/MPP", app->time_sim_results.network_cells,
+                                app->time_sim_results.network_newton_steps));
+            y += 20;
+            if (app->time_sim_results.network_failures > 0) {
+                GuiLabel((Rectangle) {x, y, w, 18},
+                         TextFormat("%d samples did not converge", app->time_sim_results.network_failures));
+                y += 20;
+            }
+        }
+
+        // Timeline scrubber: replays recorded samples without recomputing
+        const TimeSeriesHeader *ts = app->timeseries.header;
+        if (ts && ts->sample_count > 0 && ts->heading_samples > 0) {
+            static float scrub = 0.0f;
+            float prevScrub = scrub;
+            GuiLabel((Rectangle) {x, y, 60, 20}, "Timeline:");
+            GuiSlider((Rectangle) {x + 65, y, w - 65, 20}, NULL, NULL, &scrub, 0.0f, (float) (ts->sample_count - 1));
+            int sample = (int) (scrub + 0.5f);
+            if (scrub != prevScrub && sample != app->timeseries_sample) {
+                ShowTimeSeriesSample(app, sample);
+            }
+            y += 22;
+
+            if (app->timeseries_sample >= 0) {
+                int ti = app->timeseries_sample / (int) ts->heading_samples;
+                int hi = app->timeseries_sample % (int) ts->heading_samples;
+                GuiLabel((Rectangle) {x, y, w, 18},
+                         TextFormat("%.1fh, heading %.0f deg: %.1f W", ts->start_hour + ti * ts->dt_hours,
+                                    hi * ts->heading_step, app->sim_results.total_power));
+            } else {
+                GuiLabel((Rectangle) {x, y, w, 18}, "Drag to replay a sample");
+            }
+            y += 22;
+        }
+
         // Per-string energy breakdown
         if (app->string_count > 0) {
             GuiLabel((Rectangle) {x, y, w, 20}, "String Energy (Wh):");
@@ -926,6 +1283,121 @@ int DrawSimulationPanel(AppState *app, int x, int y, int w) {
         y += 55;
     }
 
+    // =========================================================================
+    // ANNUAL SIMULATION SECTION
+    // =========================================================================
+    GuiLine((Rectangle) {x, y, w, 1}, NULL);
+    y += 10;
+
+    GuiLabel((Rectangle) {x, y, w, 20}, "ANNUAL ENERGY (TMY WEATHER)");
+    y += 22;
+
+    GuiLabel((Rectangle) {x, y, w, 35}, "Hourly GHI/DNI/DHI and temperature\nfrom a TMY3, NSRDB or PVGIS CSV");
+    y += 38;
+
+    const char *weatherLabel = app->weather.record_count > 0
+                                       ? TextFormat("Weather: %s", GetFileName(app->weather_path))
+                                       : "Load Weather File (CSV)...";
+    if (GuiButton((Rectangle) {x, y, w, 22}, weatherLabel)) {
+        char const *filterPatterns[] = {"*.csv", "*.CSV"};
+        char *result = tinyfd_openFileDialog("Select Weather File", "", 2, filterPatterns, "TMY weather (*.csv)", 0);
+        if (result) {
+            LoadWeatherFile(app, result);
+        }
+    }
+    y += 26;
+
+    if (app->weather.record_count > 0) {
+        GuiLabel((Rectangle) {x, y, w, 18},
+                 TextFormat("%s%s%d h at %.2f, %.2f", app->weather.name, app->weather.name[0] ? ": " : "",
+                            (int) (app->weather.record_count * app->weather.dt_hours), app->sim_settings.latitude,
+                            app->sim_settings.longitude));
+        y += 22;
+    }
+
+    if (app->weather.record_count == 0)
+        GuiDisable();
+    if (GuiButton((Rectangle) {x, y, w, 30}, "#131#Run Annual Simulation")) {
+        RunAnnualSimulation(app);
+    }
+    GuiEnable();
+    y += 35;
+
+    if (app->annual_sim_run) {
+        const AnnualSimResults *annual = &app->annual_results;
+        GuiLine((Rectangle) {x, y, w, 1}, NULL);
+        y += 8;
+
+        GuiLabel((Rectangle) {x, y, w, 20}, "ANNUAL RESULTS");
+        y += 22;
+
+        char annualResults[256];
+        snprintf(annualResults, sizeof(annualResults),
+                 "Annual Energy: %.1f kWh\n"
+                 "Daily Average: %.2f kWh\n"
+                 "Yield: %.0f kWh/m2 of cells\n"
+                 "Direct Sun Shaded: %.1f%%",
+                 annual->total_energy_kwh, annual->total_energy_kwh / 365.0f, annual->specific_yield,
+                 annual->beam_shaded_pct);
+        GuiLabel((Rectangle) {x, y, w, 70}, annualResults);
+        y += 75;
+
+        // Monthly energy as bars scaled to the best month
+        static const char *monthInitials[12] = {"J", "F", "M", "A", "M", "J", "J", "A", "S", "O", "N", "D"};
+        float bestMonth = 0.0f;
+        for (int m = 0; m < 12; m++) {
+            bestMonth = fmaxf(bestMonth, annual->energy_by_month_kwh[m]);
+        }
+        int barW = w / 12;
+        for (int m = 0; m < 12; m++) {
+            int barH = bestMonth > 0.0f ? (int) (40.0f * annual->energy_by_month_kwh[m] / bestMonth) : 0;
+            DrawRectangle(x + m * barW + 1, y + 40 - barH, barW - 2, barH, (Color) {230, 160, 40, 255});
+            GuiLabel((Rectangle) {x + m * barW + barW / 2 - 3, y + 42, barW, 14}, monthInitials[m]);
+        }
+        y += 60;
+
+        GuiLabel((Rectangle) {x, y, w, 18},
+                 TextFormat("%d sun bins, visibility %s%s", annual->dir_count,
+                            annual->visibility_reused ? "reused" : "traced", annual->draft ? " (draft)" : ""));
+        y += 22;
+    }
+
+    // =========================================================================
+    // SUN EXPOSURE MAP SECTION
+    // =========================================================================
+    GuiLine((Rectangle) {x, y, w, 1}, NULL);
+    y += 10;
+
+    GuiLabel((Rectangle) {x, y, w, 20}, "SUN EXPOSURE MAP");
+    y += 22;
+
+    if (!app->mesh_loaded)
+        GuiDisable();
+    int halfW = (w - 5) / 2;
+    if (GuiButton((Rectangle) {x, y, halfW, 25}, "Day Exposure Map")) {
+        ComputeInsolationMap(app, false);
+    }
+    if (app->weather.record_count == 0)
+        GuiDisable();
+    if (GuiButton((Rectangle) {x + halfW + 5, y, halfW, 25}, "Annual Exposure Map")) {
+        ComputeInsolationMap(app, true);
+    }
+    GuiEnable();
+    y += 30;
+
+    if (app->insolation.exposure) {
+        GuiCheckBox((Rectangle) {x, y, 20, 20}, "Show exposure map", &app->insolation.show);
+        y += 24;
+        if (!InsolationMapCurrent(app)) {
+            GuiLabel((Rectangle) {x, y, w, 18}, "Out of date: geometry, site or sky changed");
+        } else {
+            GuiLabel((Rectangle) {x, y, w, 18},
+                     TextFormat("Peak %.1f %s", app->insolation.max_exposure,
+                                app->insolation.annual ? "kWh/m2 per year" : "Wh/m2 per day"));
+        }
+        y += 22;
+    }
+
     // =========================================================================
     // GENERAL RESULTS (shown if any simulation has run)
     // =========================================================================
@@ -0,0 +1,170 @@
+/*
+ * Multi-layer top-down height map of the vehicle
+ */
+
+#include "height_map.h"
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "raymath.h"
+
+#define HEIGHT_MAP_MERGE 1e-4f  // Hits closer than this (m) are one surface seen through a shared edge
+
+//------------------------------------------------------------------------------
+// Build
+//------------------------------------------------------------------------------
+
+// Keep the texel's layers sorted top-down, dropping the lowest when full
+static void InsertSample(HeightMap *hm, int texel, HeightMapSample sample) {
+    unsigned char *count = &hm->counts[texel];
+    HeightMapSample *layers = &hm->samples[texel * HEIGHT_MAP_LAYERS];
+
+    int pos = 0;
+    for (int k = 0; k < *count; k++) {
+        if (fabsf(layers[k].y - sample.y) < HEIGHT_MAP_MERGE)
+            return;
+        if (layers[k].y > sample.y)
+            pos = k + 1;
+    }
+    if (pos >= HEIGHT_MAP_LAYERS)
+        return;
+
+    int last = (*count < HEIGHT_MAP_LAYERS) ? (*count)++ : HEIGHT_MAP_LAYERS - 1;
+    for (int k = last; k > pos; k--) {
+        layers[k] = layers[k - 1];
+    }
+    layers[pos] = sample;
+}
+
+// Record the triangle at every texel centre its XZ projection covers
+static void RasteriseTriangle(HeightMap *hm, Vector3 p0, Vector3 p1, Vector3 p2, int triangle) {
+    float area2 = (p1.x - p0.x) * (p2.z - p0.z) - (p2.x - p0.x) * (p1.z - p0.z);
+    if (fabsf(area2) < 1e-12f)
+        return;
+
+    Vector3 normal = Vector3Normalize(Vector3CrossProduct(Vector3Subtract(p1, p0), Vector3Subtract(p2, p0)));
+    float inv = 1.0f / area2;
+
+    float lo_x = fminf(p0.x, fminf(p1.x, p2.x)), hi_x = fmaxf(p0.x, fmaxf(p1.x, p2.x));
+    float lo_z = fminf(p0.z, fminf(p1.z, p2.z)), hi_z = fmaxf(p0.z, fmaxf(p1.z, p2.z));
+    int i0 = (int) ceilf((lo_x - hm->min_x) / hm->texel - 0.5f);
+    int i1 = (int) floorf((hi_x - hm->min_x) / hm->texel - 0.5f);
+    int j0 = (int) ceilf((lo_z - hm->min_z) / hm->texel - 0.5f);
+    int j1 = (int) floorf((hi_z - hm->min_z) / hm->texel - 0.5f);
+    if (i0 < 0) i0 = 0;
+    if (j0 < 0) j0 = 0;
+    if (i1 >= hm->width) i1 = hm->width - 1;
+    if (j1 >= hm->depth) j1 = hm->depth - 1;
+
+    for (int j = j0; j <= j1; j++) {
+        float z = hm->min_z + (j + 0.5f) * hm->texel;
+        for (int i = i0; i <= i1; i++) {
+            float x = hm->min_x + (i + 0.5f) * hm->texel;
+
+            // Barycentric weights in the XZ plane, edges inclusive so shared edges leave no gaps
+            float w1 = ((x - p0.x) * (p2.z - p0.z) - (p2.x - p0.x) * (z - p0.z)) * inv;
+            float w2 = ((p1.x - p0.x) * (z - p0.z) - (x - p0.x) * (p1.z - p0.z)) * inv;
+            float w0 = 1.0f - w1 - w2;
+            if (w0 < -1e-6f || w1 < -1e-6f || w2 < -1e-6f)
+                continue;
+
+            HeightMapSample sample = {w0 * p0.y + w1 * p1.y + w2 * p2.y, normal, triangle};
+            InsertSample(hm, j * hm->width + i, sample);
+        }
+    }
+}
+
+bool HeightMap_Build(HeightMap *hm, Mesh mesh, Matrix transform, BoundingBox bounds, float texel) {
+    memset(hm, 0, sizeof(HeightMap));
+    int tri_count = mesh.indices ? mesh.triangleCount : mesh.vertexCount / 3;
+    if (tri_count <= 0 || !mesh.vertices || texel <= 0)
+        return false;
+
+    float size_x = bounds.max.x - bounds.min.x;
+    float size_z = bounds.max.z - bounds.min.z;
+    while ((size_x / texel + 1.0f) * (size_z / texel + 1.0f) > HEIGHT_MAP_MAX_TEXELS) {
+        texel *= 1.25f;
+    }
+
+    hm->min_x = bounds.min.x;
+    hm->min_z = bounds.min.z;
+    hm->texel = texel;
+    hm->width = (int) (size_x / texel) + 1;
+    hm->depth = (int) (size_z / texel) + 1;
+
+    size_t texels = (size_t) hm->width * hm->depth;
+    hm->counts = (unsigned char *) calloc(texels, 1);
+    hm->samples = (HeightMapSample *) malloc(texels * HEIGHT_MAP_LAYERS * sizeof(HeightMapSample));
+    if (!hm->counts || !hm->samples) {
+        HeightMap_Free(hm);
+        return false;
+    }
+
+    const float *v = mesh.vertices;
+    for (int t = 0; t < tri_count; t++) {
+        Vector3 p[3];
+        for (int k = 0; k < 3; k++) {
+            int vi = mesh.indices ? mesh.indices[t * 3 + k] : t * 3 + k;
+            p[k] = Vector3Transform((Vector3) {v[vi * 3], v[vi * 3 + 1], v[vi * 3 + 2]}, transform);
+        }
+        RasteriseTriangle(hm, p[0], p[1], p[2], t);
+    }
+    return true;
+}
+
+void HeightMap_Free(HeightMap *hm) {
+    free(hm->counts);
+    free(hm->samples);
+    memset(hm, 0, sizeof(HeightMap));
+}
+
+//------------------------------------------------------------------------------
+// Queries
+//------------------------------------------------------------------------------
+
+// Texel under (x, z), or -1 outside the map
+static int TexelAt(const HeightMap *hm, float x, float z, float *cx, float *cz) {
+    if (!hm->counts)
+        return -1;
+    int i = (int) floorf((x - hm->min_x) / hm->texel);
+    int j = (int) floorf((z - hm->min_z) / hm->texel);
+    if (i < 0 || j < 0 || i >= hm->width || j >= hm->depth)
+        return -1;
+    *cx = hm->min_x + (i + 0.5f) * hm->texel;
+    *cz = hm->min_z + (j + 0.5f) * hm->texel;
+    return j * hm->width + i;
+}
+
+// Layer height moved from the texel centre to (x, z) along its face plane
+static float LayerHeight(const HeightMapSample *s, float x, float z, float cx, float cz) {
+    if (fabsf(s->normal.y) < 0.05f)
+        return s->y;
+    return s->y - (s->normal.x * (x - cx) + s->normal.z * (z - cz)) / s->normal.y;
+}
+
+bool HeightMap_Top(const HeightMap *hm, float x, float z, HeightMapSample *out) {
+    float cx, cz;
+    int texel = TexelAt(hm, x, z, &cx, &cz);
+    if (texel < 0 || hm->counts[texel] == 0)
+        return false;
+
+    *out = hm->samples[texel * HEIGHT_MAP_LAYERS];
+    out->y = LayerHeight(out, x, z, cx, cz);
+    return true;
+}
+
+float HeightMap_Clearance(const HeightMap *hm, float x, float y, float z) {
+    float cx, cz;
+    int texel = TexelAt(hm, x, z, &cx, &cz);
+    if (texel < 0)
+        return FLT_MAX;
+
+    const HeightMapSample *layers = &hm->samples[texel * HEIGHT_MAP_LAYERS];
+    for (int k = hm->counts[texel] - 1; k >= 0; k--) {
+        float above = LayerHeight(&layers[k], x, z, cx, cz);
+        if (above > y)
+            return above - y;
+    }
+    return FLT_MAX;
+}
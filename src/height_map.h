@@ -0,0 +1,53 @@
+#ifndef HEIGHT_MAP_H
+#define HEIGHT_MAP_H
+
+#include <stdbool.h>
+#include "raylib.h"
+
+//------------------------------------------------------------------------------
+// Constants
+//------------------------------------------------------------------------------
+#define HEIGHT_MAP_LAYERS 4             // Surfaces kept per texel, topmost first
+#define HEIGHT_MAP_MAX_TEXELS 4000000   // Texel size is raised until the grid fits
+
+//------------------------------------------------------------------------------
+// Top-down height map
+//------------------------------------------------------------------------------
+// The transformed mesh rasterised onto a regular XZ grid. Each texel records
+// the surfaces crossed by a vertical line through its centre (height, face
+// normal and triangle id), so the vertical probes auto-layout makes - top
+// surface under a point, headroom above it - become array lookups instead of
+// mesh raycasts. Vertical faces have no footprint and are not recorded.
+
+typedef struct {
+    float y;            // World height at the texel centre
+    Vector3 normal;     // World face normal
+    int triangle;       // Triangle index in the source mesh
+} HeightMapSample;
+
+typedef struct {
+    float min_x, min_z; // World position of texel (0, 0)'s corner
+    float texel;        // Texel edge length (m)
+    int width, depth;   // Texels along X and Z
+
+    unsigned char *counts;      // Layers recorded per texel
+    HeightMapSample *samples;   // HEIGHT_MAP_LAYERS per texel, sorted by descending y
+} HeightMap;
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+
+// Rasterise mesh under transform over bounds (world); returns false on failure or empty mesh
+bool HeightMap_Build(HeightMap *hm, Mesh mesh, Matrix transform, BoundingBox bounds, float texel);
+
+// Release memory (safe on an unbuilt map)
+void HeightMap_Free(HeightMap *hm);
+
+// Topmost surface under (x, z), height corrected along the face plane; false if nothing is there
+bool HeightMap_Top(const HeightMap *hm, float x, float z, HeightMapSample *out);
+
+// Distance from y up to the lowest surface above it at (x, z), FLT_MAX if open sky
+float HeightMap_Clearance(const HeightMap *hm, float x, float y, float z);
+
+#endif // HEIGHT_MAP_H
@@ -0,0 +1,293 @@
+/*
+ * Whole-surface sun exposure map: direct irradiation on every welded vertex of the vehicle,
+ * traced once on the job threads and baked into vertex colours for display
+ */
+
+#include "app.h"
+#include "insolation.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+//------------------------------------------------------------------------------
+// Sun Directions
+//------------------------------------------------------------------------------
+
+// Clear-sky day over the daily sweep's hours and headings; weights in Wh/m^2 at normal incidence
+static int BuildDailyDirections(AppState *app, Vector3 *dirs, float *weights) {
+    SunSample samples[INSOLATION_HOURS * INSOLATION_HEADINGS];
+    SimSite site = GetSimSite(&app->sim_settings);
+    float dt = 12.0f / INSOLATION_HOURS;
+    int count = SimCore_BuildSunSamples(&site, 6.0f + 0.5f * dt, 12.0f - dt, INSOLATION_HOURS, INSOLATION_HEADINGS,
+                                        samples);
+    for (int i = 0; i < count; i++) {
+        dirs[i] = samples[i].dir;
+        weights[i] = SimCore_EffectiveIrradiance(app->sim_settings.irradiance, samples[i].altitude) * dt /
+                     INSOLATION_HEADINGS;
+    }
+    return count;
+}
+
+// Beam irradiation of the weather year folded into coarse direction bins; weights in kWh/m^2 at normal incidence
+static int BuildAnnualDirections(AppState *app, Vector3 *dirs, float *weights) {
+    const SimSkyHistogram *sky = GetAnnualSkyHistogram(app);
+    if (!sky)
+        return 0;
+
+    float *dir_weight = (float *) calloc(sky->dir_count, sizeof(float));
+    if (!dir_weight)
+        return 0;
+    for (int b = 0; b < sky->bin_count; b++) {
+        dir_weight[sky->bins[b].dir] += sky->bins[b].dni * sky->bins[b].hours / 1000.0f;
+    }
+
+    Vector3 sum[INSOLATION_ALT_BINS * INSOLATION_AZ_BINS] = {0};
+    float total[INSOLATION_ALT_BINS * INSOLATION_AZ_BINS] = {0};
+    for (int d = 0; d < sky->dir_count; d++) {
+        if (dir_weight[d] <= 0.0f)
+            continue;
+        Vector3 dir = sky->dirs[d];
+        float alt = asinf(Clampf(dir.y, 0.0f, 1.0f)) / (0.5f * PI);
+        float az = (atan2f(dir.x, -dir.z) + PI) / (2.0f * PI);
+        int a = (int) Clampf(alt * INSOLATION_ALT_BINS, 0.0f, INSOLATION_ALT_BINS - 1);
+        int z = (int) Clampf(az * INSOLATION_AZ_BINS, 0.0f, INSOLATION_AZ_BINS - 1);
+        int bin = a * INSOLATION_AZ_BINS + z;
+        sum[bin] = Vector3Add(sum[bin], Vector3Scale(dir, dir_weight[d]));
+        total[bin] += dir_weight[d];
+    }
+    free(dir_weight);
+
+    int count = 0;
+    for (int bin = 0; bin < INSOLATION_ALT_BINS * INSOLATION_AZ_BINS; bin++) {
+        if (total[bin] <= 0.0f)
+            continue;
+        dirs[count] = Vector3Normalize(sum[bin]);
+        weights[count] = total[bin];
+        count++;
+    }
+    return count;
+}
+
+//------------------------------------------------------------------------------
+// Display Mesh
+//------------------------------------------------------------------------------
+static Color ExposureColor(float t) {
+    const Color low = {30, 40, 140, 255};
+    const Color mid = {230, 80, 30, 255};
+    const Color high = {255, 240, 120, 255};
+    t = Clampf(t, 0.0f, 1.0f);
+    return t < 0.5f ? LerpColor(low, mid, 2.0f * t) : LerpColor(mid, high, 2.0f * t - 1.0f);
+}
+
+// Triangle soup in mesh space, one colour per corner from its welded vertex
+static bool BuildInsolationMesh(AppState *app) {
+    const MeshTopology *topo = &app->vehicle_topology;
+    InsolationMap *map = &app->insolation;
+
+    Mesh mesh = {0};
+    mesh.triangleCount = topo->tri_count;
+    mesh.vertexCount = topo->tri_count * 3;
+    mesh.vertices = (float *) RL_MALLOC(sizeof(float) * 3 * mesh.vertexCount);
+    mesh.colors = (unsigned char *) RL_MALLOC(4 * mesh.vertexCount);
+    if (!mesh.vertices || !mesh.colors) {
+        RL_FREE(mesh.vertices);
+        RL_FREE(mesh.colors);
+        return false;
+    }
+
+    float scale = map->max_exposure > 0.0f ? 1.0f / map->max_exposure : 0.0f;
+    for (int i = 0; i < mesh.vertexCount; i++) {
+        int v = topo->tri_vertices[i];
+        Vector3 p = topo->positions[v];
+        Color c = ExposureColor(map->exposure[v] * scale);
+        mesh.vertices[i * 3 + 0] = p.x;
+        mesh.vertices[i * 3 + 1] = p.y;
+        mesh.vertices[i * 3 + 2] = p.z;
+        memcpy(&mesh.colors[i * 4], &c, 4);
+    }
+    UploadMesh(&mesh, false);
+    map->mesh = mesh;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Computation
+//------------------------------------------------------------------------------
+
+// Progress overlay drawn between vertex batches; false if the user cancelled
+static bool ShowInsolationProgress(AppState *app, int progress) {
+    PollInputEvents();
+    if (WindowShouldClose() || IsKeyDown(KEY_ESCAPE))
+        return false;
+
+    BeginDrawing();
+    ClearBackground(BLACK);
+    AppDraw(app);
+
+    int cx = app->screen_width / 2;
+    int cy = app->screen_height / 2 - 200;
+    DrawRectangle(0, 0, app->screen_width, app->screen_height, (Color) {0, 0, 0, 100});
+
+    DrawRectangle(cx - 175, cy - 45, 350, 90, (Color) {30, 30, 30, 245});
+    DrawRectangleLines(cx - 175, cy - 45, 350, 90, WHITE);
+
+    DrawText("Exposure Map (esc to cancel)", cx - 90, cy - 35, 20, WHITE);
+    DrawText(TextFormat("Tracing %d vertices", app->vehicle_topology.vertex_count), cx - 140, cy - 8, 16, LIGHTGRAY);
+
+    int barY = cy + 15;
+    DrawRectangle(cx - 150, barY, 300, 18, DARKGRAY);
+    DrawRectangle(cx - 150, barY, (300 * progress) / 100, 18, GREEN);
+    DrawRectangleLines(cx - 150, barY, 300, 18, WHITE);
+    DrawText(TextFormat("%d%%", progress), cx - 12, barY + 2, 14, WHITE);
+
+    EndDrawing();
+    return true;
+}
+
+void FreeInsolationMap(AppState *app) {
+    InsolationMap *map = &app->insolation;
+    free(map->exposure);
+    if (map->mesh.vertexCount > 0)
+        UnloadMesh(map->mesh);
+    bool show = map->show;
+    memset(map, 0, sizeof(*map));
+    map->show = show;
+}
+
+bool ComputeInsolationMap(AppState *app, bool annual) {
+    const MeshTopology *topo = &app->vehicle_topology;
+    if (!app->mesh_loaded || topo->vertex_count == 0) {
+        SetStatus(app, "No mesh to map");
+        return false;
+    }
+
+    Vector3 dirs[INSOLATION_HOURS * INSOLATION_HEADINGS + INSOLATION_ALT_BINS * INSOLATION_AZ_BINS];
+    float weights[INSOLATION_HOURS * INSOLATION_HEADINGS + INSOLATION_ALT_BINS * INSOLATION_AZ_BINS];
+    int dir_count = annual ? BuildAnnualDirections(app, dirs, weights) : BuildDailyDirections(app, dirs, weights);
+    if (dir_count == 0) {
+        SetStatus(app, annual ? "No direct irradiance in the weather file" : "The sun never rises on this day");
+        return false;
+    }
+
+    int vertex_count = topo->vertex_count;
+    Vector3 *positions = (Vector3 *) malloc(vertex_count * sizeof(Vector3));
+    Vector3 *normals = (Vector3 *) calloc(vertex_count, sizeof(Vector3));
+    float *exposure = (float *) calloc(vertex_count, sizeof(float));
+    if (!positions || !normals || !exposure) {
+        free(positions);
+        free(normals);
+        free(exposure);
+        SetStatus(app, "Not enough memory for the exposure map");
+        return false;
+    }
+
+    // World positions, and normals from the area-weighted faces around each welded vertex
+    Matrix transform = app->vehicle_model.transform;
+    for (int v = 0; v < vertex_count; v++) {
+        positions[v] = Vector3Transform(topo->positions[v], transform);
+    }
+    for (int t = 0; t < topo->tri_count; t++) {
+        const int *tv = &topo->tri_vertices[t * 3];
+        Vector3 face = Vector3CrossProduct(Vector3Subtract(positions[tv[1]], positions[tv[0]]),
+                                           Vector3Subtract(positions[tv[2]], positions[tv[0]]));
+        for (int k = 0; k < 3; k++) {
+            normals[tv[k]] = Vector3Add(normals[tv[k]], face);
+        }
+    }
+    for (int v = 0; v < vertex_count; v++) {
+        normals[v] = Vector3Normalize(normals[v]);
+    }
+
+    bool draft = app->sim_settings.draft_shading && EnsureDraftOccluder(app);
+    SimGeometry geometry = GetSimGeometry(app);
+    for (int begin = 0; begin < vertex_count; begin += INSOLATION_CHUNK) {
+        if (!ShowInsolationProgress(app, begin * 100 / vertex_count)) {
+            free(positions);
+            free(normals);
+            free(exposure);
+            SetStatus(app, "Exposure map cancelled");
+            return false;
+        }
+        int count = vertex_count - begin < INSOLATION_CHUNK ? vertex_count - begin : INSOLATION_CHUNK;
+        SimLayout chunk = {count, positions + begin, normals + begin};
+        SimCore_DirectExposure(&geometry, &chunk, dirs, weights, dir_count, draft, exposure + begin);
+    }
+    free(positions);
+    free(normals);
+
+    FreeInsolationMap(app);
+    InsolationMap *map = &app->insolation;
+    map->exposure = exposure;
+    map->vertex_count = vertex_count;
+    map->annual = annual;
+    map->mesh_revision = app->mesh_revision;
+    map->obstacle_revision = app->obstacle_revision;
+    map->site = GetSimSite(&app->sim_settings);
+    map->irradiance = app->sim_settings.irradiance;
+    map->weather_revision = app->weather_revision;
+    map->draft = app->sim_settings.draft_shading;
+    for (int v = 0; v < vertex_count; v++) {
+        map->max_exposure = fmaxf(map->max_exposure, exposure[v]);
+    }
+    if (!BuildInsolationMesh(app)) {
+        FreeInsolationMap(app);
+        SetStatus(app, "Not enough memory for the exposure map");
+        return false;
+    }
+    map->show = true;
+
+    SetStatus(app, "Exposure map: %d vertices x %d sun directions, peak %.1f %s", vertex_count, dir_count,
+              map->max_exposure, annual ? "kWh/m^2/yr" : "Wh/m^2/day");
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Lookup and Display
+//------------------------------------------------------------------------------
+// Geometry, site and the sky the map was traced for: the clear-sky day and irradiance for a daily map, the weather
+// year (which ignores the date) for an annual one
+bool InsolationMapCurrent(const AppState *app) {
+    const InsolationMap *map = &app->insolation;
+    const SimSettings *s = &app->sim_settings;
+    if (!map->exposure || map->mesh_revision != app->mesh_revision ||
+        map->obstacle_revision != app->obstacle_revision || map->draft != s->draft_shading)
+        return false;
+
+    SimSite site = GetSimSite(s);
+    if (site.latitude != map->site.latitude || site.longitude != map->site.longitude ||
+        site.year != map->site.year || site.utc_offset != map->site.utc_offset)
+        return false;
+    if (map->annual)
+        return map->weather_revision == app->weather_revision;
+    return site.month == map->site.month && site.day == map->site.day && s->irradiance == map->irradiance;
+}
+
+// Exposure of the surface under a point as a share of the map's peak, 0 off the mesh, -1 without a current map
+float SampleInsolationPrior(AppState *app, Vector3 position, Vector3 normal) {
+    const InsolationMap *map = &app->insolation;
+    if (!InsolationMapCurrent(app) || map->max_exposure <= 0.0f)
+        return -1.0f;
+
+    Ray ray = {Vector3Add(position, Vector3Scale(normal, INSOLATION_PROBE)), Vector3Negate(normal)};
+    int triangle = -1;
+    RayCollision hit = RaycastVehicle(app, ray, &triangle);
+    if (!hit.hit || triangle < 0 || triangle >= app->vehicle_topology.tri_count)
+        return 0.0f;
+
+    const int *tv = &app->vehicle_topology.tri_vertices[triangle * 3];
+    float sum = map->exposure[tv[0]] + map->exposure[tv[1]] + map->exposure[tv[2]];
+    return sum / (3.0f * map->max_exposure);
+}
+
+bool DrawInsolationMap(AppState *app) {
+    InsolationMap *map = &app->insolation;
+    if (!map->show || map->mesh.vertexCount == 0 || !InsolationMapCurrent(app))
+        return false;
+
+    MaterialMap *diffuse = &app->vehicle_model.materials[0].maps[MATERIAL_MAP_DIFFUSE];
+    Color prev = diffuse->color;
+    diffuse->color = WHITE;
+    DrawMesh(map->mesh, app->vehicle_model.materials[0], app->vehicle_model.transform);
+    diffuse->color = prev;
+    return true;
+}
@@ -0,0 +1,15 @@
+#ifndef INSOLATION_H
+#define INSOLATION_H
+
+// Whole-surface sun exposure map implementation
+// Function declarations are in app.h
+// This header contains implementation-specific constants
+
+#define INSOLATION_HOURS 12 // Daylight hours sampled for the daily map (6:00 - 18:00)
+#define INSOLATION_HEADINGS 12 // Vehicle headings averaged per hour
+#define INSOLATION_ALT_BINS 15 // Coarse sun altitude bins for the annual map
+#define INSOLATION_AZ_BINS 12 // Coarse sun azimuth bins for the annual map
+#define INSOLATION_CHUNK 4096 // Vertices traced between progress redraws
+#define INSOLATION_PROBE 0.05f // Height above the surface a prior lookup starts its ray (m)
+
+#endif // INSOLATION_H
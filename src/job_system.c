@@ -0,0 +1,378 @@
+/*
+ * Work-stealing job system (per-thread queues, parallel-for, task groups)
+ */
+
+#include "job_system.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <process.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+#define JOB_SPIN_ROUNDS 64 // Failed steal sweeps before an idle worker goes to sleep
+
+//------------------------------------------------------------------------------
+// Platform threading
+//------------------------------------------------------------------------------
+#ifdef _WIN32
+typedef CRITICAL_SECTION JobMutex;
+typedef CONDITION_VARIABLE JobCond;
+typedef HANDLE JobThread;
+#define MutexInit(m) InitializeCriticalSection(m)
+#define MutexDestroy(m) DeleteCriticalSection(m)
+#define MutexLock(m) EnterCriticalSection(m)
+#define MutexUnlock(m) LeaveCriticalSection(m)
+#define CondInit(c) InitializeConditionVariable(c)
+#define CondDestroy(c) ((void)(c))
+#define CondWait(c, m) SleepConditionVariableCS(c, m, INFINITE)
+#define CondSignal(c) WakeConditionVariable(c)
+#define CondBroadcast(c) WakeAllConditionVariable(c)
+#define AtomicAdd(p, v) (InterlockedExchangeAdd((volatile LONG *)(p), (v)) + (v))
+#define AtomicLoad(p) InterlockedCompareExchange((volatile LONG *)(p), 0, 0)
+#define AtomicStore(p, v) InterlockedExchange((volatile LONG *)(p), (v))
+#define ThreadYield() SwitchToThread()
+#else
+typedef pthread_mutex_t JobMutex;
+typedef pthread_cond_t JobCond;
+typedef pthread_t JobThread;
+#define MutexInit(m) pthread_mutex_init(m, NULL)
+#define MutexDestroy(m) pthread_mutex_destroy(m)
+#define MutexLock(m) pthread_mutex_lock(m)
+#define MutexUnlock(m) pthread_mutex_unlock(m)
+#define CondInit(c) pthread_cond_init(c, NULL)
+#define CondDestroy(c) pthread_cond_destroy(c)
+#define CondWait(c, m) pthread_cond_wait(c, m)
+#define CondSignal(c) pthread_cond_signal(c)
+#define CondBroadcast(c) pthread_cond_broadcast(c)
+#define AtomicAdd(p, v) __atomic_add_fetch((p), (v), __ATOMIC_SEQ_CST)
+#define AtomicLoad(p) __atomic_load_n((p), __ATOMIC_SEQ_CST)
+#define AtomicStore(p, v) __atomic_store_n((p), (v), __ATOMIC_SEQ_CST)
+#define ThreadYield() sched_yield()
+#endif
+
+#ifdef _MSC_VER
+#define JOB_THREAD_LOCAL __declspec(thread)
+#else
+#define JOB_THREAD_LOCAL __thread
+#endif
+
+//------------------------------------------------------------------------------
+// Queues
+//------------------------------------------------------------------------------
+typedef struct {
+    JobFunc func;
+    void *arg;
+    JobGroup *group;
+} Job;
+
+// Owner end at bottom, thieves take from top
+typedef struct {
+    Job jobs[JOB_QUEUE_CAPACITY];
+    int top, bottom;
+    JobMutex lock;
+} JobQueue;
+
+static struct {
+    bool running;
+    int workers;                // Threads actually started
+    int queue_count;            // Requested workers + 1; queue 0 belongs to the main thread and any non-pool thread
+    JobQueue *queues;
+    JobThread threads[JOB_MAX_WORKERS];
+    int thread_slots[JOB_MAX_WORKERS];
+
+    volatile long queued;       // Jobs sitting in any queue
+    volatile long sleeping;     // Workers blocked on wake
+    volatile long shutdown;
+    JobMutex sleep_lock;
+    JobCond wake;
+} g_jobs;
+
+// Queue index of this thread: 0 = main, 1..workers = pool, -1 = a thread the pool does not own
+static JOB_THREAD_LOCAL int g_thread_slot = -1;
+
+static int CurrentSlot(void) {
+    return g_thread_slot >= 0 ? g_thread_slot : g_jobs.workers + 1;
+}
+
+static bool PushJob(JobQueue *q, Job job) {
+    MutexLock(&q->lock);
+    bool ok = q->bottom - q->top < JOB_QUEUE_CAPACITY;
+    if (ok) {
+        q->jobs[q->bottom % JOB_QUEUE_CAPACITY] = job;
+        q->bottom++;
+    }
+    MutexUnlock(&q->lock);
+    return ok;
+}
+
+static bool TakeJob(JobQueue *q, bool steal, Job *out) {
+    MutexLock(&q->lock);
+    bool ok = q->bottom > q->top;
+    if (ok) {
+        if (steal)
+            *out = q->jobs[q->top++ % JOB_QUEUE_CAPACITY];
+        else
+            *out = q->jobs[--q->bottom % JOB_QUEUE_CAPACITY];
+        if (q->top == q->bottom)
+            q->top = q->bottom = 0;
+    }
+    MutexUnlock(&q->lock);
+    return ok;
+}
+
+// Newest job from this thread's own queue, otherwise the oldest from another
+static bool FindJob(Job *out) {
+    if (!g_jobs.running || AtomicLoad(&g_jobs.queued) == 0)
+        return false;
+
+    int queue_count = g_jobs.workers + 1;
+    int own = g_thread_slot >= 0 ? g_thread_slot : 0;
+    for (int i = 0; i < queue_count; i++) {
+        int q = (own + i) % queue_count;
+        if (TakeJob(&g_jobs.queues[q], i != 0, out)) {
+            AtomicAdd(&g_jobs.queued, -1);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void RunJob(const Job *job) {
+    if (!JobCancel_IsRequested(job->group->cancel))
+        job->func(job->arg);
+    AtomicAdd(&job->group->pending, -1);
+}
+
+//------------------------------------------------------------------------------
+// Workers
+//------------------------------------------------------------------------------
+static void WorkerLoop(int slot) {
+    g_thread_slot = slot;
+    for (;;) {
+        Job job;
+        bool found = false;
+        for (int spin = 0; spin < JOB_SPIN_ROUNDS && !found; spin++) {
+            found = FindJob(&job);
+            if (!found)
+                ThreadYield();
+        }
+        if (found) {
+            RunJob(&job);
+            continue;
+        }
+
+        // Announce the sleeper before the final check so a concurrent submit either sees it or is seen here
+        MutexLock(&g_jobs.sleep_lock);
+        AtomicAdd(&g_jobs.sleeping, 1);
+        while (AtomicLoad(&g_jobs.queued) == 0 && !AtomicLoad(&g_jobs.shutdown)) {
+            CondWait(&g_jobs.wake, &g_jobs.sleep_lock);
+        }
+        AtomicAdd(&g_jobs.sleeping, -1);
+        MutexUnlock(&g_jobs.sleep_lock);
+
+        if (AtomicLoad(&g_jobs.shutdown) && AtomicLoad(&g_jobs.queued) == 0)
+            break;
+    }
+}
+
+#ifdef _WIN32
+static unsigned __stdcall WorkerThread(void *arg) {
+    WorkerLoop(*(int *) arg);
+    return 0;
+}
+#else
+static void *WorkerThread(void *arg) {
+    WorkerLoop(*(int *) arg);
+    return NULL;
+}
+#endif
+
+static int CountCores(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int) info.dwNumberOfProcessors;
+#else
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return cores > 0 ? (int) cores : 1;
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Lifecycle
+//------------------------------------------------------------------------------
+bool JobSystem_Init(int worker_count) {
+    if (g_jobs.running)
+        return true;
+
+    memset(&g_jobs, 0, sizeof(g_jobs));
+    g_thread_slot = 0;
+    if (worker_count <= 0)
+        worker_count = CountCores() - 1;
+    if (worker_count > JOB_MAX_WORKERS)
+        worker_count = JOB_MAX_WORKERS;
+    if (worker_count <= 0)
+        return true; // Single core: everything runs inline
+
+    g_jobs.queues = (JobQueue *) calloc(worker_count + 1, sizeof(JobQueue));
+    if (!g_jobs.queues)
+        return false;
+    g_jobs.queue_count = worker_count + 1;
+    for (int q = 0; q < g_jobs.queue_count; q++) {
+        MutexInit(&g_jobs.queues[q].lock);
+    }
+    MutexInit(&g_jobs.sleep_lock);
+    CondInit(&g_jobs.wake);
+    g_jobs.running = true;
+
+    for (int w = 0; w < worker_count; w++) {
+        g_jobs.thread_slots[w] = w + 1;
+#ifdef _WIN32
+        g_jobs.threads[w] = (HANDLE) _beginthreadex(NULL, 0, WorkerThread, &g_jobs.thread_slots[w], 0, NULL);
+        bool started = g_jobs.threads[w] != NULL;
+#else
+        bool started = pthread_create(&g_jobs.threads[w], NULL, WorkerThread, &g_jobs.thread_slots[w]) == 0;
+#endif
+        if (!started)
+            break;
+        g_jobs.workers++;
+    }
+    return true;
+}
+
+void JobSystem_Shutdown(void) {
+    if (!g_jobs.running)
+        return;
+
+    MutexLock(&g_jobs.sleep_lock);
+    AtomicStore(&g_jobs.shutdown, 1);
+    CondBroadcast(&g_jobs.wake);
+    MutexUnlock(&g_jobs.sleep_lock);
+
+    for (int w = 0; w < g_jobs.workers; w++) {
+#ifdef _WIN32
+        WaitForSingleObject(g_jobs.threads[w], INFINITE);
+        CloseHandle(g_jobs.threads[w]);
+#else
+        pthread_join(g_jobs.threads[w], NULL);
+#endif
+    }
+
+    for (int q = 0; q < g_jobs.queue_count; q++) {
+        MutexDestroy(&g_jobs.queues[q].lock);
+    }
+    MutexDestroy(&g_jobs.sleep_lock);
+    CondDestroy(&g_jobs.wake);
+    free(g_jobs.queues);
+    memset(&g_jobs, 0, sizeof(g_jobs));
+}
+
+int JobSystem_WorkerCount(void) {
+    return g_jobs.workers;
+}
+
+int JobSystem_SlotCount(void) {
+    return g_jobs.workers + 2; // Main, workers, and one caller from outside the pool
+}
+
+//------------------------------------------------------------------------------
+// Groups
+//------------------------------------------------------------------------------
+void JobGroup_Init(JobGroup *group, JobCancel *cancel) {
+    group->pending = 0;
+    group->cancel = cancel;
+}
+
+void JobSystem_Submit(JobGroup *group, JobFunc func, void *arg) {
+    Job job = {func, arg, group};
+    AtomicAdd(&group->pending, 1);
+
+    int own = g_thread_slot >= 0 ? g_thread_slot : 0;
+    if (!g_jobs.running || g_jobs.workers == 0 || !PushJob(&g_jobs.queues[own], job)) {
+        RunJob(&job);
+        return;
+    }
+
+    AtomicAdd(&g_jobs.queued, 1);
+    if (AtomicLoad(&g_jobs.sleeping) > 0) {
+        MutexLock(&g_jobs.sleep_lock);
+        CondSignal(&g_jobs.wake);
+        MutexUnlock(&g_jobs.sleep_lock);
+    }
+}
+
+void JobSystem_Wait(JobGroup *group) {
+    while (AtomicLoad(&group->pending) > 0) {
+        Job job;
+        if (FindJob(&job))
+            RunJob(&job);
+        else
+            ThreadYield();
+    }
+}
+
+void JobCancel_Request(JobCancel *cancel) {
+    AtomicStore(&cancel->requested, 1);
+}
+
+bool JobCancel_IsRequested(const JobCancel *cancel) {
+    return cancel && AtomicLoad((volatile long *) &cancel->requested) != 0;
+}
+
+//------------------------------------------------------------------------------
+// Parallel For
+//------------------------------------------------------------------------------
+
+// Threads pull chunks from a shared counter, so uneven chunks balance themselves
+typedef struct {
+    JobRangeFunc func;
+    void *ctx;
+    int count;
+    int grain;
+    volatile long next;
+    JobCancel *cancel;
+} ParallelRange;
+
+static void RunRange(void *arg) {
+    ParallelRange *range = (ParallelRange *) arg;
+    int slot = CurrentSlot();
+    while (!JobCancel_IsRequested(range->cancel)) {
+        long begin = AtomicAdd(&range->next, range->grain) - range->grain;
+        if (begin >= range->count)
+            break;
+        long end = begin + range->grain;
+        range->func(range->ctx, (int) begin, end < range->count ? (int) end : range->count, slot);
+    }
+}
+
+bool JobSystem_ParallelFor(int count, int grain, JobRangeFunc func, void *ctx, JobCancel *cancel) {
+    if (count <= 0)
+        return !JobCancel_IsRequested(cancel);
+
+    int threads = g_jobs.workers + 1;
+    if (grain <= 0) {
+        grain = count / (threads * JOB_CHUNKS_PER_THREAD);
+        if (grain < 1)
+            grain = 1;
+    }
+
+    ParallelRange range = {func, ctx, count, grain, 0, cancel};
+    int chunks = (count + grain - 1) / grain;
+    int helpers = chunks - 1 < g_jobs.workers ? chunks - 1 : g_jobs.workers;
+
+    JobGroup group;
+    JobGroup_Init(&group, cancel);
+    for (int h = 0; h < helpers; h++) {
+        JobSystem_Submit(&group, RunRange, &range);
+    }
+    RunRange(&range);
+    JobSystem_Wait(&group);
+    return !JobCancel_IsRequested(cancel);
+}
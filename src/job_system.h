@@ -0,0 +1,71 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <stdbool.h>
+
+//------------------------------------------------------------------------------
+// Constants
+//------------------------------------------------------------------------------
+#define JOB_MAX_WORKERS 31          // Pool threads besides the thread that initialises the pool
+#define JOB_QUEUE_CAPACITY 1024     // Jobs per thread queue; a job that does not fit runs inline
+#define JOB_CHUNKS_PER_THREAD 8     // Automatic parallel-for grain aims for this many chunks per thread
+
+//------------------------------------------------------------------------------
+// Work-stealing thread pool
+//------------------------------------------------------------------------------
+// One process-wide pool. Every thread that takes part owns a job queue: it
+// pushes and pops at one end, idle threads steal from the other. Threads
+// waiting on a group run queued jobs instead of blocking, so jobs may submit
+// and wait on further jobs. Without a pool (not initialised, or a single
+// core) everything runs inline on the calling thread.
+//
+// Jobs must not touch raylib's window or GPU state; that is main-thread only.
+
+typedef void (*JobFunc)(void *arg);
+
+// Handles items [begin, end); slot is unique among the threads running one parallel-for, < JobSystem_SlotCount()
+typedef void (*JobRangeFunc)(void *ctx, int begin, int end, int slot);
+
+// Cooperative cancellation: queued jobs of a cancelled group are dropped, running ones should poll
+typedef struct {
+    volatile long requested;
+} JobCancel;
+
+// Jobs submitted together and waited on together
+typedef struct {
+    volatile long pending;
+    JobCancel *cancel; // Optional
+} JobGroup;
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+
+// Start worker_count threads (0 = one per core, less the calling thread); call once from the main thread
+bool JobSystem_Init(int worker_count);
+
+// Finish queued jobs and join the workers
+void JobSystem_Shutdown(void);
+
+// Pool threads, excluding the main thread
+int JobSystem_WorkerCount(void);
+
+// Upper bound on the slot passed to range functions (per-slot scratch arrays are sized with this)
+int JobSystem_SlotCount(void);
+
+void JobGroup_Init(JobGroup *group, JobCancel *cancel);
+
+// Queue func(arg) in group
+void JobSystem_Submit(JobGroup *group, JobFunc func, void *arg);
+
+// Run queued jobs until every job in group has finished
+void JobSystem_Wait(JobGroup *group);
+
+// Call func over [0, count) in chunks of grain items (0 = automatic) on all threads, the caller included.
+// Returns false if cancel was requested before the range finished.
+bool JobSystem_ParallelFor(int count, int grain, JobRangeFunc func, void *ctx, JobCancel *cancel);
+
+void JobCancel_Request(JobCancel *cancel);
+bool JobCancel_IsRequested(const JobCancel *cancel);
+
+#endif // JOB_SYSTEM_H
@@ -0,0 +1,394 @@
+/*
+ * Bounding volume hierarchy for mesh raycasts
+ */
+
+#include "mesh_bvh.h"
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "raymath.h"
+
+#define BVH_EPSILON 0.000001f // Same tolerance as GetRayCollisionTriangle
+
+//------------------------------------------------------------------------------
+// Build
+//------------------------------------------------------------------------------
+typedef struct {
+    Vector3 *centroid;
+    Vector3 *tmin;
+    Vector3 *tmax;
+    int *order;
+} BuildData;
+
+static float BoxArea(Vector3 mn, Vector3 mx) {
+    Vector3 d = Vector3Subtract(mx, mn);
+    if (d.x < 0 || d.y < 0 || d.z < 0) return 0;
+    return d.x * d.y + d.y * d.z + d.z * d.x;
+}
+
+static float Axis(Vector3 v, int axis) {
+    return (axis == 0) ? v.x : (axis == 1) ? v.y : v.z;
+}
+
+static void UpdateBounds(MeshBVHNode *node, const BuildData *bd) {
+    node->min = (Vector3) {FLT_MAX, FLT_MAX, FLT_MAX};
+    node->max = (Vector3) {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+    for (int i = node->left_first; i < node->left_first + node->count; i++) {
+        int t = bd->order[i];
+        node->min = Vector3Min(node->min, bd->tmin[t]);
+        node->max = Vector3Max(node->max, bd->tmax[t]);
+    }
+}
+
+// Binned SAH split of node; returns false if the node should stay a leaf
+static bool FindSplit(const MeshBVHNode *node, const BuildData *bd, int *out_axis, float *out_pos) {
+    float best_cost = FLT_MAX;
+    int first = node->left_first;
+    int count = node->count;
+
+    // Centroid bounds
+    Vector3 cmin = {FLT_MAX, FLT_MAX, FLT_MAX}, cmax = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+    for (int i = first; i < first + count; i++) {
+        cmin = Vector3Min(cmin, bd->centroid[bd->order[i]]);
+        cmax = Vector3Max(cmax, bd->centroid[bd->order[i]]);
+    }
+
+    for (int axis = 0; axis < 3; axis++) {
+        float lo = Axis(cmin, axis), hi = Axis(cmax, axis);
+        if (hi - lo < 1e-12f) continue;
+
+        int bin_count[MESH_BVH_SAH_BINS] = {0};
+        Vector3 bin_min[MESH_BVH_SAH_BINS], bin_max[MESH_BVH_SAH_BINS];
+        for (int b = 0; b < MESH_BVH_SAH_BINS; b++) {
+            bin_min[b] = (Vector3) {FLT_MAX, FLT_MAX, FLT_MAX};
+            bin_max[b] = (Vector3) {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+        }
+
+        float scale = MESH_BVH_SAH_BINS / (hi - lo);
+        for (int i = first; i < first + count; i++) {
+            int t = bd->order[i];
+            int b = (int) ((Axis(bd->centroid[t], axis) - lo) * scale);
+            if (b >= MESH_BVH_SAH_BINS) b = MESH_BVH_SAH_BINS - 1;
+            bin_count[b]++;
+            bin_min[b] = Vector3Min(bin_min[b], bd->tmin[t]);
+            bin_max[b] = Vector3Max(bin_max[b], bd->tmax[t]);
+        }
+
+        // Sweep from the left and right to get the cost of each plane
+        float left_area[MESH_BVH_SAH_BINS - 1];
+        int left_count[MESH_BVH_SAH_BINS - 1];
+        Vector3 mn = {FLT_MAX, FLT_MAX, FLT_MAX}, mx = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+        int sum = 0;
+        for (int b = 0; b < MESH_BVH_SAH_BINS - 1; b++) {
+            sum += bin_count[b];
+            mn = Vector3Min(mn, bin_min[b]);
+            mx = Vector3Max(mx, bin_max[b]);
+            left_count[b] = sum;
+            left_area[b] = BoxArea(mn, mx);
+        }
+
+        mn = (Vector3) {FLT_MAX, FLT_MAX, FLT_MAX};
+        mx = (Vector3) {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+        sum = 0;
+        for (int b = MESH_BVH_SAH_BINS - 1; b > 0; b--) {
+            sum += bin_count[b];
+            mn = Vector3Min(mn, bin_min[b]);
+            mx = Vector3Max(mx, bin_max[b]);
+            if (left_count[b - 1] == 0 || sum == 0) continue;
+
+            float cost = left_count[b - 1] * left_area[b - 1] + sum * BoxArea(mn, mx);
+            if (cost < best_cost) {
+                best_cost = cost;
+                *out_axis = axis;
+                *out_pos = lo + b / scale;
+            }
+        }
+    }
+
+    // Only split if it beats intersecting every triangle in this node
+    return best_cost < count * BoxArea(node->min, node->max);
+}
+
+bool MeshBVH_Build(MeshBVH *bvh, Mesh mesh) {
+    memset(bvh, 0, sizeof(MeshBVH));
+    bvh->transform = MatrixIdentity();
+    bvh->inv_transform = MatrixIdentity();
+
+    int n = mesh.triangleCount;
+    if (n <= 0 || !mesh.vertices) return false;
+
+    BuildData bd;
+    bd.centroid = (Vector3 *) malloc(n * sizeof(Vector3));
+    bd.tmin = (Vector3 *) malloc(n * sizeof(Vector3));
+    bd.tmax = (Vector3 *) malloc(n * sizeof(Vector3));
+    bd.order = (int *) malloc(n * sizeof(int));
+    Vector3 *verts = (Vector3 *) malloc(3 * (size_t) n * sizeof(Vector3));
+    bvh->nodes = (MeshBVHNode *) malloc(2 * (size_t) n * sizeof(MeshBVHNode));
+
+    if (!bd.centroid || !bd.tmin || !bd.tmax || !bd.order || !verts || !bvh->nodes) {
+        free(bd.centroid);
+        free(bd.tmin);
+        free(bd.tmax);
+        free(bd.order);
+        free(verts);
+        MeshBVH_Free(bvh);
+        return false;
+    }
+
+    const float *v = mesh.vertices;
+    for (int t = 0; t < n; t++) {
+        for (int k = 0; k < 3; k++) {
+            int vi = mesh.indices ? mesh.indices[t * 3 + k] : t * 3 + k;
+            verts[t * 3 + k] = (Vector3) {v[vi * 3], v[vi * 3 + 1], v[vi * 3 + 2]};
+        }
+        Vector3 a = verts[t * 3], b = verts[t * 3 + 1], c = verts[t * 3 + 2];
+        bd.tmin[t] = Vector3Min(a, Vector3Min(b, c));
+        bd.tmax[t] = Vector3Max(a, Vector3Max(b, c));
+        bd.centroid[t] = Vector3Scale(Vector3Add(a, Vector3Add(b, c)), 1.0f / 3.0f);
+        bd.order[t] = t;
+    }
+
+    // Root covers everything; split nodes from an explicit stack
+    MeshBVHNode *root = &bvh->nodes[0];
+    root->left_first = 0;
+    root->count = n;
+    UpdateBounds(root, &bd);
+    bvh->node_count = 1;
+
+    // A depth-first walk holds at most one pending sibling per level plus the two newest children, so capping the
+    // depth bounds both this stack and the traversal stacks
+    int stack[MESH_BVH_STACK_SIZE];
+    int depth[MESH_BVH_STACK_SIZE];
+    int sp = 0;
+    stack[sp] = 0;
+    depth[sp++] = 0;
+    bvh->max_depth = 0;
+
+    while (sp > 0) {
+        --sp;
+        MeshBVHNode *node = &bvh->nodes[stack[sp]];
+        int node_depth = depth[sp];
+        if (node_depth > bvh->max_depth) bvh->max_depth = node_depth;
+        if (node->count <= MESH_BVH_LEAF_SIZE || node_depth >= MESH_BVH_MAX_DEPTH) continue;
+
+        int axis = 0;
+        float split = 0;
+        if (!FindSplit(node, &bd, &axis, &split)) continue;
+
+        // Partition triangle order around the split plane
+        int i = node->left_first;
+        int j = i + node->count - 1;
+        while (i <= j) {
+            if (Axis(bd.centroid[bd.order[i]], axis) < split) {
+                i++;
+            } else {
+                int tmp = bd.order[i];
+                bd.order[i] = bd.order[j];
+                bd.order[j--] = tmp;
+            }
+        }
+
+        int left_count = i - node->left_first;
+        if (left_count == 0 || left_count == node->count) continue;
+
+        int left = bvh->node_count;
+        bvh->node_count += 2;
+        bvh->nodes[left].left_first = node->left_first;
+        bvh->nodes[left].count = left_count;
+        bvh->nodes[left + 1].left_first = i;
+        bvh->nodes[left + 1].count = node->count - left_count;
+        UpdateBounds(&bvh->nodes[left], &bd);
+        UpdateBounds(&bvh->nodes[left + 1], &bd);
+
+        node->left_first = left;
+        node->count = 0;
+
+        stack[sp] = left;
+        depth[sp++] = node_depth + 1;
+        stack[sp] = left + 1;
+        depth[sp++] = node_depth + 1;
+    }
+
+    // Store triangles in leaf order for cache-friendly traversal
+    bvh->v0 = (Vector3 *) malloc(n * sizeof(Vector3));
+    bvh->e1 = (Vector3 *) malloc(n * sizeof(Vector3));
+    bvh->e2 = (Vector3 *) malloc(n * sizeof(Vector3));
+    bvh->tri_index = (int *) malloc(n * sizeof(int));
+    bool ok = bvh->v0 && bvh->e1 && bvh->e2 && bvh->tri_index;
+    for (int k = 0; ok && k < n; k++) {
+        int t = bd.order[k];
+        bvh->v0[k] = verts[t * 3];
+        bvh->e1[k] = Vector3Subtract(verts[t * 3 + 1], verts[t * 3]);
+        bvh->e2[k] = Vector3Subtract(verts[t * 3 + 2], verts[t * 3]);
+        bvh->tri_index[k] = t;
+    }
+    bvh->tri_count = n;
+
+    free(bd.centroid);
+    free(bd.tmin);
+    free(bd.tmax);
+    free(bd.order);
+    free(verts);
+
+    if (!ok) {
+        MeshBVH_Free(bvh);
+        return false;
+    }
+    return true;
+}
+
+void MeshBVH_Free(MeshBVH *bvh) {
+    free(bvh->nodes);
+    free(bvh->v0);
+    free(bvh->e1);
+    free(bvh->e2);
+    free(bvh->tri_index);
+    bvh->nodes = NULL;
+    bvh->v0 = bvh->e1 = bvh->e2 = NULL;
+    bvh->tri_index = NULL;
+    bvh->node_count = 0;
+    bvh->tri_count = 0;
+}
+
+void MeshBVH_SetTransform(MeshBVH *bvh, Matrix transform) {
+    bvh->transform = transform;
+    bvh->inv_transform = MatrixInvert(transform);
+}
+
+//------------------------------------------------------------------------------
+// Traversal
+//------------------------------------------------------------------------------
+typedef struct {
+    Vector3 origin;
+    Vector3 dir;
+    Vector3 inv_dir;
+} LocalRay;
+
+static LocalRay ToLocal(const Matrix *m, Ray ray) {
+    LocalRay r;
+    r.origin = Vector3Transform(ray.position, *m);
+    // Direction is not renormalised so the ray parameter stays the world parameter
+    r.dir = (Vector3) {m->m0 * ray.direction.x + m->m4 * ray.direction.y + m->m8 * ray.direction.z,
+                       m->m1 * ray.direction.x + m->m5 * ray.direction.y + m->m9 * ray.direction.z,
+                       m->m2 * ray.direction.x + m->m6 * ray.direction.y + m->m10 * ray.direction.z};
+    r.inv_dir = (Vector3) {1.0f / r.dir.x, 1.0f / r.dir.y, 1.0f / r.dir.z};
+    return r;
+}
+
+// Slab test; returns entry distance or FLT_MAX on a miss
+static float IntersectBox(const LocalRay *r, Vector3 mn, Vector3 mx, float t_max) {
+    float tx1 = (mn.x - r->origin.x) * r->inv_dir.x, tx2 = (mx.x - r->origin.x) * r->inv_dir.x;
+    float tmin = fminf(tx1, tx2), tmax = fmaxf(tx1, tx2);
+    float ty1 = (mn.y - r->origin.y) * r->inv_dir.y, ty2 = (mx.y - r->origin.y) * r->inv_dir.y;
+    tmin = fmaxf(tmin, fminf(ty1, ty2));
+    tmax = fminf(tmax, fmaxf(ty1, ty2));
+    float tz1 = (mn.z - r->origin.z) * r->inv_dir.z, tz2 = (mx.z - r->origin.z) * r->inv_dir.z;
+    tmin = fmaxf(tmin, fminf(tz1, tz2));
+    tmax = fminf(tmax, fmaxf(tz1, tz2));
+    return (tmax >= tmin && tmax > 0 && tmin < t_max) ? tmin : FLT_MAX;
+}
+
+// Moller-Trumbore; returns t or -1 on a miss
+static float IntersectTriangle(const LocalRay *r, Vector3 v0, Vector3 e1, Vector3 e2) {
+    Vector3 p = Vector3CrossProduct(r->dir, e2);
+    float det = Vector3DotProduct(e1, p);
+    if (det > -BVH_EPSILON && det < BVH_EPSILON) return -1;
+
+    float inv_det = 1.0f / det;
+    Vector3 tv = Vector3Subtract(r->origin, v0);
+    float u = Vector3DotProduct(tv, p) * inv_det;
+    if (u < 0.0f || u > 1.0f) return -1;
+
+    Vector3 q = Vector3CrossProduct(tv, e1);
+    float v = Vector3DotProduct(r->dir, q) * inv_det;
+    if (v < 0.0f || u + v > 1.0f) return -1;
+
+    float t = Vector3DotProduct(e2, q) * inv_det;
+    return (t > BVH_EPSILON) ? t : -1;
+}
+
+// Shared traversal: closest hit, or any hit in [t_min, t_max] when any_hit is set
+static int Traverse(const MeshBVH *bvh, const LocalRay *r, float t_min, float *t_best, bool any_hit) {
+    int best = -1;
+    int stack[MESH_BVH_STACK_SIZE];
+    int sp = 0;
+
+    if (IntersectBox(r, bvh->nodes[0].min, bvh->nodes[0].max, *t_best) == FLT_MAX) return -1;
+    stack[sp++] = 0;
+
+    while (sp > 0) {
+        const MeshBVHNode *node = &bvh->nodes[stack[--sp]];
+
+        if (node->count > 0) {
+            for (int k = node->left_first; k < node->left_first + node->count; k++) {
+                float t = IntersectTriangle(r, bvh->v0[k], bvh->e1[k], bvh->e2[k]);
+                if (t > t_min && t < *t_best) {
+                    *t_best = t;
+                    best = k;
+                    if (any_hit) return best;
+                }
+            }
+            continue;
+        }
+
+        // Visit the nearer child first
+        int a = node->left_first, b = a + 1;
+        float ta = IntersectBox(r, bvh->nodes[a].min, bvh->nodes[a].max, *t_best);
+        float tb = IntersectBox(r, bvh->nodes[b].min, bvh->nodes[b].max, *t_best);
+        if (ta > tb) {
+            float tt = ta;
+            ta = tb;
+            tb = tt;
+            int ti = a;
+            a = b;
+            b = ti;
+        }
+        // Depth is capped at build time, so the stack never overflows
+        if (tb != FLT_MAX) stack[sp++] = b;
+        if (ta != FLT_MAX) stack[sp++] = a;
+    }
+    return best;
+}
+
+RayCollision MeshBVH_RaycastInstance(const MeshBVH *bvh, const Matrix *inv_transform, Ray ray, float max_dist,
+                                     int *out_triangle) {
+    RayCollision hit = {0};
+    if (out_triangle) *out_triangle = -1;
+    if (!bvh->nodes) return hit;
+
+    LocalRay r = ToLocal(inv_transform, ray);
+    float t = max_dist;
+    int k = Traverse(bvh, &r, 0.0f, &t, false);
+    if (k < 0) return hit;
+
+    // World normal via the inverse transpose (handles any scale)
+    Vector3 n = Vector3CrossProduct(bvh->e1[k], bvh->e2[k]);
+    const Matrix *m = inv_transform;
+    Vector3 wn = {m->m0 * n.x + m->m1 * n.y + m->m2 * n.z, m->m4 * n.x + m->m5 * n.y + m->m6 * n.z,
+                  m->m8 * n.x + m->m9 * n.y + m->m10 * n.z};
+
+    hit.hit = true;
+    hit.distance = t;
+    hit.point = Vector3Add(ray.position, Vector3Scale(ray.direction, t));
+    hit.normal = Vector3Normalize(wn);
+    if (out_triangle) *out_triangle = bvh->tri_index[k];
+    return hit;
+}
+
+bool MeshBVH_OccludedInstance(const MeshBVH *bvh, const Matrix *inv_transform, Ray ray, float min_dist,
+                              float max_dist) {
+    if (!bvh->nodes) return false;
+
+    LocalRay r = ToLocal(inv_transform, ray);
+    float t = max_dist;
+    return Traverse(bvh, &r, min_dist, &t, true) >= 0;
+}
+
+RayCollision MeshBVH_Raycast(const MeshBVH *bvh, Ray ray, int *out_triangle) {
+    return MeshBVH_RaycastInstance(bvh, &bvh->inv_transform, ray, FLT_MAX, out_triangle);
+}
+
+bool MeshBVH_Occluded(const MeshBVH *bvh, Ray ray, float min_dist, float max_dist) {
+    return MeshBVH_OccludedInstance(bvh, &bvh->inv_transform, ray, min_dist, max_dist);
+}
@@ -0,0 +1,74 @@
+#ifndef MESH_BVH_H
+#define MESH_BVH_H
+
+#include <stdbool.h>
+#include "raylib.h"
+
+//------------------------------------------------------------------------------
+// Constants
+//------------------------------------------------------------------------------
+#define MESH_BVH_LEAF_SIZE 4      // Max triangles per leaf
+#define MESH_BVH_SAH_BINS 16      // Split candidates per axis
+#define MESH_BVH_STACK_SIZE 64
+#define MESH_BVH_MAX_DEPTH (MESH_BVH_STACK_SIZE - 1) // Deeper nodes stay leaves, so traversal never overflows
+
+//------------------------------------------------------------------------------
+// Mesh bounding volume hierarchy
+//------------------------------------------------------------------------------
+// Built once in mesh-local space when a mesh is loaded. Rays are taken into
+// local space with the inverse model transform, so rescaling or rotating the
+// mesh only updates the stored matrices. Results match GetRayCollisionMesh
+// (closest hit, both faces, geometric normal from winding) and also report
+// the triangle index.
+
+typedef struct {
+    Vector3 min, max;
+    int left_first;  // Leaf: first triangle; internal: left child (right = left + 1)
+    int count;       // Triangles in leaf, 0 for internal nodes
+} MeshBVHNode;
+
+typedef struct {
+    MeshBVHNode *nodes;
+    int node_count;
+    int max_depth;      // Deepest leaf (root = 0)
+
+    // Triangles in leaf order
+    Vector3 *v0;
+    Vector3 *e1;        // v1 - v0
+    Vector3 *e2;        // v2 - v0
+    int *tri_index;     // Original triangle index in the mesh
+    int tri_count;
+
+    Matrix transform;       // Local -> world
+    Matrix inv_transform;   // World -> local
+} MeshBVH;
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+
+// Build from a mesh (indexed or triangle soup); returns false on failure or empty mesh
+bool MeshBVH_Build(MeshBVH *bvh, Mesh mesh);
+
+// Release memory (safe on an unbuilt BVH)
+void MeshBVH_Free(MeshBVH *bvh);
+
+// Set the model transform applied to rays
+void MeshBVH_SetTransform(MeshBVH *bvh, Matrix transform);
+
+// Closest hit along a world-space ray
+// out_triangle: optional, original triangle index or -1
+RayCollision MeshBVH_Raycast(const MeshBVH *bvh, Ray ray, int *out_triangle);
+
+// True if anything is hit between min_dist and max_dist (world units) along the ray
+// Stops at the first hit, so it is cheaper than MeshBVH_Raycast for shadow tests
+bool MeshBVH_Occluded(const MeshBVH *bvh, Ray ray, float min_dist, float max_dist);
+
+// The same queries for one placed copy of the mesh: inv_transform (world -> local) is used instead of the stored
+// one, so a single BVH serves any number of instances. Raycast hits beyond max_dist are ignored.
+RayCollision MeshBVH_RaycastInstance(const MeshBVH *bvh, const Matrix *inv_transform, Ray ray, float max_dist,
+                                     int *out_triangle);
+bool MeshBVH_OccludedInstance(const MeshBVH *bvh, const Matrix *inv_transform, Ray ray, float min_dist,
+                              float max_dist);
+
+#endif // MESH_BVH_H
@@ -0,0 +1,582 @@
+/*
+ * Quadric error mesh decimation for display LODs
+ */
+
+#include "mesh_simplify.h"
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "raymath.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <process.h>
+#define AtomicLoad(p) InterlockedCompareExchange((volatile LONG *)(p), 0, 0)
+#define AtomicStore(p, v) InterlockedExchange((volatile LONG *)(p), (v))
+#else
+#include <pthread.h>
+// Release/acquire so the levels written before done are visible to the thread that sees it set
+#define AtomicLoad(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define AtomicStore(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#endif
+
+#define SIMPLIFY_MAX_ITERATIONS 100
+#define SIMPLIFY_AGGRESSIVENESS 7.0  // Threshold growth exponent (higher = faster, lower quality)
+#define SIMPLIFY_FLIP_DOT 0.2f       // Reject collapses that turn a face more than ~78 degrees
+#define SIMPLIFY_SLIVER_DOT 0.999f   // Corner angle below ~2.5 degrees counts as a sliver
+#define SIMPLIFY_INFLATE_MIN_DOT 0.5f // Sharper corners are pushed out at most twice the offset
+
+//------------------------------------------------------------------------------
+// Quadrics
+//------------------------------------------------------------------------------
+
+// Symmetric 4x4 matrix stored as its upper triangle
+typedef struct {
+    double m[10];
+} Quadric;
+
+static Quadric QuadricPlane(double a, double b, double c, double d) {
+    return (Quadric) {{a * a, a * b, a * c, a * d, b * b, b * c, b * d, c * c, c * d, d * d}};
+}
+
+static void QuadricAdd(Quadric *q, const Quadric *o) {
+    for (int i = 0; i < 10; i++) q->m[i] += o->m[i];
+}
+
+static double QuadricDet(const Quadric *q, int a11, int a12, int a13, int a21, int a22, int a23, int a31, int a32,
+                         int a33) {
+    const double *m = q->m;
+    return m[a11] * m[a22] * m[a33] + m[a13] * m[a21] * m[a32] + m[a12] * m[a23] * m[a31] -
+           m[a13] * m[a22] * m[a31] - m[a11] * m[a23] * m[a32] - m[a12] * m[a21] * m[a33];
+}
+
+static double QuadricError(const Quadric *q, Vector3 p) {
+    const double *m = q->m;
+    double x = p.x, y = p.y, z = p.z;
+    return m[0] * x * x + 2 * m[1] * x * y + 2 * m[2] * x * z + 2 * m[3] * x + m[4] * y * y + 2 * m[5] * y * z +
+           2 * m[6] * y + m[7] * z * z + 2 * m[8] * z + m[9];
+}
+
+//------------------------------------------------------------------------------
+// Simplifier state
+//------------------------------------------------------------------------------
+typedef struct {
+    int v[3];
+    float err[4];   // Collapse error per edge, [3] = minimum
+    Vector3 n;
+    bool deleted;
+    bool dirty;
+} SimTri;
+
+typedef struct {
+    Vector3 p;
+    Quadric q;
+    int tstart, tcount;  // Range in refs
+    bool border;
+} SimVert;
+
+typedef struct {
+    int tid;
+    int tvertex;
+} SimRef;
+
+typedef struct {
+    SimTri *tris;
+    int tri_count;
+    SimVert *verts;
+    int vert_count;
+    SimRef *refs;
+    int ref_count, ref_capacity;
+    bool *scratch0, *scratch1;  // Per-ref "triangle will be deleted" flags for the two collapse ends
+    int scratch0_capacity, scratch1_capacity;
+} Simplifier;
+
+static bool Reserve(void **ptr, int *capacity, int needed, size_t elem) {
+    if (needed <= *capacity) return true;
+    int cap = *capacity > 0 ? *capacity : 64;
+    while (cap < needed) cap *= 2;
+    void *p = realloc(*ptr, (size_t) cap * elem);
+    if (!p) return false;
+    *ptr = p;
+    *capacity = cap;
+    return true;
+}
+
+static bool PushRef(Simplifier *s, SimRef r) {
+    if (!Reserve((void **) &s->refs, &s->ref_capacity, s->ref_count + 1, sizeof(SimRef))) return false;
+    s->refs[s->ref_count++] = r;
+    return true;
+}
+
+static bool InitSimplifier(Simplifier *s, const MeshTopology *topo) {
+    memset(s, 0, sizeof(Simplifier));
+    s->tris = (SimTri *) malloc(topo->tri_count * sizeof(SimTri));
+    s->verts = (SimVert *) calloc(topo->vertex_count, sizeof(SimVert));
+    if (!s->tris || !s->verts) return false;
+
+    s->vert_count = topo->vertex_count;
+    for (int i = 0; i < topo->vertex_count; i++) s->verts[i].p = topo->positions[i];
+
+    // Faces collapsed by welding are dropped up front
+    for (int t = 0; t < topo->tri_count; t++) {
+        const int *v = &topo->tri_vertices[t * 3];
+        if (v[0] == v[1] || v[1] == v[2] || v[2] == v[0]) continue;
+        s->tris[s->tri_count++] = (SimTri) {{v[0], v[1], v[2]}, {0}, {0, 0, 0}, false, false};
+    }
+
+    // Open and non-manifold edges pin their vertices
+    for (int e = 0; e < topo->edge_count; e++) {
+        if (topo->edges[e].face_count != 2) {
+            s->verts[topo->edges[e].v[0]].border = true;
+            s->verts[topo->edges[e].v[1]].border = true;
+        }
+    }
+    return true;
+}
+
+static void FreeSimplifier(Simplifier *s) {
+    free(s->tris);
+    free(s->verts);
+    free(s->refs);
+    free(s->scratch0);
+    free(s->scratch1);
+    memset(s, 0, sizeof(Simplifier));
+}
+
+//------------------------------------------------------------------------------
+// Edge collapse
+//------------------------------------------------------------------------------
+
+// Error of collapsing i0-i1 and the position minimising it
+static float CollapseError(const Simplifier *s, int i0, int i1, Vector3 *out_p) {
+    Quadric q = s->verts[i0].q;
+    QuadricAdd(&q, &s->verts[i1].q);
+    bool border = s->verts[i0].border && s->verts[i1].border;
+
+    Vector3 p1 = s->verts[i0].p, p2 = s->verts[i1].p;
+    Vector3 p3 = Vector3Scale(Vector3Add(p1, p2), 0.5f);
+
+    double det = QuadricDet(&q, 0, 1, 2, 1, 4, 5, 2, 5, 7);
+    if (det != 0 && !border) {
+        Vector3 p = {(float) (-1 / det * QuadricDet(&q, 1, 2, 3, 4, 5, 6, 5, 7, 8)),
+                     (float) (1 / det * QuadricDet(&q, 0, 2, 3, 1, 5, 6, 2, 7, 8)),
+                     (float) (-1 / det * QuadricDet(&q, 0, 1, 3, 1, 4, 6, 2, 5, 8))};
+
+        // Nearly flat neighbourhoods give ill-conditioned solves that shoot far off the edge
+        if (Vector3DistanceSqr(p, p3) <= Vector3DistanceSqr(p1, p2)) {
+            *out_p = p;
+            return (float) QuadricError(&q, p);
+        }
+    }
+
+    // Singular (flat region), ill-conditioned or along a border: best of the endpoints and midpoint
+    double e1 = QuadricError(&q, p1), e2 = QuadricError(&q, p2), e3 = QuadricError(&q, p3);
+    double best = fmin(e1, fmin(e2, e3));
+    *out_p = (best == e1) ? p1 : (best == e2) ? p2 : p3;
+    return (float) best;
+}
+
+static Vector3 FaceNormal(const Simplifier *s, const SimTri *t) {
+    Vector3 p0 = s->verts[t->v[0]].p;
+    return Vector3Normalize(Vector3CrossProduct(Vector3Subtract(s->verts[t->v[1]].p, p0),
+                                                Vector3Subtract(s->verts[t->v[2]].p, p0)));
+}
+
+static void UpdateTriError(const Simplifier *s, SimTri *t) {
+    Vector3 p;
+    for (int j = 0; j < 3; j++) t->err[j] = CollapseError(s, t->v[j], t->v[(j + 1) % 3], &p);
+    t->err[3] = fminf(t->err[0], fminf(t->err[1], t->err[2]));
+}
+
+// True if moving vertex v (being merged with other) to p would fold one of its faces.
+// Faces shared with other are flagged in will_delete since the collapse removes them.
+static bool Flipped(const Simplifier *s, Vector3 p, int other, const SimVert *v, bool *will_delete) {
+    for (int k = 0; k < v->tcount; k++) {
+        const SimRef *r = &s->refs[v->tstart + k];
+        const SimTri *t = &s->tris[r->tid];
+        if (t->deleted) continue;
+
+        int id1 = t->v[(r->tvertex + 1) % 3];
+        int id2 = t->v[(r->tvertex + 2) % 3];
+        if (id1 == other || id2 == other) {
+            will_delete[k] = true;
+            continue;
+        }
+        will_delete[k] = false;
+
+        Vector3 d1 = Vector3Normalize(Vector3Subtract(s->verts[id1].p, p));
+        Vector3 d2 = Vector3Normalize(Vector3Subtract(s->verts[id2].p, p));
+        if (fabsf(Vector3DotProduct(d1, d2)) > SIMPLIFY_SLIVER_DOT) {
+            // Don't create slivers, but let existing ones (fan centres on discs and cylinders) move
+            Vector3 o1 = Vector3Normalize(Vector3Subtract(s->verts[id1].p, v->p));
+            Vector3 o2 = Vector3Normalize(Vector3Subtract(s->verts[id2].p, v->p));
+            if (fabsf(Vector3DotProduct(o1, o2)) <= SIMPLIFY_SLIVER_DOT) return true;
+        }
+        Vector3 n = Vector3Normalize(Vector3CrossProduct(d1, d2));
+        if (Vector3DotProduct(n, t->n) < SIMPLIFY_FLIP_DOT) return true;
+    }
+    return false;
+}
+
+// Point v's surviving faces at i0 and append their refs
+static bool RelinkFaces(Simplifier *s, int i0, const SimVert *v, const bool *will_delete, int *deleted_count) {
+    for (int k = 0; k < v->tcount; k++) {
+        SimRef r = s->refs[v->tstart + k];
+        SimTri *t = &s->tris[r.tid];
+        if (t->deleted) continue;
+        if (will_delete[k]) {
+            t->deleted = true;
+            (*deleted_count)++;
+            continue;
+        }
+        t->v[r.tvertex] = i0;
+        t->dirty = true;
+        t->n = FaceNormal(s, t);
+        UpdateTriError(s, t);
+        if (!PushRef(s, r)) return false;
+    }
+    return true;
+}
+
+// Drop deleted faces and rebuild the vertex -> face references
+static bool RebuildRefs(Simplifier *s, bool first) {
+    if (!first) {
+        int n = 0;
+        for (int i = 0; i < s->tri_count; i++) {
+            if (!s->tris[i].deleted) s->tris[n++] = s->tris[i];
+        }
+        s->tri_count = n;
+    }
+
+    if (first) {
+        for (int i = 0; i < s->tri_count; i++) {
+            SimTri *t = &s->tris[i];
+            Vector3 n = FaceNormal(s, t);
+            t->n = n;
+            Quadric q = QuadricPlane(n.x, n.y, n.z, -Vector3DotProduct(n, s->verts[t->v[0]].p));
+            for (int j = 0; j < 3; j++) QuadricAdd(&s->verts[t->v[j]].q, &q);
+        }
+        for (int i = 0; i < s->tri_count; i++) UpdateTriError(s, &s->tris[i]);
+    }
+
+    for (int i = 0; i < s->vert_count; i++) {
+        s->verts[i].tstart = 0;
+        s->verts[i].tcount = 0;
+    }
+    for (int i = 0; i < s->tri_count; i++) {
+        for (int j = 0; j < 3; j++) s->verts[s->tris[i].v[j]].tcount++;
+    }
+    int start = 0;
+    for (int i = 0; i < s->vert_count; i++) {
+        s->verts[i].tstart = start;
+        start += s->verts[i].tcount;
+        s->verts[i].tcount = 0;
+    }
+
+    if (!Reserve((void **) &s->refs, &s->ref_capacity, s->tri_count * 3, sizeof(SimRef))) return false;
+    s->ref_count = s->tri_count * 3;
+    for (int i = 0; i < s->tri_count; i++) {
+        for (int j = 0; j < 3; j++) {
+            SimVert *v = &s->verts[s->tris[i].v[j]];
+            s->refs[v->tstart + v->tcount++] = (SimRef) {i, j};
+        }
+    }
+    return true;
+}
+
+// Collapse edges until at most target faces remain or no collapse costs less than max_error2
+// (quadric error, i.e. summed squared plane distance); returns false on allocation failure
+static bool SimplifyTo(Simplifier *s, int target, double max_error2, bool first, int *cancel) {
+    int deleted = 0;
+    int start_count = s->tri_count;
+
+    for (int iteration = 0; iteration < SIMPLIFY_MAX_ITERATIONS; iteration++) {
+        if (start_count - deleted <= target) break;
+        if (cancel && AtomicLoad(cancel)) return false;
+
+        // Compact every few passes so refs stay short
+        if (iteration % 5 == 0 && !RebuildRefs(s, first && iteration == 0)) return false;
+        if (iteration % 5 == 0) {
+            start_count = s->tri_count;
+            deleted = 0;
+        }
+
+        for (int i = 0; i < s->tri_count; i++) s->tris[i].dirty = false;
+
+        // Only collapse edges below a threshold that grows each pass
+        double threshold = 0.000000001 * pow(iteration + 3, SIMPLIFY_AGGRESSIVENESS);
+        bool capped = threshold >= max_error2;
+        if (capped) threshold = max_error2;
+        int collapsed = 0;
+
+        for (int i = 0; i < s->tri_count; i++) {
+            SimTri *t = &s->tris[i];
+            if (t->err[3] > threshold || t->deleted || t->dirty) continue;
+
+            for (int j = 0; j < 3; j++) {
+                if (t->err[j] >= threshold) continue;
+                int i0 = t->v[j], i1 = t->v[(j + 1) % 3];
+                SimVert *v0 = &s->verts[i0], *v1 = &s->verts[i1];
+                if (v0->border != v1->border) continue;
+
+                Vector3 p;
+                CollapseError(s, i0, i1, &p);
+
+                if (!Reserve((void **) &s->scratch0, &s->scratch0_capacity, v0->tcount, sizeof(bool)) ||
+                    !Reserve((void **) &s->scratch1, &s->scratch1_capacity, v1->tcount, sizeof(bool)))
+                    return false;
+
+                if (Flipped(s, p, i1, v0, s->scratch0) || Flipped(s, p, i0, v1, s->scratch1)) continue;
+
+                v0->p = p;
+                QuadricAdd(&v0->q, &v1->q);
+
+                int tstart = s->ref_count;
+                if (!RelinkFaces(s, i0, v0, s->scratch0, &deleted)) return false;
+                if (!RelinkFaces(s, i0, v1, s->scratch1, &deleted)) return false;
+                int tcount = s->ref_count - tstart;
+
+                // Reuse v0's old ref range when the merged fan fits
+                if (tcount <= v0->tcount) {
+                    memmove(&s->refs[v0->tstart], &s->refs[tstart], tcount * sizeof(SimRef));
+                    s->ref_count = tstart;
+                } else {
+                    v0->tstart = tstart;
+                }
+                v0->tcount = tcount;
+                collapsed++;
+                break;
+            }
+            if (start_count - deleted <= target) break;
+        }
+        if (capped && collapsed == 0) break;
+    }
+
+    // Leave the face list compact for the export and the next level
+    int n = 0;
+    for (int i = 0; i < s->tri_count; i++) {
+        if (!s->tris[i].deleted) s->tris[n++] = s->tris[i];
+    }
+    s->tri_count = n;
+    return true;
+}
+
+static void FreeMeshArrays(Mesh *mesh) {
+    RL_FREE(mesh->vertices);
+    RL_FREE(mesh->normals);
+    RL_FREE(mesh->texcoords);
+}
+
+// Unindexed copy with flat normals, matching the STL loader layout
+static bool ExportMesh(const Simplifier *s, Mesh *out) {
+    Mesh mesh = {0};
+    mesh.triangleCount = s->tri_count;
+    mesh.vertexCount = s->tri_count * 3;
+    mesh.vertices = (float *) RL_MALLOC(sizeof(float) * 3 * mesh.vertexCount);
+    mesh.normals = (float *) RL_MALLOC(sizeof(float) * 3 * mesh.vertexCount);
+    mesh.texcoords = (float *) RL_CALLOC(mesh.vertexCount * 2, sizeof(float));
+    if (!mesh.vertices || !mesh.normals || !mesh.texcoords) {
+        FreeMeshArrays(&mesh);
+        return false;
+    }
+
+    for (int i = 0; i < s->tri_count; i++) {
+        const SimTri *t = &s->tris[i];
+        Vector3 n = FaceNormal(s, t);
+        for (int j = 0; j < 3; j++) {
+            Vector3 p = s->verts[t->v[j]].p;
+            int k = (i * 3 + j) * 3;
+            mesh.vertices[k] = p.x;
+            mesh.vertices[k + 1] = p.y;
+            mesh.vertices[k + 2] = p.z;
+            mesh.normals[k] = n.x;
+            mesh.normals[k + 1] = n.y;
+            mesh.normals[k + 2] = n.z;
+        }
+    }
+    *out = mesh;
+    return true;
+}
+
+// Push every vertex out along its area-weighted normal far enough that each of its faces moves out by offset
+static bool Inflate(Simplifier *s, float offset) {
+    Vector3 *normals = (Vector3 *) calloc(s->vert_count, sizeof(Vector3));
+    float *min_dot = (float *) malloc(s->vert_count * sizeof(float));
+    if (!normals || !min_dot) {
+        free(normals);
+        free(min_dot);
+        return false;
+    }
+
+    for (int i = 0; i < s->tri_count; i++) {
+        const SimTri *t = &s->tris[i];
+        Vector3 p0 = s->verts[t->v[0]].p;
+        Vector3 area = Vector3CrossProduct(Vector3Subtract(s->verts[t->v[1]].p, p0),
+                                           Vector3Subtract(s->verts[t->v[2]].p, p0));
+        for (int j = 0; j < 3; j++) normals[t->v[j]] = Vector3Add(normals[t->v[j]], area);
+    }
+    for (int i = 0; i < s->vert_count; i++) {
+        normals[i] = Vector3Normalize(normals[i]);
+        min_dot[i] = 1.0f;
+    }
+    for (int i = 0; i < s->tri_count; i++) {
+        const SimTri *t = &s->tris[i];
+        Vector3 n = FaceNormal(s, t);
+        for (int j = 0; j < 3; j++) {
+            int v = t->v[j];
+            min_dot[v] = fminf(min_dot[v], Vector3DotProduct(normals[v], n));
+        }
+    }
+    for (int i = 0; i < s->vert_count; i++) {
+        float scale = offset / fmaxf(min_dot[i], SIMPLIFY_INFLATE_MIN_DOT);
+        s->verts[i].p = Vector3Add(s->verts[i].p, Vector3Scale(normals[i], scale));
+    }
+
+    free(normals);
+    free(min_dot);
+    return true;
+}
+
+static int DecimateLevels(const MeshTopology *topo, const int *targets, int level_count, Mesh *out_levels, int *cancel) {
+    Simplifier s;
+    int produced = 0;
+    if (level_count > MESH_LOD_MAX_LEVELS) level_count = MESH_LOD_MAX_LEVELS;
+
+    if (InitSimplifier(&s, topo)) {
+        // Each level continues from the previous one rather than starting over
+        for (int l = 0; l < level_count; l++) {
+            if (!SimplifyTo(&s, targets[l], DBL_MAX, l == 0, cancel)) break;
+            if (!ExportMesh(&s, &out_levels[l])) break;
+            produced++;
+        }
+    }
+    FreeSimplifier(&s);
+    return produced;
+}
+
+int MeshSimplify_Decimate(const MeshTopology *topo, const int *targets, int level_count, Mesh *out_levels) {
+    return DecimateLevels(topo, targets, level_count, out_levels, NULL);
+}
+
+bool MeshSimplify_DecimateToError(const MeshTopology *topo, float max_error, float inflate, Mesh *out) {
+    Simplifier s;
+    bool ok = InitSimplifier(&s, topo) && SimplifyTo(&s, 0, (double) max_error * max_error, true, NULL) &&
+              (inflate == 0.0f || Inflate(&s, inflate)) && ExportMesh(&s, out);
+    FreeSimplifier(&s);
+    return ok;
+}
+
+void MeshSimplify_FreeMesh(Mesh *mesh) {
+    FreeMeshArrays(mesh);
+    *mesh = (Mesh) {0};
+}
+
+//------------------------------------------------------------------------------
+// Background job
+//------------------------------------------------------------------------------
+struct MeshSimplifyJob {
+    MeshTopology topo;  // Private copy (only the fields the simplifier reads)
+    int targets[MESH_LOD_MAX_LEVELS];
+    int level_count;
+    Mesh levels[MESH_LOD_MAX_LEVELS];
+    int produced;
+    int done;           // Set by the worker once levels and produced are final (atomic)
+    int cancel;         // Set by the owner to stop the worker (atomic)
+#ifdef _WIN32
+    HANDLE thread;
+#else
+    pthread_t thread;
+#endif
+};
+
+static void RunJob(MeshSimplifyJob *job) {
+    job->produced = DecimateLevels(&job->topo, job->targets, job->level_count, job->levels, &job->cancel);
+    AtomicStore(&job->done, 1);
+}
+
+#ifdef _WIN32
+static unsigned __stdcall SimplifyThread(void *arg) {
+    RunJob((MeshSimplifyJob *) arg);
+    return 0;
+}
+#else
+static void *SimplifyThread(void *arg) {
+    RunJob((MeshSimplifyJob *) arg);
+    return NULL;
+}
+#endif
+
+static void FreeJobTopology(MeshTopology *topo) {
+    free(topo->positions);
+    free(topo->tri_vertices);
+    free(topo->edges);
+}
+
+MeshSimplifyJob *MeshSimplify_Start(const MeshTopology *topo, const int *targets, int level_count) {
+    MeshSimplifyJob *job = (MeshSimplifyJob *) calloc(1, sizeof(MeshSimplifyJob));
+    if (!job) return NULL;
+    if (level_count > MESH_LOD_MAX_LEVELS) level_count = MESH_LOD_MAX_LEVELS;
+    memcpy(job->targets, targets, level_count * sizeof(int));
+    job->level_count = level_count;
+
+    MeshTopology *copy = &job->topo;
+    copy->tri_count = topo->tri_count;
+    copy->vertex_count = topo->vertex_count;
+    copy->edge_count = topo->edge_count;
+    copy->positions = (Vector3 *) malloc(topo->vertex_count * sizeof(Vector3));
+    copy->tri_vertices = (int *) malloc(topo->tri_count * 3 * sizeof(int));
+    copy->edges = (MeshEdge *) malloc(topo->edge_count * sizeof(MeshEdge));
+    if (!copy->positions || !copy->tri_vertices || !copy->edges) {
+        FreeJobTopology(copy);
+        free(job);
+        return NULL;
+    }
+    memcpy(copy->positions, topo->positions, topo->vertex_count * sizeof(Vector3));
+    memcpy(copy->tri_vertices, topo->tri_vertices, topo->tri_count * 3 * sizeof(int));
+    memcpy(copy->edges, topo->edges, topo->edge_count * sizeof(MeshEdge));
+
+#ifdef _WIN32
+    job->thread = (HANDLE) _beginthreadex(NULL, 0, SimplifyThread, job, 0, NULL);
+    bool started = job->thread != NULL;
+#else
+    bool started = pthread_create(&job->thread, NULL, SimplifyThread, job) == 0;
+#endif
+    if (!started) {
+        FreeJobTopology(copy);
+        free(job);
+        return NULL;
+    }
+    return job;
+}
+
+bool MeshSimplify_IsDone(MeshSimplifyJob *job) {
+    return AtomicLoad(&job->done) != 0;
+}
+
+static void JoinJob(MeshSimplifyJob *job) {
+#ifdef _WIN32
+    WaitForSingleObject(job->thread, INFINITE);
+    CloseHandle(job->thread);
+#else
+    pthread_join(job->thread, NULL);
+#endif
+    FreeJobTopology(&job->topo);
+}
+
+int MeshSimplify_Finish(MeshSimplifyJob *job, Mesh *out_levels) {
+    JoinJob(job);
+    int produced = job->produced;
+    memcpy(out_levels, job->levels, produced * sizeof(Mesh));
+    free(job);
+    return produced;
+}
+
+void MeshSimplify_Cancel(MeshSimplifyJob *job) {
+    if (!job) return;
+    AtomicStore(&job->cancel, 1);
+    JoinJob(job);
+    for (int l = 0; l < job->produced; l++) MeshSimplify_FreeMesh(&job->levels[l]);
+    free(job);
+}
@@ -0,0 +1,51 @@
+#ifndef MESH_SIMPLIFY_H
+#define MESH_SIMPLIFY_H
+
+#include <stdbool.h>
+#include "raylib.h"
+#include "mesh_topology.h"
+
+//------------------------------------------------------------------------------
+// Constants
+//------------------------------------------------------------------------------
+#define MESH_LOD_MAX_LEVELS 2
+
+//------------------------------------------------------------------------------
+// Quadric error decimation
+//------------------------------------------------------------------------------
+// Garland-Heckbert edge collapse with a rising error threshold instead of a
+// priority queue. Works on the welded mesh, keeps open boundaries in place
+// and rejects collapses that flip a face. Output meshes are unindexed with
+// flat normals (same layout as the STL loader) and are not uploaded, so they
+// can be produced on a worker thread.
+
+typedef struct MeshSimplifyJob MeshSimplifyJob;
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+
+// Decimate to each target triangle count (descending) in one pass; returns levels produced
+int MeshSimplify_Decimate(const MeshTopology *topo, const int *targets, int level_count, Mesh *out_levels);
+
+// Collapse only while each collapse stays within max_error (mesh units) of the original
+// face planes, then move every face out along its normal by inflate (0 = in place) so the
+// result can enclose the original; returns false on allocation failure
+bool MeshSimplify_DecimateToError(const MeshTopology *topo, float max_error, float inflate, Mesh *out);
+
+// Release an output mesh that was never uploaded
+void MeshSimplify_FreeMesh(Mesh *mesh);
+
+// Same as MeshSimplify_Decimate on a worker thread; the topology is copied, so it can be freed after
+MeshSimplifyJob *MeshSimplify_Start(const MeshTopology *topo, const int *targets, int level_count);
+
+// True once the worker has finished (or failed)
+bool MeshSimplify_IsDone(MeshSimplifyJob *job);
+
+// Join the worker, move the levels to out_levels and free the job; returns levels produced
+int MeshSimplify_Finish(MeshSimplifyJob *job, Mesh *out_levels);
+
+// Stop the worker early and discard its results
+void MeshSimplify_Cancel(MeshSimplifyJob *job);
+
+#endif // MESH_SIMPLIFY_H
@@ -0,0 +1,206 @@
+/*
+ * Vertex welding and edge adjacency for imported meshes
+ */
+
+#include "mesh_topology.h"
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "raymath.h"
+
+//------------------------------------------------------------------------------
+// Hashing
+//------------------------------------------------------------------------------
+
+// Open addressing table size: power of two with at least twice the entries
+static int TableSize(int entries) {
+    int size = 16;
+    while (size < entries * 2) size <<= 1;
+    return size;
+}
+
+static uint32_t HashInts(int64_t a, int64_t b, int64_t c) {
+    uint64_t h = (uint64_t) a * 0x9E3779B185EBCA87ull;
+    h ^= (uint64_t) b * 0xC2B2AE3D27D4EB4Full + (h << 6) + (h >> 2);
+    h ^= (uint64_t) c * 0x165667B19E3779F9ull + (h << 6) + (h >> 2);
+    return (uint32_t) (h ^ (h >> 32));
+}
+
+//------------------------------------------------------------------------------
+// Build
+//------------------------------------------------------------------------------
+
+// First vertex stored under cell q within sqrt(tol2) of p, or -1
+static int FindInCell(const int *table, int size, const int64_t *keys, const Vector3 *positions, const int64_t *q,
+                      Vector3 p, float tol2) {
+    uint32_t slot = HashInts(q[0], q[1], q[2]) & (size - 1);
+    while (table[slot] >= 0) {
+        int id = table[slot];
+        const int64_t *k = &keys[id * 3];
+        if (k[0] == q[0] && k[1] == q[1] && k[2] == q[2] && Vector3DistanceSqr(positions[id], p) <= tol2) return id;
+        slot = (slot + 1) & (size - 1);
+    }
+    return -1;
+}
+
+// Weld corners on a quantised grid; fills tri_vertices and positions
+static bool WeldVertices(MeshTopology *topo, Mesh mesh) {
+    int corners = topo->tri_count * 3;
+    const float *v = mesh.vertices;
+
+    Vector3 mn = {FLT_MAX, FLT_MAX, FLT_MAX}, mx = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+    for (int i = 0; i < mesh.vertexCount; i++) {
+        Vector3 p = {v[i * 3], v[i * 3 + 1], v[i * 3 + 2]};
+        mn = Vector3Min(mn, p);
+        mx = Vector3Max(mx, p);
+    }
+    float cell = Vector3Distance(mn, mx) * MESH_WELD_TOLERANCE;
+    if (cell <= 0) cell = FLT_MIN;
+
+    int size = TableSize(corners);
+    int *table = (int *) malloc(size * sizeof(int));
+    int64_t *keys = (int64_t *) malloc(corners * 3 * sizeof(int64_t));
+    topo->positions = (Vector3 *) malloc(corners * sizeof(Vector3));
+    if (!table || !keys || !topo->positions) {
+        free(table);
+        free(keys);
+        return false;
+    }
+    memset(table, -1, size * sizeof(int));
+
+    for (int c = 0; c < corners; c++) {
+        int vi = mesh.indices ? mesh.indices[c] : c;
+        Vector3 p = {v[vi * 3], v[vi * 3 + 1], v[vi * 3 + 2]};
+        int64_t q[3] = {(int64_t) floorf((p.x - mn.x) / cell), (int64_t) floorf((p.y - mn.y) / cell),
+                        (int64_t) floorf((p.z - mn.z) / cell)};
+
+        // Exact duplicates land in the same cell; near-duplicates may straddle a cell boundary
+        int id = FindInCell(table, size, keys, topo->positions, q, p, cell * cell);
+        for (int d = 0; d < 27 && id < 0; d++) {
+            if (d == 13) continue; // Own cell, already searched
+            int64_t n[3] = {q[0] + d % 3 - 1, q[1] + (d / 3) % 3 - 1, q[2] + d / 9 - 1};
+            id = FindInCell(table, size, keys, topo->positions, n, p, cell * cell);
+        }
+        if (id < 0) {
+            uint32_t slot = HashInts(q[0], q[1], q[2]) & (size - 1);
+            while (table[slot] >= 0) slot = (slot + 1) & (size - 1);
+            id = topo->vertex_count++;
+            memcpy(&keys[id * 3], q, sizeof(q));
+            topo->positions[id] = p;
+            table[slot] = id;
+        }
+        topo->tri_vertices[c] = id;
+    }
+
+    free(table);
+    free(keys);
+    return true;
+}
+
+// One edge per welded vertex pair, recording up to two adjacent faces
+static bool BuildEdges(MeshTopology *topo) {
+    int corners = topo->tri_count * 3;
+    int size = TableSize(corners);
+    int *table = (int *) malloc(size * sizeof(int));
+    topo->edges = (MeshEdge *) malloc(corners * sizeof(MeshEdge));
+    if (!table || !topo->edges) {
+        free(table);
+        return false;
+    }
+    memset(table, -1, size * sizeof(int));
+
+    for (int t = 0; t < topo->tri_count; t++) {
+        const int *tv = &topo->tri_vertices[t * 3];
+        bool collapsed = (tv[0] == tv[1] || tv[1] == tv[2] || tv[2] == tv[0]);
+        for (int k = 0; k < 3; k++) {
+            int a = tv[k];
+            int b = tv[(k + 1) % 3];
+            topo->tri_edges[t * 3 + k] = -1;
+            if (collapsed) continue; // Welding removed this face; it adds no adjacency
+            if (a > b) {
+                int tmp = a;
+                a = b;
+                b = tmp;
+            }
+
+            uint32_t slot = HashInts(a, b, 0) & (size - 1);
+            int id = -1;
+            while (table[slot] >= 0) {
+                MeshEdge *e = &topo->edges[table[slot]];
+                if (e->v[0] == a && e->v[1] == b) {
+                    id = table[slot];
+                    break;
+                }
+                slot = (slot + 1) & (size - 1);
+            }
+            if (id < 0) {
+                id = topo->edge_count++;
+                topo->edges[id] = (MeshEdge) {{a, b}, {t, -1}, 0};
+                table[slot] = id;
+            } else if (topo->edges[id].face_count == 1) {
+                topo->edges[id].face[1] = t;
+            }
+            topo->edges[id].face_count++;
+            topo->tri_edges[t * 3 + k] = id;
+        }
+    }
+
+    free(table);
+    return true;
+}
+
+bool MeshTopology_Build(MeshTopology *topo, Mesh mesh) {
+    memset(topo, 0, sizeof(MeshTopology));
+
+    int n = mesh.indices ? mesh.triangleCount : mesh.vertexCount / 3;
+    if (n <= 0 || !mesh.vertices) return false;
+    topo->tri_count = n;
+
+    topo->tri_vertices = (int *) malloc(n * 3 * sizeof(int));
+    topo->tri_edges = (int *) malloc(n * 3 * sizeof(int));
+    topo->face_normals = (Vector3 *) malloc(n * sizeof(Vector3));
+    if (!topo->tri_vertices || !topo->tri_edges || !topo->face_normals || !WeldVertices(topo, mesh) ||
+        !BuildEdges(topo)) {
+        MeshTopology_Free(topo);
+        return false;
+    }
+
+    for (int t = 0; t < n; t++) {
+        Vector3 p0 = topo->positions[topo->tri_vertices[t * 3]];
+        Vector3 p1 = topo->positions[topo->tri_vertices[t * 3 + 1]];
+        Vector3 p2 = topo->positions[topo->tri_vertices[t * 3 + 2]];
+        Vector3 cr = Vector3CrossProduct(Vector3Subtract(p1, p0), Vector3Subtract(p2, p0));
+        float len = Vector3Length(cr);
+        topo->face_normals[t] = (len > 0) ? Vector3Scale(cr, 1.0f / len) : (Vector3) {0, 0, 0};
+    }
+    return true;
+}
+
+void MeshTopology_Free(MeshTopology *topo) {
+    free(topo->positions);
+    free(topo->tri_vertices);
+    free(topo->tri_edges);
+    free(topo->face_normals);
+    free(topo->edges);
+    memset(topo, 0, sizeof(MeshTopology));
+}
+
+//------------------------------------------------------------------------------
+// Queries
+//------------------------------------------------------------------------------
+bool MeshTopology_IsCrease(const MeshTopology *topo, int edge, float crease_deg) {
+    const MeshEdge *e = &topo->edges[edge];
+    if (e->face_count != 2) return true;
+    float d = Vector3DotProduct(topo->face_normals[e->face[0]], topo->face_normals[e->face[1]]);
+    return d < cosf(crease_deg * DEG2RAD);
+}
+
+int MeshTopology_Neighbor(const MeshTopology *topo, int tri, int k) {
+    int id = topo->tri_edges[tri * 3 + k];
+    if (id < 0) return -1;
+    const MeshEdge *e = &topo->edges[id];
+    if (e->face_count != 2) return -1;
+    return (e->face[0] == tri) ? e->face[1] : e->face[0];
+}
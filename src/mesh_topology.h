@@ -0,0 +1,55 @@
+#ifndef MESH_TOPOLOGY_H
+#define MESH_TOPOLOGY_H
+
+#include <stdbool.h>
+#include "raylib.h"
+
+//------------------------------------------------------------------------------
+// Constants
+//------------------------------------------------------------------------------
+#define MESH_WELD_TOLERANCE 1e-6f   // Weld distance as a fraction of the bounding box diagonal
+
+//------------------------------------------------------------------------------
+// Mesh topology
+//------------------------------------------------------------------------------
+// Connectivity for triangle-soup imports (STL stores every corner separately).
+// Corners closer than the weld tolerance share a vertex id, and each unique
+// vertex pair becomes one edge with up to two adjacent faces. Everything is in
+// mesh-local space, so it only needs rebuilding when a new mesh is loaded.
+
+typedef struct {
+    int v[2];           // Welded vertex ids (v[0] < v[1])
+    int face[2];        // Adjacent triangles, face[1] = -1 on a boundary
+    int face_count;     // > 2 means non-manifold
+} MeshEdge;
+
+typedef struct {
+    int tri_count;
+    int vertex_count;
+
+    Vector3 *positions;     // Welded vertex positions
+    int *tri_vertices;      // 3 welded vertex ids per triangle
+    int *tri_edges;         // 3 edge ids per triangle (edge k joins corners k and k+1), -1 if collapsed
+    Vector3 *face_normals;  // Unit normal per triangle, zero if degenerate
+
+    MeshEdge *edges;
+    int edge_count;
+} MeshTopology;
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+
+// Weld vertices and build edges; returns false on failure or empty mesh
+bool MeshTopology_Build(MeshTopology *topo, Mesh mesh);
+
+// Release memory (safe on an unbuilt topology)
+void MeshTopology_Free(MeshTopology *topo);
+
+// True if the edge is a boundary, non-manifold, or its faces meet at more than crease_deg
+bool MeshTopology_IsCrease(const MeshTopology *topo, int edge, float crease_deg);
+
+// Triangle across edge k of tri, or -1 on a boundary / non-manifold edge
+int MeshTopology_Neighbor(const MeshTopology *topo, int tri, int k);
+
+#endif // MESH_TOPOLOGY_H
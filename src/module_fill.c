@@ -0,0 +1,183 @@
+#include "app.h"
+#include "job_system.h"
+#include "module_fill.h"
+#include <math.h>
+#include <stdlib.h>
+
+//------------------------------------------------------------------------------
+// Module Array Fill
+//------------------------------------------------------------------------------
+
+// Shared inputs and per-cell results for one fill; jobs write disjoint instances
+typedef struct {
+    AppState *app;
+    const SurfacePanels *panels;
+    int panel;
+
+    int cells_per_instance;
+    const float *cell_u;        // Template cell positions in the rotated panel frame
+    const float *cell_v;
+    const float *origin_u;      // Instance origins in the panel frame
+    const float *origin_v;
+    int instance_count;
+
+    const Vector3 *existing;    // World positions of cells already placed
+    int existing_count;
+    float min_dist;             // Centre spacing to existing cells
+
+    Vector3 *positions;         // instance_count * cells_per_instance
+    Vector3 *normals;
+    bool *instance_ok;
+} FillJob;
+
+// Every cell of the instance lands on the panel, faces up, has headroom and clears existing cells
+static bool ValidateInstance(FillJob *job, int instance) {
+    for (int c = 0; c < job->cells_per_instance; c++) {
+        int slot = instance * job->cells_per_instance + c;
+        RayCollision hit;
+        if (!ProjectOntoPanel(job->app, job->panels, job->panel, job->origin_u[instance] + job->cell_u[c],
+                              job->origin_v[instance] + job->cell_v[c], &hit))
+            return false;
+        if (hit.normal.y < MIN_UPWARD_NORMAL)
+            return false;
+        if (ProbeClearance(job->app, Vector3Add(hit.point, (Vector3){0, 0.01f, 0})) < MODULE_FILL_CLEARANCE)
+            return false;
+        for (int e = 0; e < job->existing_count; e++) {
+            if (Vector3Distance(hit.point, job->existing[e]) < job->min_dist)
+                return false;
+        }
+        job->positions[slot] = hit.point;
+        job->normals[slot] = hit.normal;
+    }
+    return true;
+}
+
+// Worker body: validate instances [begin, end)
+static void ValidateInstanceRange(void *ctx, int begin, int end, int slot) {
+    (void) slot;
+    FillJob *job = (FillJob *) ctx;
+    for (int i = begin; i < end; i++) {
+        job->instance_ok[i] = ValidateInstance(job, i);
+    }
+}
+
+int FillModuleOnPanel(AppState *app, int module_index, int panel) {
+    if (module_index < 0 || module_index >= app->module_count)
+        return 0;
+
+    const SurfacePanels *panels = GetSurfacePanels(app);
+    if (!panels || panel < 0 || panel >= panels->panel_count) {
+        SetStatus(app, "Module fill: no surface panel there");
+        return 0;
+    }
+
+    CellModule *mod = &app->modules[module_index];
+    const SurfacePanel *sp = &panels->panels[panel];
+    // The module's own cells set the pitch, whatever preset is selected now (files may carry a stale index)
+    int preset_index = mod->preset_index >= 0 && mod->preset_index < CELL_PRESET_COUNT ? mod->preset_index : 0;
+    CellPreset *preset = (CellPreset *)&CELL_PRESETS[preset_index];
+    float cell_pitch = fmaxf(preset->width, preset->height) * MIN_CELL_DISTANCE_FACTOR;
+    int n = mod->cell_count;
+    if (n == 0)
+        return 0;
+
+    // Template offsets are in the module's XZ plane; rotate them into the panel frame
+    float angle = app->module_fill_angle * DEG2RAD;
+    float ca = cosf(angle), sa = sinf(angle);
+    float cell_u[MAX_CELLS_PER_MODULE], cell_v[MAX_CELLS_PER_MODULE];
+    float lo_u = 1e9f, hi_u = -1e9f, lo_v = 1e9f, hi_v = -1e9f;
+    for (int c = 0; c < n; c++) {
+        Vector3 o = mod->cells[c].offset;
+        cell_u[c] = ca * o.x - sa * o.z;
+        cell_v[c] = sa * o.x + ca * o.z;
+        lo_u = fminf(lo_u, cell_u[c]);
+        hi_u = fmaxf(hi_u, cell_u[c]);
+        lo_v = fminf(lo_v, cell_v[c]);
+        hi_v = fmaxf(hi_v, cell_v[c]);
+    }
+
+    // Instance lattice over the panel; one cell pitch plus the gap keeps neighbouring instances apart
+    float pitch_u = (hi_u - lo_u) + cell_pitch + app->module_fill_gap;
+    float pitch_v = (hi_v - lo_v) + cell_pitch + app->module_fill_gap;
+    int cols = (int)((sp->max_u - sp->min_u - (hi_u - lo_u)) / pitch_u) + 1;
+    int rows = (int)((sp->max_v - sp->min_v - (hi_v - lo_v)) / pitch_v) + 1;
+    if (cols < 1 || rows < 1 || cols * rows > MODULE_FILL_MAX_INSTANCES) {
+        SetStatus(app, "Module fill: panel too small or too large for this module");
+        return 0;
+    }
+
+    int instances = cols * rows;
+    float *origin_u = (float *)malloc(instances * sizeof(float));
+    float *origin_v = (float *)malloc(instances * sizeof(float));
+    Vector3 *existing = (Vector3 *)malloc((app->cell_count + 1) * sizeof(Vector3));
+    Vector3 *positions = (Vector3 *)malloc(instances * n * sizeof(Vector3));
+    Vector3 *normals = (Vector3 *)malloc(instances * n * sizeof(Vector3));
+    bool *instance_ok = (bool *)calloc(instances, sizeof(bool));
+    if (!origin_u || !origin_v || !existing || !positions || !normals || !instance_ok) {
+        free(origin_u);
+        free(origin_v);
+        free(existing);
+        free(positions);
+        free(normals);
+        free(instance_ok);
+        return 0;
+    }
+
+    // Centre the lattice on the panel so leftover margin is split evenly
+    float span_u = (cols - 1) * pitch_u + (hi_u - lo_u);
+    float span_v = (rows - 1) * pitch_v + (hi_v - lo_v);
+    float start_u = sp->min_u + (sp->max_u - sp->min_u - span_u) * 0.5f - lo_u;
+    float start_v = sp->min_v + (sp->max_v - sp->min_v - span_v) * 0.5f - lo_v;
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < cols; c++) {
+            origin_u[r * cols + c] = start_u + c * pitch_u;
+            origin_v[r * cols + c] = start_v + r * pitch_v;
+        }
+    }
+    for (int i = 0; i < app->cell_count; i++) {
+        existing[i] = CellGetWorldPosition(app, &app->cells[i]);
+    }
+
+    FillJob job = {app, panels, panel, n, cell_u, cell_v, origin_u, origin_v, instances,
+                   existing, app->cell_count, cell_pitch, positions, normals, instance_ok};
+
+    // Workers may only read the lazily built height map; if it cannot be built, probes would retry the build
+    if (GetHeightMap(app))
+        JobSystem_ParallelFor(instances, 1, ValidateInstanceRange, &job, NULL);
+    else
+        ValidateInstanceRange(&job, 0, instances, 0);
+
+    // Insert the accepted instances in one batch, whole instances only
+    Vector3 tangent = Vector3Add(Vector3Scale(sp->axis_u, ca), Vector3Scale(sp->axis_v, sa));
+    int placed_instances = 0, placed_cells = 0, valid = 0;
+    BeginEdit(app, "Fill panel");
+    for (int i = 0; i < instances; i++) {
+        if (!instance_ok[i])
+            continue;
+        valid++;
+        if (app->cell_count + n > MAX_CELLS)
+            continue;
+        for (int c = 0; c < n; c++) {
+            if (PlaceCellOriented(app, positions[i * n + c], normals[i * n + c], tangent) >= 0)
+                placed_cells++;
+        }
+        placed_instances++;
+    }
+    EndEdit(app);
+
+    free(origin_u);
+    free(origin_v);
+    free(existing);
+    free(positions);
+    free(normals);
+    free(instance_ok);
+
+    if (valid > placed_instances) {
+        SetStatus(app, "Module fill: placed %d x '%s' (%d cells), %d more hit the cell limit", placed_instances,
+                  mod->name, placed_cells, valid - placed_instances);
+    } else {
+        SetStatus(app, "Module fill: placed %d x '%s' (%d cells, %d of %d positions fit)", placed_instances,
+                  mod->name, placed_cells, valid, instances);
+    }
+    return placed_cells;
+}
@@ -0,0 +1,11 @@
+#ifndef MODULE_FILL_H
+#define MODULE_FILL_H
+
+// Module array fill implementation
+// Function declarations are in app.h
+// This header contains implementation-specific constants
+
+#define MODULE_FILL_MAX_INSTANCES 2000  // Lattice positions considered per fill
+#define MODULE_FILL_CLEARANCE 0.05f     // Headroom required above every cell (m)
+
+#endif // MODULE_FILL_H
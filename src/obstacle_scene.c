@@ -0,0 +1,313 @@
+/*
+ * Two-level acceleration structure for obstacle scenery
+ */
+
+#include "obstacle_scene.h"
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "raymath.h"
+
+//------------------------------------------------------------------------------
+// Instance Tree
+//------------------------------------------------------------------------------
+static Vector3 InstanceCentroid(const ObstacleInstance *instance) {
+    return Vector3Scale(Vector3Add(instance->min, instance->max), 0.5f);
+}
+
+static float Axis(Vector3 v, int axis) {
+    return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+}
+
+static void UpdateBounds(const ObstacleScene *scene, MeshBVHNode *node) {
+    node->min = (Vector3) {FLT_MAX, FLT_MAX, FLT_MAX};
+    node->max = (Vector3) {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+    for (int k = node->left_first; k < node->left_first + node->count; k++) {
+        const ObstacleInstance *instance = &scene->instances[scene->order[k]];
+        node->min = Vector3Min(node->min, instance->min);
+        node->max = Vector3Max(node->max, instance->max);
+    }
+}
+
+// World bounds of the mesh's local box under the instance transform
+static void UpdateInstanceBounds(const ObstacleScene *scene, ObstacleInstance *instance) {
+    const ObstacleMesh *mesh = &scene->meshes[instance->mesh];
+    instance->min = (Vector3) {FLT_MAX, FLT_MAX, FLT_MAX};
+    instance->max = (Vector3) {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+    for (int c = 0; c < 8; c++) {
+        Vector3 corner = {(c & 1) ? mesh->max.x : mesh->min.x, (c & 2) ? mesh->max.y : mesh->min.y,
+                          (c & 4) ? mesh->max.z : mesh->min.z};
+        Vector3 p = Vector3Transform(corner, instance->transform);
+        instance->min = Vector3Min(instance->min, p);
+        instance->max = Vector3Max(instance->max, p);
+    }
+    // Pad by rounding error so rays grazing a face on the box surface still reach the mesh BVH
+    float pad = OBSTACLE_SCENE_BOUNDS_PAD * Vector3Length(Vector3Subtract(instance->max, instance->min));
+    instance->min = Vector3Subtract(instance->min, (Vector3) {pad, pad, pad});
+    instance->max = Vector3Add(instance->max, (Vector3) {pad, pad, pad});
+}
+
+// Rebuild the tree over the instance bounds, splitting at the middle of the widest centroid axis.
+// Only the instances are visited; mesh BVHs stay as they are.
+static bool RebuildTree(ObstacleScene *scene) {
+    free(scene->nodes);
+    free(scene->order);
+    scene->nodes = NULL;
+    scene->order = NULL;
+    scene->node_count = 0;
+
+    int n = scene->instance_count;
+    if (n == 0)
+        return true;
+
+    scene->nodes = (MeshBVHNode *) malloc(2 * (size_t) n * sizeof(MeshBVHNode));
+    scene->order = (int *) malloc(n * sizeof(int));
+    if (!scene->nodes || !scene->order) {
+        free(scene->nodes);
+        free(scene->order);
+        scene->nodes = NULL;
+        scene->order = NULL;
+        return false;
+    }
+    for (int i = 0; i < n; i++) {
+        scene->order[i] = i;
+    }
+
+    MeshBVHNode *root = &scene->nodes[0];
+    root->left_first = 0;
+    root->count = n;
+    UpdateBounds(scene, root);
+    scene->node_count = 1;
+
+    // Capping the depth bounds this stack and the traversal stack (see MeshBVH_Build)
+    int stack[OBSTACLE_SCENE_STACK_SIZE];
+    int depth[OBSTACLE_SCENE_STACK_SIZE];
+    int sp = 0;
+    stack[sp] = 0;
+    depth[sp++] = 0;
+    scene->max_depth = 0;
+
+    while (sp > 0) {
+        --sp;
+        MeshBVHNode *node = &scene->nodes[stack[sp]];
+        int node_depth = depth[sp];
+        if (node_depth > scene->max_depth)
+            scene->max_depth = node_depth;
+        if (node->count <= OBSTACLE_SCENE_LEAF_SIZE || node_depth >= OBSTACLE_SCENE_MAX_DEPTH)
+            continue;
+
+        Vector3 cmin = {FLT_MAX, FLT_MAX, FLT_MAX};
+        Vector3 cmax = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+        for (int k = node->left_first; k < node->left_first + node->count; k++) {
+            Vector3 c = InstanceCentroid(&scene->instances[scene->order[k]]);
+            cmin = Vector3Min(cmin, c);
+            cmax = Vector3Max(cmax, c);
+        }
+        Vector3 extent = Vector3Subtract(cmax, cmin);
+        int axis = (extent.x > extent.y && extent.x > extent.z) ? 0 : (extent.y > extent.z ? 1 : 2);
+        float split = 0.5f * (Axis(cmin, axis) + Axis(cmax, axis));
+
+        int i = node->left_first;
+        int j = i + node->count - 1;
+        while (i <= j) {
+            if (Axis(InstanceCentroid(&scene->instances[scene->order[i]]), axis) < split) {
+                i++;
+            } else {
+                int tmp = scene->order[i];
+                scene->order[i] = scene->order[j];
+                scene->order[j--] = tmp;
+            }
+        }
+
+        // Coincident centroids: halve the range instead
+        int left_count = i - node->left_first;
+        if (left_count == 0 || left_count == node->count)
+            left_count = node->count / 2;
+
+        int left = scene->node_count;
+        scene->node_count += 2;
+        scene->nodes[left].left_first = node->left_first;
+        scene->nodes[left].count = left_count;
+        scene->nodes[left + 1].left_first = node->left_first + left_count;
+        scene->nodes[left + 1].count = node->count - left_count;
+        UpdateBounds(scene, &scene->nodes[left]);
+        UpdateBounds(scene, &scene->nodes[left + 1]);
+
+        node->left_first = left;
+        node->count = 0;
+
+        stack[sp] = left;
+        depth[sp++] = node_depth + 1;
+        stack[sp] = left + 1;
+        depth[sp++] = node_depth + 1;
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Editing
+//------------------------------------------------------------------------------
+int ObstacleScene_AddMesh(ObstacleScene *scene, Mesh mesh) {
+    if (scene->mesh_count == scene->mesh_capacity) {
+        int capacity = scene->mesh_capacity ? scene->mesh_capacity * 2 : 4;
+        ObstacleMesh *meshes = (ObstacleMesh *) realloc(scene->meshes, capacity * sizeof(ObstacleMesh));
+        if (!meshes)
+            return -1;
+        scene->meshes = meshes;
+        scene->mesh_capacity = capacity;
+    }
+
+    ObstacleMesh *entry = &scene->meshes[scene->mesh_count];
+    if (!MeshBVH_Build(&entry->bvh, mesh))
+        return -1;
+    entry->min = entry->bvh.nodes[0].min;
+    entry->max = entry->bvh.nodes[0].max;
+    return scene->mesh_count++;
+}
+
+int ObstacleScene_AddInstance(ObstacleScene *scene, int mesh, Matrix transform) {
+    if (mesh < 0 || mesh >= scene->mesh_count)
+        return -1;
+    if (scene->instance_count == scene->instance_capacity) {
+        int capacity = scene->instance_capacity ? scene->instance_capacity * 2 : 8;
+        ObstacleInstance *instances =
+                (ObstacleInstance *) realloc(scene->instances, capacity * sizeof(ObstacleInstance));
+        if (!instances)
+            return -1;
+        scene->instances = instances;
+        scene->instance_capacity = capacity;
+    }
+
+    int index = scene->instance_count++;
+    scene->instances[index].mesh = mesh;
+    ObstacleScene_SetTransform(scene, index, transform);
+    if (!scene->nodes) {
+        scene->instance_count--;
+        RebuildTree(scene);
+        return -1;
+    }
+    return index;
+}
+
+void ObstacleScene_SetTransform(ObstacleScene *scene, int instance, Matrix transform) {
+    if (instance < 0 || instance >= scene->instance_count)
+        return;
+    ObstacleInstance *entry = &scene->instances[instance];
+    entry->transform = transform;
+    entry->inv_transform = MatrixInvert(transform);
+    UpdateInstanceBounds(scene, entry);
+    RebuildTree(scene);
+}
+
+void ObstacleScene_RemoveInstance(ObstacleScene *scene, int instance) {
+    if (instance < 0 || instance >= scene->instance_count)
+        return;
+    scene->instances[instance] = scene->instances[--scene->instance_count];
+    RebuildTree(scene);
+}
+
+void ObstacleScene_Free(ObstacleScene *scene) {
+    for (int m = 0; m < scene->mesh_count; m++) {
+        MeshBVH_Free(&scene->meshes[m].bvh);
+    }
+    free(scene->meshes);
+    free(scene->instances);
+    free(scene->nodes);
+    free(scene->order);
+    memset(scene, 0, sizeof(*scene));
+}
+
+//------------------------------------------------------------------------------
+// Traversal
+//------------------------------------------------------------------------------
+
+// Slab test against world bounds; returns entry distance or FLT_MAX on a miss
+static float IntersectBox(Ray ray, Vector3 inv_dir, Vector3 mn, Vector3 mx, float t_max) {
+    float tx1 = (mn.x - ray.position.x) * inv_dir.x, tx2 = (mx.x - ray.position.x) * inv_dir.x;
+    float tmin = fminf(tx1, tx2), tmax = fmaxf(tx1, tx2);
+    float ty1 = (mn.y - ray.position.y) * inv_dir.y, ty2 = (mx.y - ray.position.y) * inv_dir.y;
+    tmin = fmaxf(tmin, fminf(ty1, ty2));
+    tmax = fminf(tmax, fmaxf(ty1, ty2));
+    float tz1 = (mn.z - ray.position.z) * inv_dir.z, tz2 = (mx.z - ray.position.z) * inv_dir.z;
+    tmin = fmaxf(tmin, fminf(tz1, tz2));
+    tmax = fminf(tmax, fmaxf(tz1, tz2));
+    return (tmax >= tmin && tmax > 0 && tmin < t_max) ? tmin : FLT_MAX;
+}
+
+// Shared walk of the instance tree: closest hit, or any hit in [min_dist, *t_best] when hit is NULL
+static bool Traverse(const ObstacleScene *scene, Ray ray, float min_dist, float *t_best, RayCollision *hit,
+                     int *out_instance) {
+    if (scene->node_count == 0)
+        return false;
+
+    Vector3 inv_dir = {1.0f / ray.direction.x, 1.0f / ray.direction.y, 1.0f / ray.direction.z};
+    bool found = false;
+    int stack[OBSTACLE_SCENE_STACK_SIZE];
+    int sp = 0;
+
+    if (IntersectBox(ray, inv_dir, scene->nodes[0].min, scene->nodes[0].max, *t_best) == FLT_MAX)
+        return false;
+    stack[sp++] = 0;
+
+    while (sp > 0) {
+        const MeshBVHNode *node = &scene->nodes[stack[--sp]];
+
+        if (node->count > 0) {
+            for (int k = node->left_first; k < node->left_first + node->count; k++) {
+                int index = scene->order[k];
+                const ObstacleInstance *instance = &scene->instances[index];
+                const MeshBVH *bvh = &scene->meshes[instance->mesh].bvh;
+                if (IntersectBox(ray, inv_dir, instance->min, instance->max, *t_best) == FLT_MAX)
+                    continue;
+                if (!hit) {
+                    if (MeshBVH_OccludedInstance(bvh, &instance->inv_transform, ray, min_dist, *t_best))
+                        return true;
+                    continue;
+                }
+                RayCollision h = MeshBVH_RaycastInstance(bvh, &instance->inv_transform, ray, *t_best, NULL);
+                if (h.hit && h.distance < *t_best) {
+                    *t_best = h.distance;
+                    *hit = h;
+                    if (out_instance)
+                        *out_instance = index;
+                    found = true;
+                }
+            }
+            continue;
+        }
+
+        // Visit the nearer child first
+        int a = node->left_first, b = a + 1;
+        float ta = IntersectBox(ray, inv_dir, scene->nodes[a].min, scene->nodes[a].max, *t_best);
+        float tb = IntersectBox(ray, inv_dir, scene->nodes[b].min, scene->nodes[b].max, *t_best);
+        if (ta > tb) {
+            float tt = ta;
+            ta = tb;
+            tb = tt;
+            int ti = a;
+            a = b;
+            b = ti;
+        }
+        // Depth is capped at build time, so the stack never overflows
+        if (tb != FLT_MAX)
+            stack[sp++] = b;
+        if (ta != FLT_MAX)
+            stack[sp++] = a;
+    }
+    return found;
+}
+
+RayCollision ObstacleScene_Raycast(const ObstacleScene *scene, Ray ray, int *out_instance) {
+    RayCollision hit = {0};
+    if (out_instance)
+        *out_instance = -1;
+    float t = FLT_MAX;
+    Traverse(scene, ray, 0.0f, &t, &hit, out_instance);
+    return hit;
+}
+
+bool ObstacleScene_Occluded(const ObstacleScene *scene, Ray ray, float min_dist, float max_dist) {
+    float t = max_dist;
+    return Traverse(scene, ray, min_dist, &t, NULL, NULL);
+}
@@ -0,0 +1,80 @@
+#ifndef OBSTACLE_SCENE_H
+#define OBSTACLE_SCENE_H
+
+#include <stdbool.h>
+#include "raylib.h"
+#include "mesh_bvh.h"
+
+//------------------------------------------------------------------------------
+// Constants
+//------------------------------------------------------------------------------
+#define OBSTACLE_SCENE_LEAF_SIZE 2      // Max instances per leaf of the instance tree
+#define OBSTACLE_SCENE_STACK_SIZE 64
+#define OBSTACLE_SCENE_MAX_DEPTH (OBSTACLE_SCENE_STACK_SIZE - 1) // Deeper nodes stay leaves
+#define OBSTACLE_SCENE_BOUNDS_PAD 1e-5f // Instance bounds growth as a fraction of their diagonal
+
+//------------------------------------------------------------------------------
+// Obstacle scene
+//------------------------------------------------------------------------------
+// Scenery around the vehicle (buildings, trees, chase vehicles) as a two-level
+// hierarchy. Each obstacle mesh gets one mesh-local MeshBVH when it is added;
+// instances place a mesh with their own transform and share its BVH. A small
+// tree over the instances' world bounds is rebuilt whenever an instance is
+// added, moved or removed, which never touches the mesh BVHs, so rays pay
+// logarithmically in both the instance count and the triangles per mesh.
+
+typedef struct {
+    MeshBVH bvh;            // Mesh-local
+    Vector3 min, max;       // Local bounds
+} ObstacleMesh;
+
+typedef struct {
+    int mesh;               // Index into meshes
+    Matrix transform;       // Local -> world
+    Matrix inv_transform;   // World -> local
+    Vector3 min, max;       // World bounds
+} ObstacleInstance;
+
+typedef struct {
+    ObstacleMesh *meshes;
+    int mesh_count;
+    int mesh_capacity;
+
+    ObstacleInstance *instances;
+    int instance_count;
+    int instance_capacity;
+
+    // Instance tree, laid out like MeshBVH (leaf ranges index into order)
+    MeshBVHNode *nodes;
+    int node_count;
+    int max_depth;          // Deepest leaf (root = 0)
+    int *order;             // Instance ids in leaf order
+} ObstacleScene;
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+
+// Build the BVH for a mesh; returns its index, or -1 on failure or an empty mesh
+int ObstacleScene_AddMesh(ObstacleScene *scene, Mesh mesh);
+
+// Place a copy of a mesh; returns the instance index, or -1 on failure
+int ObstacleScene_AddInstance(ObstacleScene *scene, int mesh, Matrix transform);
+
+// Move an instance
+void ObstacleScene_SetTransform(ObstacleScene *scene, int instance, Matrix transform);
+
+// Remove an instance; the last instance takes its index
+void ObstacleScene_RemoveInstance(ObstacleScene *scene, int instance);
+
+// Release everything (safe on an empty scene)
+void ObstacleScene_Free(ObstacleScene *scene);
+
+// Closest hit along a world-space ray
+// out_instance: optional, instance index or -1
+RayCollision ObstacleScene_Raycast(const ObstacleScene *scene, Ray ray, int *out_instance);
+
+// True if any instance is hit between min_dist and max_dist along the ray
+bool ObstacleScene_Occluded(const ObstacleScene *scene, Ray ray, float min_dist, float max_dist);
+
+#endif // OBSTACLE_SCENE_H
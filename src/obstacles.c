@@ -0,0 +1,148 @@
+/*
+ * Obstacle scenery: meshes placed around the vehicle that shade it
+ */
+
+#include "app.h"
+#include "obstacles.h"
+#include "stl_loader.h"
+#include <math.h>
+#include <string.h>
+
+//------------------------------------------------------------------------------
+// Meshes
+//------------------------------------------------------------------------------
+
+// Scene mesh for a file, loading it the first time; -1 on failure
+static int FindOrLoadObstacleMesh(AppState *app, const char *path) {
+    for (int m = 0; m < app->obstacle_scene.mesh_count; m++) {
+        if (strcmp(app->obstacle_paths[m], path) == 0)
+            return m;
+    }
+    if (app->obstacle_scene.mesh_count >= MAX_OBSTACLE_MESHES) {
+        SetStatus(app, "Too many obstacle meshes (max %d)", MAX_OBSTACLE_MESHES);
+        return -1;
+    }
+
+    Model model = IsSTLFile(path) ? LoadSTL(path) : LoadModel(path);
+    if (model.meshCount == 0) {
+        SetStatus(app, "Error: Failed to load obstacle mesh");
+        return -1;
+    }
+    int mesh = ObstacleScene_AddMesh(&app->obstacle_scene, model.meshes[0]);
+    if (mesh < 0) {
+        UnloadModel(model);
+        SetStatus(app, "Error: Obstacle mesh is empty");
+        return -1;
+    }
+
+    app->obstacle_models[mesh] = model;
+    strncpy(app->obstacle_paths[mesh], path, MAX_PATH_LENGTH - 1);
+    app->obstacle_paths[mesh][MAX_PATH_LENGTH - 1] = '\0';
+    return mesh;
+}
+
+// Footprint width of an obstacle along x (m)
+static float ObstacleWidth(const AppState *app, const Obstacle *obstacle) {
+    const ObstacleMesh *mesh = &app->obstacle_scene.meshes[obstacle->mesh];
+    return (mesh->max.x - mesh->min.x) * obstacle->scale;
+}
+
+static int AddObstacleInstance(AppState *app, Obstacle obstacle) {
+    if (app->obstacle_count >= MAX_OBSTACLES) {
+        SetStatus(app, "Too many obstacles (max %d)", MAX_OBSTACLES);
+        return -1;
+    }
+    int index = ObstacleScene_AddInstance(&app->obstacle_scene, obstacle.mesh, MatrixIdentity());
+    if (index < 0) {
+        SetStatus(app, "Not enough memory for the obstacle");
+        return -1;
+    }
+    app->obstacles[index] = obstacle;
+    app->obstacle_count = app->obstacle_scene.instance_count;
+    app->selected_obstacle = index;
+    UpdateObstacleTransform(app, index);
+    return index;
+}
+
+//------------------------------------------------------------------------------
+// Editing
+//------------------------------------------------------------------------------
+int AddObstacleFromFile(AppState *app, const char *path) {
+    int mesh = FindOrLoadObstacleMesh(app, path);
+    if (mesh < 0)
+        return -1;
+
+    // Beside the vehicle on its +x side, in the vehicle's units
+    Obstacle obstacle = {mesh, {0, 0, 0}, 0.0f, app->mesh_scale};
+    float half_width = 0.5f * ObstacleWidth(app, &obstacle);
+    obstacle.position.x = (app->mesh_loaded ? app->mesh_bounds.max.x : 0.0f) + OBSTACLE_GAP + half_width;
+
+    int index = AddObstacleInstance(app, obstacle);
+    if (index >= 0)
+        SetStatus(app, "Added obstacle: %s", GetFileName(path));
+    return index;
+}
+
+int DuplicateObstacle(AppState *app, int index) {
+    if (index < 0 || index >= app->obstacle_count)
+        return -1;
+    Obstacle copy = app->obstacles[index];
+    copy.position.x += ObstacleWidth(app, &copy) + OBSTACLE_DUPLICATE_STEP;
+    return AddObstacleInstance(app, copy);
+}
+
+// Centre the mesh's footprint on position with its base on the ground, then scale and turn it about that point
+void UpdateObstacleTransform(AppState *app, int index) {
+    if (index < 0 || index >= app->obstacle_count)
+        return;
+    const Obstacle *obstacle = &app->obstacles[index];
+    const ObstacleMesh *mesh = &app->obstacle_scene.meshes[obstacle->mesh];
+
+    Matrix toOrigin = MatrixTranslate(-(mesh->min.x + mesh->max.x) / 2.0f, -mesh->min.y,
+                                      -(mesh->min.z + mesh->max.z) / 2.0f);
+    Matrix transform = MatrixMultiply(toOrigin, MatrixScale(obstacle->scale, obstacle->scale, obstacle->scale));
+    transform = MatrixMultiply(transform, MatrixRotateY(obstacle->yaw_deg * DEG2RAD));
+    transform = MatrixMultiply(transform,
+                               MatrixTranslate(obstacle->position.x, obstacle->position.y, obstacle->position.z));
+
+    ObstacleScene_SetTransform(&app->obstacle_scene, index, transform);
+    app->obstacle_revision++;
+}
+
+void RemoveObstacle(AppState *app, int index) {
+    if (index < 0 || index >= app->obstacle_count)
+        return;
+    // The scene moves its last instance into the gap; mirror that here
+    ObstacleScene_RemoveInstance(&app->obstacle_scene, index);
+    app->obstacles[index] = app->obstacles[app->obstacle_count - 1];
+    app->obstacle_count = app->obstacle_scene.instance_count;
+    if (app->selected_obstacle >= app->obstacle_count)
+        app->selected_obstacle = app->obstacle_count - 1;
+    app->obstacle_revision++;
+}
+
+void ClearObstacles(AppState *app) {
+    for (int m = 0; m < app->obstacle_scene.mesh_count; m++) {
+        UnloadModel(app->obstacle_models[m]);
+        app->obstacle_paths[m][0] = '\0';
+    }
+    ObstacleScene_Free(&app->obstacle_scene);
+    if (app->obstacle_count > 0)
+        app->obstacle_revision++;
+    app->obstacle_count = 0;
+    app->selected_obstacle = -1;
+}
+
+//------------------------------------------------------------------------------
+// Drawing
+//------------------------------------------------------------------------------
+void DrawObstacles(AppState *app) {
+    for (int i = 0; i < app->obstacle_count; i++) {
+        const ObstacleInstance *instance = &app->obstacle_scene.instances[i];
+        Model model = app->obstacle_models[instance->mesh];
+        model.transform = instance->transform;
+        DrawModel(model, (Vector3) {0, 0, 0}, 1.0f, COLOR_OBSTACLE);
+        if (i == app->selected_obstacle)
+            DrawBoundingBox((BoundingBox) {instance->min, instance->max}, ORANGE);
+    }
+}
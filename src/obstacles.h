@@ -0,0 +1,11 @@
+#ifndef OBSTACLES_H
+#define OBSTACLES_H
+
+// Obstacle scenery implementation
+// Function declarations are in app.h
+// This header contains implementation-specific constants
+
+#define OBSTACLE_GAP 1.0f // Clearance between the vehicle and a newly added obstacle (m)
+#define OBSTACLE_DUPLICATE_STEP 1.0f // Extra offset of a duplicate beyond its source's width (m)
+
+#endif // OBSTACLES_H
@@ -0,0 +1,238 @@
+/*
+ * Screen-space bucket grid for cell picking
+ */
+
+#include "pick_grid.h"
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "raymath.h"
+
+// Clip distances used by raylib's GetWorldToScreen
+#define PICK_CULL_NEAR 0.01
+#define PICK_CULL_FAR 1000.0
+
+//------------------------------------------------------------------------------
+// Projection
+//------------------------------------------------------------------------------
+typedef struct {
+    Matrix view;
+    Matrix view_proj;
+    float width, height;
+} PickProjection;
+
+static PickProjection MakeProjection(Camera3D camera, int screen_width, int screen_height) {
+    PickProjection p;
+    double aspect = (double) screen_width / (double) (screen_height > 0 ? screen_height : 1);
+    Matrix proj;
+    if (camera.projection == CAMERA_ORTHOGRAPHIC) {
+        double top = camera.fovy / 2.0;
+        double right = top * aspect;
+        proj = MatrixOrtho(-right, right, -top, top, PICK_CULL_NEAR, PICK_CULL_FAR);
+    } else {
+        proj = MatrixPerspective(camera.fovy * DEG2RAD, aspect, PICK_CULL_NEAR, PICK_CULL_FAR);
+    }
+    p.view = MatrixLookAt(camera.position, camera.target, camera.up);
+    p.view_proj = MatrixMultiply(p.view, proj);
+    p.width = (float) screen_width;
+    p.height = (float) screen_height;
+    return p;
+}
+
+// Same mapping as GetWorldToScreenEx, with the matrices built once per batch
+static Vector2 ProjectPoint(const PickProjection *p, Vector3 v, float *out_depth) {
+    const Matrix *m = &p->view_proj;
+    float x = m->m0 * v.x + m->m4 * v.y + m->m8 * v.z + m->m12;
+    float y = m->m1 * v.x + m->m5 * v.y + m->m9 * v.z + m->m13;
+    float w = m->m3 * v.x + m->m7 * v.y + m->m11 * v.z + m->m15;
+
+    // Distance in front of the camera along the view axis
+    float view_z = p->view.m2 * v.x + p->view.m6 * v.y + p->view.m10 * v.z + p->view.m14;
+    if (out_depth) *out_depth = -view_z;
+
+    if (fabsf(w) < 1e-12f) w = 1e-12f;
+    return (Vector2) {(x / w + 1.0f) * 0.5f * p->width, (1.0f - y / w) * 0.5f * p->height};
+}
+
+Vector2 PickGrid_Project(Camera3D camera, int screen_width, int screen_height, Vector3 point, float *out_depth) {
+    PickProjection p = MakeProjection(camera, screen_width, screen_height);
+    return ProjectPoint(&p, point, out_depth);
+}
+
+//------------------------------------------------------------------------------
+// Build
+//------------------------------------------------------------------------------
+bool PickGrid_IsStale(const PickGrid *grid, Camera3D camera, int screen_width, int screen_height,
+                      unsigned int revision) {
+    return !grid->valid || grid->revision != revision || grid->screen_width != screen_width ||
+           grid->screen_height != screen_height || memcmp(&grid->camera, &camera, sizeof(Camera3D)) != 0;
+}
+
+void PickGrid_Build(PickGrid *grid, const Vector3 *points, int count, Camera3D camera, int screen_width,
+                    int screen_height, unsigned int revision) {
+    if (count > PICK_GRID_MAX_POINTS) count = PICK_GRID_MAX_POINTS;
+
+    int cols = (screen_width + PICK_GRID_BUCKET_PX - 1) / PICK_GRID_BUCKET_PX;
+    int rows = (screen_height + PICK_GRID_BUCKET_PX - 1) / PICK_GRID_BUCKET_PX;
+    if (cols < 1) cols = 1;
+    if (rows < 1) rows = 1;
+
+    int needed = cols * rows + 1;
+    if (needed > grid->bucket_capacity) {
+        int *buckets = (int *) realloc(grid->bucket_start, needed * sizeof(int));
+        if (!buckets) {
+            grid->valid = false;
+            return;
+        }
+        grid->bucket_start = buckets;
+        grid->bucket_capacity = needed;
+    }
+    memset(grid->bucket_start, 0, needed * sizeof(int));
+
+    grid->camera = camera;
+    grid->screen_width = screen_width;
+    grid->screen_height = screen_height;
+    grid->revision = revision;
+    grid->count = count;
+    grid->cols = cols;
+    grid->rows = rows;
+    grid->min_depth = FLT_MAX;
+
+    // Project and count points per bucket (points behind the camera or off screen are skipped)
+    PickProjection proj = MakeProjection(camera, screen_width, screen_height);
+    int bucket_of[PICK_GRID_MAX_POINTS];
+    for (int i = 0; i < count; i++) {
+        grid->screen[i] = ProjectPoint(&proj, points[i], &grid->depth[i]);
+        bucket_of[i] = -1;
+
+        Vector2 s = grid->screen[i];
+        if (grid->depth[i] <= 0 || s.x < 0 || s.y < 0 || s.x >= screen_width || s.y >= screen_height) continue;
+
+        int b = ((int) s.y / PICK_GRID_BUCKET_PX) * cols + (int) s.x / PICK_GRID_BUCKET_PX;
+        bucket_of[i] = b;
+        grid->bucket_start[b + 1]++;
+        if (grid->depth[i] < grid->min_depth) grid->min_depth = grid->depth[i];
+    }
+
+    // Prefix sum, then scatter (counting sort by bucket)
+    for (int b = 0; b < cols * rows; b++) {
+        grid->bucket_start[b + 1] += grid->bucket_start[b];
+    }
+    int *cursor = (int *) malloc(cols * rows * sizeof(int));
+    if (!cursor) {
+        grid->valid = false;
+        return;
+    }
+    memcpy(cursor, grid->bucket_start, cols * rows * sizeof(int));
+    for (int i = 0; i < count; i++) {
+        if (bucket_of[i] >= 0) grid->order[cursor[bucket_of[i]]++] = i;
+    }
+    free(cursor);
+
+    grid->valid = true;
+}
+
+void PickGrid_Free(PickGrid *grid) {
+    free(grid->bucket_start);
+    grid->bucket_start = NULL;
+    grid->bucket_capacity = 0;
+    grid->valid = false;
+}
+
+//------------------------------------------------------------------------------
+// Queries
+//------------------------------------------------------------------------------
+
+// Clamp a screen rectangle to bucket index ranges; returns false if it misses the grid
+static bool BucketRange(const PickGrid *grid, float min_x, float min_y, float max_x, float max_y, int *c0, int *r0,
+                        int *c1, int *r1) {
+    if (max_x < 0 || max_y < 0 || min_x >= grid->screen_width || min_y >= grid->screen_height) return false;
+    *c0 = (int) fmaxf(min_x, 0) / PICK_GRID_BUCKET_PX;
+    *r0 = (int) fmaxf(min_y, 0) / PICK_GRID_BUCKET_PX;
+    *c1 = (int) fminf(max_x, grid->screen_width - 1) / PICK_GRID_BUCKET_PX;
+    *r1 = (int) fminf(max_y, grid->screen_height - 1) / PICK_GRID_BUCKET_PX;
+    return true;
+}
+
+int PickGrid_QueryRect(const PickGrid *grid, Rectangle rect, int *out, int max_out) {
+    if (!grid->valid) return 0;
+
+    float min_x = rect.x, max_x = rect.x + rect.width;
+    float min_y = rect.y, max_y = rect.y + rect.height;
+    int c0, r0, c1, r1, n = 0;
+    if (!BucketRange(grid, min_x, min_y, max_x, max_y, &c0, &r0, &c1, &r1)) return 0;
+
+    for (int r = r0; r <= r1; r++) {
+        for (int c = c0; c <= c1; c++) {
+            int b = r * grid->cols + c;
+            for (int k = grid->bucket_start[b]; k < grid->bucket_start[b + 1]; k++) {
+                int i = grid->order[k];
+                Vector2 s = grid->screen[i];
+                if (s.x >= min_x && s.x <= max_x && s.y >= min_y && s.y <= max_y && n < max_out) out[n++] = i;
+            }
+        }
+    }
+    return n;
+}
+
+// Even-odd rule point in polygon test
+static bool PointInPolygon(Vector2 p, const Vector2 *poly, int n_poly) {
+    bool inside = false;
+    for (int i = 0, j = n_poly - 1; i < n_poly; j = i++) {
+        if ((poly[i].y > p.y) != (poly[j].y > p.y)) {
+            float x = poly[j].x + (p.y - poly[j].y) * (poly[i].x - poly[j].x) / (poly[i].y - poly[j].y);
+            if (p.x < x) inside = !inside;
+        }
+    }
+    return inside;
+}
+
+int PickGrid_QueryPolygon(const PickGrid *grid, const Vector2 *poly, int n_poly, int *out, int max_out) {
+    if (!grid->valid || n_poly < 3) return 0;
+
+    float min_x = poly[0].x, max_x = poly[0].x, min_y = poly[0].y, max_y = poly[0].y;
+    for (int i = 1; i < n_poly; i++) {
+        min_x = fminf(min_x, poly[i].x);
+        max_x = fmaxf(max_x, poly[i].x);
+        min_y = fminf(min_y, poly[i].y);
+        max_y = fmaxf(max_y, poly[i].y);
+    }
+
+    int c0, r0, c1, r1, n = 0;
+    if (!BucketRange(grid, min_x, min_y, max_x, max_y, &c0, &r0, &c1, &r1)) return 0;
+
+    for (int r = r0; r <= r1; r++) {
+        for (int c = c0; c <= c1; c++) {
+            int b = r * grid->cols + c;
+            for (int k = grid->bucket_start[b]; k < grid->bucket_start[b + 1]; k++) {
+                int i = grid->order[k];
+                if (n < max_out && PointInPolygon(grid->screen[i], poly, n_poly)) out[n++] = i;
+            }
+        }
+    }
+    return n;
+}
+
+int PickGrid_QueryRadius(const PickGrid *grid, Vector2 center, float radius, int *out, int max_out) {
+    if (!grid->valid) return 0;
+
+    int c0, r0, c1, r1, n = 0;
+    if (!BucketRange(grid, center.x - radius, center.y - radius, center.x + radius, center.y + radius, &c0, &r0,
+                     &c1, &r1))
+        return 0;
+
+    float r2 = radius * radius;
+    for (int r = r0; r <= r1; r++) {
+        for (int c = c0; c <= c1; c++) {
+            int b = r * grid->cols + c;
+            for (int k = grid->bucket_start[b]; k < grid->bucket_start[b + 1]; k++) {
+                int i = grid->order[k];
+                float dx = grid->screen[i].x - center.x;
+                float dy = grid->screen[i].y - center.y;
+                if (dx * dx + dy * dy <= r2 && n < max_out) out[n++] = i;
+            }
+        }
+    }
+    return n;
+}
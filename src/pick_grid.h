@@ -0,0 +1,65 @@
+#ifndef PICK_GRID_H
+#define PICK_GRID_H
+
+#include <stdbool.h>
+#include "raylib.h"
+
+//------------------------------------------------------------------------------
+// Constants
+//------------------------------------------------------------------------------
+#define PICK_GRID_BUCKET_PX 32     // Bucket size in screen pixels
+#define PICK_GRID_MAX_POINTS 1000  // Matches MAX_CELLS
+
+//------------------------------------------------------------------------------
+// Screen-space pick grid
+//------------------------------------------------------------------------------
+// Projected cell centres bucketed into a uniform screen grid, stored in
+// compressed rows (bucket_start[b]..bucket_start[b + 1] indexes order[]).
+// Rebuilt only when the camera, window size or cell layout changes, so
+// rectangle, lasso and hover queries touch only the overlapping buckets.
+
+typedef struct {
+    bool valid;
+    Camera3D camera;                        // Camera the grid was built for
+    int screen_width, screen_height;
+    unsigned int revision;                  // Caller's layout revision at build time
+    int count;                              // Points projected
+
+    Vector2 screen[PICK_GRID_MAX_POINTS];   // Screen position per point
+    float depth[PICK_GRID_MAX_POINTS];      // View depth per point (<= 0 = behind camera)
+    int order[PICK_GRID_MAX_POINTS];        // Point indices grouped by bucket
+    float min_depth;                        // Nearest visible point
+
+    int cols, rows;
+    int *bucket_start;                      // cols * rows + 1 entries
+    int bucket_capacity;
+} PickGrid;
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+
+// True if the grid must be rebuilt for this camera, window and layout revision
+bool PickGrid_IsStale(const PickGrid *grid, Camera3D camera, int screen_width, int screen_height,
+                      unsigned int revision);
+
+// Project world points and bucket them
+void PickGrid_Build(PickGrid *grid, const Vector3 *points, int count, Camera3D camera, int screen_width,
+                    int screen_height, unsigned int revision);
+
+// Release bucket storage
+void PickGrid_Free(PickGrid *grid);
+
+// Project one world point with the same transform used by the grid
+Vector2 PickGrid_Project(Camera3D camera, int screen_width, int screen_height, Vector3 point, float *out_depth);
+
+// Points inside a screen rectangle; returns the number written to out
+int PickGrid_QueryRect(const PickGrid *grid, Rectangle rect, int *out, int max_out);
+
+// Points inside a closed screen polygon (lasso); returns the number written to out
+int PickGrid_QueryPolygon(const PickGrid *grid, const Vector2 *poly, int n_poly, int *out, int max_out);
+
+// Points within radius pixels of a screen position; returns the number written to out
+int PickGrid_QueryRadius(const PickGrid *grid, Vector2 center, float radius, int *out, int max_out);
+
+#endif // PICK_GRID_H
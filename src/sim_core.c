@@ -0,0 +1,477 @@
+/*
+ * Reentrant shading and electrical core shared by the app's simulations and auto-layout
+ */
+
+#include "sim_core.h"
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "job_system.h"
+#include "solar_position.h"
+#include "raymath.h"
+
+//------------------------------------------------------------------------------
+// Sun Position
+//------------------------------------------------------------------------------
+// Unit vector towards the sun (y up, x east, z south); a sun below the horizon points straight down
+static Vector3 SunVector(float altitude, float azimuth) {
+    if (altitude <= 0)
+        return (Vector3) {0, -1, 0};
+    float alt_rad = altitude * DEG2RAD;
+    float az_rad = azimuth * DEG2RAD;
+    return (Vector3) {cosf(alt_rad) * sinf(az_rad), sinf(alt_rad), -cosf(alt_rad) * cosf(az_rad)};
+}
+
+static double SiteJulianDay(const SimSite *site, float hour) {
+    return SolarPosition_JulianDay(site->year, site->month, site->day, (double) hour - site->utc_offset);
+}
+
+Vector3 SimCore_SunDirection(const SimSite *site, float hour, float *out_alt, float *out_az) {
+    double julian_day = SiteJulianDay(site, hour);
+    float altitude, azimuth;
+    SolarPosition_Compute(&julian_day, 1, site->latitude, site->longitude, &altitude, &azimuth);
+    if (out_alt)
+        *out_alt = altitude;
+    if (out_az)
+        *out_az = azimuth;
+    return SunVector(altitude, azimuth);
+}
+
+void SimCore_SunDirections(const SimSite *site, const float *hours, int count, Vector3 *dirs, float *altitudes,
+                           float *azimuths) {
+    double julian_days[SIM_CORE_SUN_BATCH];
+    float alt[SIM_CORE_SUN_BATCH], az[SIM_CORE_SUN_BATCH];
+    for (int begin = 0; begin < count; begin += SIM_CORE_SUN_BATCH) {
+        int n = count - begin < SIM_CORE_SUN_BATCH ? count - begin : SIM_CORE_SUN_BATCH;
+        for (int i = 0; i < n; i++) {
+            julian_days[i] = SiteJulianDay(site, hours[begin + i]);
+        }
+        SolarPosition_Compute(julian_days, n, site->latitude, site->longitude, alt, az);
+        for (int i = 0; i < n; i++) {
+            if (dirs)
+                dirs[begin + i] = SunVector(alt[i], az[i]);
+            if (altitudes)
+                altitudes[begin + i] = alt[i];
+            if (azimuths)
+                azimuths[begin + i] = az[i];
+        }
+    }
+}
+
+float SimCore_EffectiveIrradiance(float irradiance, float altitude) {
+    if (altitude <= 0.0f)
+        return 0.0f;
+    float sin_alt = sinf(altitude * DEG2RAD);
+    float air_mass = 1.0f / fmaxf(sin_alt, 0.01f);
+    return irradiance * powf(0.7f, powf(air_mass, 0.678f));
+}
+
+Vector3 SimCore_RotateToHeading(Vector3 sun_dir, float heading_deg) {
+    float heading_rad = heading_deg * DEG2RAD;
+    return (Vector3) {sun_dir.x * cosf(-heading_rad) - sun_dir.z * sinf(-heading_rad), sun_dir.y,
+                      sun_dir.x * sinf(-heading_rad) + sun_dir.z * cosf(-heading_rad)};
+}
+
+// Rodrigues rotation of v about a unit axis
+static Vector3 RotateAboutAxis(Vector3 v, Vector3 axis, float angle_rad) {
+    float c = cosf(angle_rad), s = sinf(angle_rad);
+    Vector3 cross = Vector3CrossProduct(axis, v);
+    float along = Vector3DotProduct(axis, v) * (1.0f - c);
+    return (Vector3) {v.x * c + cross.x * s + axis.x * along, v.y * c + cross.y * s + axis.y * along,
+                      v.z * c + cross.z * s + axis.z * along};
+}
+
+Vector3 SimCore_RotateToAttitude(Vector3 sun_dir, Vector3 forward, float pitch_deg, float roll_deg) {
+    // The body turns by +pitch about the lateral axis, then +roll about forward; the sun moves the other way
+    Vector3 lateral = Vector3CrossProduct(forward, (Vector3) {0, 1, 0});
+    Vector3 dir = RotateAboutAxis(sun_dir, lateral, -pitch_deg * DEG2RAD);
+    return RotateAboutAxis(dir, forward, -roll_deg * DEG2RAD);
+}
+
+int SimCore_DirectionSlot(Vector3 dir) {
+    float elevation = asinf(fminf(fmaxf(dir.y, -1.0f), 1.0f)) * RAD2DEG;
+    int alt_bin = (int) ((elevation + 90.0f) * SIM_CORE_DIR_ALT_BINS / 180.0f);
+    alt_bin = alt_bin >= SIM_CORE_DIR_ALT_BINS ? SIM_CORE_DIR_ALT_BINS - 1 : alt_bin;
+    float azimuth = atan2f(dir.x, -dir.z) * RAD2DEG;
+    if (azimuth < 0.0f)
+        azimuth += 360.0f;
+    int az_bin = (int) (azimuth * SIM_CORE_SKY_AZ_BINS / 360.0f) % SIM_CORE_SKY_AZ_BINS;
+    return alt_bin * SIM_CORE_SKY_AZ_BINS + az_bin;
+}
+
+int SimCore_BuildSunSamples(const SimSite *site, float start_hour, float duration, int hour_count, int heading_count,
+                            SunSample *out) {
+    // The sun path is shared by every heading, so it is computed once for all hours
+    float *hours = (float *) malloc(hour_count * 3 * sizeof(float));
+    Vector3 *dirs = (Vector3 *) malloc(hour_count * sizeof(Vector3));
+    if (!hours || !dirs) {
+        free(hours);
+        free(dirs);
+        return 0;
+    }
+    float *altitudes = hours + hour_count;
+    float *azimuths = altitudes + hour_count;
+    for (int hour_idx = 0; hour_idx < hour_count; hour_idx++) {
+        hours[hour_idx] = start_hour + (hour_count > 1 ? duration * hour_idx / (hour_count - 1) : 0.0f);
+    }
+    SimCore_SunDirections(site, hours, hour_count, dirs, altitudes, azimuths);
+
+    int count = 0;
+    for (int heading_idx = 0; heading_idx < heading_count; heading_idx++) {
+        float heading = (360.0f * heading_idx) / heading_count;
+
+        for (int hour_idx = 0; hour_idx < hour_count; hour_idx++) {
+            if (altitudes[hour_idx] <= 0)
+                continue;
+
+            out[count++] = (SunSample) {SimCore_RotateToHeading(dirs[hour_idx], heading), altitudes[hour_idx],
+                                        azimuths[hour_idx], hours[hour_idx], heading};
+        }
+    }
+    free(hours);
+    free(dirs);
+    return count;
+}
+
+//------------------------------------------------------------------------------
+// Weather Histogram
+//------------------------------------------------------------------------------
+typedef struct {
+    float hours;
+    float dni, dhi, ghi, temp_c;    // Hour-weighted sums
+    float month_ghi[12];
+} SkyAccumulator;
+
+bool SimCore_BuildSkyHistogram(const WeatherYear *weather, const SimSite *site, int heading_count,
+                               SimSkyHistogram *out) {
+    const int dir_slots = SIM_CORE_SKY_ALT_BINS * SIM_CORE_SKY_AZ_BINS;
+    memset(out, 0, sizeof(*out));
+
+    // Slots are [sunny][altitude][azimuth]; directions are shared by both sky classes
+    SkyAccumulator *slots = (SkyAccumulator *) calloc(2 * dir_slots, sizeof(SkyAccumulator));
+    Vector3 *dir_sums = (Vector3 *) calloc(dir_slots, sizeof(Vector3));
+    int *dir_index = (int *) malloc(dir_slots * sizeof(int));
+    double *julian_days = (double *) malloc((weather->record_count ? weather->record_count : 1) * sizeof(double));
+    float *altitudes = (float *) malloc((weather->record_count ? weather->record_count : 1) * 2 * sizeof(float));
+    if (!slots || !dir_sums || !dir_index || !julian_days || !altitudes) {
+        free(slots);
+        free(dir_sums);
+        free(dir_index);
+        free(julian_days);
+        free(altitudes);
+        return false;
+    }
+
+    // The whole year's sun path in one batch
+    float *azimuths = altitudes + weather->record_count;
+    for (int r = 0; r < weather->record_count; r++) {
+        const WeatherRecord *record = &weather->records[r];
+        julian_days[r] = SolarPosition_JulianDay(site->year, record->month, record->day,
+                                                 (double) record->hour - site->utc_offset);
+    }
+    SolarPosition_Compute(julian_days, weather->record_count, site->latitude, site->longitude, altitudes, azimuths);
+    free(julian_days);
+
+    float weight = weather->dt_hours / heading_count;
+    for (int r = 0; r < weather->record_count; r++) {
+        const WeatherRecord *record = &weather->records[r];
+        if (record->ghi <= 0.0f && record->dni <= 0.0f)
+            continue;
+
+        float altitude = altitudes[r];
+        Vector3 sun_dir = SunVector(altitude, azimuths[r]);
+        if (altitude <= 0.0f)
+            continue;
+        out->daylight_hours += weather->dt_hours;
+
+        int alt_bin = (int) (altitude * SIM_CORE_SKY_ALT_BINS / 90.0f);
+        alt_bin = alt_bin >= SIM_CORE_SKY_ALT_BINS ? SIM_CORE_SKY_ALT_BINS - 1 : alt_bin;
+        bool sunny = record->dni >= SIM_CORE_SUNNY_DNI;
+
+        for (int h = 0; h < heading_count; h++) {
+            Vector3 dir = SimCore_RotateToHeading(sun_dir, 360.0f * h / heading_count);
+            float azimuth = atan2f(dir.x, -dir.z) * RAD2DEG;
+            if (azimuth < 0.0f)
+                azimuth += 360.0f;
+            int az_bin = (int) (azimuth * SIM_CORE_SKY_AZ_BINS / 360.0f) % SIM_CORE_SKY_AZ_BINS;
+
+            int d = alt_bin * SIM_CORE_SKY_AZ_BINS + az_bin;
+            SkyAccumulator *slot = &slots[sunny * dir_slots + d];
+            slot->hours += weight;
+            slot->dni += record->dni * weight;
+            slot->dhi += record->dhi * weight;
+            slot->ghi += record->ghi * weight;
+            slot->temp_c += record->temp_c * weight;
+            slot->month_ghi[record->month - 1] += record->ghi * weight;
+            dir_sums[d] = Vector3Add(dir_sums[d], Vector3Scale(dir, weight));
+        }
+    }
+
+    free(altitudes);
+
+    // Compact to the occupied bins
+    int dir_count = 0, bin_count = 0;
+    for (int d = 0; d < dir_slots; d++) {
+        dir_index[d] = Vector3LengthSqr(dir_sums[d]) > 0.0f ? dir_count++ : -1;
+    }
+    for (int i = 0; i < 2 * dir_slots; i++) {
+        bin_count += slots[i].hours > 0.0f;
+    }
+    out->dirs = (Vector3 *) malloc((dir_count ? dir_count : 1) * sizeof(Vector3));
+    out->bins = (SimSkyBin *) malloc((bin_count ? bin_count : 1) * sizeof(SimSkyBin));
+    if (!out->dirs || !out->bins) {
+        free(slots);
+        free(dir_sums);
+        free(dir_index);
+        SimCore_FreeSkyHistogram(out);
+        return false;
+    }
+
+    for (int d = 0; d < dir_slots; d++) {
+        if (dir_index[d] >= 0)
+            out->dirs[dir_index[d]] = Vector3Normalize(dir_sums[d]);
+    }
+    out->dir_count = dir_count;
+
+    for (int i = 0; i < 2 * dir_slots; i++) {
+        const SkyAccumulator *slot = &slots[i];
+        if (slot->hours <= 0.0f)
+            continue;
+        SimSkyBin *bin = &out->bins[out->bin_count++];
+        bin->dir = dir_index[i % dir_slots];
+        bin->sunny = i >= dir_slots;
+        bin->hours = slot->hours;
+        bin->dni = slot->dni / slot->hours;
+        bin->dhi = slot->dhi / slot->hours;
+        bin->ghi = slot->ghi / slot->hours;
+        bin->temp_c = slot->temp_c / slot->hours;
+        for (int m = 0; m < 12; m++) {
+            bin->month_share[m] = slot->ghi > 0.0f ? slot->month_ghi[m] / slot->ghi : 0.0f;
+        }
+    }
+
+    free(slots);
+    free(dir_sums);
+    free(dir_index);
+    return true;
+}
+
+void SimCore_FreeSkyHistogram(SimSkyHistogram *histogram) {
+    free(histogram->dirs);
+    free(histogram->bins);
+    memset(histogram, 0, sizeof(*histogram));
+}
+
+//------------------------------------------------------------------------------
+// Shading
+//------------------------------------------------------------------------------
+bool SimCore_SunOccluded(const SimGeometry *geometry, Vector3 position, Vector3 normal, Vector3 sun_dir, bool draft) {
+    Ray ray = {Vector3Add(position, Vector3Scale(normal, SIM_CORE_RAY_OFFSET)), sun_dir};
+    if (geometry->obstacles && ObstacleScene_Occluded(geometry->obstacles, ray, SIM_CORE_MIN_HIT, FLT_MAX))
+        return true;
+    // The draft proxy is inflated to enclose the vehicle, so its answer stands either way. The cell sits inside
+    // the proxy's shell, and the ray leaves it after the shell thickness over the sun's cosine; a hit before
+    // that is the cell's own surface.
+    if (draft && geometry->draft) {
+        float facing = fmaxf(Vector3DotProduct(normal, sun_dir), SIM_CORE_DRAFT_MIN_COS);
+        return MeshBVH_Occluded(geometry->draft, ray, geometry->draft_min_hit / facing, FLT_MAX);
+    }
+
+    RayCollision hit = geometry->bvh ? MeshBVH_Raycast(geometry->bvh, ray, NULL)
+                                     : GetRayCollisionMesh(ray, geometry->mesh, geometry->transform);
+    return hit.hit && hit.distance > SIM_CORE_MIN_HIT;
+}
+
+typedef struct {
+    const SimGeometry *geometry;
+    const SimLayout *layout;
+    Vector3 sun;
+    bool draft;
+    float *facing;
+    float *check;
+} ShadeJob;
+
+static void ShadeCellRange(void *ctx, int begin, int end, int slot) {
+    (void) slot;
+    const ShadeJob *job = (const ShadeJob *) ctx;
+    for (int c = begin; c < end; c++) {
+        Vector3 pos = job->layout->positions[c];
+        Vector3 norm = job->layout->normals[c];
+        float facing = Vector3DotProduct(norm, job->sun);
+
+        bool occluded = facing <= 0 || SimCore_SunOccluded(job->geometry, pos, norm, job->sun, job->draft);
+        if (job->check) {
+            bool occluded_full = facing <= 0 || SimCore_SunOccluded(job->geometry, pos, norm, job->sun, false);
+            job->check[2 * c] = occluded ? 0.0f : facing;
+            job->check[2 * c + 1] = occluded_full ? 0.0f : facing;
+        }
+        job->facing[c] = occluded ? 0.0f : facing;
+    }
+}
+
+void SimCore_ShadeCells(const SimGeometry *geometry, const SimLayout *layout, Vector3 sun_dir, bool draft,
+                        float *facing, float *check) {
+    ShadeJob job = {geometry, layout, sun_dir, draft, facing, check};
+    JobSystem_ParallelFor(layout->cell_count, SIM_CORE_SHADE_GRAIN, ShadeCellRange, &job, NULL);
+}
+
+typedef struct {
+    const SimGeometry *geometry;
+    const SimLayout *layout;
+    const Vector3 *dirs;
+    int dir_begin;
+    int dir_end;
+    int dir_count;
+    bool draft;
+    uint8_t *visible;
+} VisibilityJob;
+
+static void VisibilityRange(void *ctx, int begin, int end, int slot) {
+    (void) slot;
+    const VisibilityJob *job = (const VisibilityJob *) ctx;
+    for (int c = begin; c < end; c++) {
+        Vector3 pos = job->layout->positions[c];
+        Vector3 norm = job->layout->normals[c];
+        uint8_t *row = job->visible + (size_t) c * job->dir_count;
+        for (int d = job->dir_begin; d < job->dir_end; d++) {
+            Vector3 dir = job->dirs[d];
+            row[d] = Vector3DotProduct(norm, dir) > 0 &&
+                     !SimCore_SunOccluded(job->geometry, pos, norm, dir, job->draft);
+        }
+    }
+}
+
+void SimCore_CellVisibility(const SimGeometry *geometry, const SimLayout *layout, const Vector3 *dirs, int dir_begin,
+                            int dir_end, int dir_count, bool draft, uint8_t *visible) {
+    VisibilityJob job = {geometry, layout, dirs, dir_begin, dir_end, dir_count, draft, visible};
+    JobSystem_ParallelFor(layout->cell_count, SIM_CORE_VISIBILITY_GRAIN, VisibilityRange, &job, NULL);
+}
+
+typedef struct {
+    const SimGeometry *geometry;
+    const SimLayout *layout;
+    bool draft;
+    float *sky;
+    float *ground;
+} ViewFactorJob;
+
+static void ViewFactorRange(void *ctx, int begin, int end, int slot) {
+    (void) slot;
+    const ViewFactorJob *job = (const ViewFactorJob *) ctx;
+    for (int c = begin; c < end; c++) {
+        Vector3 pos = job->layout->positions[c];
+        Vector3 norm = job->layout->normals[c];
+        Vector3 axis = fabsf(norm.y) < 0.9f ? (Vector3) {0, 1, 0} : (Vector3) {1, 0, 0};
+        Vector3 tangent = Vector3Normalize(Vector3CrossProduct(axis, norm));
+        Vector3 bitangent = Vector3CrossProduct(norm, tangent);
+
+        // Cosine-weighted directions over the hemisphere, spread on a golden-angle spiral
+        int sky = 0, ground = 0;
+        for (int i = 0; i < SIM_CORE_VIEW_RAYS; i++) {
+            float u = (i + 0.5f) / SIM_CORE_VIEW_RAYS;
+            float r = sqrtf(u);
+            float phi = i * 2.39996323f;
+            Vector3 dir = Vector3Add(Vector3Add(Vector3Scale(tangent, r * cosf(phi)),
+                                                Vector3Scale(bitangent, r * sinf(phi))),
+                                     Vector3Scale(norm, sqrtf(1.0f - u)));
+            if (SimCore_SunOccluded(job->geometry, pos, norm, dir, job->draft))
+                continue;
+            if (dir.y > 0.0f)
+                sky++;
+            else
+                ground++;
+        }
+        job->sky[c] = (float) sky / SIM_CORE_VIEW_RAYS;
+        job->ground[c] = (float) ground / SIM_CORE_VIEW_RAYS;
+    }
+}
+
+void SimCore_CellViewFactors(const SimGeometry *geometry, const SimLayout *layout, bool draft, float *sky,
+                             float *ground) {
+    ViewFactorJob job = {geometry, layout, draft, sky, ground};
+    JobSystem_ParallelFor(layout->cell_count, SIM_CORE_VISIBILITY_GRAIN, ViewFactorRange, &job, NULL);
+}
+
+typedef struct {
+    const SimGeometry *geometry;
+    const SimLayout *layout;
+    const Vector3 *dirs;
+    const float *weights;
+    int dir_count;
+    bool draft;
+    float *exposure;
+} ExposureJob;
+
+static void ExposureRange(void *ctx, int begin, int end, int slot) {
+    (void) slot;
+    const ExposureJob *job = (const ExposureJob *) ctx;
+    for (int c = begin; c < end; c++) {
+        Vector3 pos = job->layout->positions[c];
+        Vector3 norm = job->layout->normals[c];
+        float sum = 0.0f;
+        for (int d = 0; d < job->dir_count; d++) {
+            float facing = Vector3DotProduct(norm, job->dirs[d]);
+            if (facing > 0 && !SimCore_SunOccluded(job->geometry, pos, norm, job->dirs[d], job->draft))
+                sum += job->weights[d] * facing;
+        }
+        job->exposure[c] = sum;
+    }
+}
+
+void SimCore_DirectExposure(const SimGeometry *geometry, const SimLayout *layout, const Vector3 *dirs,
+                            const float *weights, int dir_count, bool draft, float *exposure) {
+    ExposureJob job = {geometry, layout, dirs, weights, dir_count, draft, exposure};
+    JobSystem_ParallelFor(layout->cell_count, SIM_CORE_VISIBILITY_GRAIN, ExposureRange, &job, NULL);
+}
+
+float SimCore_OcclusionScore(const SimGeometry *geometry, Vector3 position, Vector3 normal, const SunSample *samples,
+                             int sample_count, float bar, bool draft, int *rays) {
+    if (sample_count == 0)
+        return 1.0f;
+
+    int occluded_count = 0;
+    for (int i = 0; i < sample_count; i++) {
+        float facing = Vector3DotProduct(normal, samples[i].dir);
+        if (facing <= 0) {
+            occluded_count++;
+        } else {
+            if (rays)
+                (*rays)++;
+            if (SimCore_SunOccluded(geometry, position, normal, samples[i].dir, draft))
+                occluded_count++;
+        }
+
+        float lower = (float) occluded_count / sample_count;
+        float upper = (float) (occluded_count + sample_count - 1 - i) / sample_count;
+        if (lower > bar)
+            return lower;
+        if (bar <= 1.0f && upper <= bar && upper - lower <= SIM_CORE_SCORE_SETTLE * bar)
+            return upper;
+    }
+    return (float) occluded_count / sample_count;
+}
+
+//------------------------------------------------------------------------------
+// Electrical
+//------------------------------------------------------------------------------
+void SimCore_EvaluateString(const SimCellModel *model, const float *ratios, const bool *has_bypass, int cell_count,
+                            StringSimResult *result, float *cell_voltage) {
+    IVTrace cell_traces[STRING_SIM_MAX_CELLS];
+    if (cell_count > STRING_SIM_MAX_CELLS)
+        cell_count = STRING_SIM_MAX_CELLS;
+    for (int i = 0; i < cell_count; i++) {
+        IVTrace_CreateCellTrace(&cell_traces[i], model->voc, model->isc, model->n_ideal, model->series_r, ratios[i]);
+    }
+
+    StringSim_CalcStringIV(cell_traces, cell_count, model->bypass_v_drop, has_bypass, result);
+
+    if (!cell_voltage)
+        return;
+    for (int i = 0; i < cell_count; i++) {
+        if (result->current >= cell_traces[i].Isc && has_bypass[i])
+            cell_voltage[i] = -model->bypass_v_drop;
+        else
+            cell_voltage[i] = IVTrace_InterpV(&cell_traces[i], result->current);
+    }
+}
@@ -0,0 +1,180 @@
+#ifndef SIM_CORE_H
+#define SIM_CORE_H
+
+#include <stdbool.h>
+#include "raylib.h"
+#include "mesh_bvh.h"
+#include "obstacle_scene.h"
+#include "simulation/string_sim.h"
+#include "simulation/weather.h"
+
+//------------------------------------------------------------------------------
+// Constants
+//------------------------------------------------------------------------------
+#define SIM_CORE_RAY_OFFSET 0.01f   // Shading rays start this far off the cell along its normal (m)
+#define SIM_CORE_MIN_HIT 0.02f      // Hits closer than this are the cell's own surface (m)
+#define SIM_CORE_SHADE_GRAIN 16     // Cells per job when shading in parallel
+#define SIM_CORE_SCORE_SETTLE 0.05f // Occlusion score bounds within this fraction of the bar count as settled
+#define SIM_CORE_SKY_ALT_BINS 30    // 3 degree sun altitude bins in the weather histogram
+#define SIM_CORE_SKY_AZ_BINS 36     // 10 degree sun azimuth bins, in the vehicle frame
+#define SIM_CORE_SUN_BATCH 64       // Instants per solar position batch
+#define SIM_CORE_DIR_ALT_BINS 60    // 3 degree elevation bins over the whole sphere, for tilted vehicle frames
+#define SIM_CORE_SUNNY_DNI 120.0f   // Hours at or above this DNI are binned apart as sunny (WMO sunshine, W/m^2)
+#define SIM_CORE_VIEW_RAYS 64       // Hemisphere rays per cell for the sky and ground view factors
+#define SIM_CORE_VISIBILITY_GRAIN 2 // Cells per job when tracing many directions per cell
+#define SIM_CORE_DRAFT_MIN_COS 0.2f // Grazing draft rays skip the proxy's shell as if the sun were this high
+
+//------------------------------------------------------------------------------
+// Reentrant simulation core
+//------------------------------------------------------------------------------
+// Everything here reads explicit inputs and writes only the output buffers it
+// is given: geometry and layout are passed as read-only snapshots, sun
+// positions are computed from a site and an hour without touching any
+// settings. Calls can run concurrently on different (or the same) inputs,
+// and nothing depends on the application state, so the core can be linked
+// into other tools.
+
+// Where and when the sun is computed
+typedef struct {
+    float latitude;     // degrees
+    float longitude;    // degrees
+    int year;
+    int month;
+    int day;
+    float utc_offset;   // Hours the site's clock is ahead of UTC
+} SimSite;
+
+// One sun position in the vehicle frame
+typedef struct {
+    Vector3 dir;        // Unit vector towards the sun
+    float altitude;     // degrees
+    float azimuth;      // degrees
+    float hour;
+    float heading_deg;  // Vehicle heading the direction was rotated for
+} SunSample;
+
+// Occluding geometry, all in world space
+typedef struct {
+    const MeshBVH *bvh;         // Full mesh (NULL = brute force against mesh)
+    Mesh mesh;
+    Matrix transform;
+    const MeshBVH *draft;       // Simplified occluder for draft shading, NULL if none
+    float draft_min_hit;        // Draft proxy shell thickness at normal incidence; hits within it are ignored
+    const ObstacleScene *obstacles; // Scenery around the vehicle, NULL if none
+} SimGeometry;
+
+// World-space cell positions and normals at the moment of the snapshot
+typedef struct {
+    int cell_count;
+    const Vector3 *positions;
+    const Vector3 *normals;
+} SimLayout;
+
+// Electrical parameters of one cell type
+typedef struct {
+    float voc;
+    float isc;
+    float n_ideal;
+    float series_r;
+    float bypass_v_drop;
+} SimCellModel;
+
+// Weather hours that share a sun direction bin (vehicle frame) and sky class, averaged over headings
+typedef struct {
+    int dir;                // Index into SimSkyHistogram.dirs
+    bool sunny;             // DNI at or above SIM_CORE_SUNNY_DNI
+    float hours;            // Time spent in the bin over the year
+    float dni;              // Mean irradiance while in the bin (W/m^2)
+    float dhi;
+    float ghi;
+    float temp_c;           // Mean ambient temperature
+    float month_share[12];  // Share of the bin's global irradiation falling in each month
+} SimSkyBin;
+
+// Weather-weighted sun direction histogram of a year
+typedef struct {
+    Vector3 *dirs;          // Mean sun direction of each occupied direction bin
+    int dir_count;
+    SimSkyBin *bins;
+    int bin_count;
+    float daylight_hours;   // Hours with the sun up and any irradiance
+} SimSkyHistogram;
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+
+// Sun direction (y up, x east, z south) at an hour of the site's clock on its date; altitude (refracted) and
+// azimuth in degrees. Hours past 24 or below 0 run into the neighbouring days.
+Vector3 SimCore_SunDirection(const SimSite *site, float hour, float *out_alt, float *out_az);
+
+// SimCore_SunDirection for count hours of the site's date in batches; any of the outputs may be NULL
+void SimCore_SunDirections(const SimSite *site, const float *hours, int count, Vector3 *dirs, float *altitudes,
+                           float *azimuths);
+
+// Clear-sky irradiance after the atmosphere for a sun altitude, from the top-of-atmosphere setting (W/m^2)
+float SimCore_EffectiveIrradiance(float irradiance, float altitude);
+
+// Sun direction seen by a vehicle turned heading_deg
+Vector3 SimCore_RotateToHeading(Vector3 sun_dir, float heading_deg);
+
+// Sun direction seen by a vehicle pitched nose up by pitch_deg and rolled right side down by roll_deg.
+// forward is the vehicle's horizontal forward axis; pitch turns about forward x up, then roll about forward.
+Vector3 SimCore_RotateToAttitude(Vector3 sun_dir, Vector3 forward, float pitch_deg, float roll_deg);
+
+// Bin of a unit direction on the whole sphere: SIM_CORE_DIR_ALT_BINS elevation bands by SIM_CORE_SKY_AZ_BINS
+// azimuth sectors, azimuth measured as in the weather histogram
+int SimCore_DirectionSlot(Vector3 dir);
+
+// Every heading x hour sample with the sun above the horizon; hours are spread evenly over
+// [start_hour, start_hour + duration]. out must hold hour_count * heading_count. Returns the count written.
+int SimCore_BuildSunSamples(const SimSite *site, float start_hour, float duration, int hour_count, int heading_count,
+                            SunSample *out);
+
+// Bin every weather record with the sun up by sun direction in the vehicle frame, for heading_count evenly spread
+// headings, and sky class. Record dates are taken in the site's year and their hours on the site's clock.
+// Returns false (histogram empty) if out of memory.
+bool SimCore_BuildSkyHistogram(const WeatherYear *weather, const SimSite *site, int heading_count,
+                               SimSkyHistogram *out);
+
+// Release a histogram (safe on an empty one)
+void SimCore_FreeSkyHistogram(SimSkyHistogram *histogram);
+
+// Whether the vehicle or any obstacle blocks the sun from a point on a surface with the given normal (obstacles
+// are always traced at full detail; draft traces the vehicle as its inflated proxy only)
+bool SimCore_SunOccluded(const SimGeometry *geometry, Vector3 position, Vector3 normal, Vector3 sun_dir, bool draft);
+
+// Shade every cell of the layout for one sun direction on the job threads. facing[c] gets the cosine of the
+// sun angle, or 0 if the cell faces away or is occluded. When check is non-NULL, sampled draft results are
+// traced again against the full mesh and check[2c], check[2c + 1] get the draft and full incident cosines.
+void SimCore_ShadeCells(const SimGeometry *geometry, const SimLayout *layout, Vector3 sun_dir, bool draft,
+                        float *facing, float *check);
+
+// Sun visibility of every cell for directions [dir_begin, dir_end) of dirs, on the job threads:
+// visible[c * dir_count + d] is 1 if cell c faces dirs[d] and nothing blocks it, 0 otherwise
+void SimCore_CellVisibility(const SimGeometry *geometry, const SimLayout *layout, const Vector3 *dirs, int dir_begin,
+                            int dir_end, int dir_count, bool draft, uint8_t *visible);
+
+// Isotropic view factors of every cell, on the job threads: the cosine-weighted share of the cell's hemisphere
+// that reaches open sky (sky[c]) or open ground below the horizon (ground[c]). A clear flat cell has 1 and 0.
+void SimCore_CellViewFactors(const SimGeometry *geometry, const SimLayout *layout, bool draft, float *sky,
+                             float *ground);
+
+// Weighted direct exposure of every point of the layout, on the job threads: exposure[c] is the sum of
+// weights[d] * cos(angle to dirs[d]) over the directions in front of the point that nothing blocks
+void SimCore_DirectExposure(const SimGeometry *geometry, const SimLayout *layout, const Vector3 *dirs,
+                            const float *weights, int dir_count, bool draft, float *exposure);
+
+// Occluded fraction of the samples at one point. Scoring stops as soon as even the best case exceeds bar, which
+// returns the lower bound, or the worst case is at or below bar with the bounds within SIM_CORE_SCORE_SETTLE * bar
+// of each other, which returns the upper bound (a bar above 1 disables both). A settled score is never better than
+// the exact one. Adds the rays traced to *rays when rays is non-NULL.
+float SimCore_OcclusionScore(const SimGeometry *geometry, Vector3 position, Vector3 normal, const SunSample *samples,
+                             int sample_count, float bar, bool draft, int *rays);
+
+// String operating point at its MPP for per-cell irradiance ratios; cell_voltage (optional) gets each cell's
+// voltage there, negative for bypassed cells
+void SimCore_EvaluateString(const SimCellModel *model, const float *ratios, const bool *has_bypass, int cell_count,
+                            StringSimResult *result, float *cell_voltage);
+
+#endif // SIM_CORE_H
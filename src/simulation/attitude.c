@@ -0,0 +1,197 @@
+#include "attitude.h"
+#include "csv_util.h"
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LINE_LENGTH 1024
+#define MAX_FIELDS 64
+#define GRID_SIZE ((int) (2.0f * ATTITUDE_MAX_DEG / ATTITUDE_BIN_DEG) + 1)
+#define MIN_SPEED 1.0f          // Slower rows (stops) weigh as if at this speed, in the log's units
+#define DEGREES_PER_RADIAN 57.29577951f
+
+typedef struct {
+    float weight;
+    float pitch_sum;            // Weighted, for the mean attitude of the bin
+    float roll_sum;
+    bool kept;                  // One of the states; dropped bins are folded into these
+} GridBin;
+
+static float PercentToDegrees(float percent) {
+    return atanf(percent / 100.0f) * DEGREES_PER_RADIAN;
+}
+
+static int GridIndex(float angle_deg) {
+    float clamped = fminf(fmaxf(angle_deg, -ATTITUDE_MAX_DEG), ATTITUDE_MAX_DEG);
+    return (int) lroundf((clamped + ATTITUDE_MAX_DEG) / ATTITUDE_BIN_DEG);
+}
+
+void Attitude_Level(AttitudeSet *set) {
+    memset(set, 0, sizeof(*set));
+    set->states[0].weight = 1.0f;
+    set->count = 1;
+}
+
+void Attitude_FromSpread(AttitudeSet *set, float pitch_sd_deg, float roll_sd_deg) {
+    static const float nodes[3] = {0.0f, -1.7320508f, 1.7320508f};
+    static const float weights[3] = {2.0f / 3.0f, 1.0f / 6.0f, 1.0f / 6.0f};
+
+    memset(set, 0, sizeof(*set));
+    int pitch_nodes = pitch_sd_deg > 0.0f ? 3 : 1;
+    int roll_nodes = roll_sd_deg > 0.0f ? 3 : 1;
+    for (int p = 0; p < pitch_nodes; p++) {
+        for (int r = 0; r < roll_nodes; r++) {
+            AttitudeState *state = &set->states[set->count++];
+            state->pitch_deg = nodes[p] * pitch_sd_deg;
+            state->roll_deg = nodes[r] * roll_sd_deg;
+            state->weight = (pitch_nodes > 1 ? weights[p] : 1.0f) * (roll_nodes > 1 ? weights[r] : 1.0f);
+        }
+    }
+}
+
+bool Attitude_LoadCSV(AttitudeSet *set, const char *path, char *error, size_t error_size) {
+    static const char *const pitch_names[] = {"pitch"};
+    static const char *const grade_names[] = {"grade", "slope"};
+    static const char *const roll_names[] = {"roll", "bank"};
+    static const char *const camber_names[] = {"camber", "cross slope", "cross_slope", "crossfall"};
+    static const char *const speed_names[] = {"speed", "velocity"};
+
+    Attitude_Level(set);
+
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        Csv_SetError(error, error_size, "Could not open the file");
+        return false;
+    }
+    GridBin *grid = (GridBin *) calloc(GRID_SIZE * GRID_SIZE, sizeof(GridBin));
+    if (!grid) {
+        fclose(file);
+        Csv_SetError(error, error_size, "Out of memory");
+        return false;
+    }
+
+    char line[LINE_LENGTH];
+    char *fields[MAX_FIELDS];
+    int pitch = -1, grade = -1, roll = -1, camber = -1, speed = -1;
+    while (fgets(line, sizeof(line), file)) {
+        int count = Csv_SplitFields(line, fields, MAX_FIELDS);
+        pitch = Csv_FindColumn(fields, count, pitch_names, 1);
+        grade = Csv_FindColumn(fields, count, grade_names, 2);
+        roll = Csv_FindColumn(fields, count, roll_names, 2);
+        camber = Csv_FindColumn(fields, count, camber_names, 4);
+        speed = Csv_FindColumn(fields, count, speed_names, 2);
+        if (pitch >= 0 || grade >= 0 || roll >= 0 || camber >= 0)
+            break;
+    }
+    if (pitch < 0 && grade < 0 && roll < 0 && camber < 0) {
+        free(grid);
+        fclose(file);
+        Csv_SetError(error, error_size, "No pitch, grade, roll or camber column found");
+        return false;
+    }
+
+    int samples = 0;
+    while (fgets(line, sizeof(line), file)) {
+        int count = Csv_SplitFields(line, fields, MAX_FIELDS);
+        float p = 0.0f, r = 0.0f, value;
+        bool any = false;
+        if (Csv_ReadNumber(fields, count, pitch, &value)) {
+            p = value;
+            any = true;
+        } else if (Csv_ReadNumber(fields, count, grade, &value)) {
+            p = PercentToDegrees(value);
+            any = true;
+        }
+        if (Csv_ReadNumber(fields, count, roll, &value)) {
+            r = value;
+            any = true;
+        } else if (Csv_ReadNumber(fields, count, camber, &value)) {
+            r = PercentToDegrees(value);
+            any = true;
+        }
+        if (!any)
+            continue;
+
+        float weight = 1.0f;
+        if (Csv_ReadNumber(fields, count, speed, &value))
+            weight = 1.0f / fmaxf(fabsf(value), MIN_SPEED);
+
+        GridBin *bin = &grid[GridIndex(p) * GRID_SIZE + GridIndex(r)];
+        bin->weight += weight;
+        bin->pitch_sum += p * weight;
+        bin->roll_sum += r * weight;
+        samples++;
+    }
+    fclose(file);
+
+    if (samples == 0) {
+        free(grid);
+        Csv_SetError(error, error_size, "No attitude rows found");
+        return false;
+    }
+
+    // Keep the heaviest bins, at their mean attitudes
+    int kept[ATTITUDE_MAX_STATES];
+    int kept_count = 0;
+    while (kept_count < ATTITUDE_MAX_STATES) {
+        int best = -1;
+        for (int i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+            if (grid[i].weight > 0.0f && !grid[i].kept && (best < 0 || grid[i].weight > grid[best].weight))
+                best = i;
+        }
+        if (best < 0)
+            break;
+        GridBin *bin = &grid[best];
+        bin->kept = true;
+        kept[kept_count] = best;
+        set->states[kept_count++] = (AttitudeState) {bin->pitch_sum / bin->weight, bin->roll_sum / bin->weight, 0};
+    }
+
+    // Fold every dropped bin into the kept attitude nearest its mean, so its time still counts where the vehicle
+    // was closest to rather than being spread over all of them
+    for (int i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+        GridBin *bin = &grid[i];
+        if (bin->weight <= 0.0f || bin->kept)
+            continue;
+        float p = bin->pitch_sum / bin->weight;
+        float r = bin->roll_sum / bin->weight;
+        int nearest = 0;
+        float nearest_d2 = FLT_MAX;
+        for (int k = 0; k < kept_count; k++) {
+            float dp = set->states[k].pitch_deg - p;
+            float dr = set->states[k].roll_deg - r;
+            if (dp * dp + dr * dr < nearest_d2) {
+                nearest_d2 = dp * dp + dr * dr;
+                nearest = k;
+            }
+        }
+        GridBin *into = &grid[kept[nearest]];
+        into->weight += bin->weight;
+        into->pitch_sum += bin->pitch_sum;
+        into->roll_sum += bin->roll_sum;
+    }
+
+    // The folded bins move each kept attitude to the mean of everything it stands for
+    float total = 0.0f;
+    for (int k = 0; k < kept_count; k++) {
+        total += grid[kept[k]].weight;
+    }
+    for (int k = 0; k < kept_count; k++) {
+        const GridBin *bin = &grid[kept[k]];
+        set->states[k] = (AttitudeState) {bin->pitch_sum / bin->weight, bin->roll_sum / bin->weight,
+                                          bin->weight / total};
+    }
+    set->count = kept_count;
+    set->route_samples = samples;
+
+    free(grid);
+    return true;
+}
+
+bool Attitude_IsLevel(const AttitudeSet *set) {
+    if (set->count > 1)
+        return false;
+    return set->count == 0 || (set->states[0].pitch_deg == 0.0f && set->states[0].roll_deg == 0.0f);
+}
@@ -0,0 +1,56 @@
+#ifndef ATTITUDE_H
+#define ATTITUDE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+//------------------------------------------------------------------------------
+// Constants
+//------------------------------------------------------------------------------
+#define ATTITUDE_MAX_STATES 25      // Attitudes kept per distribution
+#define ATTITUDE_BIN_DEG 1.0f       // Route samples are binned to this pitch and roll resolution
+#define ATTITUDE_MAX_DEG 15.0f      // Route pitch and roll are clamped to this
+
+//------------------------------------------------------------------------------
+// Vehicle attitude distribution
+//------------------------------------------------------------------------------
+// Pitch and roll the vehicle spends its time at, as weighted states that sum
+// to 1. Pitch is nose up, roll is right side down, both in degrees about the
+// vehicle's forward axis. A distribution comes either from a spread (each
+// axis normal with the given standard deviation, sampled at the three-point
+// Gauss-Hermite nodes 0 and +-sqrt(3) sd with weights 2/3 and 1/6) or from a
+// route log:
+//   CSV with a header naming pitch (deg) or grade (%), and roll / bank (deg)
+//   or camber / cross slope (%). Either axis may be missing. An optional
+//   speed column weights each row by the time spent on it (1 / speed), for
+//   logs sampled by distance; rows are equally weighted otherwise.
+
+typedef struct {
+    float pitch_deg;
+    float roll_deg;
+    float weight;       // Share of the time spent at this attitude
+} AttitudeState;
+
+typedef struct {
+    AttitudeState states[ATTITUDE_MAX_STATES];
+    int count;
+    int route_samples;  // Rows read from a route log, 0 for a spread
+} AttitudeSet;
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+
+// Always level
+void Attitude_Level(AttitudeSet *set);
+
+// Independent normal pitch and roll with the given standard deviations (degrees)
+void Attitude_FromSpread(AttitudeSet *set, float pitch_sd_deg, float roll_sd_deg);
+
+// Histogram of a route log. On failure the set is left level and error (optional) gets the reason.
+bool Attitude_LoadCSV(AttitudeSet *set, const char *path, char *error, size_t error_size);
+
+// True if the only state is level
+bool Attitude_IsLevel(const AttitudeSet *set);
+
+#endif // ATTITUDE_H
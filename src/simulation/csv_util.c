@@ -0,0 +1,84 @@
+#include "csv_util.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void Csv_SetError(char *error, size_t error_size, const char *message) {
+    if (error && error_size > 0)
+        snprintf(error, error_size, "%s", message);
+}
+
+int Csv_SplitFields(char *line, char **fields, int max_fields) {
+    int count = 0;
+    char *p = line;
+    while (count < max_fields) {
+        while (*p == ' ' || *p == '\t')
+            p++;
+        bool quoted = *p == '"';
+        if (quoted)
+            p++;
+        char *start = p;
+        char *out = p;
+        if (quoted) {
+            while (*p && *p != '"')
+                *out++ = *p++;
+            if (*p == '"')
+                p++;
+        }
+        while (*p && *p != ',' && *p != '\r' && *p != '\n')
+            *out++ = *p++;
+        char end = *p;
+        while (out > start && (out[-1] == ' ' || out[-1] == '\t'))
+            out--;
+        *out = '\0';
+        fields[count++] = start;
+        if (end != ',')
+            break;
+        p++;
+    }
+    return count;
+}
+
+bool Csv_StartsWith(const char *field, const char *prefix) {
+    for (; *prefix; field++, prefix++) {
+        if (tolower((unsigned char) *field) != *prefix)
+            return false;
+    }
+    return true;
+}
+
+bool Csv_Equals(const char *field, const char *name) {
+    return Csv_StartsWith(field, name) && field[strlen(name)] == '\0';
+}
+
+bool Csv_ParseNumber(const char *field, float *value) {
+    char *end;
+    float v = strtof(field, &end);
+    if (end == field)
+        return false;
+    *value = v;
+    return true;
+}
+
+int Csv_FindColumn(char **fields, int count, const char *const *prefixes, int prefix_count) {
+    for (int f = 0; f < count; f++) {
+        for (int p = 0; p < prefix_count; p++) {
+            if (Csv_StartsWith(fields[f], prefixes[p]))
+                return f;
+        }
+    }
+    return -1;
+}
+
+int Csv_FindExact(char **fields, int count, const char *name) {
+    for (int f = 0; f < count; f++) {
+        if (Csv_Equals(fields[f], name))
+            return f;
+    }
+    return -1;
+}
+
+bool Csv_ReadNumber(char **fields, int count, int column, float *value) {
+    return column >= 0 && column < count && Csv_ParseNumber(fields[column], value);
+}
@@ -0,0 +1,43 @@
+#ifndef CSV_UTIL_H
+#define CSV_UTIL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+//------------------------------------------------------------------------------
+// CSV parsing helpers
+//------------------------------------------------------------------------------
+// Shared by the weather and route log readers. Lines are split in place, so
+// fields point into the caller's buffer. Column names are matched without
+// case against lower-case prefixes.
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+
+// Copy message into error (optional) for a loader's caller
+void Csv_SetError(char *error, size_t error_size, const char *message);
+
+// Split a line in place; surrounding blanks are trimmed, quotes are stripped and protect commas. Returns the
+// field count.
+int Csv_SplitFields(char *line, char **fields, int max_fields);
+
+// Whether field starts with prefix (lower case), ignoring the field's case
+bool Csv_StartsWith(const char *field, const char *prefix);
+
+// Whether field equals name (lower case), ignoring the field's case
+bool Csv_Equals(const char *field, const char *name);
+
+// Parse a leading number; false if the field does not start with one
+bool Csv_ParseNumber(const char *field, float *value);
+
+// First column whose name starts with any of the prefixes, -1 if none
+int Csv_FindColumn(char **fields, int count, const char *const *prefixes, int prefix_count);
+
+// First column named exactly name, -1 if none
+int Csv_FindExact(char **fields, int count, const char *name);
+
+// Number in a column; false if the column is -1, past the row's end or not a number
+bool Csv_ReadNumber(char **fields, int count, int column, float *value);
+
+#endif // CSV_UTIL_H
@@ -0,0 +1,116 @@
+#include "mppt_sim.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Current of trace at voltage v, where cursor is the first sample with V < v
+static float CurrentAtCursor(const IVTrace *trace, int cursor, float v) {
+    if (cursor <= 0) return 0;  // Above Voc: blocked
+    if (cursor >= trace->n_samples) return trace->I[trace->n_samples - 1];
+
+    int a = cursor - 1;
+    float dv = trace->V[a] - trace->V[cursor];
+    if (dv <= 0) return trace->I[cursor];
+    float t = (trace->V[a] - v) / dv;
+    return trace->I[a] + t * (trace->I[cursor] - trace->I[a]);
+}
+
+float MpptSim_StringCurrentAt(const IVTrace *string_trace, float voltage) {
+    if (string_trace->n_samples < 2) return 0;
+    int cursor = 0;
+    while (cursor < string_trace->n_samples && string_trace->V[cursor] >= voltage) cursor++;
+    return CurrentAtCursor(string_trace, cursor, voltage);
+}
+
+void MpptSim_CombineParallel(const IVTrace *const *string_traces, int n_strings, MpptChannelResult *result) {
+    memset(result, 0, sizeof(MpptChannelResult));
+    if (n_strings > MPPT_SIM_MAX_STRINGS) n_strings = MPPT_SIM_MAX_STRINGS;
+    result->n_strings = n_strings;
+
+    int total = 0;
+    for (int k = 0; k < n_strings; k++) {
+        if (string_traces[k]->n_samples >= 2) total += string_traces[k]->n_samples;
+    }
+    if (total == 0) return;
+
+    float *merged_v = (float *)malloc(total * sizeof(float));
+    float *merged_i = (float *)malloc(total * sizeof(float));
+    int cursor[MPPT_SIM_MAX_STRINGS] = {0};
+    if (!merged_v || !merged_i) {
+        free(merged_v);
+        free(merged_i);
+        return;
+    }
+
+    // Merge the voltage breakpoints of all strings in descending order. Each
+    // trace is monotone, so one forward cursor per string evaluates its current.
+    int m = 0;
+    float best_p = 0, best_v = 0, best_i = 0;
+    for (;;) {
+        float v = -1.0f;
+        for (int k = 0; k < n_strings; k++) {
+            const IVTrace *t = string_traces[k];
+            if (t->n_samples >= 2 && cursor[k] < t->n_samples && t->V[cursor[k]] > v) v = t->V[cursor[k]];
+        }
+        if (v < 0) break;
+
+        float i_sum = 0;
+        for (int k = 0; k < n_strings; k++) {
+            const IVTrace *t = string_traces[k];
+            if (t->n_samples < 2) continue;
+            while (cursor[k] < t->n_samples && t->V[cursor[k]] >= v) cursor[k]++;
+            i_sum += CurrentAtCursor(t, cursor[k], v);
+        }
+
+        // Between breakpoints every string current is linear in V, so power is
+        // quadratic; check the vertex of the segment to the previous breakpoint
+        if (m > 0) {
+            float v0 = merged_v[m - 1], i0 = merged_i[m - 1];
+            float s = (i_sum - i0) / (v - v0);
+            if (v0 > v && s < 0) {
+                float v_star = 0.5f * (v0 - i0 / s);
+                if (v_star > v && v_star < v0) {
+                    float i_star = i0 + s * (v_star - v0);
+                    if (v_star * i_star > best_p) {
+                        best_p = v_star * i_star;
+                        best_v = v_star;
+                        best_i = i_star;
+                    }
+                }
+            }
+        }
+
+        if (v * i_sum > best_p) {
+            best_p = v * i_sum;
+            best_v = v;
+            best_i = i_sum;
+        }
+
+        merged_v[m] = v;
+        merged_i[m] = i_sum;
+        m++;
+    }
+
+    result->power_out = best_p;
+    result->voltage = best_v;
+    result->current = best_i;
+    for (int k = 0; k < n_strings; k++) {
+        result->string_current[k] = MpptSim_StringCurrentAt(string_traces[k], best_v);
+    }
+
+    // Keep a resampled copy of the combined curve
+    int n_out = (m < IV_TRACE_MAX_SAMPLES) ? m : IV_TRACE_MAX_SAMPLES;
+    for (int i = 0; i < n_out; i++) {
+        int src = (n_out > 1) ? (int)((long)i * (m - 1) / (n_out - 1)) : 0;
+        result->iv_trace.V[i] = merged_v[src];
+        result->iv_trace.I[i] = merged_i[src];
+    }
+    result->iv_trace.n_samples = n_out;
+    result->iv_trace.Voc = merged_v[0];
+    result->iv_trace.Isc = merged_i[m - 1];
+    result->iv_trace.Vmp = best_v;
+    result->iv_trace.Imp = best_i;
+
+    free(merged_v);
+    free(merged_i);
+}
@@ -0,0 +1,41 @@
+#ifndef MPPT_SIM_H
+#define MPPT_SIM_H
+
+#include "iv_trace.h"
+#include <stdbool.h>
+
+//------------------------------------------------------------------------------
+// Constants
+//------------------------------------------------------------------------------
+#define MPPT_SIM_MAX_STRINGS 50
+
+//------------------------------------------------------------------------------
+// MPPT channel simulation
+//------------------------------------------------------------------------------
+// Strings wired in parallel onto one tracker share a common voltage. The
+// channel IV curve is the sum of the string currents at each voltage, and the
+// tracker settles at the MPP of that combined curve rather than at each
+// string's own MPP.
+
+typedef struct {
+    float power_out;                             // Channel power at combined MPP (W)
+    float voltage;                               // Common string voltage at MPP (V)
+    float current;                               // Total channel current at MPP (A)
+    int n_strings;
+    float string_current[MPPT_SIM_MAX_STRINGS];  // Each string's current at the channel voltage
+    IVTrace iv_trace;                            // Combined IV trace (I ascending, V descending)
+} MpptChannelResult;
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+
+// Combine string IV traces connected in parallel and find the channel MPP
+// string_traces: string traces as produced by StringSim_CalcStringIV (I ascending, V descending)
+// Strings are assumed to have blocking diodes, so a string above its Voc carries no current
+void MpptSim_CombineParallel(const IVTrace *const *string_traces, int n_strings, MpptChannelResult *result);
+
+// Current drawn from a string trace at a given string voltage
+float MpptSim_StringCurrentAt(const IVTrace *string_trace, float voltage);
+
+#endif // MPPT_SIM_H
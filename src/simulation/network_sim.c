@@ -0,0 +1,848 @@
+/*
+ * Series-parallel array network: netlist, sparse LDL' Newton solver, MPP search
+ */
+
+#include "network_sim.h"
+#include <ctype.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LINE_LENGTH 1024
+#define MAX_TOKENS 8
+#define EXP_LIMIT 80.0          // Exponentials grow linearly past this argument
+#define GOLDEN 0.61803398875
+
+typedef struct {
+    char name[NETWORK_SIM_NAME_LENGTH];
+} NodeName;
+
+static void SetError(char *error, size_t error_size, const char *message) {
+    if (error && error_size > 0)
+        snprintf(error, error_size, "%s", message);
+}
+
+static void SetLineError(char *error, size_t error_size, int line, const char *message) {
+    if (error && error_size > 0)
+        snprintf(error, error_size, "Line %d: %s", line, message);
+}
+
+// Split a netlist line in place on blanks, dropping any '#' comment. Returns the token count.
+static int SplitTokens(char *line, char **tokens, int max_tokens) {
+    char *comment = strchr(line, '#');
+    if (comment)
+        *comment = '\0';
+    int count = 0;
+    char *p = line;
+    while (count < max_tokens) {
+        while (*p && isspace((unsigned char) *p))
+            p++;
+        if (!*p)
+            break;
+        tokens[count++] = p;
+        while (*p && !isspace((unsigned char) *p))
+            p++;
+        if (*p)
+            *p++ = '\0';
+    }
+    return count;
+}
+
+static bool Equals(const char *token, const char *keyword) {
+    for (; *keyword; token++, keyword++) {
+        if (tolower((unsigned char) *token) != *keyword)
+            return false;
+    }
+    return *token == '\0';
+}
+
+static bool ParseNumber(const char *token, double *value) {
+    char *end;
+    double v = strtod(token, &end);
+    if (end == token || *end)
+        return false;
+    *value = v;
+    return true;
+}
+
+// Index of a node name, adding it if new; -1 if out of memory
+static int FindNode(NodeName **names, int *count, int *capacity, const char *name) {
+    for (int i = 0; i < *count; i++) {
+        if (strcmp((*names)[i].name, name) == 0)
+            return i;
+    }
+    if (*count == *capacity) {
+        int grown = *capacity ? *capacity * 2 : 64;
+        NodeName *resized = (NodeName *) realloc(*names, grown * sizeof(NodeName));
+        if (!resized)
+            return -1;
+        *names = resized;
+        *capacity = grown;
+    }
+    snprintf((*names)[*count].name, NETWORK_SIM_NAME_LENGTH, "%s", name);
+    return (*count)++;
+}
+
+//------------------------------------------------------------------------------
+// Device equations
+//------------------------------------------------------------------------------
+
+static double LimitedExp(double x) {
+    return x > EXP_LIMIT ? exp(EXP_LIMIT) * (1.0 + x - EXP_LIMIT) : exp(x);
+}
+
+// SPICE junction limiting: past the critical voltage, a forward step follows the log of the current it would imply
+static double LimitJunction(double v_new, double v_old, double vt, double v_crit, bool *limited) {
+    if (v_new > v_crit && fabs(v_new - v_old) > 2.0 * vt) {
+        *limited = true;
+        if (v_old > 0.0) {
+            double arg = 1.0 + (v_new - v_old) / vt;
+            return arg > 0.0 ? v_old + vt * log(arg) : v_crit;
+        }
+        return vt * log(v_new / vt);
+    }
+    return v_new;
+}
+
+static double CellSaturation(const NetworkSimCellModel *model, double vt) {
+    return model->isc * exp(-model->voc / vt);
+}
+
+static double DiodeSaturation(double drop, double vt) {
+    return NETWORK_SIM_DIODE_REF_I * exp(-drop / vt);
+}
+
+static double CellSeriesR(const NetworkSimCellModel *model) {
+    return fmax(model->series_r, NETWORK_SIM_MIN_SERIES_R);
+}
+
+static double WireR(const NetworkSimElement *element) {
+    return element->value > 0.0 ? element->value : NETWORK_SIM_WIRE_R;
+}
+
+//------------------------------------------------------------------------------
+// Elements and netlist
+//------------------------------------------------------------------------------
+
+int NetworkSim_AddElement(NetworkSim *net, NetworkSimElementType type, int a, int b, int cell_id, double value) {
+    if (net->element_count == net->element_capacity) {
+        int grown = net->element_capacity ? net->element_capacity * 2 : 64;
+        NetworkSimElement *resized = (NetworkSimElement *) realloc(net->elements, grown * sizeof(NetworkSimElement));
+        if (!resized)
+            return -1;
+        net->elements = resized;
+        net->element_capacity = grown;
+    }
+    NetworkSimElement *element = &net->elements[net->element_count];
+    memset(element, 0, sizeof(*element));
+    element->type = type;
+    element->a = a;
+    element->b = b;
+    element->cell_id = cell_id;
+    element->value = value;
+    element->junction = -1;
+    element->ratio = 1.0;
+    if (a >= net->node_count)
+        net->node_count = a + 1;
+    if (b >= net->node_count)
+        net->node_count = b + 1;
+    if (type == NETWORK_SIM_CELL)
+        net->cell_count++;
+    net->built = false;
+    return net->element_count++;
+}
+
+bool NetworkSim_LoadNetlist(NetworkSim *net, const char *path, double default_diode_drop, char *error,
+                            size_t error_size) {
+    NetworkSim_Free(net);
+
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        SetError(error, error_size, "Could not open the file");
+        return false;
+    }
+
+    NodeName *names = NULL;
+    int name_count = 0, name_capacity = 0;
+    int port_pos = -1, port_neg = -1;
+    char line[LINE_LENGTH];
+    char *tokens[MAX_TOKENS];
+    int line_number = 0;
+    bool ok = true;
+
+    // Nodes are numbered in file order while reading; the port terminals move to 0 / 1 afterwards
+    while (ok && fgets(line, sizeof(line), file)) {
+        line_number++;
+        int count = SplitTokens(line, tokens, MAX_TOKENS);
+        if (count == 0)
+            continue;
+
+        bool is_port = Equals(tokens[0], "port");
+        bool is_cell = Equals(tokens[0], "cell");
+        bool is_diode = Equals(tokens[0], "diode");
+        bool is_wire = Equals(tokens[0], "wire");
+        if (!is_port && !is_cell && !is_diode && !is_wire) {
+            SetLineError(error, error_size, line_number, "Unknown element (expected port, cell, diode or wire)");
+            ok = false;
+            break;
+        }
+
+        int first = is_cell ? 2 : 1;
+        if (count < first + 2) {
+            SetLineError(error, error_size, line_number, "Missing node name");
+            ok = false;
+            break;
+        }
+        int a = FindNode(&names, &name_count, &name_capacity, tokens[first]);
+        int b = FindNode(&names, &name_count, &name_capacity, tokens[first + 1]);
+        if (a < 0 || b < 0) {
+            SetError(error, error_size, "Out of memory");
+            ok = false;
+            break;
+        }
+        if (a == b) {
+            SetLineError(error, error_size, line_number, "Both ends on the same node");
+            ok = false;
+            break;
+        }
+
+        if (is_port) {
+            if (port_pos >= 0) {
+                SetLineError(error, error_size, line_number, "Only one port is supported");
+                ok = false;
+                break;
+            }
+            port_pos = a;
+            port_neg = b;
+            continue;
+        }
+
+        double id = 0.0, value = 0.0;
+        if (is_cell && (!ParseNumber(tokens[1], &id) || id < 0.0)) {
+            SetLineError(error, error_size, line_number, "Cell id must be a non-negative number");
+            ok = false;
+            break;
+        }
+        if (is_diode)
+            value = default_diode_drop;
+        if (!is_cell && count > 3 && (!ParseNumber(tokens[3], &value) || value < 0.0)) {
+            SetLineError(error, error_size, line_number, is_diode ? "Bad diode drop" : "Bad wire resistance");
+            ok = false;
+            break;
+        }
+
+        NetworkSimElementType type = is_cell ? NETWORK_SIM_CELL : is_diode ? NETWORK_SIM_DIODE : NETWORK_SIM_WIRE;
+        if (NetworkSim_AddElement(net, type, a, b, (int) id, value) < 0) {
+            SetError(error, error_size, "Out of memory");
+            ok = false;
+        }
+    }
+    fclose(file);
+
+    if (ok && port_pos < 0) {
+        SetError(error, error_size, "No port line");
+        ok = false;
+    }
+    if (ok && net->cell_count == 0) {
+        SetError(error, error_size, "No cells");
+        ok = false;
+    }
+
+    int *remap = ok ? (int *) malloc(name_count * sizeof(int)) : NULL;
+    if (ok && !remap) {
+        SetError(error, error_size, "Out of memory");
+        ok = false;
+    }
+    if (ok) {
+        int next = 2;
+        for (int i = 0; i < name_count; i++) {
+            remap[i] = i == port_neg ? 0 : i == port_pos ? 1 : next++;
+        }
+        for (int e = 0; e < net->element_count; e++) {
+            net->elements[e].a = remap[net->elements[e].a];
+            net->elements[e].b = remap[net->elements[e].b];
+        }
+        net->node_count = name_count;
+    }
+
+    free(remap);
+    free(names);
+    if (!ok)
+        NetworkSim_Free(net);
+    return ok;
+}
+
+//------------------------------------------------------------------------------
+// Symbolic analysis
+//------------------------------------------------------------------------------
+
+// Unknown of a node (-1 for the reference)
+static int NodeUnknown(int node) {
+    return node - 1;
+}
+
+// The one or two two-terminal branches an element stamps, as unknowns
+static int ElementBranches(const NetworkSim *net, const NetworkSimElement *element, int ends[2][2]) {
+    if (element->type == NETWORK_SIM_CELL) {
+        int junction = net->node_count - 1 + element->junction;
+        ends[0][0] = NodeUnknown(element->a);
+        ends[0][1] = junction;
+        ends[1][0] = junction;
+        ends[1][1] = NodeUnknown(element->b);
+        return 2;
+    }
+    ends[0][0] = NodeUnknown(element->a);
+    ends[0][1] = NodeUnknown(element->b);
+    ends[1][0] = -1;
+    ends[1][1] = -1;
+    return 1;
+}
+
+static int FindSlot(const NetworkSim *net, int row, int column) {
+    if (row < 0 || column < 0)
+        return -1;
+    for (int p = net->col_start[column]; p < net->col_start[column + 1]; p++) {
+        if (net->row_index[p] == row)
+            return p;
+    }
+    return -1;
+}
+
+static int BitCount(uint64_t bits) {
+    int count = 0;
+    for (; bits; bits &= bits - 1) {
+        count++;
+    }
+    return count;
+}
+
+// Greedy minimum degree on the elimination graph, kept as adjacency bitsets
+static bool OrderMinimumDegree(NetworkSim *net) {
+    const int n = net->unknowns;
+    const int words = (n + 63) / 64;
+    uint64_t *adjacency = (uint64_t *) calloc((size_t) n * words, sizeof(uint64_t));
+    int *degree = (int *) malloc(n * sizeof(int));
+    bool *eliminated = (bool *) calloc(n, sizeof(bool));
+    if (!adjacency || !degree || !eliminated) {
+        free(adjacency);
+        free(degree);
+        free(eliminated);
+        return false;
+    }
+
+    for (int j = 0; j < n; j++) {
+        for (int p = net->col_start[j]; p < net->col_start[j + 1]; p++) {
+            int i = net->row_index[p];
+            if (i != j)
+                adjacency[(size_t) j * words + i / 64] |= (uint64_t) 1 << (i % 64);
+        }
+        degree[j] = net->col_start[j + 1] - net->col_start[j] - 1;
+    }
+
+    for (int k = 0; k < n; k++) {
+        int best = -1;
+        for (int i = 0; i < n; i++) {
+            if (!eliminated[i] && (best < 0 || degree[i] < degree[best]))
+                best = i;
+        }
+        net->perm[k] = best;
+        eliminated[best] = true;
+
+        // The neighbours of the eliminated unknown become a clique
+        uint64_t *row = &adjacency[(size_t) best * words];
+        for (int i = 0; i < n; i++) {
+            if (!(row[i / 64] >> (i % 64) & 1))
+                continue;
+            uint64_t *neighbour = &adjacency[(size_t) i * words];
+            for (int w = 0; w < words; w++) {
+                neighbour[w] |= row[w];
+            }
+            neighbour[i / 64] &= ~((uint64_t) 1 << (i % 64));
+            neighbour[best / 64] &= ~((uint64_t) 1 << (best % 64));
+            int count = 0;
+            for (int w = 0; w < words; w++) {
+                count += BitCount(neighbour[w]);
+            }
+            degree[i] = count;
+        }
+        for (int i = 0; i < n; i++) {
+            if (row[i / 64] >> (i % 64) & 1)
+                adjacency[(size_t) i * words + best / 64] &= ~((uint64_t) 1 << (best % 64));
+        }
+    }
+
+    for (int k = 0; k < n; k++) {
+        net->perm_inv[net->perm[k]] = k;
+    }
+    free(adjacency);
+    free(degree);
+    free(eliminated);
+    return true;
+}
+
+// Elimination tree and column counts of L for the permuted matrix (Davis, LDL)
+static void FactorSymbolic(NetworkSim *net) {
+    const int n = net->unknowns;
+    for (int k = 0; k < n; k++) {
+        net->parent[k] = -1;
+        net->flag[k] = k;
+        net->l_count[k] = 0;
+        int column = net->perm[k];
+        for (int p = net->col_start[column]; p < net->col_start[column + 1]; p++) {
+            int i = net->perm_inv[net->row_index[p]];
+            if (i >= k)
+                continue;
+            for (; net->flag[i] != k; i = net->parent[i]) {
+                if (net->parent[i] == -1)
+                    net->parent[i] = k;
+                net->l_count[i]++;
+                net->flag[i] = k;
+            }
+        }
+    }
+    net->l_start[0] = 0;
+    for (int k = 0; k < n; k++) {
+        net->l_start[k + 1] = net->l_start[k] + net->l_count[k];
+    }
+}
+
+bool NetworkSim_Build(NetworkSim *net, const NetworkSimCellModel *model) {
+    net->model = *model;
+    net->built = false;
+    if (net->node_count < 2 || net->cell_count == 0)
+        return false;
+
+    int junction = 0;
+    for (int e = 0; e < net->element_count; e++) {
+        if (net->elements[e].type == NETWORK_SIM_CELL)
+            net->elements[e].junction = junction++;
+    }
+    const int n = net->node_count - 1 + net->cell_count;
+    net->unknowns = n;
+
+    // Pattern: diagonal plus both off-diagonal entries of every branch
+    int *column_entries = (int *) calloc(n, sizeof(int));
+    int *fill = (int *) malloc(n * sizeof(int));
+    int branch_count = 0;
+    for (int e = 0; e < net->element_count; e++) {
+        int ends[2][2];
+        branch_count += ElementBranches(net, &net->elements[e], ends);
+    }
+    int capacity = n + 2 * branch_count;
+
+    free(net->col_start);
+    free(net->row_index);
+    net->col_start = (int *) malloc((n + 1) * sizeof(int));
+    net->row_index = (int *) malloc(capacity * sizeof(int));
+    if (!column_entries || !fill || !net->col_start || !net->row_index) {
+        free(column_entries);
+        free(fill);
+        return false;
+    }
+
+    for (int j = 0; j < n; j++) {
+        column_entries[j] = 1;
+    }
+    for (int e = 0; e < net->element_count; e++) {
+        int ends[2][2];
+        int branches = ElementBranches(net, &net->elements[e], ends);
+        for (int b = 0; b < branches; b++) {
+            if (ends[b][0] >= 0 && ends[b][1] >= 0) {
+                column_entries[ends[b][0]]++;
+                column_entries[ends[b][1]]++;
+            }
+        }
+    }
+    net->col_start[0] = 0;
+    for (int j = 0; j < n; j++) {
+        net->col_start[j + 1] = net->col_start[j] + column_entries[j];
+        fill[j] = net->col_start[j];
+        net->row_index[fill[j]++] = j;
+    }
+    for (int e = 0; e < net->element_count; e++) {
+        int ends[2][2];
+        int branches = ElementBranches(net, &net->elements[e], ends);
+        for (int b = 0; b < branches; b++) {
+            int u = ends[b][0], w = ends[b][1];
+            if (u < 0 || w < 0)
+                continue;
+            bool present = false;
+            for (int p = net->col_start[u]; p < fill[u]; p++) {
+                present = present || net->row_index[p] == w;
+            }
+            if (!present) {
+                net->row_index[fill[u]++] = w;
+                net->row_index[fill[w]++] = u;
+            }
+        }
+    }
+
+    // Compact out the slots left by parallel branches
+    int out = 0;
+    for (int j = 0; j < n; j++) {
+        int start = net->col_start[j];
+        net->col_start[j] = out;
+        for (int p = start; p < fill[j]; p++) {
+            net->row_index[out++] = net->row_index[p];
+        }
+    }
+    net->col_start[n] = out;
+    free(column_entries);
+    free(fill);
+
+    free(net->values);
+    free(net->diag_slot);
+    free(net->perm);
+    free(net->perm_inv);
+    free(net->parent);
+    free(net->l_start);
+    free(net->l_count);
+    free(net->diag);
+    free(net->v);
+    free(net->rhs);
+    free(net->work);
+    free(net->pattern);
+    free(net->flag);
+    net->values = (double *) malloc(out * sizeof(double));
+    net->diag_slot = (int *) malloc(n * sizeof(int));
+    net->perm = (int *) malloc(n * sizeof(int));
+    net->perm_inv = (int *) malloc(n * sizeof(int));
+    net->parent = (int *) malloc(n * sizeof(int));
+    net->l_start = (int *) malloc((n + 1) * sizeof(int));
+    net->l_count = (int *) malloc(n * sizeof(int));
+    net->diag = (double *) malloc(n * sizeof(double));
+    net->v = (double *) calloc(n, sizeof(double));
+    net->rhs = (double *) malloc(n * sizeof(double));
+    net->work = (double *) malloc(n * sizeof(double));
+    net->pattern = (int *) malloc(n * sizeof(int));
+    net->flag = (int *) malloc(n * sizeof(int));
+    if (!net->values || !net->diag_slot || !net->perm || !net->perm_inv || !net->parent || !net->l_start ||
+        !net->l_count || !net->diag || !net->v || !net->rhs || !net->work || !net->pattern || !net->flag)
+        return false;
+
+    for (int j = 0; j < n; j++) {
+        net->diag_slot[j] = FindSlot(net, j, j);
+    }
+    for (int e = 0; e < net->element_count; e++) {
+        NetworkSimElement *element = &net->elements[e];
+        int ends[2][2];
+        int branches = ElementBranches(net, element, ends);
+        for (int b = 0; b < 2; b++) {
+            int u = b < branches ? ends[b][0] : -1, w = b < branches ? ends[b][1] : -1;
+            element->slot[b][0] = u >= 0 ? net->diag_slot[u] : -1;
+            element->slot[b][1] = w >= 0 ? net->diag_slot[w] : -1;
+            element->slot[b][2] = FindSlot(net, u, w);
+            element->slot[b][3] = FindSlot(net, w, u);
+        }
+        element->vd = 0.0;
+    }
+
+    if (!OrderMinimumDegree(net))
+        return false;
+    FactorSymbolic(net);
+
+    free(net->l_row);
+    free(net->l_value);
+    int l_size = net->l_start[n] > 0 ? net->l_start[n] : 1;
+    net->l_row = (int *) malloc(l_size * sizeof(int));
+    net->l_value = (double *) malloc(l_size * sizeof(double));
+    if (!net->l_row || !net->l_value)
+        return false;
+
+    net->built = true;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Numeric solve
+//------------------------------------------------------------------------------
+
+// L D L' of the permuted matrix on the symbolic pattern (Davis, LDL); false if a pivot vanishes
+static bool FactorNumeric(NetworkSim *net) {
+    const int n = net->unknowns;
+    double *y = net->work;
+    for (int k = 0; k < n; k++) {
+        y[k] = 0.0;
+        int top = n;
+        net->flag[k] = k;
+        net->l_count[k] = 0;
+        int column = net->perm[k];
+        for (int p = net->col_start[column]; p < net->col_start[column + 1]; p++) {
+            int i = net->perm_inv[net->row_index[p]];
+            if (i > k)
+                continue;
+            y[i] += net->values[p];
+            int length = 0;
+            for (; net->flag[i] != k; i = net->parent[i]) {
+                net->pattern[length++] = i;
+                net->flag[i] = k;
+            }
+            while (length > 0) {
+                net->pattern[--top] = net->pattern[--length];
+            }
+        }
+
+        net->diag[k] = y[k];
+        y[k] = 0.0;
+        for (; top < n; top++) {
+            int i = net->pattern[top];
+            double yi = y[i];
+            y[i] = 0.0;
+            int end = net->l_start[i] + net->l_count[i];
+            for (int p = net->l_start[i]; p < end; p++) {
+                y[net->l_row[p]] -= net->l_value[p] * yi;
+            }
+            double l_ki = yi / net->diag[i];
+            net->diag[k] -= l_ki * yi;
+            net->l_row[end] = k;
+            net->l_value[end] = l_ki;
+            net->l_count[i]++;
+        }
+        if (net->diag[k] == 0.0)
+            return false;
+    }
+    return true;
+}
+
+// Solve with the current factor; rhs in unknown order, result to out
+static void SolveFactored(NetworkSim *net, double *out) {
+    const int n = net->unknowns;
+    double *x = net->work;
+    for (int k = 0; k < n; k++) {
+        x[k] = net->rhs[net->perm[k]];
+    }
+    for (int j = 0; j < n; j++) {
+        for (int p = net->l_start[j]; p < net->l_start[j + 1]; p++) {
+            x[net->l_row[p]] -= net->l_value[p] * x[j];
+        }
+    }
+    for (int j = 0; j < n; j++) {
+        x[j] /= net->diag[j];
+    }
+    for (int j = n - 1; j >= 0; j--) {
+        for (int p = net->l_start[j]; p < net->l_start[j + 1]; p++) {
+            x[j] -= net->l_value[p] * x[net->l_row[p]];
+        }
+    }
+    for (int k = 0; k < n; k++) {
+        out[net->perm[k]] = x[k];
+    }
+}
+
+static double BranchVoltage(const NetworkSim *net, int u, int w) {
+    return (u >= 0 ? net->v[u] : 0.0) - (w >= 0 ? net->v[w] : 0.0);
+}
+
+static void StampConductance(NetworkSim *net, const int *slot, double g) {
+    if (slot[0] >= 0)
+        net->values[slot[0]] += g;
+    if (slot[1] >= 0)
+        net->values[slot[1]] += g;
+    if (slot[2] >= 0) {
+        net->values[slot[2]] -= g;
+        net->values[slot[3]] -= g;
+    }
+}
+
+// Current source driving current from u to w through the element (out of u, into w)
+static void StampCurrent(NetworkSim *net, int u, int w, double current) {
+    if (u >= 0)
+        net->rhs[u] -= current;
+    if (w >= 0)
+        net->rhs[w] += current;
+}
+
+// Junction companion model: conductance plus the current source that makes it tangent at vd
+static void StampJunction(NetworkSim *net, const int *slot, int u, int w, double saturation, double vt, double vd) {
+    double e = LimitedExp(vd / vt);
+    double current = saturation * (e - 1.0);
+    double g = saturation * (vd / vt > EXP_LIMIT ? exp(EXP_LIMIT) : e) / vt;
+    StampConductance(net, slot, g);
+    StampCurrent(net, u, w, current - g * vd);
+}
+
+// Newton iteration for the port conductance g_port driving the tracker voltage; warm starts from net->v
+static bool SolveOperatingPoint(NetworkSim *net, double g_port, double port_voltage, double tolerance, int *steps) {
+    const int n = net->unknowns;
+    const double cell_vt = net->model.n_ideal * NETWORK_SIM_THERMAL_V;
+    const double diode_vt = NETWORK_SIM_DIODE_N * NETWORK_SIM_THERMAL_V;
+    const double cell_is = CellSaturation(&net->model, cell_vt);
+    const double cell_g = 1.0 / CellSeriesR(&net->model);
+    const double cell_crit = cell_vt * log(cell_vt / (sqrt(2.0) * cell_is));
+
+    for (int iteration = 0; iteration < NETWORK_SIM_MAX_NEWTON; iteration++) {
+        memset(net->values, 0, net->col_start[n] * sizeof(double));
+        memset(net->rhs, 0, n * sizeof(double));
+        for (int j = 0; j < n; j++) {
+            net->values[net->diag_slot[j]] = NETWORK_SIM_GMIN;
+        }
+        net->values[net->diag_slot[0]] += g_port;
+        net->rhs[0] += g_port * port_voltage;
+
+        bool limited = false;
+        for (int e = 0; e < net->element_count; e++) {
+            NetworkSimElement *element = &net->elements[e];
+            int ends[2][2];
+            ElementBranches(net, element, ends);
+            if (element->type == NETWORK_SIM_WIRE) {
+                StampConductance(net, element->slot[0], 1.0 / WireR(element));
+            } else if (element->type == NETWORK_SIM_DIODE) {
+                double saturation = DiodeSaturation(element->value, diode_vt);
+                double crit = diode_vt * log(diode_vt / (sqrt(2.0) * saturation));
+                double vd = BranchVoltage(net, ends[0][0], ends[0][1]);
+                element->vd = LimitJunction(vd, element->vd, diode_vt, crit, &limited);
+                StampJunction(net, element->slot[0], ends[0][0], ends[0][1], saturation, diode_vt, element->vd);
+            } else {
+                int u = ends[1][0], w = ends[1][1];
+                double vd = BranchVoltage(net, u, w);
+                element->vd = LimitJunction(vd, element->vd, cell_vt, cell_crit, &limited);
+                StampConductance(net, element->slot[0], cell_g);
+                StampConductance(net, element->slot[1], 1.0 / NETWORK_SIM_CELL_SHUNT_R);
+                StampJunction(net, element->slot[1], u, w, cell_is, cell_vt, element->vd);
+                StampCurrent(net, w, u, net->model.isc * element->ratio);
+            }
+        }
+
+        (*steps)++;
+        if (!FactorNumeric(net))
+            return false;
+        SolveFactored(net, net->rhs);
+
+        double change = 0.0;
+        for (int j = 0; j < n; j++) {
+            change = fmax(change, fabs(net->rhs[j] - net->v[j]));
+            net->v[j] = net->rhs[j];
+        }
+        if (!limited && change < tolerance)
+            return true;
+    }
+    return false;
+}
+
+// Port power at a tracker voltage; fills the port voltage and current
+static double PortPower(NetworkSim *net, double port_voltage, double tolerance, double *voltage, double *current,
+                        int *steps, bool *converged) {
+    if (!SolveOperatingPoint(net, NETWORK_SIM_PORT_G, port_voltage, tolerance, steps))
+        *converged = false;
+    *voltage = net->v[0];
+    *current = NETWORK_SIM_PORT_G * (net->v[0] - port_voltage);
+    return *voltage * *current;
+}
+
+void NetworkSim_SetCellIrradiance(NetworkSim *net, int element, float ratio) {
+    net->elements[element].ratio = ratio > 0.0f ? ratio : 0.0f;
+}
+
+bool NetworkSim_SolveMpp(NetworkSim *net, NetworkSimResult *result) {
+    memset(result, 0, sizeof(*result));
+    if (!net->built)
+        return false;
+    result->converged = true;
+
+    bool lit = false;
+    for (int e = 0; e < net->element_count; e++) {
+        lit = lit || (net->elements[e].type == NETWORK_SIM_CELL && net->elements[e].ratio > 0.0);
+    }
+    if (!lit) {
+        memset(net->v, 0, net->unknowns * sizeof(double));
+        for (int e = 0; e < net->element_count; e++) {
+            net->elements[e].vd = 0.0;
+        }
+        return true;
+    }
+
+    if (!SolveOperatingPoint(net, 0.0, 0.0, NETWORK_SIM_SWEEP_V_TOL, &result->newton_steps))
+        result->converged = false;
+    double voc = net->v[0];
+    result->voc = (float) voc;
+    if (voc <= 0.0)
+        return result->converged;
+
+    // Coarse sweep down from open circuit; the ends carry no power
+    double voltage, current;
+    double sweep[NETWORK_SIM_SWEEP_STEPS + 1] = {0};
+    int best = 0;
+    for (int k = NETWORK_SIM_SWEEP_STEPS - 1; k >= 1; k--) {
+        sweep[k] = PortPower(net, voc * k / NETWORK_SIM_SWEEP_STEPS, NETWORK_SIM_SWEEP_V_TOL, &voltage, &current,
+                             &result->newton_steps, &result->converged);
+        if (best == 0 || sweep[k] > sweep[best])
+            best = k;
+    }
+
+    // Parabolic interpolation on the bracket around the best point, as in Brent's method: a vertex is only taken
+    // inside the bracket and while the steps keep halving, else a golden step goes into the wider side. Bypass
+    // diodes put kinks in the curve, which the golden steps get past.
+    double x[3] = {voc * (best - 1) / NETWORK_SIM_SWEEP_STEPS, voc * best / NETWORK_SIM_SWEEP_STEPS,
+                   voc * (best + 1) / NETWORK_SIM_SWEEP_STEPS};
+    double p[3] = {sweep[best - 1], sweep[best], sweep[best + 1]};
+    const double tolerance = NETWORK_SIM_MPP_TOL * voc;
+    double last_step = x[2] - x[0], step_before = last_step;
+    for (int iteration = 0; iteration < NETWORK_SIM_MAX_REFINE && x[2] - x[0] > tolerance; iteration++) {
+        double left = (x[1] - x[0]) * (p[1] - p[2]), right = (x[1] - x[2]) * (p[1] - p[0]);
+        double denominator = left - right;
+        double next = denominator != 0.0
+                              ? x[1] - 0.5 * ((x[1] - x[0]) * left - (x[1] - x[2]) * right) / denominator
+                              : x[0];
+        double step = fabs(next - x[1]);
+        if (!(next > x[0] && next < x[2]) || step > 0.5 * step_before || step < 0.5 * tolerance) {
+            next = x[1] - x[0] > x[2] - x[1] ? x[1] - (1.0 - GOLDEN) * (x[1] - x[0])
+                                              : x[1] + (1.0 - GOLDEN) * (x[2] - x[1]);
+            step = fabs(next - x[1]);
+        }
+        step_before = last_step;
+        last_step = step;
+
+        double power = PortPower(net, next, NETWORK_SIM_V_TOL, &voltage, &current, &result->newton_steps,
+                                 &result->converged);
+        if (power > p[1]) {
+            int side = next < x[1] ? 2 : 0;
+            x[side] = x[1];
+            p[side] = p[1];
+            x[1] = next;
+            p[1] = power;
+        } else {
+            int side = next < x[1] ? 0 : 2;
+            x[side] = next;
+            p[side] = power;
+        }
+    }
+
+    double power = PortPower(net, x[1], NETWORK_SIM_V_TOL, &voltage, &current, &result->newton_steps,
+                             &result->converged);
+    result->power = (float) fmax(power, 0.0);
+    result->voltage = (float) voltage;
+    result->current = (float) current;
+    return result->converged;
+}
+
+void NetworkSim_CellOperatingPoint(const NetworkSim *net, int element, float *voltage, float *current) {
+    const NetworkSimElement *cell = &net->elements[element];
+    int ends[2][2];
+    ElementBranches(net, cell, ends);
+    *voltage = (float) BranchVoltage(net, ends[0][0], ends[1][1]);
+    *current = (float) (BranchVoltage(net, ends[0][1], ends[0][0]) / CellSeriesR(&net->model));
+}
+
+void NetworkSim_Free(NetworkSim *net) {
+    free(net->elements);
+    free(net->col_start);
+    free(net->row_index);
+    free(net->values);
+    free(net->diag_slot);
+    free(net->perm);
+    free(net->perm_inv);
+    free(net->parent);
+    free(net->l_start);
+    free(net->l_count);
+    free(net->l_row);
+    free(net->l_value);
+    free(net->diag);
+    free(net->v);
+    free(net->rhs);
+    free(net->work);
+    free(net->pattern);
+    free(net->flag);
+    memset(net, 0, sizeof(*net));
+}
@@ -0,0 +1,152 @@
+#ifndef NETWORK_SIM_H
+#define NETWORK_SIM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+//------------------------------------------------------------------------------
+// Constants
+//------------------------------------------------------------------------------
+#define NETWORK_SIM_THERMAL_V 0.026      // Thermal voltage at 25C, as the IV traces use (V)
+#define NETWORK_SIM_GMIN 1e-9            // Conductance from every node to the port's negative terminal (S)
+#define NETWORK_SIM_WIRE_R 0.001         // Default wire resistance (ohm)
+#define NETWORK_SIM_MIN_SERIES_R 1e-4    // Cells with no series resistance get this (ohm)
+#define NETWORK_SIM_CELL_SHUNT_R 1000.0  // Cell shunt resistance (ohm)
+#define NETWORK_SIM_DIODE_REF_I 1.0      // Current at which a diode's forward drop is given (A)
+#define NETWORK_SIM_DIODE_N 1.0          // Diode ideality factor
+#define NETWORK_SIM_PORT_G 1e3           // Conductance holding the port near the tracker voltage (S)
+#define NETWORK_SIM_MAX_NEWTON 80        // Newton iterations per operating point
+#define NETWORK_SIM_V_TOL 1e-7           // Newton converges when no node moves more than this (V)
+#define NETWORK_SIM_SWEEP_V_TOL 1e-4     // Looser, for the open-circuit and coarse sweep points that only rank
+#define NETWORK_SIM_SWEEP_STEPS 16       // Coarse port voltages tried before the MPP is refined
+#define NETWORK_SIM_MAX_REFINE 20        // Refinement solves after the coarse sweep
+#define NETWORK_SIM_MPP_TOL 1e-3         // MPP voltage bracket, as a fraction of the open-circuit voltage
+#define NETWORK_SIM_NAME_LENGTH 32       // Longest node name in a netlist
+
+//------------------------------------------------------------------------------
+// Series-parallel array network
+//------------------------------------------------------------------------------
+// An array wired as an arbitrary network of cells, diodes and wires feeding
+// one tracker port, for layouts a single series chain cannot describe:
+// shingled sub-strings, parallel cell groups, cross-ties, blocking diodes.
+//
+// Each cell is a single-diode model: photocurrent and junction (with the
+// saturation current that reproduces the IV traces' Voc) in parallel with a
+// shunt, behind its series resistance, so every cell adds one internal
+// junction node. The port's negative terminal is the reference node; its
+// positive terminal is tied to the tracker voltage through a stiff Norton
+// source, and the port current is what flows into it.
+//
+// Operating points come from Newton iteration on the nodal equations with
+// junction voltage limiting. The nodal matrix is symmetric positive definite
+// and its sparsity depends only on the topology, so NetworkSim_Build orders it
+// (minimum degree) and computes the elimination tree and the pattern of the
+// LDL' factor once; each Newton step only refills the values and runs the
+// numeric factorisation. The MPP is found by a coarse port voltage sweep, which
+// picks the global peak when bypass diodes make several, then parabolic
+// refinement around it. Each point is warm-started from the last, and the
+// solution carries over to the next call as the next sweep sample's start.
+//
+// Netlist text, one element per line ('#' starts a comment):
+//   port  <positive> <negative>        tracker input (exactly one)
+//   cell  <cell id> <+ node> <- node>  a layout cell
+//   diode <anode> <cathode> [drop V]   bypass or blocking diode
+//   wire  <node> <node> [ohm]          interconnect, cross-tie
+// Node names are any tokens.
+
+typedef enum {
+    NETWORK_SIM_CELL,
+    NETWORK_SIM_DIODE,
+    NETWORK_SIM_WIRE
+} NetworkSimElementType;
+
+typedef struct {
+    NetworkSimElementType type;
+    int a, b;               // Nodes: cell + / -, diode anode / cathode, wire ends (0 = port negative)
+    int cell_id;            // Cells: layout cell id
+    double value;           // Diode forward drop at NETWORK_SIM_DIODE_REF_I (V), wire resistance (ohm)
+
+    // Filled by NetworkSim_Build and the solver
+    int junction;           // Cells: internal node behind the series resistance
+    int slot[2][4];         // Matrix positions of the branch stamps (uu, ww, uw, wu), -1 at the reference
+    double ratio;           // Cells: irradiance ratio
+    double vd;              // Last junction voltage, for Newton limiting
+} NetworkSimElement;
+
+// Cell parameters at full sun
+typedef struct {
+    float voc;
+    float isc;
+    float n_ideal;
+    float series_r;
+} NetworkSimCellModel;
+
+typedef struct {
+    float power;            // At the MPP (W)
+    float voltage;          // Port voltage (V)
+    float current;          // Port current (A)
+    float voc;              // Port open-circuit voltage (V)
+    int newton_steps;       // Factorisations used
+    bool converged;         // Every operating point converged
+} NetworkSimResult;
+
+typedef struct {
+    NetworkSimElement *elements;
+    int element_count;
+    int element_capacity;
+    int node_count;         // Named nodes; 0 = port negative, 1 = port positive
+    int cell_count;         // Cell elements
+    NetworkSimCellModel model;
+
+    // Built once per topology
+    int unknowns;           // Nodes 1.. then cell junctions
+    int *col_start;         // Full symmetric nodal matrix, compressed columns
+    int *row_index;
+    double *values;
+    int *diag_slot;         // Position of each unknown's diagonal in values
+    int *perm;              // Elimination order (perm[k] = unknown eliminated k-th)
+    int *perm_inv;
+    int *parent;            // Elimination tree
+    int *l_start;           // Factor L, compressed columns, unit diagonal not stored
+    int *l_count;
+    int *l_row;
+    double *l_value;
+    double *diag;           // D of L D L'
+
+    // Solver state
+    double *v;              // Node voltages (unknown order), kept between solves
+    double *rhs;
+    double *work;
+    int *pattern;
+    int *flag;
+    bool built;
+} NetworkSim;
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+
+// Append an element; returns its index or -1 if out of memory
+int NetworkSim_AddElement(NetworkSim *net, NetworkSimElementType type, int a, int b, int cell_id, double value);
+
+// Read a netlist (see above); diodes without a drop get default_diode_drop. On failure the network is left empty
+// and error (optional) gets the reason with its line number.
+bool NetworkSim_LoadNetlist(NetworkSim *net, const char *path, double default_diode_drop, char *error,
+                            size_t error_size);
+
+// Order the nodal matrix and compute its symbolic factorisation; call once after the last element is added
+bool NetworkSim_Build(NetworkSim *net, const NetworkSimCellModel *model);
+
+// Irradiance ratio (0-1) of a cell element
+void NetworkSim_SetCellIrradiance(NetworkSim *net, int element, float ratio);
+
+// Find the port MPP for the current irradiance; the node voltages are left at it
+bool NetworkSim_SolveMpp(NetworkSim *net, NetworkSimResult *result);
+
+// Voltage across a cell element (+ minus -, negative when driven in reverse) and the current out of its + node
+void NetworkSim_CellOperatingPoint(const NetworkSim *net, int element, float *voltage, float *current);
+
+// Release everything (safe on an empty network)
+void NetworkSim_Free(NetworkSim *net);
+
+#endif // NETWORK_SIM_H
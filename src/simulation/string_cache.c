@@ -0,0 +1,121 @@
+#include "string_cache.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Stop inserting once the table is this full (keeps probe chains short)
+#define STRING_CACHE_MAX_LOAD 0.7f
+
+bool StringSimCache_Init(StringSimCache *cache, int capacity, float quant_step) {
+    memset(cache, 0, sizeof(StringSimCache));
+
+    int cap = 16;
+    while (cap < capacity) cap <<= 1;
+
+    cache->entries = (StringSimCacheEntry *)calloc(cap, sizeof(StringSimCacheEntry));
+    if (!cache->entries) return false;
+
+    cache->capacity = cap;
+    cache->quant_step = fmaxf(quant_step, STRING_CACHE_MIN_STEP);
+    return true;
+}
+
+void StringSimCache_Free(StringSimCache *cache) {
+    free(cache->entries);
+    cache->entries = NULL;
+    cache->capacity = 0;
+    cache->count = 0;
+}
+
+void StringSimCache_Clear(StringSimCache *cache) {
+    if (!cache->entries) return;
+    for (int i = 0; i < cache->capacity; i++) {
+        cache->entries[i].used = false;
+    }
+    cache->count = 0;
+}
+
+uint32_t StringSimCache_Quantise(const StringSimCache *cache, const float *ratios, int n_cells,
+                                 uint16_t *codes, float *quantised) {
+    // FNV-1a over the codes
+    uint32_t hash = 2166136261u;
+    float step = cache->quant_step;
+
+    for (int i = 0; i < n_cells; i++) {
+        float q = ratios[i] > 0 ? ratios[i] / step + 0.5f : 0.0f;
+        if (q > 65535.0f) q = 65535.0f;
+        uint16_t code = (uint16_t)q;
+
+        codes[i] = code;
+        if (quantised) quantised[i] = code * step;
+
+        hash ^= code & 0xFF;
+        hash *= 16777619u;
+        hash ^= code >> 8;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static bool KeyMatches(const StringSimCacheEntry *e, int slot, const uint16_t *codes, int n_cells, uint32_t hash) {
+    return e->hash == hash && e->slot == slot && e->n_cells == n_cells &&
+           memcmp(e->codes, codes, n_cells * sizeof(uint16_t)) == 0;
+}
+
+const StringSimCacheEntry *StringSimCache_Find(StringSimCache *cache, int slot, const uint16_t *codes,
+                                               int n_cells, uint32_t hash) {
+    if (!cache->entries || n_cells > STRING_SIM_MAX_CELLS) {
+        cache->misses++;
+        return NULL;
+    }
+
+    uint32_t mask = (uint32_t)cache->capacity - 1;
+    uint32_t idx = (hash ^ (uint32_t)slot * 2654435761u) & mask;
+
+    // Linear probe until an empty slot
+    for (int probe = 0; probe < cache->capacity; probe++) {
+        const StringSimCacheEntry *e = &cache->entries[idx];
+        if (!e->used) break;
+        if (KeyMatches(e, slot, codes, n_cells, hash)) {
+            cache->hits++;
+            return e;
+        }
+        idx = (idx + 1) & mask;
+    }
+
+    cache->misses++;
+    return NULL;
+}
+
+StringSimCacheEntry *StringSimCache_Insert(StringSimCache *cache, int slot, const uint16_t *codes,
+                                           int n_cells, uint32_t hash) {
+    if (!cache->entries || n_cells > STRING_SIM_MAX_CELLS) return NULL;
+
+    if (cache->count + 1 > (int)(cache->capacity * STRING_CACHE_MAX_LOAD)) {
+        StringSimCache_Clear(cache);
+    }
+
+    uint32_t mask = (uint32_t)cache->capacity - 1;
+    uint32_t idx = (hash ^ (uint32_t)slot * 2654435761u) & mask;
+
+    while (cache->entries[idx].used) {
+        if (KeyMatches(&cache->entries[idx], slot, codes, n_cells, hash)) {
+            return &cache->entries[idx];
+        }
+        idx = (idx + 1) & mask;
+    }
+
+    StringSimCacheEntry *e = &cache->entries[idx];
+    e->used = true;
+    e->slot = slot;
+    e->n_cells = n_cells;
+    e->hash = hash;
+    memcpy(e->codes, codes, n_cells * sizeof(uint16_t));
+    cache->count++;
+    return e;
+}
+
+float StringSimCache_HitRate(const StringSimCache *cache) {
+    int total = cache->hits + cache->misses;
+    return (total > 0) ? (float)cache->hits / total : 0.0f;
+}
@@ -0,0 +1,75 @@
+#ifndef STRING_CACHE_H
+#define STRING_CACHE_H
+
+#include "string_sim.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+//------------------------------------------------------------------------------
+// Constants
+//------------------------------------------------------------------------------
+#define STRING_CACHE_DEFAULT_CAPACITY 1024
+#define STRING_CACHE_DEFAULT_STEP 0.005f // Irradiance ratio quantisation step
+#define STRING_CACHE_MIN_STEP 0.0001f    // Keeps quantised codes within 16 bits
+
+//------------------------------------------------------------------------------
+// String result memoisation
+//------------------------------------------------------------------------------
+// Many (time, heading) samples produce the same shading pattern for a string.
+// Entries are keyed by the string slot and the quantised per-cell irradiance
+// ratios, so a repeated pattern reuses the prior StringSimResult instead of
+// re-running the full IV sweep.
+
+typedef struct {
+    bool used;
+    int slot;                                   // Caller-defined string slot
+    int n_cells;
+    uint32_t hash;
+    uint16_t codes[STRING_SIM_MAX_CELLS];       // Quantised irradiance ratios
+    StringSimResult result;                     // String result at MPP
+    float cell_voltage[STRING_SIM_MAX_CELLS];   // Cell voltage at MPP current (negative when bypassed)
+} StringSimCacheEntry;
+
+typedef struct {
+    StringSimCacheEntry *entries;
+    int capacity;      // Power of two
+    int count;
+    float quant_step;  // Irradiance ratio step (accuracy control)
+    int hits;
+    int misses;
+} StringSimCache;
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+
+// Allocate a cache with room for at least `capacity` entries
+// quant_step: irradiance ratio quantisation step (clamped to STRING_CACHE_MIN_STEP)
+// Returns false if allocation failed
+bool StringSimCache_Init(StringSimCache *cache, int capacity, float quant_step);
+
+// Release cache memory
+void StringSimCache_Free(StringSimCache *cache);
+
+// Drop all entries (statistics are kept)
+void StringSimCache_Clear(StringSimCache *cache);
+
+// Quantise irradiance ratios into codes and return the key hash
+// quantised: optional output of the bucket ratio for each cell (can alias ratios)
+uint32_t StringSimCache_Quantise(const StringSimCache *cache, const float *ratios, int n_cells,
+                                 uint16_t *codes, float *quantised);
+
+// Look up a previously stored result; counts a hit or a miss
+// Returns NULL on a miss
+const StringSimCacheEntry *StringSimCache_Find(StringSimCache *cache, int slot, const uint16_t *codes,
+                                               int n_cells, uint32_t hash);
+
+// Reserve an entry for a key (the caller fills result and cell_voltage)
+// The table is cleared when it reaches its load limit
+StringSimCacheEntry *StringSimCache_Insert(StringSimCache *cache, int slot, const uint16_t *codes,
+                                           int n_cells, uint32_t hash);
+
+// Fraction of lookups that were hits (0-1)
+float StringSimCache_HitRate(const StringSimCache *cache);
+
+#endif // STRING_CACHE_H
@@ -0,0 +1,294 @@
+#include "timeseries.h"
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//------------------------------------------------------------------------------
+// Half precision
+//------------------------------------------------------------------------------
+uint16_t TimeSeries_FloatToHalf(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+    int32_t exponent = (int32_t)((bits >> 23) & 0xFF) - 127 + 15;
+    uint32_t mantissa = bits & 0x7FFFFF;
+
+    if (((bits >> 23) & 0xFF) == 0xFF) {
+        return sign | 0x7C00 | (mantissa ? 0x200 : 0);  // Inf / NaN
+    }
+    if (exponent >= 31) return sign | 0x7C00;           // Overflow to Inf
+    if (exponent <= 0) {
+        if (exponent < -10) return sign;                // Underflow to zero
+        mantissa |= 0x800000;
+        uint32_t shift = (uint32_t)(14 - exponent);
+        uint16_t half = (uint16_t)(mantissa >> shift);
+        if ((mantissa >> (shift - 1)) & 1) half++;      // Round to nearest
+        return sign | half;
+    }
+
+    uint16_t half = sign | (uint16_t)(exponent << 10) | (uint16_t)(mantissa >> 13);
+    if (mantissa & 0x1000) half++;                      // Round to nearest (carries into exponent)
+    return half;
+}
+
+float TimeSeries_HalfToFloat(uint16_t half) {
+    uint32_t sign = (uint32_t)(half & 0x8000) << 16;
+    uint32_t exponent = (half >> 10) & 0x1F;
+    uint32_t mantissa = half & 0x3FF;
+    uint32_t bits;
+
+    if (exponent == 0) {
+        if (mantissa == 0) {
+            bits = sign;
+        } else {
+            // Subnormal: normalise
+            exponent = 127 - 15 + 1;
+            while (!(mantissa & 0x400)) {
+                mantissa <<= 1;
+                exponent--;
+            }
+            bits = sign | (exponent << 23) | ((mantissa & 0x3FF) << 13);
+        }
+    } else if (exponent == 31) {
+        bits = sign | 0x7F800000 | (mantissa << 13);
+    } else {
+        bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+    }
+
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+//------------------------------------------------------------------------------
+// Writer
+//------------------------------------------------------------------------------
+size_t TimeSeries_BlockSize(int cell_count, int string_count) {
+    size_t size = sizeof(TimeSeriesSampleHeader) + (size_t)cell_count * (sizeof(int16_t) + sizeof(uint8_t)) +
+                  (size_t)string_count * sizeof(uint16_t);
+    return (size + 3) & ~(size_t)3;
+}
+
+bool TimeSeries_Open(TimeSeriesWriter *writer, const char *path, int cell_count, int string_count,
+                     int time_samples, int heading_samples, float start_hour, float dt_hours,
+                     float heading_step, float cell_power_scale) {
+    memset(writer, 0, sizeof(TimeSeriesWriter));
+
+    writer->block_size = TimeSeries_BlockSize(cell_count, string_count);
+    writer->block = (uint8_t *)calloc(1, writer->block_size);
+    if (!writer->block) return false;
+
+    writer->file = fopen(path, "wb");
+    if (!writer->file) {
+        free(writer->block);
+        writer->block = NULL;
+        return false;
+    }
+
+    TimeSeriesHeader *h = &writer->header;
+    memcpy(h->magic, TIMESERIES_MAGIC, 4);
+    h->version = TIMESERIES_VERSION;
+    h->cell_count = (uint32_t)cell_count;
+    h->string_count = (uint32_t)string_count;
+    h->time_samples = (uint32_t)time_samples;
+    h->heading_samples = (uint32_t)heading_samples;
+    h->sample_count = 0;
+    h->start_hour = start_hour;
+    h->dt_hours = dt_hours;
+    h->heading_step = heading_step;
+    h->cell_power_scale = (cell_power_scale > 0) ? cell_power_scale : 1.0f;
+
+    return fwrite(h, sizeof(TimeSeriesHeader), 1, writer->file) == 1;
+}
+
+bool TimeSeries_WriteSample(TimeSeriesWriter *writer, const TimeSeriesSampleHeader *sample,
+                            const float *cell_power, const uint8_t *cell_flags, const float *string_power) {
+    if (!writer->file) return false;
+
+    int n_cells = (int)writer->header.cell_count;
+    int n_strings = (int)writer->header.string_count;
+    uint8_t *p = writer->block;
+
+    memcpy(p, sample, sizeof(TimeSeriesSampleHeader));
+    p += sizeof(TimeSeriesSampleHeader);
+
+    float inv_scale = 1.0f / writer->header.cell_power_scale;
+    for (int i = 0; i < n_cells; i++) {
+        float q = cell_power ? cell_power[i] * inv_scale : 0.0f;
+        q = fminf(fmaxf(q, -32767.0f), 32767.0f);
+        int16_t code = (int16_t)lrintf(q);
+        memcpy(p, &code, sizeof(code));
+        p += sizeof(code);
+    }
+
+    if (cell_flags) {
+        memcpy(p, cell_flags, (size_t)n_cells);
+    } else {
+        memset(p, 0, (size_t)n_cells);
+    }
+    p += n_cells;
+
+    for (int s = 0; s < n_strings; s++) {
+        uint16_t half = TimeSeries_FloatToHalf(string_power ? string_power[s] : 0.0f);
+        memcpy(p, &half, sizeof(half));
+        p += sizeof(half);
+    }
+
+    if (fwrite(writer->block, writer->block_size, 1, writer->file) != 1) return false;
+    writer->header.sample_count++;
+    return true;
+}
+
+bool TimeSeries_Close(TimeSeriesWriter *writer) {
+    bool ok = false;
+    if (writer->file) {
+        // Patch the sample count now that the run is complete
+        ok = fseek(writer->file, 0, SEEK_SET) == 0 &&
+             fwrite(&writer->header, sizeof(TimeSeriesHeader), 1, writer->file) == 1;
+        ok = (fclose(writer->file) == 0) && ok;
+        writer->file = NULL;
+    }
+    free(writer->block);
+    writer->block = NULL;
+    return ok;
+}
+
+//------------------------------------------------------------------------------
+// Reader
+//------------------------------------------------------------------------------
+static bool ValidateMapping(TimeSeriesReader *reader) {
+    if (reader->size < sizeof(TimeSeriesHeader)) return false;
+
+    const TimeSeriesHeader *h = (const TimeSeriesHeader *)reader->data;
+    if (memcmp(h->magic, TIMESERIES_MAGIC, 4) != 0 || h->version != TIMESERIES_VERSION) return false;
+
+    // The counts come from the file: each cell takes 3 bytes and each string 2 in every block, so neither can
+    // exceed the payload, which also keeps the block size from overflowing
+    size_t payload = reader->size - sizeof(TimeSeriesHeader);
+    if (h->cell_count > payload / 3 || h->string_count > payload / 2) return false;
+    if (h->cell_count > INT_MAX || h->string_count > INT_MAX) return false;
+    if ((uint64_t)h->sample_count > (uint64_t)h->time_samples * h->heading_samples) return false;
+
+    reader->header = h;
+    reader->block_size = TimeSeries_BlockSize((int)h->cell_count, (int)h->string_count);
+    return reader->block_size > 0 && h->sample_count <= payload / reader->block_size;
+}
+
+bool TimeSeries_Map(TimeSeriesReader *reader, const char *path) {
+    memset(reader, 0, sizeof(TimeSeriesReader));
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!mapping) {
+        CloseHandle(file);
+        return false;
+    }
+
+    const void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    reader->file_handle = file;
+    reader->mapping_handle = mapping;
+    reader->data = (const uint8_t *)view;
+    reader->size = (size_t)size.QuadPart;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return false;
+    }
+
+    void *view = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (view == MAP_FAILED) {
+        close(fd);
+        return false;
+    }
+
+    reader->fd = fd;
+    reader->data = (const uint8_t *)view;
+    reader->size = (size_t)st.st_size;
+#endif
+
+    if (!ValidateMapping(reader)) {
+        TimeSeries_Unmap(reader);
+        return false;
+    }
+    return true;
+}
+
+void TimeSeries_Unmap(TimeSeriesReader *reader) {
+    if (!reader->data) return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(reader->data);
+    CloseHandle((HANDLE)reader->mapping_handle);
+    CloseHandle((HANDLE)reader->file_handle);
+#else
+    munmap((void *)reader->data, reader->size);
+    close(reader->fd);
+#endif
+
+    memset(reader, 0, sizeof(TimeSeriesReader));
+}
+
+bool TimeSeries_ReadSample(const TimeSeriesReader *reader, int index, TimeSeriesSampleHeader *sample,
+                           float *cell_power, uint8_t *cell_flags, float *string_power) {
+    if (!reader->data || index < 0 || index >= (int)reader->header->sample_count) return false;
+
+    int n_cells = (int)reader->header->cell_count;
+    int n_strings = (int)reader->header->string_count;
+    const uint8_t *p = reader->data + sizeof(TimeSeriesHeader) + (size_t)index * reader->block_size;
+
+    if (sample) memcpy(sample, p, sizeof(TimeSeriesSampleHeader));
+    p += sizeof(TimeSeriesSampleHeader);
+
+    if (cell_power) {
+        float scale = reader->header->cell_power_scale;
+        for (int i = 0; i < n_cells; i++) {
+            int16_t code;
+            memcpy(&code, p + i * sizeof(int16_t), sizeof(code));
+            cell_power[i] = code * scale;
+        }
+    }
+    p += n_cells * sizeof(int16_t);
+
+    if (cell_flags) memcpy(cell_flags, p, (size_t)n_cells);
+    p += n_cells;
+
+    if (string_power) {
+        for (int s = 0; s < n_strings; s++) {
+            uint16_t half;
+            memcpy(&half, p + s * sizeof(uint16_t), sizeof(half));
+            string_power[s] = TimeSeries_HalfToFloat(half);
+        }
+    }
+    return true;
+}
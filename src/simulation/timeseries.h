@@ -0,0 +1,114 @@
+#ifndef TIMESERIES_H
+#define TIMESERIES_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+//------------------------------------------------------------------------------
+// Constants
+//------------------------------------------------------------------------------
+#define TIMESERIES_MAGIC "SPTS"
+#define TIMESERIES_VERSION 1
+
+// Cell flags
+#define TIMESERIES_CELL_SHADED 0x01
+#define TIMESERIES_CELL_BYPASSED 0x02
+
+// Sample flags
+#define TIMESERIES_SAMPLE_NIGHT 0x01
+
+//------------------------------------------------------------------------------
+// Time-series results store
+//------------------------------------------------------------------------------
+// One fixed-size block per (time, heading) sample, in sweep order
+// (time major). Each block is columnar:
+//   TimeSeriesSampleHeader
+//   int16  cell_power[cell_count]    (units of cell_power_scale W)
+//   uint8  cell_flags[cell_count]
+//   uint16 string_power[string_count] (IEEE half float, W)
+//   padding to 4 bytes
+// Fixed block size lets a mapped file be indexed directly by sample number.
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t cell_count;
+    uint32_t string_count;
+    uint32_t time_samples;
+    uint32_t heading_samples;
+    uint32_t sample_count;   // Blocks written (patched on close)
+    float start_hour;
+    float dt_hours;
+    float heading_step;      // Degrees between heading samples
+    float cell_power_scale;  // Watts per cell power unit
+    uint32_t reserved;
+} TimeSeriesHeader;
+
+typedef struct {
+    float hour;
+    float heading_deg;
+    float sun_dir[3];        // Sun direction in the vehicle frame
+    float sun_altitude;
+    float sun_azimuth;
+    float total_power;       // Array power for this sample (W)
+    uint32_t flags;
+    uint32_t reserved;
+} TimeSeriesSampleHeader;
+
+typedef struct {
+    FILE *file;
+    TimeSeriesHeader header;
+    size_t block_size;
+    uint8_t *block;          // Staging buffer for one sample
+} TimeSeriesWriter;
+
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    const TimeSeriesHeader *header;
+    size_t block_size;
+#ifdef _WIN32
+    void *file_handle;
+    void *mapping_handle;
+#else
+    int fd;
+#endif
+} TimeSeriesReader;
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+
+// Size in bytes of one sample block
+size_t TimeSeries_BlockSize(int cell_count, int string_count);
+
+// Create a recording and write its header
+bool TimeSeries_Open(TimeSeriesWriter *writer, const char *path, int cell_count, int string_count,
+                     int time_samples, int heading_samples, float start_hour, float dt_hours,
+                     float heading_step, float cell_power_scale);
+
+// Append one sample block
+// cell_flags, string_power: may be NULL (written as zero)
+bool TimeSeries_WriteSample(TimeSeriesWriter *writer, const TimeSeriesSampleHeader *sample,
+                            const float *cell_power, const uint8_t *cell_flags, const float *string_power);
+
+// Patch the sample count and close the file
+bool TimeSeries_Close(TimeSeriesWriter *writer);
+
+// Memory-map a recording for random access
+bool TimeSeries_Map(TimeSeriesReader *reader, const char *path);
+
+// Release a mapping (safe on an unmapped reader)
+void TimeSeries_Unmap(TimeSeriesReader *reader);
+
+// Decode one sample; any output pointer may be NULL
+bool TimeSeries_ReadSample(const TimeSeriesReader *reader, int index, TimeSeriesSampleHeader *sample,
+                           float *cell_power, uint8_t *cell_flags, float *string_power);
+
+// IEEE 754 half precision conversion
+uint16_t TimeSeries_FloatToHalf(float value);
+float TimeSeries_HalfToFloat(uint16_t half);
+
+#endif // TIMESERIES_H
@@ -0,0 +1,252 @@
+#include "weather.h"
+#include "csv_util.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LINE_LENGTH 4096
+#define MAX_FIELDS 96
+#define HEADER_SEARCH_LINES 64   // Metadata lines allowed before the column header
+
+// How each row says when it is
+typedef enum {
+    TIME_DATE_CLOCK,    // TMY3 Date + Time, hour-ending
+    TIME_COLUMNS,       // Month, Day, Hour (+ Minute)
+    TIME_STAMP          // PVGIS YYYYMMDD:HHMM
+} TimeLayout;
+
+typedef struct {
+    int ghi, dni, dhi, temp;
+    int date, time;
+    int month, day, hour, minute;
+    TimeLayout layout;
+} Columns;
+
+static bool FindColumns(char **fields, int count, Columns *columns) {
+    static const char *const ghi[] = {"ghi", "g(h)", "global horizontal"};
+    static const char *const dni[] = {"dni", "gb(n)", "direct normal"};
+    static const char *const dhi[] = {"dhi", "gd(h)", "diffuse horizontal"};
+    static const char *const temp[] = {"dry-bulb", "temperature", "temp", "t2m"};
+    static const char *const date[] = {"date"};
+    static const char *const time[] = {"time"};
+    static const char *const stamp[] = {"time(utc)"};
+
+    columns->ghi = Csv_FindColumn(fields, count, ghi, 3);
+    columns->dni = Csv_FindColumn(fields, count, dni, 3);
+    columns->dhi = Csv_FindColumn(fields, count, dhi, 3);
+    if (columns->ghi < 0 || columns->dni < 0 || columns->dhi < 0)
+        return false;
+    columns->temp = Csv_FindColumn(fields, count, temp, 4);
+
+    columns->date = Csv_FindColumn(fields, count, date, 1);
+    columns->time = Csv_FindColumn(fields, count, time, 1);
+    columns->month = Csv_FindExact(fields, count, "month");
+    columns->day = Csv_FindExact(fields, count, "day");
+    columns->hour = Csv_FindExact(fields, count, "hour");
+    columns->minute = Csv_FindExact(fields, count, "minute");
+
+    if (columns->date >= 0 && columns->time >= 0) {
+        columns->layout = TIME_DATE_CLOCK;
+    } else if (columns->month >= 0 && columns->day >= 0 && columns->hour >= 0) {
+        columns->layout = TIME_COLUMNS;
+    } else if (Csv_FindColumn(fields, count, stamp, 1) >= 0) {
+        columns->time = Csv_FindColumn(fields, count, stamp, 1);
+        columns->layout = TIME_STAMP;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Label time of a data row: month, day and decimal hour as written. Returns false for rows that are not data.
+static bool ParseTime(char **fields, int count, const Columns *columns, int *month, int *day, float *hour) {
+    int m = 0, d = 0, hh = 0, mm = 0;
+    switch (columns->layout) {
+        case TIME_DATE_CLOCK:
+            if (columns->date >= count || columns->time >= count ||
+                sscanf(fields[columns->date], "%d/%d", &m, &d) != 2 ||
+                sscanf(fields[columns->time], "%d:%d", &hh, &mm) < 1)
+                return false;
+            break;
+        case TIME_COLUMNS:
+            if (columns->month >= count || columns->day >= count || columns->hour >= count)
+                return false;
+            m = atoi(fields[columns->month]);
+            d = atoi(fields[columns->day]);
+            hh = atoi(fields[columns->hour]);
+            if (columns->minute >= 0 && columns->minute < count)
+                mm = atoi(fields[columns->minute]);
+            break;
+        case TIME_STAMP: {
+            int year;
+            if (columns->time >= count ||
+                sscanf(fields[columns->time], "%4d%2d%2d:%2d%2d", &year, &m, &d, &hh, &mm) != 5)
+                return false;
+            break;
+        }
+    }
+    if (m < 1 || m > 12 || d < 1 || d > 31 || hh < 0 || hh > 24)
+        return false;
+    *month = m;
+    *day = d;
+    *hour = hh + mm / 60.0f;
+    return true;
+}
+
+// Column value, or missing for blanks and the -999 / -9900 fill values
+static float ReadValue(char **fields, int count, int column, float missing) {
+    float value;
+    if (!Csv_ReadNumber(fields, count, column, &value) || value < -900.0f)
+        return missing;
+    return value;
+}
+
+// Metadata ahead of the header: PVGIS "Name: value" lines and TMY3's unlabelled site line
+static void ReadPreamble(WeatherYear *weather, const char *raw, char **fields, int count, int line_index) {
+    float value;
+    const char *colon = strchr(raw, ':');
+    if (colon && Csv_StartsWith(raw, "latitude") && Csv_ParseNumber(colon + 1, &value)) {
+        weather->latitude = value;
+        weather->has_location = true;
+    } else if (colon && Csv_StartsWith(raw, "longitude") && Csv_ParseNumber(colon + 1, &value)) {
+        weather->longitude = value;
+    } else if (line_index == 0 && count >= 6 && Csv_ParseNumber(fields[0], &value)) {
+        float timezone, latitude, longitude;
+        if (Csv_ParseNumber(fields[3], &timezone) && Csv_ParseNumber(fields[4], &latitude) &&
+            Csv_ParseNumber(fields[5], &longitude)) {
+            weather->timezone = timezone;
+            weather->has_timezone = true;
+            weather->latitude = latitude;
+            weather->longitude = longitude;
+            weather->has_location = true;
+            snprintf(weather->name, sizeof(weather->name), "%s", fields[1]);
+        }
+    }
+}
+
+// NSRDB: a labelled metadata row, values on the next line
+static void ReadMetadataPair(WeatherYear *weather, char **names, int name_count, char **values, int value_count) {
+    int lat = Csv_FindExact(names, name_count, "latitude");
+    int lon = Csv_FindExact(names, name_count, "longitude");
+    int tz = Csv_FindExact(names, name_count, "time zone");
+    int city = Csv_FindExact(names, name_count, "city");
+    if (lat >= 0 && lat < value_count && lon >= 0 && lon < value_count &&
+        Csv_ParseNumber(values[lat], &weather->latitude) && Csv_ParseNumber(values[lon], &weather->longitude)) {
+        weather->has_location = true;
+    }
+    if (tz >= 0 && tz < value_count && Csv_ParseNumber(values[tz], &weather->timezone))
+        weather->has_timezone = true;
+    if (city >= 0 && city < value_count && values[city][0] && values[city][0] != '-')
+        snprintf(weather->name, sizeof(weather->name), "%s", values[city]);
+}
+
+//------------------------------------------------------------------------------
+// Loading
+//------------------------------------------------------------------------------
+bool Weather_LoadCSV(WeatherYear *weather, const char *path, char *error, size_t error_size) {
+    memset(weather, 0, sizeof(*weather));
+
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        Csv_SetError(error, error_size, "Could not open the file");
+        return false;
+    }
+
+    char *line = (char *) malloc(LINE_LENGTH);
+    char *prev = (char *) malloc(LINE_LENGTH);
+    char *raw = (char *) malloc(LINE_LENGTH);
+    weather->records = (WeatherRecord *) malloc(WEATHER_MAX_RECORDS * sizeof(WeatherRecord));
+    if (!line || !prev || !raw || !weather->records) {
+        free(line);
+        free(prev);
+        free(raw);
+        fclose(file);
+        Weather_Free(weather);
+        Csv_SetError(error, error_size, "Out of memory");
+        return false;
+    }
+
+    // Find the column header, reading any site metadata on the way
+    char *fields[MAX_FIELDS];
+    char *prev_fields[MAX_FIELDS];
+    int prev_count = 0;
+    Columns columns;
+    bool found = false;
+    for (int index = 0; index < HEADER_SEARCH_LINES && fgets(line, LINE_LENGTH, file); index++) {
+        memcpy(raw, line, LINE_LENGTH);
+        int count = Csv_SplitFields(line, fields, MAX_FIELDS);
+        if (FindColumns(fields, count, &columns)) {
+            found = true;
+            break;
+        }
+        ReadPreamble(weather, raw, fields, count, index);
+        if (prev_count > 0 && Csv_FindExact(prev_fields, prev_count, "latitude") >= 0)
+            ReadMetadataPair(weather, prev_fields, prev_count, fields, count);
+
+        // Keep this row's fields for the next one
+        char *swap = prev;
+        prev = line;
+        line = swap;
+        prev_count = count;
+        memcpy(prev_fields, fields, count * sizeof(char *));
+    }
+    // PVGIS hours are UTC whatever the site
+    if (found && columns.layout == TIME_STAMP) {
+        weather->timezone = 0.0f;
+        weather->has_timezone = true;
+    }
+
+    bool hour_ending = found && columns.layout == TIME_DATE_CLOCK;
+    bool on_the_hour = true;
+    while (found && fgets(line, LINE_LENGTH, file) && weather->record_count < WEATHER_MAX_RECORDS) {
+        int count = Csv_SplitFields(line, fields, MAX_FIELDS);
+        WeatherRecord record;
+        int month, day;
+        if (!ParseTime(fields, count, &columns, &month, &day, &record.hour))
+            continue;
+        record.month = (uint8_t) month;
+        record.day = (uint8_t) day;
+        record.ghi = fmaxf(ReadValue(fields, count, columns.ghi, 0.0f), 0.0f);
+        record.dni = fmaxf(ReadValue(fields, count, columns.dni, 0.0f), 0.0f);
+        record.dhi = fmaxf(ReadValue(fields, count, columns.dhi, 0.0f), 0.0f);
+        record.temp_c = ReadValue(fields, count, columns.temp, 25.0f);
+        if (record.hour != floorf(record.hour))
+            on_the_hour = false;
+        weather->records[weather->record_count++] = record;
+    }
+
+    free(line);
+    free(prev);
+    free(raw);
+    fclose(file);
+
+    if (!found) {
+        Weather_Free(weather);
+        Csv_SetError(error, error_size, "No GHI, DNI and DHI columns with dates found");
+        return false;
+    }
+    if (weather->record_count < 2) {
+        Weather_Free(weather);
+        Csv_SetError(error, error_size, "No weather rows found");
+        return false;
+    }
+
+    // Interval from the first two rows; hourly if they disagree with that
+    const WeatherRecord *a = &weather->records[0];
+    const WeatherRecord *b = &weather->records[1];
+    float dt = (b->day - a->day) * 24.0f + (b->hour - a->hour);
+    weather->dt_hours = (b->month == a->month && dt > 0.0f && dt <= 1.0f) ? dt : 1.0f;
+
+    // Shift labels to the middle of the interval they stand for
+    float shift = hour_ending ? -0.5f * weather->dt_hours : on_the_hour ? 0.5f * weather->dt_hours : 0.0f;
+    for (int r = 0; r < weather->record_count; r++) {
+        weather->records[r].hour += shift;
+    }
+    return true;
+}
+
+void Weather_Free(WeatherYear *weather) {
+    free(weather->records);
+    memset(weather, 0, sizeof(*weather));
+}
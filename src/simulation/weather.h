@@ -0,0 +1,63 @@
+#ifndef WEATHER_H
+#define WEATHER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+//------------------------------------------------------------------------------
+// Constants
+//------------------------------------------------------------------------------
+#define WEATHER_MAX_RECORDS 17568    // A leap year at 30 minute steps
+#define WEATHER_NAME_LENGTH 64
+
+//------------------------------------------------------------------------------
+// Typical-meteorological-year weather
+//------------------------------------------------------------------------------
+// Hourly (or finer) irradiance and temperature for one site over a year, read
+// from the CSV layouts TMY data usually comes in:
+//   TMY3:  site line (USAF, name, state, TZ, lat, lon, ...), then
+//          Date (MM/DD/YYYY), Time (HH:MM) labelling the end of each hour
+//   NSRDB: Latitude / Longitude / Time Zone metadata pair, then
+//          Year, Month, Day, Hour, Minute columns
+//   PVGIS: "Latitude (decimal degrees): ..." lines, then time(UTC) as
+//          YYYYMMDD:HHMM
+// Columns are found by name (GHI / G(h), DNI / Gb(n), DHI / Gd(h),
+// Dry-bulb / Temperature / T2m), so extra columns and order do not matter.
+// Missing values (-9999) and negative irradiance read as zero; a missing
+// temperature reads as 25 C.
+
+typedef struct {
+    uint8_t month;      // 1-12
+    uint8_t day;        // 1-31
+    float hour;         // Middle of the interval, in the file's time zone
+    float ghi;          // Global horizontal irradiance (W/m^2)
+    float dni;          // Direct normal irradiance (W/m^2)
+    float dhi;          // Diffuse horizontal irradiance (W/m^2)
+    float temp_c;       // Ambient dry-bulb temperature (C)
+} WeatherRecord;
+
+typedef struct {
+    WeatherRecord *records;
+    int record_count;
+    float dt_hours;     // Interval each record stands for
+
+    bool has_location;  // The file named its site
+    float latitude;     // degrees
+    float longitude;    // degrees
+    bool has_timezone;  // The file said which time zone its hours are in
+    float timezone;     // Hours from UTC of the record hours
+    char name[WEATHER_NAME_LENGTH];
+} WeatherYear;
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+
+// Read a TMY-style CSV. On failure the weather is left empty and error (optional) gets the reason.
+bool Weather_LoadCSV(WeatherYear *weather, const char *path, char *error, size_t error_size);
+
+// Release the records (safe on an empty weather year)
+void Weather_Free(WeatherYear *weather);
+
+#endif // WEATHER_H
@@ -0,0 +1,64 @@
+/*
+ * Solar position (PSA algorithm with refraction) over arrays of instants
+ */
+
+#include "solar_position.h"
+#include <math.h>
+
+#define J2000 2451545.0
+#define TWO_PI 6.28318530717958647692
+#define RAD_PER_DEG (TWO_PI / 360.0)
+#define EARTH_MEAN_RADIUS 6371.01          // km
+#define ASTRONOMICAL_UNIT 149597890.0      // km
+#define REFRACTION_LIMIT -0.83337          // Sun fully below the horizon, including its radius (degrees)
+
+double SolarPosition_JulianDay(int year, int month, int day, double hour_ut) {
+    // Fliegel & Van Flandern day number (noon based), in integer arithmetic
+    long a = (month - 14) / 12;
+    long jdn = (1461L * (year + 4800 + a)) / 4 + (367L * (month - 2 - 12 * a)) / 12 -
+               (3L * ((year + 4900 + a) / 100)) / 4 + day - 32075;
+    return (double) jdn - 0.5 + hour_ut / 24.0;
+}
+
+void SolarPosition_Compute(const double *julian_day, int count, double latitude, double longitude,
+                           float *altitude, float *azimuth) {
+    const double lat = latitude * RAD_PER_DEG;
+    const double sin_lat = sin(lat), cos_lat = cos(lat);
+    const double refraction_scale = (SOLAR_POSITION_PRESSURE / 1010.0) * (283.0 / (273.0 + SOLAR_POSITION_TEMPERATURE));
+
+    for (int i = 0; i < count; i++) {
+        double n = julian_day[i] - J2000;
+        double hour_ut = (n - floor(n + 0.5) + 0.5) * 24.0;
+
+        // Ecliptic coordinates of the sun (radians)
+        double omega = 2.1429 - 0.0010394594 * n;
+        double mean_longitude = 4.8950630 + 0.017202791698 * n;
+        double mean_anomaly = 6.2400600 + 0.0172019699 * n;
+        double ecliptic_longitude = mean_longitude + 0.03341607 * sin(mean_anomaly) +
+                                    0.00034894 * sin(2.0 * mean_anomaly) - 0.0001134 - 0.0000203 * sin(omega);
+        double obliquity = 0.4090928 - 6.2140e-9 * n + 0.0000396 * cos(omega);
+
+        // Celestial coordinates
+        double sin_longitude = sin(ecliptic_longitude);
+        double right_ascension = atan2(cos(obliquity) * sin_longitude, cos(ecliptic_longitude));
+        double declination = asin(sin(obliquity) * sin_longitude);
+
+        // Local coordinates
+        double gmst = 6.6974243242 + 0.0657098283 * n + hour_ut;
+        double hour_angle = (gmst * 15.0 + longitude) * RAD_PER_DEG - right_ascension;
+        double cos_hour_angle = cos(hour_angle);
+        double zenith = acos(cos_lat * cos_hour_angle * cos(declination) + sin(declination) * sin_lat);
+        double az = atan2(-sin(hour_angle), tan(declination) * cos_lat - sin_lat * cos_hour_angle);
+        az = az < 0.0 ? az + TWO_PI : az;
+
+        // Parallax, then refraction of the apparent elevation (degrees)
+        zenith += (EARTH_MEAN_RADIUS / ASTRONOMICAL_UNIT) * sin(zenith);
+        double elevation = 90.0 - zenith / RAD_PER_DEG;
+        double refraction = refraction_scale * 1.02 /
+                            (60.0 * tan((elevation + 10.3 / (elevation + 5.11)) * RAD_PER_DEG));
+        elevation += elevation >= REFRACTION_LIMIT ? refraction : 0.0;
+
+        altitude[i] = (float) elevation;
+        azimuth[i] = (float) (az / RAD_PER_DEG);
+    }
+}
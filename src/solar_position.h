@@ -0,0 +1,39 @@
+#ifndef SOLAR_POSITION_H
+#define SOLAR_POSITION_H
+
+//------------------------------------------------------------------------------
+// Constants
+//------------------------------------------------------------------------------
+#define SOLAR_POSITION_PRESSURE 1010.0    // Mean site pressure for refraction (mbar)
+#define SOLAR_POSITION_TEMPERATURE 10.0   // Mean site temperature for refraction (C)
+
+//------------------------------------------------------------------------------
+// Solar position
+//------------------------------------------------------------------------------
+// Topocentric sun position in double precision from the PSA algorithm
+// (Blanco-Muriel et al. 2001): low-order ecliptic series for the sun, mean
+// sidereal time, parallax, then the SPA-style atmospheric refraction for the
+// constants above. Within about 0.01 degrees of NREL SPA over 2000-2050, at
+// a small fraction of its cost.
+//
+// Instants are Julian days in UT, built with SolarPosition_JulianDay from a
+// proleptic Gregorian date, so leap years and time zones are exact rather
+// than approximated. The batch call runs one straight-line loop over arrays
+// of instants (structure of arrays, no per-sample branches besides the
+// horizon test of the refraction), which compilers vectorise with a vector
+// math library; per-sample cost is a few dozen flops either way.
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+
+// Julian day of a Gregorian date at hour_ut hours UT. Hours outside 0-24 and days past the end of the month roll
+// over into the neighbouring days.
+double SolarPosition_JulianDay(int year, int month, int day, double hour_ut);
+
+// Sun altitude (degrees above the horizon, refracted) and azimuth (degrees clockwise from north) seen from
+// latitude / longitude (degrees, east positive) at count instants
+void SolarPosition_Compute(const double *julian_day, int count, double latitude, double longitude,
+                           float *altitude, float *azimuth);
+
+#endif // SOLAR_POSITION_H
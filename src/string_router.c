@@ -0,0 +1,438 @@
+/*
+ * Shortest-path ordering of the cells in a series string
+ */
+
+#include "string_router.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "raymath.h"
+
+#define ROUTE_EPSILON 1e-6f // Smallest length change (m) that counts as an improvement
+#define GRID_MAX_DIM 64     // Buckets along any axis of the point grid
+
+//------------------------------------------------------------------------------
+// Point Grid
+//------------------------------------------------------------------------------
+
+// Uniform bucket grid over the points, sized for about one point per bucket across the surface they lie on
+typedef struct {
+    float min[3];
+    float size;
+    int dim[3];
+    int *head;  // First point in each bucket, -1 = empty
+    int *next;  // Next point in the same bucket
+} PointGrid;
+
+static float Axis(Vector3 p, int axis) {
+    return axis == 0 ? p.x : (axis == 1 ? p.y : p.z);
+}
+
+static int BucketCoord(const PointGrid *grid, Vector3 p, int axis) {
+    int c = (int) ((Axis(p, axis) - grid->min[axis]) / grid->size);
+    if (c < 0)
+        return 0;
+    return c < grid->dim[axis] ? c : grid->dim[axis] - 1;
+}
+
+static bool BuildGrid(PointGrid *grid, const Vector3 *points, int count) {
+    float max[3];
+    for (int a = 0; a < 3; a++) {
+        grid->min[a] = max[a] = Axis(points[0], a);
+    }
+    for (int i = 1; i < count; i++) {
+        for (int a = 0; a < 3; a++) {
+            grid->min[a] = fminf(grid->min[a], Axis(points[i], a));
+            max[a] = fmaxf(max[a], Axis(points[i], a));
+        }
+    }
+
+    // Cells sit on a surface, so size buckets from the two largest extents
+    float e[3] = {max[0] - grid->min[0], max[1] - grid->min[1], max[2] - grid->min[2]};
+    float largest = fmaxf(e[0], fmaxf(e[1], e[2]));
+    float smallest = fminf(e[0], fminf(e[1], e[2]));
+    float middle = e[0] + e[1] + e[2] - largest - smallest;
+    grid->size = sqrtf(fmaxf(largest * middle, 1e-8f) / count);
+    grid->size = fmaxf(grid->size, fmaxf(largest / GRID_MAX_DIM, 1e-4f));
+
+    int buckets = 1;
+    for (int a = 0; a < 3; a++) {
+        grid->dim[a] = (int) (e[a] / grid->size) + 1;
+        if (grid->dim[a] > GRID_MAX_DIM)
+            grid->dim[a] = GRID_MAX_DIM;
+        buckets *= grid->dim[a];
+    }
+
+    grid->head = (int *) malloc(buckets * sizeof(int));
+    grid->next = (int *) malloc(count * sizeof(int));
+    if (!grid->head || !grid->next)
+        return false;
+    memset(grid->head, -1, buckets * sizeof(int));
+    for (int i = 0; i < count; i++) {
+        int b = (BucketCoord(grid, points[i], 2) * grid->dim[1] + BucketCoord(grid, points[i], 1)) * grid->dim[0] +
+                BucketCoord(grid, points[i], 0);
+        grid->next[i] = grid->head[b];
+        grid->head[b] = i;
+    }
+    return true;
+}
+
+static void FreeGrid(PointGrid *grid) {
+    free(grid->head);
+    free(grid->next);
+    memset(grid, 0, sizeof(PointGrid));
+}
+
+// Up to k points nearest points[from] for which skip[] is false, written nearest first; returns how many
+static int NearestPoints(const PointGrid *grid, const Vector3 *points, int from, const bool *skip, int k,
+                         int *out, float *out_dist) {
+    Vector3 p = points[from];
+    int c[3] = {BucketCoord(grid, p, 0), BucketCoord(grid, p, 1), BucketCoord(grid, p, 2)};
+    int max_ring = grid->dim[0];
+    if (grid->dim[1] > max_ring) max_ring = grid->dim[1];
+    if (grid->dim[2] > max_ring) max_ring = grid->dim[2];
+
+    int found = 0;
+    for (int r = 0; r < max_ring; r++) {
+        // Visit the shell of buckets at Chebyshev distance r
+        for (int dz = -r; dz <= r; dz++) {
+            int z = c[2] + dz;
+            if (z < 0 || z >= grid->dim[2])
+                continue;
+            for (int dy = -r; dy <= r; dy++) {
+                int y = c[1] + dy;
+                if (y < 0 || y >= grid->dim[1])
+                    continue;
+                for (int dx = -r; dx <= r; dx++) {
+                    int x = c[0] + dx;
+                    if (x < 0 || x >= grid->dim[0])
+                        continue;
+                    if (abs(dx) != r && abs(dy) != r && abs(dz) != r)
+                        continue;
+
+                    for (int i = grid->head[(z * grid->dim[1] + y) * grid->dim[0] + x]; i >= 0; i = grid->next[i]) {
+                        if (i == from || skip[i])
+                            continue;
+                        float d = Vector3Distance(p, points[i]);
+                        if (found == k && d >= out_dist[k - 1])
+                            continue;
+
+                        int slot = (found < k) ? found++ : k - 1;
+                        while (slot > 0 && out_dist[slot - 1] > d) {
+                            out[slot] = out[slot - 1];
+                            out_dist[slot] = out_dist[slot - 1];
+                            slot--;
+                        }
+                        out[slot] = i;
+                        out_dist[slot] = d;
+                    }
+                }
+            }
+        }
+
+        // Anything in a further shell is at least r buckets away
+        if (found == k && out_dist[k - 1] <= r * grid->size)
+            break;
+    }
+    return found;
+}
+
+//------------------------------------------------------------------------------
+// Tour
+//------------------------------------------------------------------------------
+
+// Open path as a closed tour through a virtual end node (index count) that is zero distance from everything
+typedef struct {
+    const Vector3 *points;
+    int count;          // Real points
+    int size;           // Tour length (count + 1)
+    int end;            // Virtual end node
+    int *tour;
+    int *pos;           // Position of each node in tour
+    int *neighbours;    // (STRING_ROUTER_NEIGHBOURS + 1) per point, nearest first
+    int *neighbour_count;
+    bool pinned[2];     // points[0] / points[count - 1] must stay next to the end node
+    int *scratch;       // 2 * count
+} Tour;
+
+static float Dist(const Tour *t, int a, int b) {
+    if (a == t->end || b == t->end)
+        return 0.0f;
+    return Vector3Distance(t->points[a], t->points[b]);
+}
+
+// A pinned point's edge to the end node may never be broken
+static bool Removable(const Tour *t, int a, int b) {
+    int other = (a == t->end) ? b : (b == t->end ? a : -1);
+    if (other < 0)
+        return true;
+    return !((t->pinned[0] && other == 0) || (t->pinned[1] && other == t->count - 1));
+}
+
+static int Succ(const Tour *t, int node) {
+    return t->tour[(t->pos[node] + 1) % t->size];
+}
+
+static int Pred(const Tour *t, int node) {
+    return t->tour[(t->pos[node] + t->size - 1) % t->size];
+}
+
+// Reverse tour positions i..j (inclusive, wrapping); the shorter side is flipped since both give the same tour
+static void Reverse(Tour *t, int i, int j) {
+    int len = (j - i + t->size) % t->size + 1;
+    if (len * 2 > t->size) {
+        int ni = (j + 1) % t->size;
+        j = (i + t->size - 1) % t->size;
+        i = ni;
+        len = t->size - len;
+    }
+    for (int k = 0; k < len / 2; k++) {
+        int a = (i + k) % t->size, b = (j - k + t->size) % t->size;
+        int na = t->tour[a], nb = t->tour[b];
+        t->tour[a] = nb;
+        t->tour[b] = na;
+        t->pos[nb] = a;
+        t->pos[na] = b;
+    }
+}
+
+// Replace edges (a, succ a) and (c, succ c), or the pred edges, with (a, c) and the matching pair
+static bool TwoOptPass(Tour *t, int *moves) {
+    bool improved = false;
+    for (int a = 0; a < t->count; a++) {
+        for (int dir = 0; dir < 2; dir++) {
+            int b = dir == 0 ? Succ(t, a) : Pred(t, a);
+            if (!Removable(t, a, b))
+                continue;
+            float dab = Dist(t, a, b);
+
+            bool moved = false;
+            const int *nb = &t->neighbours[a * (STRING_ROUTER_NEIGHBOURS + 1)];
+            for (int k = 0; k < t->neighbour_count[a] && !moved; k++) {
+                int c = nb[k];
+                float dac = Dist(t, a, c);
+                if (dac >= dab - ROUTE_EPSILON)
+                    break;
+                int d = dir == 0 ? Succ(t, c) : Pred(t, c);
+                if (c == b || d == a || !Removable(t, c, d))
+                    continue;
+
+                if (dab + Dist(t, c, d) - dac - Dist(t, b, d) > ROUTE_EPSILON) {
+                    if (dir == 0)
+                        Reverse(t, t->pos[b], t->pos[c]);
+                    else
+                        Reverse(t, t->pos[a], t->pos[d]);
+                    (*moves)++;
+                    improved = moved = true;
+                }
+            }
+            if (moved)
+                break;
+        }
+    }
+    return improved;
+}
+
+// Rebuild the tour with the run seg[0..len-1] (currently between p and n) inserted after x
+static void MoveSegment(Tour *t, const int *seg, int len, int n, int x, bool reversed) {
+    int out = 0;
+    for (int node = n;; node = Succ(t, node)) {
+        t->scratch[out++] = node;
+        if (node == x) {
+            for (int s = 0; s < len; s++) {
+                t->scratch[out++] = seg[reversed ? len - 1 - s : s];
+            }
+        }
+        if (Succ(t, node) == seg[0])
+            break;
+    }
+    for (int i = 0; i < t->size; i++) {
+        t->tour[i] = t->scratch[i];
+        t->pos[t->tour[i]] = i;
+    }
+}
+
+// Move a run of 1..STRING_ROUTER_OR_SEGMENT points, either way round, next to a neighbour of one of its ends
+static bool OrOptPass(Tour *t, int *moves) {
+    bool improved = false;
+    int seg[STRING_ROUTER_OR_SEGMENT];
+
+    for (int a = 0; a < t->count; a++) {
+        bool moved = false;
+        for (int len = 1; len <= STRING_ROUTER_OR_SEGMENT && len < t->size - 2 && !moved; len++) {
+            bool real = true;
+            for (int s = 0; s < len; s++) {
+                seg[s] = t->tour[(t->pos[a] + s) % t->size];
+                real = real && seg[s] != t->end;
+            }
+            if (!real)
+                break;
+
+            int first = seg[0], last = seg[len - 1];
+            int p = Pred(t, first), n = Succ(t, last);
+            if (!Removable(t, p, first) || !Removable(t, last, n))
+                continue;
+            float removed = Dist(t, p, first) + Dist(t, last, n) - Dist(t, p, n);
+            if (removed <= ROUTE_EPSILON)
+                continue;
+
+            for (int e = 0; e < 2 && !moved; e++) {
+                int from = e == 0 ? first : last;
+                const int *nb = &t->neighbours[from * (STRING_ROUTER_NEIGHBOURS + 1)];
+                for (int k = 0; k < t->neighbour_count[from] && !moved; k++) {
+                    for (int side = 0; side < 2 && !moved; side++) {
+                        int x = side == 0 ? nb[k] : Pred(t, nb[k]);
+                        int y = Succ(t, x);
+                        int ox = (t->pos[x] - t->pos[a] + t->size) % t->size;
+                        int oy = (t->pos[y] - t->pos[a] + t->size) % t->size;
+                        if (ox < len || oy < len || !Removable(t, x, y))
+                            continue;
+
+                        float base = Dist(t, x, y);
+                        float forward = Dist(t, x, first) + Dist(t, last, y) - base;
+                        float backward = Dist(t, x, last) + Dist(t, first, y) - base;
+                        bool reversed = backward < forward;
+                        if (removed - (reversed ? backward : forward) > ROUTE_EPSILON) {
+                            MoveSegment(t, seg, len, n, x, reversed);
+                            (*moves)++;
+                            improved = moved = true;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return improved;
+}
+
+//------------------------------------------------------------------------------
+// Solve
+//------------------------------------------------------------------------------
+float StringRouter_PathLength(const Vector3 *points, const int *order, int count) {
+    float length = 0.0f;
+    for (int i = 0; i + 1 < count; i++) {
+        length += Vector3Distance(points[order[i]], points[order[i + 1]]);
+    }
+    return length;
+}
+
+// Nearest-neighbour walk from start; hold (if >= 0) is left for the final step
+static void BuildGreedyPath(const PointGrid *grid, const Vector3 *points, int count, int start, int hold,
+                            bool *visited, int *path) {
+    int current = start;
+    visited[start] = true;
+    if (hold >= 0)
+        visited[hold] = true;
+
+    int filled = 0;
+    path[filled++] = start;
+    while (filled < count - (hold >= 0 ? 1 : 0)) {
+        int next;
+        float d;
+        if (NearestPoints(grid, points, current, visited, 1, &next, &d) == 0)
+            break;
+        visited[next] = true;
+        path[filled++] = next;
+        current = next;
+    }
+    if (hold >= 0)
+        path[filled++] = hold;
+}
+
+bool StringRouter_Solve(const Vector3 *points, int count, bool fix_first, bool fix_last, int *order,
+                        RouteStats *stats) {
+    for (int i = 0; i < count; i++) {
+        order[i] = i;
+    }
+    float initial = StringRouter_PathLength(points, order, count);
+    if (stats)
+        *stats = (RouteStats) {initial, initial, 0, 0};
+    if (count < 4)
+        return true;
+
+    int stride = STRING_ROUTER_NEIGHBOURS + 1;
+    Tour t = {0};
+    t.points = points;
+    t.count = count;
+    t.size = count + 1;
+    t.end = count;
+    PointGrid grid = {0};
+    t.tour = (int *) malloc(t.size * sizeof(int));
+    t.pos = (int *) malloc(t.size * sizeof(int));
+    t.scratch = (int *) malloc(2 * count * sizeof(int)); // Tour rebuilds, then the path and its final order
+    t.neighbours = (int *) malloc(count * stride * sizeof(int));
+    t.neighbour_count = (int *) malloc(count * sizeof(int));
+    bool *visited = (bool *) calloc(count, sizeof(bool));
+    float *dist = (float *) malloc(STRING_ROUTER_NEIGHBOURS * sizeof(float));
+    bool ok = t.tour && t.pos && t.scratch && t.neighbours && t.neighbour_count && visited && dist &&
+              BuildGrid(&grid, points, count);
+
+    if (ok) {
+        // Candidate partners: the end node (free to take any unpinned point) then the nearest points
+        for (int i = 0; i < count; i++) {
+            int *nb = &t.neighbours[i * stride];
+            nb[0] = t.end;
+            t.neighbour_count[i] = 1 + NearestPoints(&grid, points, i, visited, STRING_ROUTER_NEIGHBOURS, nb + 1,
+                                                     dist);
+        }
+
+        // Start from a pinned end, otherwise from the point furthest from the centroid
+        int start = fix_first ? 0 : (fix_last ? count - 1 : 0);
+        if (!fix_first && !fix_last) {
+            Vector3 centroid = {0};
+            for (int i = 0; i < count; i++) {
+                centroid = Vector3Add(centroid, points[i]);
+            }
+            centroid = Vector3Scale(centroid, 1.0f / count);
+            float furthest = -1.0f;
+            for (int i = 0; i < count; i++) {
+                float d = Vector3DistanceSqr(points[i], centroid);
+                if (d > furthest) {
+                    furthest = d;
+                    start = i;
+                }
+            }
+        }
+        t.tour[0] = t.end;
+        BuildGreedyPath(&grid, points, count, start, (fix_first && fix_last) ? count - 1 : -1, visited, t.tour + 1);
+        for (int i = 0; i < t.size; i++) {
+            t.pos[t.tour[i]] = i;
+        }
+        t.pinned[0] = fix_first;
+        t.pinned[1] = fix_last;
+
+        int two_opt = 0, or_opt = 0;
+        for (int pass = 0; pass < STRING_ROUTER_MAX_PASSES; pass++) {
+            bool improved = TwoOptPass(&t, &two_opt);
+            improved = OrOptPass(&t, &or_opt) || improved;
+            if (!improved)
+                break;
+        }
+
+        // Read the path from the end node, facing the pinned ends the right way
+        for (int i = 0; i < count; i++) {
+            t.scratch[i] = t.tour[(t.pos[t.end] + 1 + i) % t.size];
+        }
+        bool flip = fix_first ? t.scratch[0] != 0 : (fix_last && t.scratch[count - 1] != count - 1);
+        for (int i = 0; i < count; i++) {
+            t.scratch[i + count] = t.scratch[flip ? count - 1 - i : i];
+        }
+
+        float length = StringRouter_PathLength(points, t.scratch + count, count);
+        if (length < initial - ROUTE_EPSILON) {
+            memcpy(order, t.scratch + count, count * sizeof(int));
+            if (stats)
+                *stats = (RouteStats) {initial, length, two_opt, or_opt};
+        }
+    }
+
+    FreeGrid(&grid);
+    free(t.tour);
+    free(t.pos);
+    free(t.scratch);
+    free(t.neighbours);
+    free(t.neighbour_count);
+    free(visited);
+    free(dist);
+    return ok;
+}
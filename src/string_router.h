@@ -0,0 +1,40 @@
+#ifndef STRING_ROUTER_H
+#define STRING_ROUTER_H
+
+#include <stdbool.h>
+#include "raylib.h"
+
+//------------------------------------------------------------------------------
+// Series string routing
+//------------------------------------------------------------------------------
+// Orders a set of cell positions into an open path of minimal length. A
+// nearest-neighbour walk over a uniform grid gives the starting path, which
+// is then improved with 2-opt (reverse a stretch) and Or-opt (move a run of
+// up to three cells) moves drawn from each point's nearest neighbours. The
+// path is handled as a tour through a virtual end node, so moving or
+// freeing an end costs nothing extra; pinned ends keep their edge to it.
+
+#define STRING_ROUTER_NEIGHBOURS 8  // Candidate partners considered per point
+#define STRING_ROUTER_OR_SEGMENT 3  // Longest run moved by an Or-opt step
+#define STRING_ROUTER_MAX_PASSES 50 // Improvement sweeps before giving up on convergence
+
+typedef struct {
+    float initial_length;   // Path length in the order given
+    float length;           // Path length of the result
+    int two_opt_moves;      // Improving moves applied
+    int or_opt_moves;
+} RouteStats;
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+
+// Total length of the open path visiting points[order[0..count-1]]
+float StringRouter_PathLength(const Vector3 *points, const int *order, int count);
+
+// Write a short visiting order of count points to order; fix_first / fix_last keep points[0] / points[count - 1]
+// at the ends. The given order is kept if the search cannot beat it. Returns false if out of memory.
+bool StringRouter_Solve(const Vector3 *points, int count, bool fix_first, bool fix_last, int *order,
+                        RouteStats *stats);
+
+#endif // STRING_ROUTER_H
@@ -0,0 +1,172 @@
+/*
+ * Region-growing segmentation of the vehicle surface into smooth panels
+ */
+
+#include "surface_panels.h"
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "raymath.h"
+
+//------------------------------------------------------------------------------
+// Build
+//------------------------------------------------------------------------------
+
+// World normals, centroids and areas; degenerate faces get a zero normal
+static void ComputeFaces(SurfacePanels *sp, const MeshTopology *topo, const Vector3 *world) {
+    for (int t = 0; t < sp->tri_count; t++) {
+        const int *tv = &topo->tri_vertices[t * 3];
+        Vector3 p0 = world[tv[0]], p1 = world[tv[1]], p2 = world[tv[2]];
+        Vector3 cr = Vector3CrossProduct(Vector3Subtract(p1, p0), Vector3Subtract(p2, p0));
+        float len = Vector3Length(cr);
+        sp->tri_normals[t] = (len > 0) ? Vector3Scale(cr, 1.0f / len) : (Vector3) {0, 0, 0};
+        sp->tri_areas[t] = 0.5f * len;
+        sp->tri_centers[t] = Vector3Scale(Vector3Add(Vector3Add(p0, p1), p2), 1.0f / 3.0f);
+    }
+}
+
+// Breadth-first growth from seed; the queue is the panel's slice of tri_order
+static int GrowPanel(SurfacePanels *sp, const MeshTopology *topo, int seed, int panel, int first, float cos_limit) {
+    int head = first, tail = first;
+    Vector3 sum = Vector3Scale(sp->tri_normals[seed], sp->tri_areas[seed]);
+    Vector3 mean = sp->tri_normals[seed];
+
+    sp->tri_panel[seed] = panel;
+    sp->tri_order[tail++] = seed;
+    while (head < tail) {
+        int t = sp->tri_order[head++];
+        for (int k = 0; k < 3; k++) {
+            int nb = MeshTopology_Neighbor(topo, t, k);
+            if (nb < 0 || sp->tri_panel[nb] != -1 || sp->tri_areas[nb] <= 0)
+                continue;
+            Vector3 n = sp->tri_normals[nb];
+            if (Vector3DotProduct(n, sp->tri_normals[t]) < cos_limit || Vector3DotProduct(n, mean) < cos_limit)
+                continue;
+
+            sp->tri_panel[nb] = panel;
+            sp->tri_order[tail++] = nb;
+            sum = Vector3Add(sum, Vector3Scale(n, sp->tri_areas[nb]));
+            float len = Vector3Length(sum);
+            if (len > 0)
+                mean = Vector3Scale(sum, 1.0f / len);
+        }
+    }
+    return tail - first;
+}
+
+// Mean normal, 2D frame and extents of a grown panel
+static void MeasurePanel(SurfacePanels *sp, const MeshTopology *topo, const Vector3 *world, SurfacePanel *p) {
+    Vector3 sum = {0, 0, 0}, centroid = {0, 0, 0};
+    p->area = 0.0f;
+    p->min_ny = FLT_MAX;
+    p->max_ny = -FLT_MAX;
+    for (int i = p->first; i < p->first + p->tri_count; i++) {
+        int t = sp->tri_order[i];
+        float a = sp->tri_areas[t];
+        sum = Vector3Add(sum, Vector3Scale(sp->tri_normals[t], a));
+        centroid = Vector3Add(centroid, Vector3Scale(sp->tri_centers[t], a));
+        p->area += a;
+        p->min_ny = fminf(p->min_ny, sp->tri_normals[t].y);
+        p->max_ny = fmaxf(p->max_ny, sp->tri_normals[t].y);
+    }
+    p->normal = Vector3Normalize(sum);
+    p->origin = (p->area > 0) ? Vector3Scale(centroid, 1.0f / p->area) : sp->tri_centers[sp->tri_order[p->first]];
+
+    // Horizontal first axis keeps grid rows level on sloped panels
+    Vector3 u = Vector3CrossProduct((Vector3) {0, 1, 0}, p->normal);
+    if (Vector3Length(u) < 1e-3f)
+        u = Vector3CrossProduct(p->normal, (Vector3) {0, 0, 1});
+    p->axis_u = Vector3Normalize(u);
+    p->axis_v = Vector3CrossProduct(p->normal, p->axis_u);
+
+    p->min_u = p->min_v = p->min_y = FLT_MAX;
+    p->max_u = p->max_v = p->max_y = -FLT_MAX;
+    for (int i = p->first; i < p->first + p->tri_count; i++) {
+        const int *tv = &topo->tri_vertices[sp->tri_order[i] * 3];
+        for (int k = 0; k < 3; k++) {
+            Vector3 d = Vector3Subtract(world[tv[k]], p->origin);
+            float pu = Vector3DotProduct(d, p->axis_u);
+            float pv = Vector3DotProduct(d, p->axis_v);
+            p->min_u = fminf(p->min_u, pu);
+            p->max_u = fmaxf(p->max_u, pu);
+            p->min_v = fminf(p->min_v, pv);
+            p->max_v = fmaxf(p->max_v, pv);
+            p->min_y = fminf(p->min_y, world[tv[k]].y);
+            p->max_y = fmaxf(p->max_y, world[tv[k]].y);
+        }
+    }
+}
+
+bool SurfacePanels_Build(SurfacePanels *sp, const MeshTopology *topo, Matrix transform, float threshold_deg) {
+    memset(sp, 0, sizeof(SurfacePanels));
+    int n = topo->tri_count;
+    if (n <= 0)
+        return false;
+    sp->tri_count = n;
+    sp->threshold_deg = threshold_deg;
+
+    Vector3 *world = (Vector3 *) malloc(topo->vertex_count * sizeof(Vector3));
+    sp->tri_panel = (int *) malloc(n * sizeof(int));
+    sp->tri_order = (int *) malloc(n * sizeof(int));
+    sp->tri_normals = (Vector3 *) malloc(n * sizeof(Vector3));
+    sp->tri_centers = (Vector3 *) malloc(n * sizeof(Vector3));
+    sp->tri_areas = (float *) malloc(n * sizeof(float));
+    if (!world || !sp->tri_panel || !sp->tri_order || !sp->tri_normals || !sp->tri_centers || !sp->tri_areas) {
+        free(world);
+        SurfacePanels_Free(sp);
+        return false;
+    }
+
+    for (int i = 0; i < topo->vertex_count; i++) {
+        world[i] = Vector3Transform(topo->positions[i], transform);
+    }
+    ComputeFaces(sp, topo, world);
+
+    float cos_limit = cosf(threshold_deg * DEG2RAD);
+    int capacity = 0, ordered = 0;
+    memset(sp->tri_panel, -1, n * sizeof(int));
+    for (int t = 0; t < n; t++) {
+        if (sp->tri_panel[t] != -1 || sp->tri_areas[t] <= 0)
+            continue;
+
+        if (sp->panel_count == capacity) {
+            capacity = capacity ? capacity * 2 : 256;
+            SurfacePanel *grown = (SurfacePanel *) realloc(sp->panels, capacity * sizeof(SurfacePanel));
+            if (!grown) {
+                free(world);
+                SurfacePanels_Free(sp);
+                return false;
+            }
+            sp->panels = grown;
+        }
+
+        SurfacePanel *p = &sp->panels[sp->panel_count];
+        p->first = ordered;
+        p->tri_count = GrowPanel(sp, topo, t, sp->panel_count, ordered, cos_limit);
+        MeasurePanel(sp, topo, world, p);
+        ordered += p->tri_count;
+        sp->panel_count++;
+    }
+
+    free(world);
+    return sp->panel_count > 0;
+}
+
+void SurfacePanels_Free(SurfacePanels *sp) {
+    free(sp->panels);
+    free(sp->tri_panel);
+    free(sp->tri_order);
+    free(sp->tri_normals);
+    free(sp->tri_centers);
+    free(sp->tri_areas);
+    memset(sp, 0, sizeof(SurfacePanels));
+}
+
+//------------------------------------------------------------------------------
+// Queries
+//------------------------------------------------------------------------------
+Vector3 SurfacePanels_ToWorld(const SurfacePanels *sp, int p, float u, float v) {
+    const SurfacePanel *panel = &sp->panels[p];
+    return Vector3Add(panel->origin, Vector3Add(Vector3Scale(panel->axis_u, u), Vector3Scale(panel->axis_v, v)));
+}
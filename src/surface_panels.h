@@ -0,0 +1,59 @@
+#ifndef SURFACE_PANELS_H
+#define SURFACE_PANELS_H
+
+#include <stdbool.h>
+#include "raylib.h"
+#include "mesh_topology.h"
+
+//------------------------------------------------------------------------------
+// Surface panels
+//------------------------------------------------------------------------------
+// Region-growing segmentation of the welded mesh into smooth panels. A face
+// joins a panel when it bends less than the threshold against the neighbour
+// it was reached from and against the panel's running mean normal, so a
+// gently curved shell splits into near-planar pieces that each have a usable
+// 2D frame. Everything is in world space, so the segmentation has to be
+// rebuilt when the vehicle transform changes.
+
+typedef struct {
+    int first;          // Start of this panel's faces in SurfacePanels.tri_order
+    int tri_count;
+    float area;         // World area (m²)
+    Vector3 normal;     // Area-weighted mean normal
+    Vector3 origin;     // Area-weighted centroid, origin of the 2D frame
+    Vector3 axis_u;     // In-plane axes; axis_u is horizontal (world X on flat panels)
+    Vector3 axis_v;
+    float min_u, max_u; // Extent of the panel's vertices in the frame
+    float min_v, max_v;
+    float min_y, max_y; // World height range
+    float min_ny, max_ny; // Range of face normal Y components
+} SurfacePanel;
+
+typedef struct {
+    SurfacePanel *panels;
+    int panel_count;
+
+    int tri_count;
+    int *tri_panel;         // Panel per triangle, -1 for degenerate faces
+    int *tri_order;         // Triangle ids grouped by panel
+    Vector3 *tri_normals;   // World unit normal per triangle
+    Vector3 *tri_centers;   // World centroid per triangle
+    float *tri_areas;       // World area per triangle
+
+    float threshold_deg;    // Threshold the panels were grown with
+} SurfacePanels;
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+
+// Segment topo (mesh-local) under transform; returns false on failure or empty mesh
+bool SurfacePanels_Build(SurfacePanels *sp, const MeshTopology *topo, Matrix transform, float threshold_deg);
+
+// Release memory (safe on an unbuilt segmentation)
+void SurfacePanels_Free(SurfacePanels *sp);
+
+// Map a point in panel p's frame back to world space (on the panel plane)
+Vector3 SurfacePanels_ToWorld(const SurfacePanels *sp, int p, float u, float v);
+
+#endif // SURFACE_PANELS_H
@@ -0,0 +1,166 @@
+/*
+ * Job system micro-benchmark: per-task overhead and parallel-for scaling
+ *
+ * Usage: job_bench [workers]   (0 or omitted = one per core)
+ */
+
+#include "job_system.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#define BENCH_TASKS 200000      // Empty jobs per overhead run
+#define BENCH_ITEMS 2000000     // Items per parallel-for run
+#define BENCH_REPEATS 5         // Best of this many runs is reported
+
+static double NowSeconds(void) {
+#ifdef _WIN32
+    LARGE_INTEGER freq, count;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return (double) count.QuadPart / (double) freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Workloads
+//------------------------------------------------------------------------------
+static void EmptyJob(void *arg) {
+    (void) arg;
+}
+
+// A few dozen flops per item, about the cost of one cheap per-cell update
+static float ItemWork(int i) {
+    float x = (float) i * 0.001f;
+    for (int k = 0; k < 8; k++) {
+        x = sinf(x) * 0.5f + cosf(x) * 0.5f;
+    }
+    return x;
+}
+
+typedef struct {
+    float *out;
+} RangeCtx;
+
+static void RangeWork(void *ctx, int begin, int end, int slot) {
+    (void) slot;
+    float *out = ((RangeCtx *) ctx)->out;
+    for (int i = begin; i < end; i++) {
+        out[i] = ItemWork(i);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Runs
+//------------------------------------------------------------------------------
+
+// Submit BENCH_TASKS empty jobs and wait; nanoseconds per job. Jobs go in batches that fit the submitting
+// thread's queue, with a wait after each, so they are queued rather than run inline by the queue-full fallback.
+static double TaskOverhead(void) {
+    double best = 1e30;
+    for (int r = 0; r < BENCH_REPEATS; r++) {
+        double t0 = NowSeconds();
+        for (int done = 0; done < BENCH_TASKS; done += JOB_QUEUE_CAPACITY) {
+            int batch = BENCH_TASKS - done < JOB_QUEUE_CAPACITY ? BENCH_TASKS - done : JOB_QUEUE_CAPACITY;
+            JobGroup group;
+            JobGroup_Init(&group, NULL);
+            for (int i = 0; i < batch; i++) {
+                JobSystem_Submit(&group, EmptyJob, NULL);
+            }
+            JobSystem_Wait(&group);
+        }
+        double t = NowSeconds() - t0;
+        if (t < best)
+            best = t;
+    }
+    return best * 1e9 / BENCH_TASKS;
+}
+
+// Parallel-for with one item per thread: fixed cost of fanning out and joining, in microseconds
+static double ForkJoinOverhead(float *out) {
+    RangeCtx ctx = {out};
+    int items = JobSystem_WorkerCount() + 1;
+    double best = 1e30;
+    for (int r = 0; r < BENCH_REPEATS; r++) {
+        double t0 = NowSeconds();
+        for (int i = 0; i < 1000; i++) {
+            JobSystem_ParallelFor(items, 1, RangeWork, &ctx, NULL);
+        }
+        double t = NowSeconds() - t0;
+        if (t < best)
+            best = t;
+    }
+    return best * 1e6 / 1000;
+}
+
+static double ParallelForSeconds(float *out, int grain) {
+    RangeCtx ctx = {out};
+    double best = 1e30;
+    for (int r = 0; r < BENCH_REPEATS; r++) {
+        double t0 = NowSeconds();
+        JobSystem_ParallelFor(BENCH_ITEMS, grain, RangeWork, &ctx, NULL);
+        double t = NowSeconds() - t0;
+        if (t < best)
+            best = t;
+    }
+    return best;
+}
+
+static double SerialSeconds(float *out) {
+    double best = 1e30;
+    for (int r = 0; r < BENCH_REPEATS; r++) {
+        double t0 = NowSeconds();
+        for (int i = 0; i < BENCH_ITEMS; i++) {
+            out[i] = ItemWork(i);
+        }
+        double t = NowSeconds() - t0;
+        if (t < best)
+            best = t;
+    }
+    return best;
+}
+
+int main(int argc, char **argv) {
+    int workers = argc > 1 ? atoi(argv[1]) : 0;
+    if (!JobSystem_Init(workers)) {
+        fprintf(stderr, "job_bench: could not start the job system\n");
+        return 1;
+    }
+    printf("Workers: %d (+ main thread)\n", JobSystem_WorkerCount());
+
+    float *out = (float *) malloc(BENCH_ITEMS * sizeof(float));
+    if (!out) {
+        JobSystem_Shutdown();
+        return 1;
+    }
+
+    printf("Submit + wait, empty job:   %8.1f ns/job (batches of %d)\n", TaskOverhead(), JOB_QUEUE_CAPACITY);
+    printf("Parallel-for fork/join:     %8.2f us\n", ForkJoinOverhead(out));
+
+    double serial = SerialSeconds(out);
+    printf("Serial, %d items:      %8.2f ms (%.1f ns/item)\n", BENCH_ITEMS, serial * 1e3, serial * 1e9 / BENCH_ITEMS);
+
+    const int grains[] = {1, 16, 256, 0};
+    for (int g = 0; g < (int) (sizeof(grains) / sizeof(grains[0])); g++) {
+        double t = ParallelForSeconds(out, grains[g]);
+        if (grains[g] > 0)
+            printf("Parallel-for, grain %-6d %8.2f ms (x%.2f)\n", grains[g], t * 1e3, serial / t);
+        else
+            printf("Parallel-for, grain auto   %8.2f ms (x%.2f)\n", t * 1e3, serial / t);
+    }
+
+    free(out);
+    JobSystem_Shutdown();
+    return 0;
+}
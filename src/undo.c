@@ -0,0 +1,553 @@
+#include "app.h"
+#include "undo.h"
+#include <stdlib.h>
+#include <string.h>
+
+//------------------------------------------------------------------------------
+// Undo / Redo
+//------------------------------------------------------------------------------
+// Every edit to cells, strings, bypass diodes or the mesh transform is
+// journalled as the primitive changes it makes, in order, each with enough
+// data to be replayed in either direction. Undo walks a step's records
+// backwards applying their inverses; redo walks them forwards. Records name
+// array positions and check the ids found there, so a mismatch (state that
+// changed outside the journal) is caught and repaired from the step's
+// nearest checkpoint instead of corrupting the layout.
+
+typedef enum {
+    UNDO_CELL_INSERT = 1,       // CellRecord: cell inserted at index
+    UNDO_CELL_ERASE,            // CellRecord: cell removed from index
+    UNDO_CELL_WIRE,             // CellWireRecord: string membership changed
+    UNDO_STRING_INSERT,         // StringRecord
+    UNDO_STRING_ERASE,          // StringRecord
+    UNDO_STRING_CELL_INSERT,    // StringCellRecord: cell id inserted into a string's list
+    UNDO_STRING_CELL_ERASE,     // StringCellRecord
+    UNDO_STRING_ORDER,          // StringOrderRecord: string's cell list reordered
+    UNDO_DIODE_INSERT,          // DiodeRecord
+    UNDO_DIODE_ERASE,           // DiodeRecord
+    UNDO_TRANSFORM,             // TransformRecord
+    UNDO_ACTIVE_STRING          // ActiveStringRecord
+} UndoRecordType;
+
+typedef struct {
+    int index;
+    SolarCell cell;
+} CellRecord;
+
+// [0] before, [1] after
+typedef struct {
+    int index;
+    int cell_id;
+    int string_id[2];
+    int order[2];
+} CellWireRecord;
+
+// String identity and wiring; simulation outputs are not kept
+typedef struct {
+    int index;
+    int id;
+    Color color;
+    int mppt_channel;
+    int cell_count;
+    int cell_ids[]; // cell_count entries
+} StringRecord;
+
+typedef struct {
+    int index;
+    int string_id;
+    int position;
+    int cell_id;
+} StringCellRecord;
+
+typedef struct {
+    int index;
+    int string_id;
+    int count;
+    int cell_ids[]; // count entries before, then count after
+} StringOrderRecord;
+
+typedef struct {
+    int index;
+    BypassDiode diode;
+} DiodeRecord;
+
+typedef struct {
+    float scale[2];
+    Vector3 rotation[2];
+    double time; // When the latest merged edit was made
+} TransformRecord;
+
+typedef struct {
+    int active[2];
+} ActiveStringRecord;
+
+// Checkpoint payload: this header, cells, diodes, then string_count StringRecords
+typedef struct {
+    int cell_count;
+    int string_count;
+    int diode_count;
+    int active_string_id;
+    float mesh_scale;
+    Vector3 mesh_rotation;
+} CheckpointHeader;
+
+// What an apply touched, for refreshing caches afterwards
+typedef struct {
+    bool cells;
+    bool transform;
+} ApplyEffects;
+
+static uint32_t StringRecordSize(int cell_count) {
+    return (uint32_t) (sizeof(StringRecord) + cell_count * sizeof(int));
+}
+
+static void FillStringRecord(StringRecord *record, int index, const CellString *str) {
+    record->index = index;
+    record->id = str->id;
+    record->color = str->color;
+    record->mppt_channel = str->mppt_channel;
+    record->cell_count = str->cell_count;
+    memcpy(record->cell_ids, str->cell_ids, str->cell_count * sizeof(int));
+}
+
+static void StringFromRecord(CellString *str, const StringRecord *record) {
+    memset(str, 0, sizeof(*str));
+    str->id = record->id;
+    str->color = record->color;
+    str->mppt_channel = record->mppt_channel;
+    str->cell_count = record->cell_count;
+    memcpy(str->cell_ids, record->cell_ids, record->cell_count * sizeof(int));
+}
+
+//------------------------------------------------------------------------------
+// Recording
+//------------------------------------------------------------------------------
+static size_t CheckpointSize(const AppState *app) {
+    size_t size = sizeof(CheckpointHeader) + app->cell_count * sizeof(SolarCell) +
+                  app->bypass_diode_count * sizeof(BypassDiode);
+    for (int s = 0; s < app->string_count; s++) {
+        size += StringRecordSize(app->strings[s].cell_count);
+    }
+    return size;
+}
+
+static void WriteCheckpoint(AppState *app, size_t size) {
+    unsigned char *out = (unsigned char *) UndoJournal_AppendCheckpoint(&app->undo, (uint32_t) size);
+    if (!out)
+        return;
+
+    CheckpointHeader header = {app->cell_count, app->string_count, app->bypass_diode_count, app->active_string_id,
+                               app->mesh_scale, app->mesh_rotation};
+    memcpy(out, &header, sizeof(header));
+    out += sizeof(header);
+    memcpy(out, app->cells, app->cell_count * sizeof(SolarCell));
+    out += app->cell_count * sizeof(SolarCell);
+    memcpy(out, app->bypass_diodes, app->bypass_diode_count * sizeof(BypassDiode));
+    out += app->bypass_diode_count * sizeof(BypassDiode);
+    for (int s = 0; s < app->string_count; s++) {
+        FillStringRecord((StringRecord *) out, s, &app->strings[s]);
+        out += StringRecordSize(app->strings[s].cell_count);
+    }
+}
+
+void BeginEdit(AppState *app, const char *label) {
+    if (!UndoJournal_BeginStep(&app->undo, label))
+        return;
+
+    app->edit_active_string = app->active_string_id;
+    size_t size = CheckpointSize(app);
+    if (UndoJournal_CheckpointDue(&app->undo, size))
+        WriteCheckpoint(app, size);
+}
+
+void EndEdit(AppState *app) {
+    if (app->undo.depth == 1 && app->active_string_id != app->edit_active_string) {
+        ActiveStringRecord *record = (ActiveStringRecord *) UndoJournal_Append(&app->undo, UNDO_ACTIVE_STRING,
+                                                                               sizeof(ActiveStringRecord));
+        if (record) {
+            record->active[0] = app->edit_active_string;
+            record->active[1] = app->active_string_id;
+        }
+    }
+    UndoJournal_EndStep(&app->undo, UNDO_HISTORY_BUDGET);
+}
+
+void ClearEditHistory(AppState *app) {
+    UndoJournal_Clear(&app->undo);
+}
+
+void JournalCellAdded(AppState *app, int index) {
+    CellRecord *record = (CellRecord *) UndoJournal_Append(&app->undo, UNDO_CELL_INSERT, sizeof(CellRecord));
+    if (record) {
+        record->index = index;
+        record->cell = app->cells[index];
+    }
+}
+
+void JournalCellRemoving(AppState *app, int index) {
+    CellRecord *record = (CellRecord *) UndoJournal_Append(&app->undo, UNDO_CELL_ERASE, sizeof(CellRecord));
+    if (record) {
+        record->index = index;
+        record->cell = app->cells[index];
+    }
+}
+
+void JournalCellWired(AppState *app, int index, int old_string_id, int old_order) {
+    const SolarCell *cell = &app->cells[index];
+    if (cell->string_id == old_string_id && cell->order_in_string == old_order)
+        return;
+    CellWireRecord *record = (CellWireRecord *) UndoJournal_Append(&app->undo, UNDO_CELL_WIRE,
+                                                                   sizeof(CellWireRecord));
+    if (record) {
+        record->index = index;
+        record->cell_id = cell->id;
+        record->string_id[0] = old_string_id;
+        record->string_id[1] = cell->string_id;
+        record->order[0] = old_order;
+        record->order[1] = cell->order_in_string;
+    }
+}
+
+static void JournalString(AppState *app, UndoRecordType type, int index) {
+    const CellString *str = &app->strings[index];
+    StringRecord *record = (StringRecord *) UndoJournal_Append(&app->undo, type, StringRecordSize(str->cell_count));
+    if (record)
+        FillStringRecord(record, index, str);
+}
+
+void JournalStringAdded(AppState *app, int index) {
+    JournalString(app, UNDO_STRING_INSERT, index);
+}
+
+void JournalStringRemoving(AppState *app, int index) {
+    JournalString(app, UNDO_STRING_ERASE, index);
+}
+
+static void JournalStringCell(AppState *app, UndoRecordType type, int index, int position) {
+    StringCellRecord *record = (StringCellRecord *) UndoJournal_Append(&app->undo, type, sizeof(StringCellRecord));
+    if (record) {
+        record->index = index;
+        record->string_id = app->strings[index].id;
+        record->position = position;
+        record->cell_id = app->strings[index].cell_ids[position];
+    }
+}
+
+void JournalStringCellAdded(AppState *app, int index, int position) {
+    JournalStringCell(app, UNDO_STRING_CELL_INSERT, index, position);
+}
+
+void JournalStringCellRemoving(AppState *app, int index, int position) {
+    JournalStringCell(app, UNDO_STRING_CELL_ERASE, index, position);
+}
+
+void JournalStringReordered(AppState *app, int index, const int *old_cell_ids) {
+    const CellString *str = &app->strings[index];
+    StringOrderRecord *record = (StringOrderRecord *) UndoJournal_Append(
+            &app->undo, UNDO_STRING_ORDER, (uint32_t) (sizeof(StringOrderRecord) + 2 * str->cell_count * sizeof(int)));
+    if (record) {
+        record->index = index;
+        record->string_id = str->id;
+        record->count = str->cell_count;
+        memcpy(record->cell_ids, old_cell_ids, str->cell_count * sizeof(int));
+        memcpy(record->cell_ids + str->cell_count, str->cell_ids, str->cell_count * sizeof(int));
+    }
+}
+
+void JournalDiodeAdded(AppState *app, int index) {
+    DiodeRecord *record = (DiodeRecord *) UndoJournal_Append(&app->undo, UNDO_DIODE_INSERT, sizeof(DiodeRecord));
+    if (record) {
+        record->index = index;
+        record->diode = app->bypass_diodes[index];
+    }
+}
+
+void JournalDiodeRemoving(AppState *app, int index) {
+    DiodeRecord *record = (DiodeRecord *) UndoJournal_Append(&app->undo, UNDO_DIODE_ERASE, sizeof(DiodeRecord));
+    if (record) {
+        record->index = index;
+        record->diode = app->bypass_diodes[index];
+    }
+}
+
+void RecordTransformEdit(AppState *app, float old_scale, Vector3 old_rotation) {
+    double now = GetTime();
+
+    // A slider drag changes the transform every frame; keep extending the step it started
+    UndoRecord *last = UndoJournal_LastSingleRecord(&app->undo);
+    if (last && last->type == UNDO_TRANSFORM) {
+        TransformRecord *record = (TransformRecord *) UndoRecord_Data(last);
+        if (now - record->time < UNDO_MERGE_SECONDS) {
+            record->scale[1] = app->mesh_scale;
+            record->rotation[1] = app->mesh_rotation;
+            record->time = now;
+            return;
+        }
+    }
+
+    BeginEdit(app, "Mesh transform");
+    TransformRecord *record = (TransformRecord *) UndoJournal_Append(&app->undo, UNDO_TRANSFORM,
+                                                                     sizeof(TransformRecord));
+    if (record) {
+        record->scale[0] = old_scale;
+        record->scale[1] = app->mesh_scale;
+        record->rotation[0] = old_rotation;
+        record->rotation[1] = app->mesh_rotation;
+        record->time = now;
+    }
+    EndEdit(app);
+}
+
+//------------------------------------------------------------------------------
+// Applying
+//------------------------------------------------------------------------------
+// Each helper checks the position it is given before changing anything, so a failed record leaves state intact
+static bool InsertCellAt(AppState *app, int index, const SolarCell *cell) {
+    if (index < 0 || index > app->cell_count || app->cell_count >= MAX_CELLS)
+        return false;
+    memmove(&app->cells[index + 1], &app->cells[index], (app->cell_count - index) * sizeof(SolarCell));
+    app->cells[index] = *cell;
+    app->cell_count++;
+    return true;
+}
+
+static bool EraseCellAt(AppState *app, int index, int id) {
+    if (index < 0 || index >= app->cell_count || app->cells[index].id != id)
+        return false;
+    memmove(&app->cells[index], &app->cells[index + 1], (app->cell_count - index - 1) * sizeof(SolarCell));
+    app->cell_count--;
+    return true;
+}
+
+static bool InsertStringAt(AppState *app, const StringRecord *record) {
+    int index = record->index;
+    if (index < 0 || index > app->string_count || app->string_count >= MAX_STRINGS)
+        return false;
+    memmove(&app->strings[index + 1], &app->strings[index], (app->string_count - index) * sizeof(CellString));
+    StringFromRecord(&app->strings[index], record);
+    app->string_count++;
+    return true;
+}
+
+static bool EraseStringAt(AppState *app, int index, int id) {
+    if (index < 0 || index >= app->string_count || app->strings[index].id != id)
+        return false;
+    memmove(&app->strings[index], &app->strings[index + 1], (app->string_count - index - 1) * sizeof(CellString));
+    app->string_count--;
+    return true;
+}
+
+static bool InsertStringCell(AppState *app, const StringCellRecord *record) {
+    if (record->index < 0 || record->index >= app->string_count)
+        return false;
+    CellString *str = &app->strings[record->index];
+    if (str->id != record->string_id || record->position < 0 || record->position > str->cell_count ||
+        str->cell_count >= MAX_CELLS_PER_STRING)
+        return false;
+    memmove(&str->cell_ids[record->position + 1], &str->cell_ids[record->position],
+            (str->cell_count - record->position) * sizeof(int));
+    str->cell_ids[record->position] = record->cell_id;
+    str->cell_count++;
+    return true;
+}
+
+static bool EraseStringCell(AppState *app, const StringCellRecord *record) {
+    if (record->index < 0 || record->index >= app->string_count)
+        return false;
+    CellString *str = &app->strings[record->index];
+    if (str->id != record->string_id || record->position < 0 || record->position >= str->cell_count ||
+        str->cell_ids[record->position] != record->cell_id)
+        return false;
+    memmove(&str->cell_ids[record->position], &str->cell_ids[record->position + 1],
+            (str->cell_count - record->position - 1) * sizeof(int));
+    str->cell_count--;
+    return true;
+}
+
+static bool SetStringOrder(AppState *app, const StringOrderRecord *record, bool forward) {
+    if (record->index < 0 || record->index >= app->string_count)
+        return false;
+    CellString *str = &app->strings[record->index];
+    if (str->id != record->string_id || str->cell_count != record->count)
+        return false;
+    const int *from = forward ? record->cell_ids : record->cell_ids + record->count;
+    const int *to = forward ? record->cell_ids + record->count : record->cell_ids;
+    if (memcmp(str->cell_ids, from, record->count * sizeof(int)) != 0)
+        return false;
+    memcpy(str->cell_ids, to, record->count * sizeof(int));
+    return true;
+}
+
+static bool InsertDiodeAt(AppState *app, int index, const BypassDiode *diode) {
+    if (index < 0 || index > app->bypass_diode_count || app->bypass_diode_count >= MAX_BYPASS_DIODES)
+        return false;
+    memmove(&app->bypass_diodes[index + 1], &app->bypass_diodes[index],
+            (app->bypass_diode_count - index) * sizeof(BypassDiode));
+    app->bypass_diodes[index] = *diode;
+    app->bypass_diode_count++;
+    return true;
+}
+
+static bool EraseDiodeAt(AppState *app, int index, int id) {
+    if (index < 0 || index >= app->bypass_diode_count || app->bypass_diodes[index].id != id)
+        return false;
+    memmove(&app->bypass_diodes[index], &app->bypass_diodes[index + 1],
+            (app->bypass_diode_count - index - 1) * sizeof(BypassDiode));
+    app->bypass_diode_count--;
+    return true;
+}
+
+// Replay one record forwards (redo) or backwards (undo)
+static bool ApplyRecord(AppState *app, const UndoRecord *rec, bool forward, ApplyEffects *effects) {
+    const void *data = UndoRecord_Data(rec);
+    int side = forward ? 1 : 0;
+
+    switch ((UndoRecordType) rec->type) {
+    case UNDO_CELL_INSERT:
+    case UNDO_CELL_ERASE: {
+        const CellRecord *r = (const CellRecord *) data;
+        effects->cells = true;
+        bool insert = (rec->type == UNDO_CELL_INSERT) == forward;
+        return insert ? InsertCellAt(app, r->index, &r->cell) : EraseCellAt(app, r->index, r->cell.id);
+    }
+    case UNDO_CELL_WIRE: {
+        const CellWireRecord *r = (const CellWireRecord *) data;
+        if (r->index < 0 || r->index >= app->cell_count || app->cells[r->index].id != r->cell_id)
+            return false;
+        app->cells[r->index].string_id = r->string_id[side];
+        app->cells[r->index].order_in_string = r->order[side];
+        return true;
+    }
+    case UNDO_STRING_INSERT:
+    case UNDO_STRING_ERASE: {
+        const StringRecord *r = (const StringRecord *) data;
+        bool insert = (rec->type == UNDO_STRING_INSERT) == forward;
+        return insert ? InsertStringAt(app, r) : EraseStringAt(app, r->index, r->id);
+    }
+    case UNDO_STRING_CELL_INSERT:
+    case UNDO_STRING_CELL_ERASE: {
+        const StringCellRecord *r = (const StringCellRecord *) data;
+        bool insert = (rec->type == UNDO_STRING_CELL_INSERT) == forward;
+        return insert ? InsertStringCell(app, r) : EraseStringCell(app, r);
+    }
+    case UNDO_STRING_ORDER:
+        return SetStringOrder(app, (const StringOrderRecord *) data, forward);
+    case UNDO_DIODE_INSERT:
+    case UNDO_DIODE_ERASE: {
+        const DiodeRecord *r = (const DiodeRecord *) data;
+        bool insert = (rec->type == UNDO_DIODE_INSERT) == forward;
+        return insert ? InsertDiodeAt(app, r->index, &r->diode) : EraseDiodeAt(app, r->index, r->diode.id);
+    }
+    case UNDO_TRANSFORM: {
+        const TransformRecord *r = (const TransformRecord *) data;
+        app->mesh_scale = r->scale[side];
+        app->mesh_rotation = r->rotation[side];
+        effects->transform = true;
+        return true;
+    }
+    case UNDO_ACTIVE_STRING:
+        app->active_string_id = ((const ActiveStringRecord *) data)->active[side];
+        return true;
+    }
+    return rec->type == UNDO_RECORD_CHECKPOINT;
+}
+
+static bool ApplyStep(AppState *app, int step, bool forward, ApplyEffects *effects) {
+    UndoJournal *journal = &app->undo;
+    UndoRecord *rec = forward ? UndoJournal_FirstRecord(journal, step) : UndoJournal_LastRecord(journal, step);
+    while (rec) {
+        if (!ApplyRecord(app, rec, forward, effects))
+            return false;
+        rec = forward ? UndoJournal_NextRecord(journal, step, rec) : UndoJournal_PrevRecord(journal, step, rec);
+    }
+    return true;
+}
+
+static void RestoreCheckpoint(AppState *app, const unsigned char *in) {
+    CheckpointHeader header;
+    memcpy(&header, in, sizeof(header));
+    in += sizeof(header);
+
+    app->cell_count = header.cell_count;
+    memcpy(app->cells, in, header.cell_count * sizeof(SolarCell));
+    in += header.cell_count * sizeof(SolarCell);
+    app->bypass_diode_count = header.diode_count;
+    memcpy(app->bypass_diodes, in, header.diode_count * sizeof(BypassDiode));
+    in += header.diode_count * sizeof(BypassDiode);
+    app->string_count = header.string_count;
+    for (int s = 0; s < header.string_count; s++) {
+        const StringRecord *record = (const StringRecord *) in;
+        StringFromRecord(&app->strings[s], record);
+        in += StringRecordSize(record->cell_count);
+    }
+    app->active_string_id = header.active_string_id;
+    app->mesh_scale = header.mesh_scale;
+    app->mesh_rotation = header.mesh_rotation;
+}
+
+// Rebuild the state after the first target steps from the nearest earlier checkpoint
+static bool RecoverTo(AppState *app, int target, ApplyEffects *effects) {
+    int from = UndoJournal_CheckpointBefore(&app->undo, target);
+    if (from < 0)
+        return false;
+
+    RestoreCheckpoint(app, (const unsigned char *) UndoRecord_Data(UndoJournal_FirstRecord(&app->undo, from)));
+    effects->cells = true;
+    effects->transform = true;
+    for (int s = from; s < target; s++) {
+        if (!ApplyStep(app, s, true, effects))
+            return false;
+    }
+    return true;
+}
+
+static void FinishApply(AppState *app, const ApplyEffects *effects) {
+    app->cell_revision++;
+    if (effects->transform)
+        UpdateMeshTransform(app);
+    if (effects->cells) {
+        app->hovered_cell_id = -1;
+        app->placing_bypass_diode = false;
+        app->bypass_diode_start_cell = -1;
+    }
+}
+
+static bool MoveInHistory(AppState *app, bool forward) {
+    UndoJournal *journal = &app->undo;
+    if (journal->depth > 0)
+        return false;
+    if (forward ? journal->position >= journal->step_count : journal->position == 0) {
+        SetStatus(app, forward ? "Nothing to redo" : "Nothing to undo");
+        return false;
+    }
+
+    int step = forward ? journal->position : journal->position - 1;
+    int target = forward ? step + 1 : step;
+    char label[UNDO_JOURNAL_LABEL_LENGTH];
+    memcpy(label, journal->steps[step].label, sizeof(label));
+
+    ApplyEffects effects = {false, false};
+    bool ok = ApplyStep(app, step, forward, &effects);
+    if (!ok) {
+        TraceLog(LOG_WARNING, "Undo: '%s' no longer matches the layout, rebuilding from a checkpoint", label);
+        ok = RecoverTo(app, target, &effects);
+    }
+    FinishApply(app, &effects);
+
+    if (!ok) {
+        UndoJournal_Clear(journal);
+        SetStatus(app, "Could not %s '%s'; history cleared", forward ? "redo" : "undo", label);
+        return false;
+    }
+    journal->position = target;
+    SetStatus(app, "%s: %s", forward ? "Redo" : "Undo", label);
+    return true;
+}
+
+bool UndoEdit(AppState *app) {
+    return MoveInHistory(app, false);
+}
+
+bool RedoEdit(AppState *app) {
+    return MoveInHistory(app, true);
+}
@@ -0,0 +1,11 @@
+#ifndef UNDO_H
+#define UNDO_H
+
+// Undo / redo implementation
+// Function declarations are in app.h
+// This header contains implementation-specific constants
+
+#define UNDO_HISTORY_BUDGET (16 * 1024 * 1024) // Journal bytes kept before the oldest steps are dropped
+#define UNDO_MERGE_SECONDS 0.75 // Transform edits closer together than this undo as one step
+
+#endif // UNDO_H
@@ -0,0 +1,247 @@
+/*
+ * Step journal of delta records for undo / redo
+ */
+
+#include "undo_journal.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Records are laid out as header, payload padded to 8 bytes, then a footer holding the record's total size so
+// steps can also be walked backwards
+#define RECORD_ALIGN 8
+#define RECORD_FOOTER 8
+
+static size_t PaddedSize(uint32_t size) {
+    return ((size_t) size + RECORD_ALIGN - 1) & ~(size_t) (RECORD_ALIGN - 1);
+}
+
+static size_t RecordBytes(uint32_t size) {
+    return sizeof(UndoRecord) + PaddedSize(size) + RECORD_FOOTER;
+}
+
+static bool Reserve(UndoJournal *journal, size_t bytes) {
+    if (journal->size + bytes <= journal->capacity)
+        return true;
+    size_t capacity = journal->capacity ? journal->capacity : 4096;
+    while (capacity < journal->size + bytes) {
+        capacity *= 2;
+    }
+    unsigned char *data = (unsigned char *) realloc(journal->data, capacity);
+    if (!data)
+        return false;
+    journal->data = data;
+    journal->capacity = capacity;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Lifecycle
+//------------------------------------------------------------------------------
+void UndoJournal_Init(UndoJournal *journal) {
+    memset(journal, 0, sizeof(*journal));
+}
+
+void UndoJournal_Free(UndoJournal *journal) {
+    free(journal->data);
+    free(journal->steps);
+    UndoJournal_Init(journal);
+}
+
+void UndoJournal_Clear(UndoJournal *journal) {
+    if (journal->depth > 0) {
+        // Keep what the open step has recorded so far
+        size_t open_bytes = journal->size - journal->open.begin;
+        memmove(journal->data, journal->data + journal->open.begin, open_bytes);
+        journal->size = open_bytes;
+        journal->open.begin = 0;
+    } else {
+        journal->size = 0;
+    }
+    journal->step_count = 0;
+    journal->position = 0;
+}
+
+//------------------------------------------------------------------------------
+// Recording
+//------------------------------------------------------------------------------
+bool UndoJournal_BeginStep(UndoJournal *journal, const char *label) {
+    if (journal->depth++ > 0)
+        return false;
+
+    memset(&journal->open, 0, sizeof(journal->open));
+    journal->open.begin = journal->size;
+    strncpy(journal->open.label, label ? label : "Edit", UNDO_JOURNAL_LABEL_LENGTH - 1);
+    journal->open_records = 0;
+    journal->failed = false;
+    return true;
+}
+
+static UndoRecord *AppendRecord(UndoJournal *journal, uint32_t type, uint32_t size) {
+    if (journal->depth == 0 || journal->failed || !Reserve(journal, RecordBytes(size))) {
+        // A missing record would leave the steps around it impossible to replay
+        journal->failed = true;
+        UndoJournal_Clear(journal);
+        return NULL;
+    }
+
+    UndoRecord *record = (UndoRecord *) (journal->data + journal->size);
+    record->type = type;
+    record->size = size;
+    size_t total = RecordBytes(size);
+    unsigned char *footer = journal->data + journal->size + total - RECORD_FOOTER;
+    memset(footer, 0, RECORD_FOOTER);
+    *(uint32_t *) footer = (uint32_t) total;
+    journal->size += total;
+    return record;
+}
+
+void *UndoJournal_Append(UndoJournal *journal, uint32_t type, uint32_t size) {
+    UndoRecord *record = AppendRecord(journal, type, size);
+    if (!record)
+        return NULL;
+    journal->open_records++;
+    return UndoRecord_Data(record);
+}
+
+void *UndoJournal_AppendCheckpoint(UndoJournal *journal, uint32_t size) {
+    if (journal->depth == 0 || journal->size != journal->open.begin)
+        return NULL;
+    UndoRecord *record = AppendRecord(journal, UNDO_RECORD_CHECKPOINT, size);
+    if (!record)
+        return NULL;
+    journal->open.checkpoint = true;
+    return UndoRecord_Data(record);
+}
+
+int UndoJournal_CheckpointBefore(const UndoJournal *journal, int step) {
+    if (step >= journal->step_count)
+        step = journal->step_count - 1;
+    for (int s = step; s >= 0; s--) {
+        if (journal->steps[s].checkpoint)
+            return s;
+    }
+    return -1;
+}
+
+bool UndoJournal_CheckpointDue(const UndoJournal *journal, size_t checkpoint_size) {
+    // The open step will replace the redo steps, so only applied steps count
+    int last = UndoJournal_CheckpointBefore(journal, journal->position - 1);
+    if (last < 0)
+        return true;
+    return journal->steps[journal->position - 1].end - journal->steps[last].begin >= checkpoint_size;
+}
+
+// Drop the oldest steps, a checkpoint run at a time, so the remaining history still starts at a checkpoint
+static void Trim(UndoJournal *journal, size_t budget) {
+    while (journal->size > budget) {
+        int keep_from = -1;
+        for (int s = 1; s < journal->position; s++) {
+            if (journal->steps[s].checkpoint) {
+                keep_from = s;
+                break;
+            }
+        }
+        if (keep_from < 0)
+            return;
+
+        size_t offset = journal->steps[keep_from].begin;
+        memmove(journal->data, journal->data + offset, journal->size - offset);
+        journal->size -= offset;
+        memmove(journal->steps, journal->steps + keep_from, (journal->step_count - keep_from) * sizeof(UndoStep));
+        journal->step_count -= keep_from;
+        journal->position -= keep_from;
+        for (int s = 0; s < journal->step_count; s++) {
+            journal->steps[s].begin -= offset;
+            journal->steps[s].end -= offset;
+        }
+    }
+}
+
+bool UndoJournal_EndStep(UndoJournal *journal, size_t budget) {
+    if (journal->depth == 0 || --journal->depth > 0)
+        return false;
+
+    if (journal->failed) {
+        UndoJournal_Clear(journal);
+        journal->failed = false;
+        return false;
+    }
+
+    // Nothing changed: forget the step (and its checkpoint), keeping the redo steps
+    if (journal->open_records == 0) {
+        journal->size = journal->open.begin;
+        return false;
+    }
+
+    // The new step replaces the redo steps
+    size_t tail = journal->position < journal->step_count ? journal->steps[journal->position].begin
+                                                           : journal->open.begin;
+    if (tail < journal->open.begin) {
+        memmove(journal->data + tail, journal->data + journal->open.begin, journal->size - journal->open.begin);
+        journal->size -= journal->open.begin - tail;
+        journal->open.begin = tail;
+    }
+    journal->step_count = journal->position;
+
+    if (journal->step_count == journal->step_capacity) {
+        int capacity = journal->step_capacity ? journal->step_capacity * 2 : 64;
+        UndoStep *steps = (UndoStep *) realloc(journal->steps, capacity * sizeof(UndoStep));
+        if (!steps) {
+            UndoJournal_Clear(journal);
+            return false;
+        }
+        journal->steps = steps;
+        journal->step_capacity = capacity;
+    }
+
+    journal->open.end = journal->size;
+    journal->steps[journal->step_count++] = journal->open;
+    journal->position = journal->step_count;
+
+    Trim(journal, budget);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Iteration
+//------------------------------------------------------------------------------
+void *UndoRecord_Data(const UndoRecord *record) {
+    return (void *) (record + 1);
+}
+
+UndoRecord *UndoJournal_FirstRecord(const UndoJournal *journal, int step) {
+    const UndoStep *s = &journal->steps[step];
+    return s->begin < s->end ? (UndoRecord *) (journal->data + s->begin) : NULL;
+}
+
+UndoRecord *UndoJournal_NextRecord(const UndoJournal *journal, int step, const UndoRecord *record) {
+    size_t next = (size_t) ((const unsigned char *) record - journal->data) + RecordBytes(record->size);
+    return next < journal->steps[step].end ? (UndoRecord *) (journal->data + next) : NULL;
+}
+
+UndoRecord *UndoJournal_LastRecord(const UndoJournal *journal, int step) {
+    const UndoStep *s = &journal->steps[step];
+    if (s->begin >= s->end)
+        return NULL;
+    uint32_t total = *(const uint32_t *) (journal->data + s->end - RECORD_FOOTER);
+    return (UndoRecord *) (journal->data + s->end - total);
+}
+
+UndoRecord *UndoJournal_PrevRecord(const UndoJournal *journal, int step, const UndoRecord *record) {
+    size_t at = (size_t) ((const unsigned char *) record - journal->data);
+    if (at <= journal->steps[step].begin)
+        return NULL;
+    uint32_t total = *(const uint32_t *) (journal->data + at - RECORD_FOOTER);
+    return (UndoRecord *) (journal->data + at - total);
+}
+
+UndoRecord *UndoJournal_LastSingleRecord(const UndoJournal *journal) {
+    if (journal->depth > 0 || journal->step_count == 0 || journal->position != journal->step_count)
+        return NULL;
+    int step = journal->step_count - 1;
+    UndoRecord *record = UndoJournal_LastRecord(journal, step);
+    if (!record || record->type == UNDO_RECORD_CHECKPOINT)
+        return NULL;
+    UndoRecord *prev = UndoJournal_PrevRecord(journal, step, record);
+    return (!prev || prev->type == UNDO_RECORD_CHECKPOINT) ? record : NULL;
+}
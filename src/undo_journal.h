@@ -0,0 +1,102 @@
+#ifndef UNDO_JOURNAL_H
+#define UNDO_JOURNAL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+//------------------------------------------------------------------------------
+// Constants
+//------------------------------------------------------------------------------
+#define UNDO_JOURNAL_LABEL_LENGTH 48 // Step names shown by undo / redo
+#define UNDO_RECORD_CHECKPOINT 0     // Record type reserved for checkpoints; callers use types >= 1
+
+//------------------------------------------------------------------------------
+// Undo journal
+//------------------------------------------------------------------------------
+// Edits are stored as steps of small delta records, appended to one byte
+// buffer, so memory and time per step follow the size of the edit rather
+// than the size of the document. The caller decides what a record means and
+// how to apply or invert it; the journal only keeps the records in order
+// and walks them forwards (redo) or backwards (undo).
+//
+// Every so often a step starts with a checkpoint: a full copy of the state
+// before that step. Checkpoints are only read to recover when replaying a
+// record fails, and they mark where old history can be dropped once the
+// journal grows past its byte budget.
+
+// Record header; size bytes of payload follow, padded to 8
+typedef struct {
+    uint32_t type;
+    uint32_t size;
+} UndoRecord;
+
+typedef struct {
+    size_t begin;       // Byte range of the step's records in data
+    size_t end;
+    bool checkpoint;    // First record is a checkpoint of the state before the step
+    char label[UNDO_JOURNAL_LABEL_LENGTH];
+} UndoStep;
+
+typedef struct {
+    unsigned char *data;
+    size_t size;
+    size_t capacity;
+
+    UndoStep *steps;
+    int step_count;
+    int step_capacity;
+    int position;       // Steps before this are applied; the rest can be redone
+
+    // Step being recorded (depth > 0), written after the redo steps until it is kept
+    int depth;
+    UndoStep open;
+    int open_records;   // Records in the open step, checkpoint excluded
+    bool failed;        // A record could not be stored; the history is dropped when the step ends
+} UndoJournal;
+
+//------------------------------------------------------------------------------
+// Functions
+//------------------------------------------------------------------------------
+
+void UndoJournal_Init(UndoJournal *journal);
+void UndoJournal_Free(UndoJournal *journal);
+
+// Forget all steps (an open step keeps recording into a fresh history)
+void UndoJournal_Clear(UndoJournal *journal);
+
+// Open a step, or nest inside the open one. Returns true if this call opened the outermost step.
+bool UndoJournal_BeginStep(UndoJournal *journal, const char *label);
+
+// Close a nesting level. When the outermost level closes, a step with records replaces any redo steps and the
+// oldest history is dropped down to budget bytes (at checkpoint boundaries). Returns true if a step was kept.
+bool UndoJournal_EndStep(UndoJournal *journal, size_t budget);
+
+// Space for a record of size bytes in the open step; NULL (and the history is dropped) if there is no open step
+// or no memory
+void *UndoJournal_Append(UndoJournal *journal, uint32_t type, uint32_t size);
+
+// True if the open step should start with a checkpoint of checkpoint_size bytes: there is none yet, or the
+// steps since the last one are at least as large
+bool UndoJournal_CheckpointDue(const UndoJournal *journal, size_t checkpoint_size);
+
+// Space for the open step's checkpoint; must come before its first record
+void *UndoJournal_AppendCheckpoint(UndoJournal *journal, uint32_t size);
+
+// Latest step at or before step that starts with a checkpoint, -1 if none
+int UndoJournal_CheckpointBefore(const UndoJournal *journal, int step);
+
+// Record iteration within a step; NULL past the end
+UndoRecord *UndoJournal_FirstRecord(const UndoJournal *journal, int step);
+UndoRecord *UndoJournal_NextRecord(const UndoJournal *journal, int step, const UndoRecord *record);
+UndoRecord *UndoJournal_LastRecord(const UndoJournal *journal, int step);
+UndoRecord *UndoJournal_PrevRecord(const UndoJournal *journal, int step, const UndoRecord *record);
+
+// Payload of a record
+void *UndoRecord_Data(const UndoRecord *record);
+
+// The only record of the newest step, if that step is applied, has exactly one record and no step is open;
+// lets rapid edits of one value (a slider drag) merge into a single step
+UndoRecord *UndoJournal_LastSingleRecord(const UndoJournal *journal);
+
+#endif // UNDO_JOURNAL_H